@@ -94,6 +94,22 @@ void run_test(uint32_t spanlen, uint32_t intvlen, double density, order_t order)
     }
     printf("          %6.1f\n", array_min(results, num_passes));
 
+    printf("  roaring_bitmap_lazy_add():");
+    for (int p = 0; p < num_passes; p++) {
+        roaring_bitmap_t *r = roaring_bitmap_create();
+        RDTSC_START(cycles_start);
+        for (int64_t i = 0; i < count; i++) {
+            for (uint32_t j = 0; j < intvlen; j++) {
+                roaring_bitmap_lazy_add(r, offsets[i] + j);
+            }
+        }
+        roaring_bitmap_repair_after_lazy(r);
+        RDTSC_FINAL(cycles_final);
+        results[p] = (cycles_final - cycles_start) * 1.0 / count / intvlen;
+        roaring_bitmap_free(r);
+    }
+    printf("     %6.1f\n", array_min(results, num_passes));
+
     printf("  roaring_bitmap_add_many():");
     for (int p = 0; p < num_passes; p++) {
         roaring_bitmap_t *r = roaring_bitmap_create();
@@ -161,6 +177,8 @@ int main(int argc, char* argv[]) {
     (void)argc;
     (void)argv;
 
+    // SHUFFLE is random-order ingest and ASC sequential ingest; compare
+    // roaring_bitmap_add and roaring_bitmap_lazy_add across the two
     const uint32_t spanlen = 1000*1000;
     uint32_t intvlen_array[] = {1, 4, 16, 64};
     order_t order_array[] = {SHUFFLE, ASC, DESC};
@@ -0,0 +1,99 @@
+/*
+ * allocation_counter.h
+ *
+ * Counts the calls to the allocator made by a benchmark. With glibc, we
+ * interpose the whole malloc family (free included, so that a preloaded
+ * allocator never sees memory from glibc or the reverse) and forward it to
+ * the libc entry points. Elsewhere, or under a sanitizer (which owns the
+ * allocator), nothing is interposed: ALLOCATION_COUNTER_ENABLED is 0 and the
+ * count stays at zero. Defining ALLOCATION_COUNTER_DISABLE also turns it off,
+ * e.g. for static builds where libc already defines malloc.
+ *
+ * Include this header from a single source file per executable.
+ */
+
+#ifndef BENCHMARKS_ALLOCATION_COUNTER_H_
+#define BENCHMARKS_ALLOCATION_COUNTER_H_
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+static uint64_t allocation_count = 0;
+
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(memory_sanitizer) || \
+    __has_feature(thread_sanitizer)
+#define ALLOCATION_COUNTER_SANITIZED 1
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define ALLOCATION_COUNTER_SANITIZED 1
+#endif
+
+#if defined(__linux__) && defined(__GLIBC__) && \
+    !defined(ALLOCATION_COUNTER_SANITIZED) &&   \
+    !defined(ALLOCATION_COUNTER_DISABLE)
+#define ALLOCATION_COUNTER_ENABLED 1
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+extern void *__libc_valloc(size_t size);
+extern void *__libc_pvalloc(size_t size);
+extern void __libc_free(void *ptr);
+
+void *malloc(size_t size) {
+    allocation_count++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size) {
+    allocation_count++;
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    allocation_count++;
+    return __libc_realloc(ptr, size);
+}
+
+int posix_memalign(void **memptr, size_t alignment, size_t size) {
+    allocation_count++;
+    void *p = __libc_memalign(alignment, size);
+    if (p == NULL) return ENOMEM;
+    *memptr = p;
+    return 0;
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+    allocation_count++;
+    return __libc_memalign(alignment, size);
+}
+
+void *memalign(size_t alignment, size_t size) {
+    allocation_count++;
+    return __libc_memalign(alignment, size);
+}
+
+void *valloc(size_t size) {
+    allocation_count++;
+    return __libc_valloc(size);
+}
+
+void *pvalloc(size_t size) {
+    allocation_count++;
+    return __libc_pvalloc(size);
+}
+
+void free(void *ptr) { __libc_free(ptr); }
+
+#else
+#define ALLOCATION_COUNTER_ENABLED 0
+#endif
+
+/* number of allocations since the start of the program */
+static inline uint64_t allocation_counter_get(void) { return allocation_count; }
+
+#endif
@@ -71,6 +71,18 @@ int intersection_test(array_container_t* B1, array_container_t* B2,
     array_container_intersection(B1, B2, BO);
     return BO->cardinality;
 }
+
+int xor_test(array_container_t* B1, array_container_t* B2,
+             array_container_t* BO) {
+    array_container_xor(B1, B2, BO);
+    return BO->cardinality;
+}
+
+int andnot_test(array_container_t* B1, array_container_t* B2,
+                array_container_t* BO) {
+    array_container_andnot(B1, B2, BO);
+    return BO->cardinality;
+}
 int main() {
     int repeat = 500;
     int size = TESTSIZE;
@@ -155,6 +167,32 @@ int main() {
     printf("intersection cardinality = %d \n", answer);
     BEST_TIME(intersection_test(B1, B2, BO), answer, repeat, answer);
 
+    printf("==skewed union, xor and andnot test 3 \n");
+    array_container_clear(B1);
+    array_container_clear(B2);
+    for (int x = 0; x < 4000; ++x) {
+        array_container_add(B1, (uint16_t)(x * 16));
+    }
+    for (int x = 0; x < 10; ++x) {
+        array_container_add(B2, (uint16_t)(x * 6007));
+    }
+    inputsize = B1->cardinality + B2->cardinality;
+    printf("input 1 cardinality = %d, input 2 cardinality = %d \n",
+           B1->cardinality, B2->cardinality);
+    answer = union_test(B1, B2, BO);
+    printf("union cardinality = %d \n", answer);
+    BEST_TIME(union_test(B1, B2, BO), answer, repeat, inputsize);
+    BEST_TIME(union_test(B2, B1, BO), answer, repeat, inputsize);
+    answer = xor_test(B1, B2, BO);
+    printf("xor cardinality = %d \n", answer);
+    BEST_TIME(xor_test(B1, B2, BO), answer, repeat, inputsize);
+    answer = andnot_test(B1, B2, BO);
+    printf("B1 - B2 cardinality = %d \n", answer);
+    BEST_TIME(andnot_test(B1, B2, BO), answer, repeat, inputsize);
+    answer = andnot_test(B2, B1, BO);
+    printf("B2 - B1 cardinality = %d \n", answer);
+    BEST_TIME(andnot_test(B2, B1, BO), answer, repeat, B2->cardinality);
+
     array_container_free(B1);
     array_container_free(B2);
     array_container_free(BO);
@@ -0,0 +1,324 @@
+#define _GNU_SOURCE
+#include <roaring/roaring.h>
+#include "benchmark.h"
+#include "numbersfromtextfiles.h"
+
+/*
+ * A small LZ77 codec in the style of LZ4, standing in for the one a caller
+ * would supply: each sequence is a token (the number of literals and the
+ * length of the match, 4 bits each, longer lengths continuing in the next
+ * bytes), the literals, then the 16-bit distance of the match. The last
+ * sequence has literals only.
+ */
+enum { LZ_HASH_BITS = 12, LZ_MIN_MATCH = 4, LZ_MAX_DISTANCE = 65535 };
+
+static inline uint32_t lz_hash(const char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return (v * UINT32_C(2654435761)) >> (32 - LZ_HASH_BITS);
+}
+
+// writes the part of a length beyond 15, returns NULL if it does not fit
+static char *lz_write_length(char *out, const char *limit, size_t length) {
+    for (length -= 15; length >= 255; length -= 255) {
+        if (out == limit) return NULL;
+        *out++ = (char)255;
+    }
+    if (out == limit) return NULL;
+    *out++ = (char)length;
+    return out;
+}
+
+static char *lz_write_sequence(char *out, const char *limit,
+                               const char *literals, size_t n_literals,
+                               size_t distance, size_t match) {
+    if (out == limit) return NULL;
+    char *token = out++;
+    *token = (char)((n_literals < 15 ? n_literals : 15) << 4);
+    if (n_literals >= 15) out = lz_write_length(out, limit, n_literals);
+    if (out == NULL || (size_t)(limit - out) < n_literals) return NULL;
+    memcpy(out, literals, n_literals);
+    out += n_literals;
+    if (match == 0) return out;
+    const size_t extra = match - LZ_MIN_MATCH;
+    *token |= (char)(extra < 15 ? extra : 15);
+    if (limit - out < 2) return NULL;
+    const uint16_t d = (uint16_t)distance;
+    memcpy(out, &d, sizeof(d));
+    out += sizeof(d);
+    if (extra >= 15) out = lz_write_length(out, limit, extra);
+    return out;
+}
+
+static size_t lz_compress(const char *src, size_t src_len, char *dst,
+                          size_t dst_capacity, void *arg) {
+    (void)arg;
+    uint32_t table[1 << LZ_HASH_BITS];  // the last positions, plus one
+    memset(table, 0, sizeof(table));
+    const char *limit = dst + dst_capacity;
+    char *out = dst;
+    size_t anchor = 0;
+    size_t i = 0;
+    while (i + LZ_MIN_MATCH <= src_len) {
+        const uint32_t h = lz_hash(src + i);
+        const size_t candidate = table[h];
+        table[h] = (uint32_t)(i + 1);
+        if (candidate == 0 || i - (candidate - 1) > LZ_MAX_DISTANCE ||
+            memcmp(src + candidate - 1, src + i, LZ_MIN_MATCH) != 0) {
+            i++;
+            continue;
+        }
+        const size_t start = candidate - 1;
+        size_t match = LZ_MIN_MATCH;
+        while (i + match < src_len && src[start + match] == src[i + match]) {
+            match++;
+        }
+        out = lz_write_sequence(out, limit, src + anchor, i - anchor,
+                                i - start, match);
+        if (out == NULL) return 0;
+        i += match;
+        anchor = i;
+    }
+    out = lz_write_sequence(out, limit, src + anchor, src_len - anchor, 0, 0);
+    return out == NULL ? 0 : (size_t)(out - dst);
+}
+
+// reads the part of a length beyond 15, returns false past the end
+static bool lz_read_length(const char **in, const char *end, size_t *length) {
+    unsigned char byte;
+    do {
+        if (*in == end) return false;
+        byte = (unsigned char)*(*in)++;
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+static bool lz_decompress(const char *src, size_t src_len, char *dst,
+                          size_t dst_len, void *arg) {
+    (void)arg;
+    const char *in = src;
+    const char *end = src + src_len;
+    size_t out = 0;
+    while (in < end) {
+        const unsigned char token = (unsigned char)*in++;
+        size_t n_literals = token >> 4;
+        if (n_literals == 15 && !lz_read_length(&in, end, &n_literals)) {
+            return false;
+        }
+        if ((size_t)(end - in) < n_literals || dst_len - out < n_literals) {
+            return false;
+        }
+        memcpy(dst + out, in, n_literals);
+        in += n_literals;
+        out += n_literals;
+        if (in == end) break;  // the last sequence
+        uint16_t distance;
+        if (end - in < 2) return false;
+        memcpy(&distance, in, sizeof(distance));
+        in += sizeof(distance);
+        size_t match = token & 15;
+        if (match == 15 && !lz_read_length(&in, end, &match)) return false;
+        match += LZ_MIN_MATCH;
+        if (distance == 0 || distance > out || dst_len - out < match) {
+            return false;
+        }
+        // the match may overlap its own output
+        for (size_t k = 0; k < match; k++, out++) {
+            dst[out] = dst[out - distance];
+        }
+    }
+    return out == dst_len;
+}
+
+/*
+ * The containers hold sorted 16-bit values, which LZ compresses poorly: the
+ * same codec after replacing the values by their differences and splitting
+ * their low and high bytes, whose runs of zeros then compress. The sizes of
+ * the blocks are even. arg points to a scratch buffer large enough for a
+ * block.
+ */
+static void delta_shuffle(const char *src, size_t src_len, char *dst) {
+    const size_t n = src_len / 2;
+    uint16_t previous = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint16_t v;
+        memcpy(&v, src + 2 * i, sizeof(v));
+        const uint16_t delta = (uint16_t)(v - previous);
+        previous = v;
+        dst[i] = (char)(delta & 0xFF);
+        dst[n + i] = (char)(delta >> 8);
+    }
+}
+
+static void unshuffle_delta(const char *src, size_t src_len, char *dst) {
+    const size_t n = src_len / 2;
+    uint16_t previous = 0;
+    for (size_t i = 0; i < n; i++) {
+        previous += (uint16_t)((unsigned char)src[i] |
+                               ((unsigned char)src[n + i] << 8));
+        memcpy(dst + 2 * i, &previous, sizeof(previous));
+    }
+}
+
+static size_t delta_lz_compress(const char *src, size_t src_len, char *dst,
+                                size_t dst_capacity, void *arg) {
+    char *scratch = (char *)arg;
+    delta_shuffle(src, src_len, scratch);
+    return lz_compress(scratch, src_len, dst, dst_capacity, NULL);
+}
+
+static bool delta_lz_decompress(const char *src, size_t src_len, char *dst,
+                                size_t dst_len, void *arg) {
+    char *scratch = (char *)arg;
+    if (!lz_decompress(src, src_len, scratch, dst_len, NULL)) return false;
+    unshuffle_delta(scratch, dst_len, dst);
+    return true;
+}
+
+static void printusage(char *command) {
+    printf(
+        " Try %s directory \n where directory could be "
+        "benchmarks/realdata/census1881\n",
+        command);
+}
+
+int main(int argc, char **argv) {
+    int c;
+    const char *extension = ".txt";
+    while ((c = getopt(argc, argv, "e:h")) != -1) switch (c) {
+            case 'e':
+                extension = optarg;
+                break;
+            case 'h':
+                printusage(argv[0]);
+                return 0;
+            default:
+                abort();
+        }
+    if (optind >= argc) {
+        printusage(argv[0]);
+        return -1;
+    }
+    char *dirname = argv[optind];
+    size_t count;
+    size_t *howmany = NULL;
+    uint32_t **numbers =
+        read_all_integer_files(dirname, extension, &howmany, &count);
+    if (numbers == NULL) {
+        printf(
+            "I could not find or load any data file with extension %s in "
+            "directory %s.\n",
+            extension, dirname);
+        return -1;
+    }
+    roaring_bitmap_t **bitmaps = malloc(sizeof(roaring_bitmap_t *) * count);
+    size_t portable_bytes = 0;
+    size_t max_portable_bytes = 0;
+    size_t bound = 0;
+    for (size_t i = 0; i < count; i++) {
+        bitmaps[i] = roaring_bitmap_of_ptr(howmany[i], numbers[i]);
+        roaring_bitmap_run_optimize(bitmaps[i]);
+        const size_t size = roaring_bitmap_portable_size_in_bytes(bitmaps[i]);
+        portable_bytes += size;
+        if (size > max_portable_bytes) max_portable_bytes = size;
+        bound += roaring_bitmap_compressed_size_bound(bitmaps[i]);
+    }
+    printf("Loaded %d bitmaps from directory %s \n", (int)count, dirname);
+
+    uint64_t cycles_start = 0, cycles_final = 0;
+    char *portable = malloc(portable_bytes);
+    size_t offset = 0;
+    for (size_t i = 0; i < count; i++) {
+        offset += roaring_bitmap_portable_serialize(bitmaps[i],
+                                                    portable + offset);
+    }
+    RDTSC_START(cycles_start);
+    offset = 0;
+    for (size_t i = 0; i < count; i++) {
+        roaring_bitmap_t *r = roaring_bitmap_portable_deserialize_safe(
+            portable + offset, portable_bytes - offset);
+        offset += roaring_bitmap_portable_size_in_bytes(r);
+        roaring_bitmap_free(r);
+    }
+    RDTSC_FINAL(cycles_final);
+    printf("Portable format: %zu bytes, decoded in %" PRIu64 " cycles\n",
+           portable_bytes, cycles_final - cycles_start);
+    free(portable);
+
+    char *scratch = malloc(max_portable_bytes);
+    const roaring_codec_t codecs[] = {
+        {lz_compress, lz_decompress, NULL},
+        {delta_lz_compress, delta_lz_decompress, scratch}};
+    const char *codec_names[] = {"LZ", "delta+LZ"};
+    const uint32_t block_sizes[] = {0, 1 << 14, 1 << 16, UINT32_MAX};
+    const size_t n_block_sizes = sizeof(block_sizes) / sizeof(block_sizes[0]);
+    char *compressed = malloc(bound);
+    size_t *sizes = malloc(sizeof(size_t) * count);
+    for (size_t t = 0; t < 2 * n_block_sizes; t++) {
+        const roaring_codec_t codec = codecs[t / n_block_sizes];
+        const size_t b = t % n_block_sizes;
+        RDTSC_START(cycles_start);
+        offset = 0;
+        for (size_t i = 0; i < count; i++) {
+            sizes[i] = roaring_bitmap_compressed_serialize(
+                bitmaps[i], &codec, block_sizes[b], compressed + offset);
+            offset += sizes[i];
+        }
+        RDTSC_FINAL(cycles_final);
+        const size_t compressed_bytes = offset;
+        const uint64_t encoding = cycles_final - cycles_start;
+        RDTSC_START(cycles_start);
+        offset = 0;
+        for (size_t i = 0; i < count; i++) {
+            roaring_bitmap_t *r = roaring_bitmap_compressed_deserialize_safe(
+                compressed + offset, sizes[i], &codec);
+            if (r == NULL || !roaring_bitmap_equals(r, bitmaps[i])) {
+                printf("compressed serialization is wrong somehow\n");
+                return -1;
+            }
+            roaring_bitmap_free(r);
+            offset += sizes[i];
+        }
+        RDTSC_FINAL(cycles_final);
+        const uint64_t decoding = cycles_final - cycles_start;
+        // looking up the middle value of each bitmap, one block at a time
+        RDTSC_START(cycles_start);
+        offset = 0;
+        for (size_t i = 0; i < count; i++) {
+            const uint32_t x = numbers[i][howmany[i] / 2];
+            roaring_compressed_t view;
+            if (!roaring_compressed_init(&view, compressed + offset, sizes[i],
+                                         &codec)) {
+                return -1;
+            }
+            roaring_bitmap_t *r = roaring_compressed_block_deserialize(
+                &view, roaring_compressed_find_block(&view, x));
+            if (r == NULL || !roaring_bitmap_contains(r, x)) {
+                printf("compressed block lookup is wrong somehow\n");
+                return -1;
+            }
+            roaring_bitmap_free(r);
+            offset += sizes[i];
+        }
+        RDTSC_FINAL(cycles_final);
+        printf("%s, blocks of %" PRIu32 " bytes: %zu bytes (%.1f%%), "
+               "encoded in %" PRIu64 " cycles, decoded in %" PRIu64
+               " cycles, one block decoded in %" PRIu64 " cycles\n",
+               codec_names[t / n_block_sizes], block_sizes[b],
+               compressed_bytes, 100.0 * compressed_bytes / portable_bytes,
+               encoding, decoding, cycles_final - cycles_start);
+    }
+    free(sizes);
+    free(compressed);
+    free(scratch);
+
+    for (size_t i = 0; i < count; i++) {
+        free(numbers[i]);
+        roaring_bitmap_free(bitmaps[i]);
+    }
+    free(bitmaps);
+    free(howmany);
+    free(numbers);
+    return 0;
+}
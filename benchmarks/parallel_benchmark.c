@@ -0,0 +1,102 @@
+#define _GNU_SOURCE
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <roaring/roaring.h>
+#include "benchmark.h"
+
+/*
+ * Deserializes a large bitmap in the portable format with
+ * roaring_bitmap_portable_deserialize_parallel, running the tasks on as many
+ * threads, then one container at a time.
+ */
+
+typedef struct thread_task_s {
+    void (*task)(void *, uint32_t);
+    void *task_arg;
+    uint32_t i;
+} thread_task_t;
+
+static void *thread_run(void *arg) {
+    const thread_task_t *t = (const thread_task_t *)arg;
+    t->task(t->task_arg, t->i);
+    return NULL;
+}
+
+// a thread per task, where a caller would use its thread pool
+static void threads_run(void (*task)(void *, uint32_t), void *task_arg,
+                        uint32_t n_tasks, void *arg) {
+    (void)arg;
+    pthread_t *threads = malloc(n_tasks * sizeof(pthread_t));
+    thread_task_t *tasks = malloc(n_tasks * sizeof(thread_task_t));
+    for (uint32_t i = 0; i < n_tasks; i++) {
+        tasks[i].task = task;
+        tasks[i].task_arg = task_arg;
+        tasks[i].i = i;
+        pthread_create(&threads[i], NULL, thread_run, &tasks[i]);
+    }
+    for (uint32_t i = 0; i < n_tasks; i++) pthread_join(threads[i], NULL);
+    free(tasks);
+    free(threads);
+}
+
+int main(int argc, char **argv) {
+    const uint32_t n_containers = argc > 1 ? (uint32_t)atoi(argv[1]) : 16384;
+    // bitsets, arrays and runs in turn
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    uint32_t seed = 1;
+    for (uint32_t k = 0; k < n_containers; k++) {
+        const uint32_t base = k << 16;
+        switch (k % 3) {
+            case 0:
+                for (uint32_t i = 0; i < 65536; i += 1 + (seed >> 29)) {
+                    roaring_bitmap_add(r, base + i);
+                    seed = seed * 1103515245 + 12345;
+                }
+                break;
+            case 1:
+                for (uint32_t i = 0; i < 65536; i += 20 + (seed >> 26)) {
+                    roaring_bitmap_add(r, base + i);
+                    seed = seed * 1103515245 + 12345;
+                }
+                break;
+            default:
+                for (uint32_t i = 0; i < 65536; i += 200 + (seed >> 24)) {
+                    roaring_bitmap_add_range(r, base + i, base + i + 100);
+                    seed = seed * 1103515245 + 12345;
+                }
+        }
+    }
+    roaring_bitmap_run_optimize(r);
+    const size_t size = roaring_bitmap_portable_size_in_bytes(r);
+    char *buf = malloc(size);
+    roaring_bitmap_portable_serialize(r, buf);
+    printf("%u containers, %zu bytes\n", n_containers, size);
+
+    uint64_t cycles_start = 0, cycles_final = 0;
+    for (uint32_t n_threads = 1; n_threads <= 8; n_threads *= 2) {
+        roaring_executor_t executor = {threads_run, n_threads, NULL};
+        RDTSC_START(cycles_start);
+        const roaring_bitmap_t *r2 =
+            roaring_bitmap_portable_deserialize_parallel(buf, size, &executor);
+        RDTSC_FINAL(cycles_final);
+        printf("In parallel on %u threads: %" PRIu64 " cycles\n", n_threads,
+               cycles_final - cycles_start);
+        if (!roaring_bitmap_equals(r, r2)) {
+            printf("Bug!\n");
+            return 1;
+        }
+        roaring_bitmap_free(r2);
+    }
+    RDTSC_START(cycles_start);
+    roaring_bitmap_t *r1 = roaring_bitmap_portable_deserialize_safe(buf, size);
+    RDTSC_FINAL(cycles_final);
+    printf("Container by container: %" PRIu64 " cycles\n",
+           cycles_final - cycles_start);
+    roaring_bitmap_free(r1);
+    free(buf);
+    roaring_bitmap_free(r);
+    return 0;
+}
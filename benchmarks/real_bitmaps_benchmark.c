@@ -1,5 +1,6 @@
 #define _GNU_SOURCE
 #include <roaring/roaring.h>
+#include "allocation_counter.h"
 #include "benchmark.h"
 #include "numbersfromtextfiles.h"
 
@@ -134,27 +135,145 @@ int main(int argc, char **argv) {
     for (int i = 0; i < (int)count; i++) {
         copyofr[i] = roaring_bitmap_copy(bitmaps[i]);
     }
+    uint64_t allocations_start = allocation_counter_get();
     RDTSC_START(cycles_start);
     for (int i = 0; i < (int)count - 1; i++) {
         roaring_bitmap_and_inplace(copyofr[i], bitmaps[i + 1]);
     }
     RDTSC_FINAL(cycles_final);
     printf(" %zu successive in-place bitmaps intersections took %" PRIu64
-           " cycles\n",
-           count - 1, cycles_final - cycles_start);
+           " cycles and %" PRIu64 " allocations\n",
+           count - 1, cycles_final - cycles_start,
+           allocation_counter_get() - allocations_start);
 
     free(copyofr);
     copyofr = malloc(sizeof(roaring_bitmap_t *) * count);
     for (int i = 0; i < (int)count; i++) {
         copyofr[i] = roaring_bitmap_copy(bitmaps[i]);
     }
+    allocations_start = allocation_counter_get();
     RDTSC_START(cycles_start);
     for (int i = 0; i < (int)count - 1; i++) {
         roaring_bitmap_or_inplace(copyofr[i], bitmaps[i + 1]);
     }
     RDTSC_FINAL(cycles_final);
-    printf(" %zu successive in-place bitmaps unions took %" PRIu64 " cycles\n",
-           count - 1, cycles_final - cycles_start);
+    printf(" %zu successive in-place bitmaps unions took %" PRIu64
+           " cycles and %" PRIu64 " allocations\n",
+           count - 1, cycles_final - cycles_start,
+           allocation_counter_get() - allocations_start);
+
+    for (int i = 0; i < (int)count; i++) {
+        roaring_bitmap_free(copyofr[i]);
+        copyofr[i] = roaring_bitmap_copy(bitmaps[i]);
+    }
+    allocations_start = allocation_counter_get();
+    RDTSC_START(cycles_start);
+    for (int i = 0; i < (int)count - 1; i++) {
+        roaring_bitmap_xor_inplace(copyofr[i], bitmaps[i + 1]);
+    }
+    RDTSC_FINAL(cycles_final);
+    printf(" %zu successive in-place bitmaps xors took %" PRIu64
+           " cycles and %" PRIu64 " allocations\n",
+           count - 1, cycles_final - cycles_start,
+           allocation_counter_get() - allocations_start);
+    for (int i = 0; i < (int)count; i++) {
+        roaring_bitmap_free(copyofr[i]);
+    }
+    free(copyofr);
+
+    // incremental aggregation, as done when bitmaps arrive one at a time
+    roaring_bitmap_t *aggregate = roaring_bitmap_create();
+    allocations_start = allocation_counter_get();
+    RDTSC_START(cycles_start);
+    for (int i = 0; i < (int)count; i++) {
+        roaring_bitmap_or_inplace(aggregate, bitmaps[i]);
+    }
+    RDTSC_FINAL(cycles_final);
+    printf(" aggregating %zu bitmaps with in-place unions took %" PRIu64
+           " cycles and %" PRIu64 " allocations\n",
+           count, cycles_final - cycles_start,
+           allocation_counter_get() - allocations_start);
+    roaring_bitmap_free(aggregate);
+
+    // wide unions, with each strategy and with the planned one
+    const char *strategy_names[] = {"fold", "heap", "horizontal"};
+    roaring_union_plan_t plan;
+    RDTSC_START(cycles_start);
+    roaring_bitmap_or_many_plan(count, (const roaring_bitmap_t **)bitmaps,
+                                &plan);
+    RDTSC_FINAL(cycles_final);
+    printf(" planning the union of %zu bitmaps (%" PRIu64
+           " containers, %" PRIu32 " keys) took %" PRIu64
+           " cycles and chose %s\n",
+           count, plan.n_containers, plan.n_keys, cycles_final - cycles_start,
+           strategy_names[plan.strategy]);
+    for (int s = ROARING_UNION_FOLD; s <= ROARING_UNION_HORIZONTAL; s++) {
+        allocations_start = allocation_counter_get();
+        RDTSC_START(cycles_start);
+        roaring_bitmap_t *wide = roaring_bitmap_or_many_with_strategy(
+            count, (const roaring_bitmap_t **)bitmaps,
+            (roaring_union_strategy_t)s);
+        RDTSC_FINAL(cycles_final);
+        printf(" %s union of %zu bitmaps took %" PRIu64 " cycles and %" PRIu64
+               " allocations\n",
+               strategy_names[s], count, cycles_final - cycles_start,
+               allocation_counter_get() - allocations_start);
+        roaring_bitmap_free(wide);
+    }
+    allocations_start = allocation_counter_get();
+    RDTSC_START(cycles_start);
+    roaring_bitmap_t *wide_xor =
+        roaring_bitmap_xor_many(count, (const roaring_bitmap_t **)bitmaps);
+    RDTSC_FINAL(cycles_final);
+    printf(" xor of %zu bitmaps took %" PRIu64 " cycles and %" PRIu64
+           " allocations\n",
+           count, cycles_final - cycles_start,
+           allocation_counter_get() - allocations_start);
+    roaring_bitmap_free(wide_xor);
+    // values in at least T bitmaps, compared with counting them in T levels
+    // of bitmaps (level j holds the values seen at least j + 1 times)
+    const uint32_t thresholds[] = {2, 3, (uint32_t)count / 2};
+    for (int t = 0; t < 3; t++) {
+        const uint32_t threshold = thresholds[t];
+        RDTSC_START(cycles_start);
+        roaring_bitmap_t *above = roaring_bitmap_threshold_many(
+            count, (const roaring_bitmap_t **)bitmaps, threshold);
+        RDTSC_FINAL(cycles_final);
+        const uint64_t threshold_cycles = cycles_final - cycles_start;
+        roaring_bitmap_t **levels =
+            malloc(sizeof(roaring_bitmap_t *) * threshold);
+        for (uint32_t j = 0; j < threshold; j++) {
+            levels[j] = roaring_bitmap_create();
+        }
+        RDTSC_START(cycles_start);
+        for (size_t i = 0; i < count; i++) {
+            for (uint32_t j = threshold - 1; j > 0; j--) {
+                roaring_bitmap_t *more = roaring_bitmap_and(levels[j - 1],
+                                                            bitmaps[i]);
+                roaring_bitmap_or_inplace(levels[j], more);
+                roaring_bitmap_free(more);
+            }
+            roaring_bitmap_or_inplace(levels[0], bitmaps[i]);
+        }
+        RDTSC_FINAL(cycles_final);
+        if (!roaring_bitmap_equals(above, levels[threshold - 1])) {
+            printf(KRED "threshold is wrong somehow\n");
+            return -1;
+        }
+        printf(" values in at least %" PRIu32 " of %zu bitmaps (%" PRIu64
+               " values) took %" PRIu64 " cycles, %" PRIu64
+               " cycles with and/or levels\n",
+               threshold, count, roaring_bitmap_get_cardinality(above),
+               threshold_cycles, cycles_final - cycles_start);
+        for (uint32_t j = 0; j < threshold; j++) {
+            roaring_bitmap_free(levels[j]);
+        }
+        free(levels);
+        roaring_bitmap_free(above);
+    }
+#if !ALLOCATION_COUNTER_ENABLED
+    printf(" (allocations are not counted on this platform)\n");
+#endif
     size_t total_count = 0;
     RDTSC_START(cycles_start);
     for (size_t i = 0; i < count; ++i) {
@@ -172,6 +291,82 @@ int main(int argc, char **argv) {
            " cycles\n",
            count, total_count, cycles_final - cycles_start);
 
+    // sizing then serializing, with and without a serialization layout
+    size_t total_bytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        total_bytes += roaring_bitmap_size_in_bytes(bitmaps[i]);
+    }
+    char *written = malloc(total_bytes);
+    // a first pass, so that neither variant pays for the cold caches
+    size_t written_bytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        written_bytes +=
+            roaring_bitmap_serialize(bitmaps[i], written + written_bytes);
+    }
+    RDTSC_START(cycles_start);
+    written_bytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        size_t size = roaring_bitmap_size_in_bytes(bitmaps[i]);
+        written_bytes +=
+            roaring_bitmap_serialize(bitmaps[i], written + written_bytes);
+        (void)size;
+    }
+    RDTSC_FINAL(cycles_final);
+    uint64_t two_calls = cycles_final - cycles_start;
+    RDTSC_START(cycles_start);
+    written_bytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        roaring_serialization_t s;
+        if (!roaring_serialization_init(bitmaps[i], &s)) return -1;
+        written_bytes +=
+            roaring_serialization_write(&s, written + written_bytes);
+        roaring_serialization_free(&s);
+    }
+    RDTSC_FINAL(cycles_final);
+    uint64_t with_layout = cycles_final - cycles_start;
+    printf("Sizing and serializing %zu bitmaps took %" PRIu64
+           " cycles (%" PRIu64 " cycles with a serialization layout)\n",
+           count, two_calls, with_layout);
+    free(written);
+
+    // portable format with and without packed bitset containers
+    size_t portable_bytes = 0;
+    size_t packed_bytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        portable_bytes += roaring_bitmap_portable_size_in_bytes(bitmaps[i]);
+        packed_bytes += roaring_bitmap_portable_packed_size_in_bytes(bitmaps[i]);
+    }
+    char *serialized = malloc(packed_bytes);
+    RDTSC_START(cycles_start);
+    size_t offset = 0;
+    for (size_t i = 0; i < count; ++i) {
+        offset += roaring_bitmap_portable_packed_serialize(bitmaps[i],
+                                                           serialized + offset);
+    }
+    RDTSC_FINAL(cycles_final);
+    printf("Packed serialization of %zu bitmaps took %" PRIu64
+           " cycles: %zu bytes instead of %zu bytes (%.1f%%)\n",
+           count, cycles_final - cycles_start, packed_bytes, portable_bytes,
+           100.0 * packed_bytes / portable_bytes);
+    RDTSC_START(cycles_start);
+    offset = 0;
+    for (size_t i = 0; i < count; ++i) {
+        size_t length = roaring_bitmap_portable_deserialize_size(
+            serialized + offset, packed_bytes - offset);
+        roaring_bitmap_t *r = roaring_bitmap_portable_deserialize_safe(
+            serialized + offset, length);
+        if (r == NULL || !roaring_bitmap_equals(r, bitmaps[i])) {
+            printf(KRED "packed serialization is wrong somehow\n");
+            return -1;
+        }
+        roaring_bitmap_free(r);
+        offset += length;
+    }
+    RDTSC_FINAL(cycles_final);
+    printf("Packed deserialization of %zu bitmaps took %" PRIu64 " cycles\n",
+           count, cycles_final - cycles_start);
+    free(serialized);
+
     for (int i = 0; i < (int)count; ++i) {
         free(numbers[i]);
         numbers[i] = NULL;  // paranoid
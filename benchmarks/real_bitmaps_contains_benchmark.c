@@ -2,6 +2,7 @@
 #include <roaring/roaring.h>
 #include "benchmark.h"
 #include "numbersfromtextfiles.h"
+#include "random.h"
 
 #define STARTBEST(numberoftests) \
    { \
@@ -124,6 +125,45 @@ int main(int argc, char **argv) {
     printf("Quartile queries on %zu bitmaps took %" PRIu64 " cycles\n", count,
                            cycles);
 
+    // random point queries, dominated by the search for the container
+    const int random_test_repetitions = 100;
+    const size_t number_of_queries = 1000;
+    uint32_t *queries = malloc(number_of_queries * sizeof(uint32_t));
+    for (size_t j = 0; j < number_of_queries; ++j) {
+        queries[j] = ranged_random(maxvalue + 1);
+    }
+    uint64_t randomcount;
+    STARTBEST(random_test_repetitions)
+    randomcount = 0;
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t j = 0; j < number_of_queries; ++j) {
+            randomcount += roaring_bitmap_contains(bitmaps[i], queries[j]);
+        }
+    }
+    ENDBEST(cycles)
+    printf("%zu random queries on %zu bitmaps took %.2f cycles per query\n",
+           number_of_queries, count,
+           (double)cycles / (number_of_queries * count));
+
+    // the same on a bitmap using all 65536 keys
+    roaring_bitmap_t *widebitmap = roaring_bitmap_create();
+    for (uint32_t key = 0; key < 65536; ++key) {
+        roaring_bitmap_add(widebitmap, (key << 16) | (key & 0xFF));
+    }
+    for (size_t j = 0; j < number_of_queries; ++j) {
+        queries[j] = pcg32_random();
+    }
+    STARTBEST(random_test_repetitions)
+    for (size_t j = 0; j < number_of_queries; ++j) {
+        randomcount += roaring_bitmap_contains(widebitmap, queries[j]);
+    }
+    ENDBEST(cycles)
+    printf("%zu random queries on a bitmap with 65536 containers took %.2f "
+           "cycles per query\n",
+           number_of_queries, (double)cycles / number_of_queries);
+    roaring_bitmap_free(widebitmap);
+    free(queries);
+
 
     for (int i = 0; i < (int)count; ++i) {
         free(numbers[i]);
@@ -135,5 +175,5 @@ int main(int argc, char **argv) {
     free(howmany);
     free(numbers);
 
-    return (int) quartcount;
+    return (int) (quartcount + randomcount);
 }
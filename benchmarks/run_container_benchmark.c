@@ -1,8 +1,13 @@
 #include <roaring/portability.h>
+#include <roaring/containers/containers.h>
 #include <roaring/containers/run.h>
 #include <roaring/misc/configreport.h>
+#include <roaring/roaring.h>
 #include "benchmark.h"
 #include "random.h"
+#ifndef _WIN32
+#include "numbersfromtextfiles.h"
+#endif
 
 enum { TESTSIZE = 2048 };
 
@@ -72,7 +77,119 @@ int intersection_test(run_container_t* B1, run_container_t* B2,
     return run_container_cardinality(BO);
 }
 
-int main() {
+int andnot_test(run_container_t* B1, run_container_t* B2,
+                run_container_t* BO) {
+    run_container_andnot(B1, B2, BO);
+    return run_container_cardinality(BO);
+}
+
+int contains_many_test(run_container_t* B, uint16_t* values, int32_t n,
+                       bool* answer) {
+    return run_container_contains_many(B, values, n, answer);
+}
+
+#ifndef _WIN32
+int realdata_union_test(run_container_t** L, run_container_t** R, size_t n,
+                        run_container_t* BO) {
+    int card = 0;
+    for (size_t i = 0; i < n; i++) card += union_test(L[i], R[i], BO);
+    return card;
+}
+
+int realdata_intersection_test(run_container_t** L, run_container_t** R,
+                               size_t n, run_container_t* BO) {
+    int card = 0;
+    for (size_t i = 0; i < n; i++) card += intersection_test(L[i], R[i], BO);
+    return card;
+}
+
+int realdata_andnot_test(run_container_t** L, run_container_t** R, size_t n,
+                         run_container_t* BO) {
+    int card = 0;
+    for (size_t i = 0; i < n; i++) card += andnot_test(L[i], R[i], BO);
+    return card;
+}
+
+/**
+ * Runs the run-run kernels over every pair of run containers sharing a key in
+ * consecutive bitmaps of a data set, e.g. benchmarks/realdata/census1881_srt.
+ * Times are expressed in cycles per input run.
+ */
+void realdata_test(const char* dirname, int repeat) {
+    size_t count;
+    size_t* howmany = NULL;
+    uint32_t** numbers =
+        read_all_integer_files(dirname, ".txt", &howmany, &count);
+    if (numbers == NULL) {
+        printf("I could not load any data file in directory %s.\n", dirname);
+        return;
+    }
+    roaring_bitmap_t** bitmaps = malloc(sizeof(roaring_bitmap_t*) * count);
+    for (size_t i = 0; i < count; i++) {
+        bitmaps[i] = roaring_bitmap_of_ptr(howmany[i], numbers[i]);
+        roaring_bitmap_run_optimize(bitmaps[i]);
+        free(numbers[i]);
+    }
+    free(numbers);
+    free(howmany);
+
+    size_t npairs = 0, maxpairs = 0;
+    run_container_t** L = NULL;
+    run_container_t** R = NULL;
+    int32_t inputsize = 0;
+    for (size_t i = 0; i + 1 < count; i++) {
+        const roaring_array_t* ra1 = &bitmaps[i]->high_low_container;
+        const roaring_array_t* ra2 = &bitmaps[i + 1]->high_low_container;
+        int32_t pos1 = 0, pos2 = 0;
+        while (pos1 < ra1->size && pos2 < ra2->size) {
+            if (ra1->keys[pos1] < ra2->keys[pos2]) {
+                pos1++;
+            } else if (ra1->keys[pos1] > ra2->keys[pos2]) {
+                pos2++;
+            } else {
+                if (ra1->typecodes[pos1] == RUN_CONTAINER_TYPE_CODE &&
+                    ra2->typecodes[pos2] == RUN_CONTAINER_TYPE_CODE) {
+                    if (npairs == maxpairs) {
+                        maxpairs = 2 * maxpairs + 16;
+                        L = realloc(L, maxpairs * sizeof(run_container_t*));
+                        R = realloc(R, maxpairs * sizeof(run_container_t*));
+                    }
+                    L[npairs] = (run_container_t*)ra1->containers[pos1];
+                    R[npairs] = (run_container_t*)ra2->containers[pos2];
+                    inputsize += L[npairs]->n_runs + R[npairs]->n_runs;
+                    npairs++;
+                }
+                pos1++;
+                pos2++;
+            }
+        }
+    }
+    printf("\n==real data: %s, %zu run-run pairs, %d input runs\n", dirname,
+           npairs, (int)inputsize);
+    if (npairs > 0) {
+        run_container_t* BO = run_container_create();
+        int answer = realdata_union_test(L, R, npairs, BO);
+        BEST_TIME(realdata_union_test(L, R, npairs, BO), answer, repeat,
+                  inputsize);
+        answer = realdata_intersection_test(L, R, npairs, BO);
+        BEST_TIME(realdata_intersection_test(L, R, npairs, BO), answer, repeat,
+                  inputsize);
+        answer = realdata_andnot_test(L, R, npairs, BO);
+        BEST_TIME(realdata_andnot_test(L, R, npairs, BO), answer, repeat,
+                  inputsize);
+        run_container_free(BO);
+    }
+    free(L);
+    free(R);
+    for (size_t i = 0; i < count; i++) roaring_bitmap_free(bitmaps[i]);
+    free(bitmaps);
+}
+#endif
+
+// Pass a data directory such as benchmarks/realdata/census1881_srt to also
+// time the run-run kernels on real data. Configure with
+// -DROARING_DISABLE_AVX=ON to compare against the scalar run skipping.
+int main(int argc, char** argv) {
     int repeat = 500;
     int size = TESTSIZE;
     tellmeall();
@@ -86,6 +203,21 @@ int main() {
     BEST_TIME(remove_test(B), 0, repeat, size);
     run_container_free(B);
 
+    B = run_container_create();
+    for (int x = 0; x < (1 << 16); x += 100) {
+        run_container_add_range(B, (uint32_t)x, (uint32_t)x + 9);
+    }
+    {
+        enum { NPROBES = 4096 };
+        uint16_t probes[NPROBES];
+        bool found[NPROBES];
+        for (int i = 0; i < NPROBES; i++) probes[i] = (uint16_t)(i * 16);
+        answer = contains_many_test(B, probes, NPROBES, found);
+        BEST_TIME(contains_many_test(B, probes, NPROBES, found), answer,
+                  repeat, NPROBES);
+    }
+    run_container_free(B);
+
     for (int howmany = 32; howmany <= (1 << 16); howmany *= 8) {
         run_container_t* Bt = run_container_create();
         for (int j = 0; j < howmany; ++j) {
@@ -140,6 +272,9 @@ int main() {
     answer = intersection_test(B1, B2, BO);
     printf("intersection cardinality = %d \n", answer);
     BEST_TIME(intersection_test(B1, B2, BO), answer, repeat, answer);
+    answer = andnot_test(B1, B2, BO);
+    printf("difference cardinality = %d \n", answer);
+    BEST_TIME(andnot_test(B1, B2, BO), answer, repeat, inputsize);
     printf("==intersection and union test 2 \n");
     run_container_clear(B1);
     run_container_clear(B2);
@@ -163,9 +298,18 @@ int main() {
     answer = intersection_test(B1, B2, BO);
     printf("intersection cardinality = %d \n", answer);
     BEST_TIME(intersection_test(B1, B2, BO), answer, repeat, answer);
+    answer = andnot_test(B1, B2, BO);
+    printf("difference cardinality = %d \n", answer);
+    BEST_TIME(andnot_test(B1, B2, BO), answer, repeat, inputsize);
 
     run_container_free(B1);
     run_container_free(B2);
     run_container_free(BO);
+#ifndef _WIN32
+    if (argc > 1) realdata_test(argv[1], repeat);
+#else
+    (void)argc;
+    (void)argv;
+#endif
     return 0;
 }
@@ -8,11 +8,15 @@ A C++ header for Roaring Bitmaps.
 
 #include <roaring/roaring.h>
 #include <algorithm>
+#include <functional>
+#include <memory>
 #include <new>
 #include <stdexcept>
 #include <string>
 
 class RoaringSetBitForwardIterator;
+class RoaringSetBitBulkIterator;
+class RoaringSetBitReverseIterator;
 
 class Roaring {
    public:
@@ -42,6 +46,8 @@ class Roaring {
         }
         roaring_bitmap_set_copy_on_write(&roaring,
             roaring_bitmap_get_copy_on_write(&r.roaring));
+        roaring_bitmap_set_auto_run(&roaring,
+            roaring_bitmap_get_auto_run(&r.roaring));
     }
 
     /**
@@ -168,6 +174,8 @@ class Roaring {
         }
         roaring_bitmap_set_copy_on_write(&roaring,
             roaring_bitmap_get_copy_on_write(&r.roaring));
+        roaring_bitmap_set_auto_run(&roaring,
+            roaring_bitmap_get_auto_run(&r.roaring));
         return *this;
     }
 
@@ -275,6 +283,16 @@ class Roaring {
         roaring_bitmap_range_uint32_array(&roaring, offset, limit, ans);
     }
 
+    /**
+     * to int array with pagination, in decreasing order starting from the
+     * maximum
+     */
+    void rangeUint32ArrayDescending(uint32_t *ans, size_t offset,
+                                    size_t limit) const {
+        roaring_bitmap_range_uint32_array_descending(&roaring, offset, limit,
+                                                     ans);
+    }
+
     /**
      * Return true if the two bitmaps contain the same elements.
      */
@@ -532,6 +550,60 @@ class Roaring {
         return Roaring(r);
     }
 
+    /**
+     * Overloads taking a temporary (rvalue) operand compute the result in
+     * place within that temporary and hand it back, instead of allocating
+     * a new bitmap. Chained expressions such as (a & b) | (c & d) - e thus
+     * only allocate one bitmap per non-temporary pair of operands.
+     */
+    friend Roaring operator&(Roaring &&a, const Roaring &b) {
+        a &= b;
+        return std::move(a);
+    }
+    friend Roaring operator&(const Roaring &a, Roaring &&b) {
+        b &= a;
+        return std::move(b);
+    }
+    friend Roaring operator&(Roaring &&a, Roaring &&b) {
+        a &= b;
+        return std::move(a);
+    }
+
+    friend Roaring operator-(Roaring &&a, const Roaring &b) {
+        a -= b;
+        return std::move(a);
+    }
+    friend Roaring operator-(Roaring &&a, Roaring &&b) {
+        a -= b;
+        return std::move(a);
+    }
+
+    friend Roaring operator|(Roaring &&a, const Roaring &b) {
+        a |= b;
+        return std::move(a);
+    }
+    friend Roaring operator|(const Roaring &a, Roaring &&b) {
+        b |= a;
+        return std::move(b);
+    }
+    friend Roaring operator|(Roaring &&a, Roaring &&b) {
+        a |= b;
+        return std::move(a);
+    }
+
+    friend Roaring operator^(Roaring &&a, const Roaring &b) {
+        a ^= b;
+        return std::move(a);
+    }
+    friend Roaring operator^(const Roaring &a, Roaring &&b) {
+        b ^= a;
+        return std::move(b);
+    }
+    friend Roaring operator^(Roaring &&a, Roaring &&b) {
+        a ^= b;
+        return std::move(a);
+    }
+
     /**
      * Whether or not we apply copy and write.
      */
@@ -576,6 +648,14 @@ class Roaring {
         return roaring_bitmap_get_copy_on_write(&roaring);
     }
 
+    /**
+     * Whether set operations writing to this bitmap emit run containers
+     * directly when they are smaller (see roaring_bitmap_set_auto_run).
+     */
+    void setAutoRun(bool val) { roaring_bitmap_set_auto_run(&roaring, val); }
+
+    bool getAutoRun() const { return roaring_bitmap_get_auto_run(&roaring); }
+
     /**
      * computes the logical or (union) between "n" bitmaps (referenced by a
      * pointer).
@@ -620,6 +700,33 @@ class Roaring {
     */
     const_iterator &end() const;
 
+    typedef RoaringSetBitBulkIterator const_bulk_iterator;
+
+    /**
+    * Returns an iterator that decodes the set bits in blocks, so that
+    * advancing it is usually a plain buffer increment. Prefer it over
+    * begin() for long scans and for leapfrogging with skipTo.
+    */
+    const_bulk_iterator bulk_begin() const;
+
+    /**
+    * A bogus iterator that can be used together with bulk_begin().
+    */
+    const_bulk_iterator &bulk_end() const;
+
+    typedef RoaringSetBitReverseIterator const_reverse_iterator;
+
+    /**
+    * Returns an iterator that visits the set bits in decreasing order,
+    * starting from the maximum.
+    */
+    const_reverse_iterator rbegin() const;
+
+    /**
+    * A bogus iterator that can be used together with rbegin().
+    */
+    const_reverse_iterator &rend() const;
+
     roaring_bitmap_t roaring;
 };
 
@@ -716,6 +823,663 @@ class RoaringSetBitForwardIterator final {
     roaring_uint32_iterator_t i;
 };
 
+/**
+ * Forward iterator over the set bits which decodes values in blocks through
+ * roaring_read_uint32_iterator, so that the per-value cost is a buffer read.
+ * The block lives on the heap and is shared by copies of the iterator until
+ * one of them refills it, so copying (e.g., i++) does not copy the values.
+ */
+class RoaringSetBitBulkIterator final {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef uint32_t *pointer;
+    typedef uint32_t &reference_type;
+    typedef uint32_t value_type;
+    typedef int32_t difference_type;
+    typedef RoaringSetBitBulkIterator type_of_iterator;
+
+    enum { BUFFER_SIZE = 256 };
+
+    /**
+     * Provides the location of the set bit.
+     */
+    value_type operator*() const { return buffer->values[pos]; }
+
+    /**
+     * Whether the iterator points to a value (i.e., is not exhausted).
+     */
+    bool has_value() const { return pos < len; }
+
+    /**
+     * Move the iterator to the first value >= val. The iterator never moves
+     * backward: if it already points to a value >= val, it is unchanged.
+     * Returns false if there is no such value.
+     */
+    bool skipTo(uint32_t val) {
+        if (pos >= len) return false;
+        const uint32_t *values = buffer->values;
+        if (values[pos] >= val) return true;
+        if (values[len - 1] >= val) {
+            pos = (uint32_t)(std::lower_bound(values + pos, values + len, val) -
+                             values);
+            return true;
+        }
+        roaring_move_uint32_iterator_equalorlarger(&i, val);
+        refill();
+        return pos < len;
+    }
+
+    type_of_iterator &operator++() {  // ++i, must returned inc. value
+        if (++pos == len) refill();
+        return *this;
+    }
+
+    type_of_iterator operator++(int) {  // i++, must return orig. value
+        RoaringSetBitBulkIterator orig(*this);
+        ++*this;
+        return orig;
+    }
+
+    bool operator==(const RoaringSetBitBulkIterator &o) const {
+        if (!has_value() || !o.has_value())
+            return has_value() == o.has_value();
+        return **this == *o;
+    }
+
+    bool operator!=(const RoaringSetBitBulkIterator &o) const {
+        return !(*this == o);
+    }
+
+    RoaringSetBitBulkIterator(const Roaring &parent, bool exhausted = false)
+        : pos(0), len(0) {
+        i.parent = &parent.roaring;
+        i.has_value = false;
+        if (!exhausted) {
+            roaring_init_iterator(&parent.roaring, &i);
+            refill();
+        }
+    }
+
+   private:
+    struct Buffer {
+        uint32_t values[BUFFER_SIZE];
+    };
+
+    void refill() {
+        pos = 0;
+        len = 0;
+        if (!i.has_value) return;  // exhausted: no need for a buffer
+        // copies still reading the current block keep it
+        if (!buffer || buffer.use_count() > 1)
+            buffer = std::make_shared<Buffer>();
+        len = roaring_read_uint32_iterator(&i, buffer->values, BUFFER_SIZE);
+    }
+
+    roaring_uint32_iterator_t i;  // positioned after the buffered values
+    std::shared_ptr<Buffer> buffer;
+    uint32_t pos;
+    uint32_t len;
+};
+
+/**
+ * Iterator visiting the set bits in decreasing order. Like
+ * RoaringSetBitBulkIterator, it decodes values in shared heap blocks, through
+ * roaring_read_previous_uint32_iterator.
+ */
+class RoaringSetBitReverseIterator final {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef uint32_t *pointer;
+    typedef uint32_t &reference_type;
+    typedef uint32_t value_type;
+    typedef int32_t difference_type;
+    typedef RoaringSetBitReverseIterator type_of_iterator;
+
+    enum { BUFFER_SIZE = 256 };
+
+    /**
+     * Provides the location of the set bit.
+     */
+    value_type operator*() const { return buffer->values[pos]; }
+
+    /**
+     * Whether the iterator points to a value (i.e., is not exhausted).
+     */
+    bool has_value() const { return pos < len; }
+
+    /**
+     * Move the iterator to the last value <= val. The iterator never moves
+     * forward: if it already points to a value <= val, it is unchanged.
+     * Returns false if there is no such value.
+     */
+    bool skipTo(uint32_t val) {
+        if (pos >= len) return false;
+        const uint32_t *values = buffer->values;
+        if (values[pos] <= val) return true;
+        if (values[len - 1] <= val) {
+            pos = (uint32_t)(std::lower_bound(values + pos, values + len, val,
+                                              std::greater<uint32_t>()) -
+                             values);
+            return true;
+        }
+        if (!roaring_move_uint32_iterator_equalorlarger(&i, val)) {
+            roaring_init_iterator_last(i.parent, &i);
+        } else if (i.current_value > val) {
+            roaring_previous_uint32_iterator(&i);
+        }
+        refill();
+        return pos < len;
+    }
+
+    type_of_iterator &operator++() {  // ++i, must returned inc. value
+        if (++pos == len) refill();
+        return *this;
+    }
+
+    type_of_iterator operator++(int) {  // i++, must return orig. value
+        RoaringSetBitReverseIterator orig(*this);
+        ++*this;
+        return orig;
+    }
+
+    bool operator==(const RoaringSetBitReverseIterator &o) const {
+        if (!has_value() || !o.has_value())
+            return has_value() == o.has_value();
+        return **this == *o;
+    }
+
+    bool operator!=(const RoaringSetBitReverseIterator &o) const {
+        return !(*this == o);
+    }
+
+    RoaringSetBitReverseIterator(const Roaring &parent,
+                                 bool exhausted = false)
+        : pos(0), len(0) {
+        i.parent = &parent.roaring;
+        i.has_value = false;
+        if (!exhausted) {
+            roaring_init_iterator_last(&parent.roaring, &i);
+            refill();
+        }
+    }
+
+   private:
+    struct Buffer {
+        uint32_t values[BUFFER_SIZE];
+    };
+
+    void refill() {
+        pos = 0;
+        len = 0;
+        if (!i.has_value) return;  // exhausted: no need for a buffer
+        // copies still reading the current block keep it
+        if (!buffer || buffer.use_count() > 1)
+            buffer = std::make_shared<Buffer>();
+        len = roaring_read_previous_uint32_iterator(&i, buffer->values,
+                                                    BUFFER_SIZE);
+    }
+
+    roaring_uint32_iterator_t i;  // positioned after the buffered values
+    std::shared_ptr<Buffer> buffer;
+    uint32_t pos;
+    uint32_t len;
+};
+
+/**
+ * Enumerates the intersection of several bitmaps lazily, without allocating
+ * the result: see roaring_create_intersection_iterator. The inputs must
+ * outlive the iterator and must not be modified while it is in use.
+ */
+class RoaringIntersectionIterator final {
+   public:
+    RoaringIntersectionIterator(size_t n, const Roaring **inputs) {
+        const roaring_bitmap_t **x =
+            (const roaring_bitmap_t **)malloc(n * sizeof(roaring_bitmap_t *));
+        if (x == NULL && n > 0) {
+            throw std::runtime_error("failed memory alloc in iterator");
+        }
+        for (size_t k = 0; k < n; ++k) x[k] = &inputs[k]->roaring;
+        i = roaring_create_intersection_iterator(n, x);
+        free(x);
+        if (i == NULL) {
+            throw std::runtime_error("failed memory alloc in iterator");
+        }
+    }
+
+    RoaringIntersectionIterator(RoaringIntersectionIterator &&o) noexcept
+        : i(o.i) {
+        o.i = NULL;
+    }
+
+    RoaringIntersectionIterator(const RoaringIntersectionIterator &) = delete;
+    RoaringIntersectionIterator &operator=(
+        const RoaringIntersectionIterator &) = delete;
+
+    ~RoaringIntersectionIterator() { roaring_free_intersection_iterator(i); }
+
+    /**
+     * Provides the current value of the intersection.
+     */
+    uint32_t operator*() const { return i->current_value; }
+
+    /**
+     * Whether the iterator points to a value (i.e., is not exhausted).
+     */
+    bool has_value() const { return i->has_value; }
+
+    RoaringIntersectionIterator &operator++() {
+        roaring_advance_intersection_iterator(i);
+        return *this;
+    }
+
+    /**
+     * Move the iterator to the first value >= val, never backward.
+     * Returns false if there is no such value.
+     */
+    bool skipTo(uint32_t val) {
+        return roaring_move_intersection_iterator_equalorlarger(i, val);
+    }
+
+    /**
+     * Write up to count values to buf, returns how many were written.
+     */
+    uint32_t read(uint32_t *buf, uint32_t count) {
+        return roaring_read_intersection_iterator(i, buf, count);
+    }
+
+   private:
+    roaring_intersection_iterator_t *i;
+};
+
+/**
+ * Enumerates the union of several bitmaps, or the values of the first that
+ * are absent from the others, lazily and with bounded memory: see
+ * roaring_create_union_iterator and roaring_create_andnot_iterator. The
+ * inputs must outlive the iterator and must not be modified while it is in
+ * use.
+ */
+class RoaringMergeIterator final {
+   public:
+    /**
+     * Iterates over the union of the n inputs.
+     */
+    static RoaringMergeIterator unionOf(size_t n, const Roaring **inputs) {
+        return RoaringMergeIterator(n, inputs, false);
+    }
+
+    /**
+     * Iterates over inputs[0] minus the union of the remaining inputs.
+     */
+    static RoaringMergeIterator andnotOf(size_t n, const Roaring **inputs) {
+        return RoaringMergeIterator(n, inputs, true);
+    }
+
+    RoaringMergeIterator(RoaringMergeIterator &&o) noexcept : i(o.i) {
+        o.i = NULL;
+    }
+
+    RoaringMergeIterator(const RoaringMergeIterator &) = delete;
+    RoaringMergeIterator &operator=(const RoaringMergeIterator &) = delete;
+
+    ~RoaringMergeIterator() { roaring_free_merge_iterator(i); }
+
+    /**
+     * Provides the current value.
+     */
+    uint32_t operator*() const { return i->current_value; }
+
+    /**
+     * Whether the iterator points to a value (i.e., is not exhausted).
+     */
+    bool has_value() const { return i->has_value; }
+
+    RoaringMergeIterator &operator++() {
+        roaring_advance_merge_iterator(i);
+        return *this;
+    }
+
+    /**
+     * Move the iterator to the first value >= val, never backward.
+     * Returns false if there is no such value.
+     */
+    bool skipTo(uint32_t val) {
+        return roaring_move_merge_iterator_equalorlarger(i, val);
+    }
+
+    /**
+     * Write up to count values to buf, returns how many were written.
+     */
+    uint32_t read(uint32_t *buf, uint32_t count) {
+        return roaring_read_merge_iterator(i, buf, count);
+    }
+
+   private:
+    RoaringMergeIterator(size_t n, const Roaring **inputs, bool andnot) {
+        const roaring_bitmap_t **x =
+            (const roaring_bitmap_t **)malloc(n * sizeof(roaring_bitmap_t *));
+        if (x == NULL && n > 0) {
+            throw std::runtime_error("failed memory alloc in iterator");
+        }
+        for (size_t k = 0; k < n; ++k) x[k] = &inputs[k]->roaring;
+        i = andnot ? roaring_create_andnot_iterator(n, x)
+                   : roaring_create_union_iterator(n, x);
+        free(x);
+        if (i == NULL) {
+            throw std::runtime_error("failed memory alloc in iterator");
+        }
+    }
+
+    roaring_merge_iterator_t *i;
+};
+
+/**
+ * Expression templates over bitmaps. Wrapping a bitmap in RoaringExpr makes
+ * &, |, ^ and - build a tree of operations instead of bitmaps. Converting
+ * the tree to a Roaring evaluates the whole expression key by key: only the
+ * keys that may be in the result are visited, and the containers of the
+ * operands are combined directly, without any intermediate bitmap.
+ *
+ *     Roaring r = ((RoaringExpr(a) & b) | (RoaringExpr(c) & d)) - e;
+ *
+ * The operands are referenced, not copied: they must outlive the expression
+ * (beware of auto) and must not be modified before it is evaluated.
+ */
+template <class Derived>
+class RoaringExprBase {
+   public:
+    const Derived &derived() const {
+        return static_cast<const Derived &>(*this);
+    }
+
+    /**
+     * Computes the bitmap of the expression.
+     */
+    Roaring evaluate() const;
+
+    operator Roaring() const { return evaluate(); }
+};
+
+/**
+ * A bitmap as the operand of an expression.
+ */
+class RoaringExpr final : public RoaringExprBase<RoaringExpr> {
+   public:
+    // past the last key, when there is none left
+    static const uint32_t END = UINT32_C(0x10000);
+
+    explicit RoaringExpr(const Roaring &r)
+        : ra(&r.roaring.high_low_container), pos(0) {}
+
+    /**
+     * The smallest key at least key that may hold values, or END. The keys
+     * passed to nextKey and container must never decrease.
+     */
+    uint32_t nextKey(uint32_t key) {
+        if (key >= END) return END;
+        pos = ra_advance_until(ra, (uint16_t)key, pos - 1);
+        return pos < ra->size ? ra->keys[pos] : END;
+    }
+
+    /**
+     * The container at key, or NULL if it is empty. If owned is set, the
+     * caller must free it.
+     */
+    const void *container(uint16_t key, uint8_t *typecode, bool *owned) {
+        *owned = false;
+        if (nextKey(key) != key) return NULL;
+        *typecode = ra->typecodes[pos];
+        return container_unwrap_shared(ra->containers[pos], typecode);
+    }
+
+   private:
+    const roaring_array_t *ra;
+    int32_t pos;
+};
+
+/**
+ * An operation between two expressions, see RoaringExprAnd and its siblings.
+ */
+template <class Op, class L, class R>
+class RoaringExprNode final
+    : public RoaringExprBase<RoaringExprNode<Op, L, R>> {
+   public:
+    RoaringExprNode(const L &l, const R &r) : left(l), right(r) {}
+
+    uint32_t nextKey(uint32_t key) { return Op::nextKey(left, right, key); }
+
+    const void *container(uint16_t key, uint8_t *typecode, bool *owned) {
+        return Op::container(left, right, key, typecode, owned);
+    }
+
+   private:
+    L left;
+    R right;
+};
+
+namespace roaring_expr_internal {
+inline void release(const void *c, uint8_t typecode, bool owned) {
+    if (owned) container_free(const_cast<void *>(c), typecode);
+}
+
+// takes the result of a container operation, which may be empty
+inline const void *result(void *c, uint8_t typecode, bool *owned) {
+    if (c == NULL) {
+        throw std::runtime_error("failed materalization in expression");
+    }
+    if (!container_nonzero_cardinality(c, typecode)) {
+        container_free(c, typecode);
+        return NULL;
+    }
+    *owned = true;
+    return c;
+}
+}  // namespace roaring_expr_internal
+
+struct RoaringExprAnd {
+    template <class L, class R>
+    static uint32_t nextKey(L &left, R &right, uint32_t key) {
+        uint32_t k = left.nextKey(key);
+        while (k < RoaringExpr::END) {
+            const uint32_t other = right.nextKey(k);
+            if (other == k) return k;
+            k = left.nextKey(other);
+        }
+        return RoaringExpr::END;
+    }
+
+    template <class L, class R>
+    static const void *container(L &left, R &right, uint16_t key,
+                                 uint8_t *typecode, bool *owned) {
+        uint8_t lt, rt;
+        bool lo, ro;
+        const void *l = left.container(key, &lt, &lo);
+        if (l == NULL) return NULL;
+        const void *r = right.container(key, &rt, &ro);
+        if (r == NULL) {
+            roaring_expr_internal::release(l, lt, lo);
+            return NULL;
+        }
+        void *c = container_and(l, lt, r, rt, typecode);
+        roaring_expr_internal::release(l, lt, lo);
+        roaring_expr_internal::release(r, rt, ro);
+        return roaring_expr_internal::result(c, *typecode, owned);
+    }
+};
+
+struct RoaringExprOr {
+    template <class L, class R>
+    static uint32_t nextKey(L &left, R &right, uint32_t key) {
+        return std::min(left.nextKey(key), right.nextKey(key));
+    }
+
+    template <class L, class R>
+    static const void *container(L &left, R &right, uint16_t key,
+                                 uint8_t *typecode, bool *owned) {
+        uint8_t lt, rt;
+        bool lo, ro;
+        const void *l = left.container(key, &lt, &lo);
+        const void *r = right.container(key, &rt, &ro);
+        if (r == NULL) {
+            if (l != NULL) {
+                *typecode = lt;
+                *owned = lo;
+            }
+            return l;
+        }
+        if (l == NULL) {
+            *typecode = rt;
+            *owned = ro;
+            return r;
+        }
+        void *c = container_or(l, lt, r, rt, typecode);
+        roaring_expr_internal::release(l, lt, lo);
+        roaring_expr_internal::release(r, rt, ro);
+        return roaring_expr_internal::result(c, *typecode, owned);
+    }
+};
+
+struct RoaringExprXor {
+    template <class L, class R>
+    static uint32_t nextKey(L &left, R &right, uint32_t key) {
+        return std::min(left.nextKey(key), right.nextKey(key));
+    }
+
+    template <class L, class R>
+    static const void *container(L &left, R &right, uint16_t key,
+                                 uint8_t *typecode, bool *owned) {
+        uint8_t lt, rt;
+        bool lo, ro;
+        const void *l = left.container(key, &lt, &lo);
+        const void *r = right.container(key, &rt, &ro);
+        if (r == NULL) {
+            if (l != NULL) {
+                *typecode = lt;
+                *owned = lo;
+            }
+            return l;
+        }
+        if (l == NULL) {
+            *typecode = rt;
+            *owned = ro;
+            return r;
+        }
+        void *c = container_xor(l, lt, r, rt, typecode);
+        roaring_expr_internal::release(l, lt, lo);
+        roaring_expr_internal::release(r, rt, ro);
+        return roaring_expr_internal::result(c, *typecode, owned);
+    }
+};
+
+struct RoaringExprAndNot {
+    template <class L, class R>
+    static uint32_t nextKey(L &left, R &, uint32_t key) {
+        return left.nextKey(key);
+    }
+
+    template <class L, class R>
+    static const void *container(L &left, R &right, uint16_t key,
+                                 uint8_t *typecode, bool *owned) {
+        uint8_t lt, rt;
+        bool lo, ro;
+        const void *l = left.container(key, &lt, &lo);
+        if (l == NULL) return NULL;
+        const void *r = right.container(key, &rt, &ro);
+        if (r == NULL) {
+            *typecode = lt;
+            *owned = lo;
+            return l;
+        }
+        void *c = container_andnot(l, lt, r, rt, typecode);
+        roaring_expr_internal::release(l, lt, lo);
+        roaring_expr_internal::release(r, rt, ro);
+        return roaring_expr_internal::result(c, *typecode, owned);
+    }
+};
+
+template <class Derived>
+Roaring RoaringExprBase<Derived>::evaluate() const {
+    Derived e(derived());  // the cursors of the operands move
+    Roaring ans;
+    roaring_array_t *ra = &ans.roaring.high_low_container;
+    for (uint32_t key = e.nextKey(0); key < RoaringExpr::END;
+         key = e.nextKey(key + 1)) {
+        uint8_t typecode;
+        bool owned;
+        const void *c = e.container((uint16_t)key, &typecode, &owned);
+        if (c == NULL) continue;
+        void *out = owned ? const_cast<void *>(c) : container_clone(c, typecode);
+        if (out == NULL) {
+            throw std::runtime_error("failed materalization in expression");
+        }
+        ra_append(ra, (uint16_t)key, out, typecode);
+    }
+    return ans;
+}
+
+template <class L, class R>
+RoaringExprNode<RoaringExprAnd, L, R> operator&(const RoaringExprBase<L> &l,
+                                                const RoaringExprBase<R> &r) {
+    return RoaringExprNode<RoaringExprAnd, L, R>(l.derived(), r.derived());
+}
+template <class L>
+RoaringExprNode<RoaringExprAnd, L, RoaringExpr> operator&(
+    const RoaringExprBase<L> &l, const Roaring &r) {
+    return l & RoaringExpr(r);
+}
+template <class R>
+RoaringExprNode<RoaringExprAnd, RoaringExpr, R> operator&(
+    const Roaring &l, const RoaringExprBase<R> &r) {
+    return RoaringExpr(l) & r;
+}
+
+template <class L, class R>
+RoaringExprNode<RoaringExprOr, L, R> operator|(const RoaringExprBase<L> &l,
+                                               const RoaringExprBase<R> &r) {
+    return RoaringExprNode<RoaringExprOr, L, R>(l.derived(), r.derived());
+}
+template <class L>
+RoaringExprNode<RoaringExprOr, L, RoaringExpr> operator|(
+    const RoaringExprBase<L> &l, const Roaring &r) {
+    return l | RoaringExpr(r);
+}
+template <class R>
+RoaringExprNode<RoaringExprOr, RoaringExpr, R> operator|(
+    const Roaring &l, const RoaringExprBase<R> &r) {
+    return RoaringExpr(l) | r;
+}
+
+template <class L, class R>
+RoaringExprNode<RoaringExprXor, L, R> operator^(const RoaringExprBase<L> &l,
+                                                const RoaringExprBase<R> &r) {
+    return RoaringExprNode<RoaringExprXor, L, R>(l.derived(), r.derived());
+}
+template <class L>
+RoaringExprNode<RoaringExprXor, L, RoaringExpr> operator^(
+    const RoaringExprBase<L> &l, const Roaring &r) {
+    return l ^ RoaringExpr(r);
+}
+template <class R>
+RoaringExprNode<RoaringExprXor, RoaringExpr, R> operator^(
+    const Roaring &l, const RoaringExprBase<R> &r) {
+    return RoaringExpr(l) ^ r;
+}
+
+template <class L, class R>
+RoaringExprNode<RoaringExprAndNot, L, R> operator-(
+    const RoaringExprBase<L> &l, const RoaringExprBase<R> &r) {
+    return RoaringExprNode<RoaringExprAndNot, L, R>(l.derived(), r.derived());
+}
+template <class L>
+RoaringExprNode<RoaringExprAndNot, L, RoaringExpr> operator-(
+    const RoaringExprBase<L> &l, const Roaring &r) {
+    return l - RoaringExpr(r);
+}
+template <class R>
+RoaringExprNode<RoaringExprAndNot, RoaringExpr, R> operator-(
+    const Roaring &l, const RoaringExprBase<R> &r) {
+    return RoaringExpr(l) - r;
+}
+
 inline RoaringSetBitForwardIterator Roaring::begin() const {
     return RoaringSetBitForwardIterator(*this);
 }
@@ -725,4 +1489,22 @@ inline RoaringSetBitForwardIterator &Roaring::end() const {
     return e;
 }
 
+inline RoaringSetBitBulkIterator Roaring::bulk_begin() const {
+    return RoaringSetBitBulkIterator(*this);
+}
+
+inline RoaringSetBitBulkIterator &Roaring::bulk_end() const {
+    static RoaringSetBitBulkIterator e(*this, true);
+    return e;
+}
+
+inline RoaringSetBitReverseIterator Roaring::rbegin() const {
+    return RoaringSetBitReverseIterator(*this);
+}
+
+inline RoaringSetBitReverseIterator &Roaring::rend() const {
+    static RoaringSetBitReverseIterator e(*this, true);
+    return e;
+}
+
 #endif /* INCLUDE_ROARING_HH_ */
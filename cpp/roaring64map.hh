@@ -683,6 +683,58 @@ class Roaring64Map {
         return Roaring64Map(*this) ^= o;
     }
 
+    /**
+     * Overloads taking a temporary (rvalue) operand reuse it for the result
+     * rather than copying, see the corresponding overloads in Roaring.
+     */
+    friend Roaring64Map operator&(Roaring64Map &&a, const Roaring64Map &b) {
+        a &= b;
+        return std::move(a);
+    }
+    friend Roaring64Map operator&(const Roaring64Map &a, Roaring64Map &&b) {
+        b &= a;
+        return std::move(b);
+    }
+    friend Roaring64Map operator&(Roaring64Map &&a, Roaring64Map &&b) {
+        a &= b;
+        return std::move(a);
+    }
+
+    friend Roaring64Map operator-(Roaring64Map &&a, const Roaring64Map &b) {
+        a -= b;
+        return std::move(a);
+    }
+    friend Roaring64Map operator-(Roaring64Map &&a, Roaring64Map &&b) {
+        a -= b;
+        return std::move(a);
+    }
+
+    friend Roaring64Map operator|(Roaring64Map &&a, const Roaring64Map &b) {
+        a |= b;
+        return std::move(a);
+    }
+    friend Roaring64Map operator|(const Roaring64Map &a, Roaring64Map &&b) {
+        b |= a;
+        return std::move(b);
+    }
+    friend Roaring64Map operator|(Roaring64Map &&a, Roaring64Map &&b) {
+        a |= b;
+        return std::move(a);
+    }
+
+    friend Roaring64Map operator^(Roaring64Map &&a, const Roaring64Map &b) {
+        a ^= b;
+        return std::move(a);
+    }
+    friend Roaring64Map operator^(const Roaring64Map &a, Roaring64Map &&b) {
+        b ^= a;
+        return std::move(b);
+    }
+    friend Roaring64Map operator^(Roaring64Map &&a, Roaring64Map &&b) {
+        a ^= b;
+        return std::move(a);
+    }
+
     /**
      * Whether or not we apply copy and write.
      */
@@ -32,6 +32,53 @@ inline int32_t binarySearch(const uint16_t *array, int32_t lenarray,
     return -(low + 1);
 }
 
+/**
+ * Same result as binarySearch, for arrays of unique values. The range is
+ * halved without branches (so without mispredictions) until it fits in a
+ * few values, which are then compared to ikey with SIMD instructions: the
+ * insertion point is the number of values smaller than ikey. As the values are
+ * sorted, the lanes holding smaller values form a prefix.
+ */
+inline int32_t branchlessBinarySearch(const uint16_t *array,
+                                      int32_t lenarray, uint16_t ikey) {
+    const uint16_t *base = array;
+    int32_t n = lenarray;
+    // the insertion point remains in [base, base + n]
+    while (n > 16) {
+        const int32_t half = n >> 1;
+        base = (base[half] < ikey) ? base + half : base;
+        n -= half;
+    }
+    int32_t i = 0;
+    int32_t below = 0;
+#ifdef IS_X64
+    // SSE2 only has signed comparisons, flipping the sign bits fixes the order
+    const __m128i flip = _mm_set1_epi16(INT16_MIN);
+    const __m128i target = _mm_xor_si128(_mm_set1_epi16((int16_t)ikey), flip);
+    for (; i + 8 <= n; i += 8) {
+        const __m128i values = _mm_xor_si128(
+            _mm_loadu_si128((const __m128i *)(base + i)), flip);
+        const uint32_t mask =
+            (uint32_t)_mm_movemask_epi8(_mm_cmplt_epi16(values, target));
+        below += __builtin_ctzll(~(uint64_t)mask) >> 1;
+    }
+    if ((i < n) && (n >= 8)) {
+        // the last 8 values overlap those already counted, we mask them out
+        const __m128i values = _mm_xor_si128(
+            _mm_loadu_si128((const __m128i *)(base + n - 8)), flip);
+        const uint32_t mask = (uint32_t)_mm_movemask_epi8(
+                                  _mm_cmplt_epi16(values, target)) >>
+                              (2 * (8 - (n - i)));
+        below += __builtin_ctzll(~(uint64_t)mask) >> 1;
+        i = n;
+    }
+#endif
+    for (; i < n; ++i) below += (base[i] < ikey);
+    const int32_t pos = (int32_t)(base - array) + below;
+    if ((pos < lenarray) && (array[pos] == ikey)) return pos;
+    return -(pos + 1);
+}
+
 /**
  * Galloping search
  * Assumes that array is sorted, has logarithmic complexity.
@@ -146,6 +193,31 @@ int32_t intersect_skewed_uint16_cardinality(const uint16_t *smallarray,
 /* Check whether the size of the intersection between one small and one large set of uint16_t is non-zero. */
 bool intersect_skewed_uint16_nonempty(const uint16_t *smallarray, size_t size_s,
                                 const uint16_t *largearray, size_t size_l);
+
+/* Computes the union between one small and one large set of uint16_t by
+ * galloping through the large set and copying it in blocks. Stores the result
+ * into buffer and returns the number of elements. One input may also live in
+ * buffer, shifted by the size of the other input. */
+int32_t union_skewed_uint16(const uint16_t *smallarray, size_t size_s,
+                            const uint16_t *largearray, size_t size_l,
+                            uint16_t *buffer);
+
+/* Like union_skewed_uint16, for the symmetric difference. */
+int32_t xor_skewed_uint16(const uint16_t *smallarray, size_t size_s,
+                          const uint16_t *largearray, size_t size_l,
+                          uint16_t *buffer);
+
+/* Computes set_1 - set_2 when one of the two sets is much smaller than the
+ * other. buffer may be set_1. Returns the number of elements. */
+int32_t difference_skewed_uint16(const uint16_t *set_1, size_t size_1,
+                                 const uint16_t *set_2, size_t size_2,
+                                 uint16_t *buffer);
+
+/* Merges a small set of uint16_t into a large one in place; largearray must
+ * have room for size_l + size_s values. Only the values of the large set that
+ * are greater than the smallest new value are moved. Returns the new size. */
+int32_t union_skewed_uint16_inplace(uint16_t *largearray, size_t size_l,
+                                    const uint16_t *smallarray, size_t size_s);
 /**
  * Generic intersection function.
  */
@@ -162,6 +234,18 @@ int32_t intersect_uint16_cardinality(const uint16_t *A, const size_t lenA,
  */
 bool intersect_uint16_nonempty(const uint16_t *A, const size_t lenA,
                          const uint16_t *B, const size_t lenB);
+/*
+ * The uint16_t unions and xors (union_uint16, xor_uint16, union_vector16,
+ * xor_vector16, and the skewed ones above) may write into the buffer holding
+ * one of their inputs, if that input starts further up by at least the size
+ * of the other input: the in-place unions and xors shift the first container
+ * that way. The invariant is that writes never pass the unread part of the
+ * shifted input. Having read i of its values and j of the other input's, a
+ * merge has written at most i + j values, and the SIMD kernels store 8 values
+ * at a time, all below the last 8 values they loaded. This is why their
+ * pointers are not __restrict__ and their tails are copied with memmove.
+ */
+
 /**
  * Generic union function.
  */
@@ -201,15 +285,15 @@ size_t union_uint32(const uint32_t *set_1, size_t size_1, const uint32_t *set_2,
 /**
  * A fast SSE-based union function.
  */
-uint32_t union_vector16(const uint16_t *__restrict__ set_1, uint32_t size_1,
-                        const uint16_t *__restrict__ set_2, uint32_t size_2,
-                        uint16_t *__restrict__ buffer);
+uint32_t union_vector16(const uint16_t *set_1, uint32_t size_1,
+                        const uint16_t *set_2, uint32_t size_2,
+                        uint16_t *buffer);
 /**
  * A fast SSE-based XOR function.
  */
-uint32_t xor_vector16(const uint16_t *__restrict__ array1, uint32_t length1,
-                      const uint16_t *__restrict__ array2, uint32_t length2,
-                      uint16_t *__restrict__ output);
+uint32_t xor_vector16(const uint16_t *array1, uint32_t length1,
+                      const uint16_t *array2, uint32_t length2,
+                      uint16_t *output);
 
 /**
  * A fast SSE-based difference function.
@@ -194,6 +194,25 @@ int32_t array_container_write(const array_container_t *container, char *buf);
 int32_t array_container_read(int32_t cardinality, array_container_t *container,
                              const char *buf);
 
+/* Number of bytes needed to write the array as a packed container (see
+ * packed.h), or limit if that is not less than limit, in which case the
+ * array is not scanned to the end. */
+int32_t array_container_packed_size_in_bytes(const array_container_t *container,
+                                             int32_t limit);
+
+/* Write the array as a packed container (see packed.h). Returns the number of
+ * bytes written. */
+int32_t array_container_write_packed(const array_container_t *container,
+                                     char *buf);
+
+/* Read cardinality values from a packed container (see packed.h) straight
+ * into the array, which is overwritten and must have the capacity for them.
+ * The packed data must have been validated with packed_size_from_buffer.
+ * Returns the number of bytes read, or -1 if the values overflow 16 bits. */
+int32_t array_container_read_packed(int32_t cardinality,
+                                    array_container_t *container,
+                                    const char *buf);
+
 /**
  * Return the serialized size in bytes of a container (see
  * bitset_container_write)
@@ -266,6 +285,13 @@ static inline void array_container_append(array_container_t *arr,
     arr->array[arr->cardinality++] = pos;
 }
 
+/* Sort the values of arr and drop duplicates. Arrays filled out of order
+ * with array_container_append (see container_lazy_add) are restored this way;
+ * the sorted prefix is kept and only the remaining values are sorted. If no
+ * memory is left for the merge, the whole array is sorted in place instead.
+ * The cardinality may exceed DEFAULT_MAX_SIZE afterwards. */
+void array_container_normalize(array_container_t *arr);
+
 /**
  * Add value to the set if final cardinality doesn't exceed max_cardinality.
  * Return code:
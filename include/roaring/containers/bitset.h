@@ -360,6 +360,23 @@ int bitset_container_xor_nocard(const bitset_container_t *src_1,
                                 const bitset_container_t *src_2,
                                 bitset_container_t *dst);
 
+/* Computes the union of `dst' and the n bitsets `srcs' into `dst', in a single
+ * pass over the words of `dst'. Does not update the cardinality (it is set to
+ * BITSET_UNKNOWN_CARDINALITY). `dst' must not be one of `srcs'. */
+void bitset_container_or_many(bitset_container_t *dst,
+                              const bitset_container_t *const *srcs,
+                              int32_t n);
+
+/* Same as bitset_container_or_many, for the exclusive or. */
+void bitset_container_xor_many(bitset_container_t *dst,
+                               const bitset_container_t *const *srcs,
+                               int32_t n);
+
+/* Same as bitset_container_or_many, for the intersection. */
+void bitset_container_and_many(bitset_container_t *dst,
+                               const bitset_container_t *const *srcs,
+                               int32_t n);
+
 /* Computes the and not of bitsets `src_1' and `src_2' into `dst' and return the
  * cardinality. */
 int bitset_container_andnot(const bitset_container_t *src_1,
@@ -377,6 +394,22 @@ int bitset_container_andnot_nocard(const bitset_container_t *src_1,
                                    const bitset_container_t *src_2,
                                    bitset_container_t *dst);
 
+/* Same as bitset_container_or, bitset_container_and, bitset_container_xor and
+ * bitset_container_andnot, but the runs of the result are also counted, in the
+ * same pass, into *n_runs. `dst' may be `src_1'. */
+int bitset_container_or_runs(const bitset_container_t *src_1,
+                             const bitset_container_t *src_2,
+                             bitset_container_t *dst, int32_t *n_runs);
+int bitset_container_and_runs(const bitset_container_t *src_1,
+                              const bitset_container_t *src_2,
+                              bitset_container_t *dst, int32_t *n_runs);
+int bitset_container_xor_runs(const bitset_container_t *src_1,
+                              const bitset_container_t *src_2,
+                              bitset_container_t *dst, int32_t *n_runs);
+int bitset_container_andnot_runs(const bitset_container_t *src_1,
+                                 const bitset_container_t *src_2,
+                                 bitset_container_t *dst, int32_t *n_runs);
+
 /*
  * Write out the 16-bit integers contained in this container as a list of 32-bit
  * integers using base
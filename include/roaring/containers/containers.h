@@ -340,8 +340,20 @@ static inline void *container_repair_after_lazy(void *container,
             }
             return container;
         case ARRAY_CONTAINER_TYPE_CODE:
-            return container;  // nothing to do
+            // only container_lazy_add leaves arrays unsorted or oversized
+            array_container_normalize((array_container_t *)container);
+            if (((array_container_t *)container)->cardinality >
+                DEFAULT_MAX_SIZE) {
+                result = bitset_container_from_array(
+                    (const array_container_t *)container);
+                array_container_free((array_container_t *)container);
+                *typecode = BITSET_CONTAINER_TYPE_CODE;
+                return result;
+            }
+            return container;
         case RUN_CONTAINER_TYPE_CODE:
+            // only container_lazy_add leaves runs unsorted or overlapping
+            run_container_normalize((run_container_t *)container);
             return convert_run_to_efficient_container_and_free(
                 (run_container_t *)container, typecode);
         case SHARED_CONTAINER_TYPE_CODE:
@@ -399,6 +411,57 @@ static inline int32_t container_size_in_bytes(const void *container,
     return 0;  // unreached
 }
 
+/**
+ * Get the container size in bytes when written as a packed container (see
+ * container_write_packed), requires a typecode. Returns 0 if the container
+ * should not be packed: only bitsets and arrays are packed, and only when
+ * this is smaller than container_size_in_bytes.
+ */
+static inline int32_t container_packed_size_in_bytes(const void *container,
+                                                     uint8_t typecode) {
+    container = container_unwrap_shared(container, &typecode);
+    switch (typecode) {
+        case BITSET_CONTAINER_TYPE_CODE: {
+            const bitset_container_t *bitset =
+                (const bitset_container_t *)container;
+            const int32_t limit = bitset_container_size_in_bytes(bitset);
+            const int32_t packed =
+                bitset_container_packed_size_in_bytes(bitset, limit);
+            return packed < limit ? packed : 0;
+        }
+        case ARRAY_CONTAINER_TYPE_CODE: {
+            const array_container_t *array =
+                (const array_container_t *)container;
+            const int32_t limit = array_container_size_in_bytes(array);
+            const int32_t packed =
+                array_container_packed_size_in_bytes(array, limit);
+            return packed < limit ? packed : 0;
+        }
+        case RUN_CONTAINER_TYPE_CODE:
+            return 0;
+    }
+    assert(false);
+    __builtin_unreachable();
+    return 0;  // unreached
+}
+
+/**
+ * Writes the underlying array as a packed container (see packed.h), returns
+ * the number of bytes written, container_packed_size_in_bytes(container).
+ * Only valid when that size is not zero.
+ */
+static inline int32_t container_write_packed(const void *container,
+                                             uint8_t typecode, char *buf) {
+    container = container_unwrap_shared(container, &typecode);
+    if (typecode == ARRAY_CONTAINER_TYPE_CODE) {
+        return array_container_write_packed(
+            (const array_container_t *)container, buf);
+    }
+    assert(typecode == BITSET_CONTAINER_TYPE_CODE);
+    return bitset_container_write_packed((const bitset_container_t *)container,
+                                         buf);
+}
+
 /**
  * print the container (useful for debugging), requires a  typecode
  */
@@ -501,6 +564,52 @@ static inline void *container_add(void *container, uint16_t val,
     }
 }
 
+/**
+ * Add a value to a container, like container_add, except that array and run
+ * containers are appended to without keeping them sorted or unique. They grow
+ * to twice DEFAULT_MAX_SIZE values or runs before being normalized, and are
+ * converted if that leaves them too large. container_repair_after_lazy must
+ * be called before the container is used in any other way.
+ */
+static inline void *container_lazy_add(void *container, uint16_t val,
+                                       uint8_t typecode,
+                                       uint8_t *new_typecode) {
+    container = get_writable_copy_if_shared(container, &typecode);
+    if (typecode == BITSET_CONTAINER_TYPE_CODE) {
+        return container_add(container, val, typecode, new_typecode);
+    }
+    if (typecode == RUN_CONTAINER_TYPE_CODE) {
+        run_container_t *run = (run_container_t *)container;
+        if (run->n_runs == 2 * DEFAULT_MAX_SIZE) {
+            run_container_normalize(run);
+            // with many runs left, a bitset or an array is more compact
+            uint8_t efficient_typecode = RUN_CONTAINER_TYPE_CODE;
+            void *efficient =
+                convert_run_to_efficient_container(run, &efficient_typecode);
+            if (efficient != run) {
+                return container_lazy_add(efficient, val, efficient_typecode,
+                                          new_typecode);
+            }
+        }
+        run_container_lazy_append(run, val);
+        *new_typecode = RUN_CONTAINER_TYPE_CODE;
+        return run;
+    }
+    array_container_t *ac = (array_container_t *)container;
+    if (ac->cardinality == 2 * DEFAULT_MAX_SIZE) {
+        array_container_normalize(ac);
+        if (ac->cardinality > DEFAULT_MAX_SIZE) {
+            bitset_container_t *bitset = bitset_container_from_array(ac);
+            bitset_container_add(bitset, val);
+            *new_typecode = BITSET_CONTAINER_TYPE_CODE;
+            return bitset;
+        }
+    }
+    array_container_append(ac, val);
+    *new_typecode = ARRAY_CONTAINER_TYPE_CODE;
+    return ac;
+}
+
 /**
  * Remove a value from a container, requires a  typecode, fills in new_typecode
  * and
@@ -831,6 +940,103 @@ static inline int container_and_cardinality(const void *c1, uint8_t type1,
     }
 }
 
+/**
+ * Compute the cardinality of the difference c1 - c2 without materializing it.
+ */
+static inline int container_andnot_cardinality(const void *c1, uint8_t type1,
+                                               const void *c2, uint8_t type2) {
+    c1 = container_unwrap_shared(c1, &type1);
+    c2 = container_unwrap_shared(c2, &type2);
+    switch (CONTAINER_PAIR(type1, type2)) {
+        case CONTAINER_PAIR(BITSET_CONTAINER_TYPE_CODE,
+                            BITSET_CONTAINER_TYPE_CODE):
+            return bitset_container_andnot_justcard(
+                (const bitset_container_t *)c1, (const bitset_container_t *)c2);
+        case CONTAINER_PAIR(ARRAY_CONTAINER_TYPE_CODE,
+                            ARRAY_CONTAINER_TYPE_CODE):
+            return array_array_container_andnot_cardinality(
+                (const array_container_t *)c1, (const array_container_t *)c2);
+        case CONTAINER_PAIR(RUN_CONTAINER_TYPE_CODE, RUN_CONTAINER_TYPE_CODE):
+            return run_run_container_andnot_cardinality(
+                (const run_container_t *)c1, (const run_container_t *)c2);
+        case CONTAINER_PAIR(BITSET_CONTAINER_TYPE_CODE,
+                            ARRAY_CONTAINER_TYPE_CODE):
+            return bitset_array_container_andnot_cardinality(
+                (const bitset_container_t *)c1, (const array_container_t *)c2);
+        case CONTAINER_PAIR(ARRAY_CONTAINER_TYPE_CODE,
+                            BITSET_CONTAINER_TYPE_CODE):
+            return array_bitset_container_andnot_cardinality(
+                (const array_container_t *)c1, (const bitset_container_t *)c2);
+        case CONTAINER_PAIR(BITSET_CONTAINER_TYPE_CODE,
+                            RUN_CONTAINER_TYPE_CODE):
+            return bitset_run_container_andnot_cardinality(
+                (const bitset_container_t *)c1, (const run_container_t *)c2);
+        case CONTAINER_PAIR(RUN_CONTAINER_TYPE_CODE,
+                            BITSET_CONTAINER_TYPE_CODE):
+            return run_bitset_container_andnot_cardinality(
+                (const run_container_t *)c1, (const bitset_container_t *)c2);
+        case CONTAINER_PAIR(ARRAY_CONTAINER_TYPE_CODE, RUN_CONTAINER_TYPE_CODE):
+            return array_run_container_andnot_cardinality(
+                (const array_container_t *)c1, (const run_container_t *)c2);
+        case CONTAINER_PAIR(RUN_CONTAINER_TYPE_CODE, ARRAY_CONTAINER_TYPE_CODE):
+            return run_array_container_andnot_cardinality(
+                (const run_container_t *)c1, (const array_container_t *)c2);
+        default:
+            assert(false);
+            __builtin_unreachable();
+            return 0;
+    }
+}
+
+/**
+ * Compute the cardinality of the symmetric difference of c1 and c2 without
+ * materializing it.
+ */
+static inline int container_xor_cardinality(const void *c1, uint8_t type1,
+                                            const void *c2, uint8_t type2) {
+    c1 = container_unwrap_shared(c1, &type1);
+    c2 = container_unwrap_shared(c2, &type2);
+    switch (CONTAINER_PAIR(type1, type2)) {
+        case CONTAINER_PAIR(BITSET_CONTAINER_TYPE_CODE,
+                            BITSET_CONTAINER_TYPE_CODE):
+            return bitset_container_xor_justcard(
+                (const bitset_container_t *)c1, (const bitset_container_t *)c2);
+        case CONTAINER_PAIR(ARRAY_CONTAINER_TYPE_CODE,
+                            ARRAY_CONTAINER_TYPE_CODE):
+            return array_array_container_xor_cardinality(
+                (const array_container_t *)c1, (const array_container_t *)c2);
+        case CONTAINER_PAIR(RUN_CONTAINER_TYPE_CODE, RUN_CONTAINER_TYPE_CODE):
+            return run_run_container_xor_cardinality(
+                (const run_container_t *)c1, (const run_container_t *)c2);
+        case CONTAINER_PAIR(BITSET_CONTAINER_TYPE_CODE,
+                            ARRAY_CONTAINER_TYPE_CODE):
+            return array_bitset_container_xor_cardinality(
+                (const array_container_t *)c2, (const bitset_container_t *)c1);
+        case CONTAINER_PAIR(ARRAY_CONTAINER_TYPE_CODE,
+                            BITSET_CONTAINER_TYPE_CODE):
+            return array_bitset_container_xor_cardinality(
+                (const array_container_t *)c1, (const bitset_container_t *)c2);
+        case CONTAINER_PAIR(BITSET_CONTAINER_TYPE_CODE,
+                            RUN_CONTAINER_TYPE_CODE):
+            return run_bitset_container_xor_cardinality(
+                (const run_container_t *)c2, (const bitset_container_t *)c1);
+        case CONTAINER_PAIR(RUN_CONTAINER_TYPE_CODE,
+                            BITSET_CONTAINER_TYPE_CODE):
+            return run_bitset_container_xor_cardinality(
+                (const run_container_t *)c1, (const bitset_container_t *)c2);
+        case CONTAINER_PAIR(ARRAY_CONTAINER_TYPE_CODE, RUN_CONTAINER_TYPE_CODE):
+            return array_run_container_xor_cardinality(
+                (const array_container_t *)c1, (const run_container_t *)c2);
+        case CONTAINER_PAIR(RUN_CONTAINER_TYPE_CODE, ARRAY_CONTAINER_TYPE_CODE):
+            return array_run_container_xor_cardinality(
+                (const array_container_t *)c2, (const run_container_t *)c1);
+        default:
+            assert(false);
+            __builtin_unreachable();
+            return 0;
+    }
+}
+
 /**
  * Check whether two containers intersect.
  */
@@ -976,6 +1182,37 @@ static inline void *container_iand(void *c1, uint8_t type1, const void *c2,
     }
 }
 
+/**
+ * Same as container_iand, but a bitset result keeps an unknown cardinality
+ * and stays a bitset even when it is small. It requires repair later on the
+ * generated containers. c1 must not be shared.
+ */
+static inline void *container_lazy_iand(void *c1, uint8_t type1,
+                                        const void *c2, uint8_t type2,
+                                        uint8_t *result_type) {
+    assert(type1 != SHARED_CONTAINER_TYPE_CODE);
+    c2 = container_unwrap_shared(c2, &type2);
+    switch (CONTAINER_PAIR(type1, type2)) {
+        case CONTAINER_PAIR(BITSET_CONTAINER_TYPE_CODE,
+                            BITSET_CONTAINER_TYPE_CODE):
+            bitset_container_and_nocard((const bitset_container_t *)c1,
+                                        (const bitset_container_t *)c2,
+                                        (bitset_container_t *)c1);  // is lazy
+            *result_type = BITSET_CONTAINER_TYPE_CODE;
+            return c1;
+        case CONTAINER_PAIR(BITSET_CONTAINER_TYPE_CODE,
+                            RUN_CONTAINER_TYPE_CODE):
+            run_bitset_container_lazy_intersection(
+                (const run_container_t *)c2, (const bitset_container_t *)c1,
+                (bitset_container_t *)c1);  // is lazy
+            *result_type = BITSET_CONTAINER_TYPE_CODE;
+            return c1;
+        default:
+            // the other pairs never need the cardinality of a bitset c1
+            return container_iand(c1, type1, c2, type2, result_type);
+    }
+}
+
 /**
  * Compute union between two containers, generate a new container (having type
  * result_type), requires a typecode. This allocates new memory, caller
@@ -1285,12 +1522,8 @@ static inline void *container_ior(void *c1, uint8_t type1, const void *c2,
             *result_type = BITSET_CONTAINER_TYPE_CODE;
             return result;
         case CONTAINER_PAIR(ARRAY_CONTAINER_TYPE_CODE, RUN_CONTAINER_TYPE_CODE):
-            result = run_container_create();
-            array_run_container_union((const array_container_t *)c1,
-                                      (const run_container_t *)c2,
-                                      (run_container_t *)result);
-            result = convert_run_to_efficient_container_and_free(
-                (run_container_t *)result, result_type);
+            *result_type = array_run_container_ior(
+                (array_container_t *)c1, (const run_container_t *)c2, &result);
             return result;
         case CONTAINER_PAIR(RUN_CONTAINER_TYPE_CODE, ARRAY_CONTAINER_TYPE_CODE):
             array_run_container_inplace_union((const array_container_t *)c2,
@@ -1741,6 +1974,58 @@ static inline void *container_lazy_ixor(void *c1, uint8_t type1, const void *c2,
     }
 }
 
+/**
+ * Compute the union of n >= 2 containers (having the typecodes typecodes),
+ * generate a new container (having type result_type). Unless the inputs are
+ * few and small, they are combined in a single bitset: bitsets in one pass,
+ * then arrays are scattered and runs painted into it. This allocates new
+ * memory, caller is responsible for deallocation.
+ */
+void *container_or_many(const void *const *containers, const uint8_t *typecodes,
+                        int32_t n, uint8_t *result_type);
+
+/**
+ * Same as container_or_many, for the exclusive or. The result may be empty.
+ */
+void *container_xor_many(const void *const *containers,
+                         const uint8_t *typecodes, int32_t n,
+                         uint8_t *result_type);
+
+/**
+ * Bit-sliced counters of the 65536 values of a key, as used by
+ * container_threshold_many. Each counter starts at 2^n_slices - threshold, so
+ * that the carry out of its last slice marks the values seen threshold times.
+ */
+typedef struct container_counters_s {
+    uint32_t threshold;
+    int32_t n_slices;
+    uint64_t *slices;   // n_slices bitsets, least significant first
+    uint64_t *reached;  // the values seen at least threshold times
+    uint64_t dirty[BITSET_CONTAINER_SIZE_IN_WORDS / 64];  // words in use
+} container_counters_t;
+
+/**
+ * Allocates counters for a threshold of at least 2. Returns false if memory
+ * runs out.
+ */
+bool container_counters_init(container_counters_t *counters,
+                             uint32_t threshold);
+
+void container_counters_free(container_counters_t *counters);
+
+/**
+ * Compute the values present in at least counters->threshold of the n
+ * containers, generate a new container (having type result_type), which may
+ * be empty. Bitsets are added to the counters with carry-save adders over
+ * their words, arrays and runs only touch the words holding their values.
+ * The counters are reset for the next call. This allocates new memory, caller
+ * is responsible for deallocation.
+ */
+void *container_threshold_many(const void *const *containers,
+                               const uint8_t *typecodes, int32_t n,
+                               container_counters_t *counters,
+                               uint8_t *result_type);
+
 /**
  * Compute difference (andnot) between two containers, generate a new
  * container (having type result_type), requires a typecode. This allocates new
@@ -1933,6 +2218,40 @@ static inline void *container_iandnot(void *c1, uint8_t type1, const void *c2,
     }
 }
 
+/**
+ * Same as container_iandnot, but a bitset c1 stays a bitset with an unknown
+ * cardinality. It requires repair later on the generated containers. c1 must
+ * not be shared.
+ */
+static inline void *container_lazy_iandnot(void *c1, uint8_t type1,
+                                           const void *c2, uint8_t type2,
+                                           uint8_t *result_type) {
+    assert(type1 != SHARED_CONTAINER_TYPE_CODE);
+    c2 = container_unwrap_shared(c2, &type2);
+    switch (CONTAINER_PAIR(type1, type2)) {
+        case CONTAINER_PAIR(BITSET_CONTAINER_TYPE_CODE,
+                            BITSET_CONTAINER_TYPE_CODE):
+            bitset_container_andnot_nocard((const bitset_container_t *)c1,
+                                           (const bitset_container_t *)c2,
+                                           (bitset_container_t *)c1);
+            break;
+        case CONTAINER_PAIR(BITSET_CONTAINER_TYPE_CODE,
+                            ARRAY_CONTAINER_TYPE_CODE):
+            bitset_array_container_lazy_iandnot((bitset_container_t *)c1,
+                                                (const array_container_t *)c2);
+            break;
+        case CONTAINER_PAIR(BITSET_CONTAINER_TYPE_CODE,
+                            RUN_CONTAINER_TYPE_CODE):
+            bitset_run_container_lazy_iandnot((bitset_container_t *)c1,
+                                              (const run_container_t *)c2);
+            break;
+        default:
+            return container_iandnot(c1, type1, c2, type2, result_type);
+    }
+    *result_type = BITSET_CONTAINER_TYPE_CODE;
+    return c1;
+}
+
 /**
  * Visit all values x of the container once, passing (base+x,ptr)
  * to iterator. You need to specify a container and its type.
@@ -2120,6 +2439,26 @@ static inline void *container_inot_range(void *c, uint8_t typ,
     return NULL;
 }
 
+/**
+ * Same as container_inot_range, but a bitset is flipped in place and keeps
+ * an unknown cardinality. It requires repair later on the generated
+ * containers.
+ */
+static inline void *container_lazy_inot_range(void *c, uint8_t typ,
+                                              uint32_t range_start,
+                                              uint32_t range_end,
+                                              uint8_t *result_type) {
+    c = get_writable_copy_if_shared(c, &typ);
+    if (typ == BITSET_CONTAINER_TYPE_CODE) {
+        bitset_container_t *bitset = (bitset_container_t *)c;
+        bitset_flip_range(bitset->array, range_start, range_end);
+        bitset->cardinality = BITSET_UNKNOWN_CARDINALITY;
+        *result_type = BITSET_CONTAINER_TYPE_CODE;
+        return c;
+    }
+    return container_inot_range(c, typ, range_start, range_end, result_type);
+}
+
 /**
  * If the element of given rank is in this container, supposing that
  * the first
@@ -8,6 +8,7 @@
 
 #include <roaring/containers/array.h>
 #include <roaring/containers/bitset.h>
+#include <roaring/containers/packed.h>
 #include <roaring/containers/run.h>
 
 /* Convert an array into a bitset. The input container is not freed or modified.
@@ -38,6 +39,13 @@ void *convert_to_bitset_or_array_container(run_container_t *r, int32_t card,
 void *convert_run_optimize(void *c, uint8_t typecode_original,
                            uint8_t *typecode_after);
 
+/* Same as convert_run_optimize for a bitset whose number of runs, n_runs, is
+ * already known (e.g. from bitset_container_or_runs) and whose cardinality is
+ * up to date. A bitset holding DEFAULT_MAX_SIZE values or fewer becomes an
+ * array or a run, whichever is smaller. The bitset might be freed. */
+void *convert_bitset_run_optimize(bitset_container_t *c, int32_t n_runs,
+                                  uint8_t *typecode_after);
+
 /* converts a run container to either an array or a bitset, IF it saves space.
  */
 /* If a conversion occurs, the caller is responsible to free the original
@@ -56,4 +64,23 @@ void *convert_run_to_efficient_container_and_free(run_container_t *c,
 bitset_container_t *bitset_container_from_run_range(const run_container_t *run,
                                                     uint32_t min, uint32_t max);
 
+/* Number of bytes needed to write the bitset as a packed container (see
+ * packed.h), or limit if that is not less than limit, in which case the
+ * bitset is not scanned to the end. */
+int32_t bitset_container_packed_size_in_bytes(const bitset_container_t *bits,
+                                              int32_t limit);
+
+/* Write the bitset as a packed container (see packed.h). Returns the number of
+ * bytes written. The input container is not freed or modified. */
+int32_t bitset_container_write_packed(const bitset_container_t *bits,
+                                      char *buf);
+
+/* Read cardinality values from a packed container (see packed.h) into the
+ * bitset, which is overwritten. The packed data must have been validated with
+ * packed_size_from_buffer. Returns the number of bytes read, or -1 if the
+ * values overflow 16 bits. */
+int32_t bitset_container_read_packed(int32_t cardinality,
+                                     bitset_container_t *bits,
+                                     const char *buf);
+
 #endif /* INCLUDE_CONTAINERS_CONVERT_H_ */
@@ -38,6 +38,11 @@ bool bitset_array_container_andnot(const bitset_container_t *src_1,
 bool bitset_array_container_iandnot(bitset_container_t *src_1,
                                     const array_container_t *src_2, void **dst);
 
+/* Compute the andnot of src_1 and src_2 and write the result to src_1, which
+ * stays a bitset. Its cardinality is set to BITSET_UNKNOWN_CARDINALITY. */
+void bitset_array_container_lazy_iandnot(bitset_container_t *src_1,
+                                         const array_container_t *src_2);
+
 /* Compute the andnot of src_1 and src_2 and write the result to
  * dst. Result may be either a bitset or an array container
  * (returns "result is bitset"). dst does not initially have
@@ -78,6 +83,11 @@ bool bitset_run_container_andnot(const bitset_container_t *src_1,
 bool bitset_run_container_iandnot(bitset_container_t *src_1,
                                   const run_container_t *src_2, void **dst);
 
+/* Lazy version of bitset_run_container_iandnot: src_1 stays a bitset and its
+ * cardinality is set to BITSET_UNKNOWN_CARDINALITY. */
+void bitset_run_container_lazy_iandnot(bitset_container_t *src_1,
+                                       const run_container_t *src_2);
+
 /* dst does not indicate a valid container initially.  Eventually it
  * can become any type of container.
  */
@@ -157,4 +167,31 @@ bool bitset_bitset_container_andnot(const bitset_container_t *src_1,
 bool bitset_bitset_container_iandnot(bitset_container_t *src_1,
                                      const bitset_container_t *src_2,
                                      void **dst);
+
+/* Compute the size of the difference src_1 - src_2, without materializing
+ * it. For bitset-bitset, use bitset_container_andnot_justcard. */
+
+int array_bitset_container_andnot_cardinality(const array_container_t *src_1,
+                                              const bitset_container_t *src_2);
+
+int bitset_array_container_andnot_cardinality(const bitset_container_t *src_1,
+                                              const array_container_t *src_2);
+
+int run_bitset_container_andnot_cardinality(const run_container_t *src_1,
+                                            const bitset_container_t *src_2);
+
+int bitset_run_container_andnot_cardinality(const bitset_container_t *src_1,
+                                            const run_container_t *src_2);
+
+int array_run_container_andnot_cardinality(const array_container_t *src_1,
+                                           const run_container_t *src_2);
+
+int run_array_container_andnot_cardinality(const run_container_t *src_1,
+                                           const array_container_t *src_2);
+
+int array_array_container_andnot_cardinality(const array_container_t *src_1,
+                                             const array_container_t *src_2);
+
+int run_run_container_andnot_cardinality(const run_container_t *src_1,
+                                         const run_container_t *src_2);
 #endif
@@ -58,6 +58,14 @@ bool run_bitset_container_intersection(const run_container_t *src_1,
                                        const bitset_container_t *src_2,
                                        void **dst);
 
+/* Compute the intersection of src_1 and src_2 and write the result to
+ * dst. It is allowed for dst to be src_2. This version does not update the
+ * cardinality of dst (it is set to BITSET_UNKNOWN_CARDINALITY) and keeps
+ * the result as a bitset even when it is small. */
+void run_bitset_container_lazy_intersection(const run_container_t *src_1,
+                                            const bitset_container_t *src_2,
+                                            bitset_container_t *dst);
+
 /* Compute the size of the intersection between src_1 and src_2 . */
 int array_run_container_intersection_cardinality(const array_container_t *src_1,
                                                  const run_container_t *src_2);
@@ -42,7 +42,7 @@ bool array_array_container_union(const array_container_t *src_1,
  * to *dst if it cannot be written to src_1. If the return function is true,
  * the result is a bitset_container_t
  * otherwise is a array_container_t. When the result is an array_container_t, it
- * it either written to src_1 (if *dst is null) or to *dst.
+ * is written to src_1 (growing it if needed) and *dst is null.
  * If the result is a bitset_container_t and *dst is null, then there was a failure.
  */
 bool array_array_container_inplace_union(array_container_t *src_1,
@@ -80,6 +80,13 @@ void array_run_container_union(const array_container_t *src_1,
 void array_run_container_inplace_union(const array_container_t *src_1,
                                        run_container_t *src_2);
 
+/* Compute the union of src_1 and src_2. When the result is best stored as an
+ * array, it is written to src_1 (growing it if needed) and *dst is src_1.
+ * Otherwise *dst is a new container and src_1 is left untouched.
+ * Returns the type of *dst. */
+int array_run_container_ior(array_container_t *src_1,
+                            const run_container_t *src_2, void **dst);
+
 /* Compute the union of src_1 and src_2 and write the result to
  * dst. It is allowed for dst to be src_2.
  * If run_container_is_full(src_1) is true, you must not be calling this
@@ -146,9 +146,29 @@ int array_run_container_ixor(array_container_t *src_1,
 int run_array_container_ixor(run_container_t *src_1,
                              const array_container_t *src_2, void **dst);
 
+/* When the result fits in an array, it is written to src_1 (growing it if
+ * needed) and *dst is src_1; otherwise src_1 is freed. */
 bool array_array_container_ixor(array_container_t *src_1,
                                 const array_container_t *src_2, void **dst);
 
 int run_run_container_ixor(run_container_t *src_1, const run_container_t *src_2,
                            void **dst);
+/* Compute the size of the symmetric difference of src_1 and src_2, without
+ * materializing it. For bitset-bitset, use bitset_container_xor_justcard. */
+
+int array_bitset_container_xor_cardinality(const array_container_t *src_1,
+                                           const bitset_container_t *src_2);
+
+int run_bitset_container_xor_cardinality(const run_container_t *src_1,
+                                         const bitset_container_t *src_2);
+
+int array_run_container_xor_cardinality(const array_container_t *src_1,
+                                        const run_container_t *src_2);
+
+int array_array_container_xor_cardinality(const array_container_t *src_1,
+                                          const array_container_t *src_2);
+
+int run_run_container_xor_cardinality(const run_container_t *src_1,
+                                      const run_container_t *src_2);
+
 #endif
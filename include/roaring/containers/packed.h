@@ -0,0 +1,51 @@
+/*
+ * packed.h
+ *
+ * Packed containers store a sorted set of 16-bit values as bit-packed deltas.
+ * They are a serialized form only: they suit chunks that are too dense for an
+ * array container but whose gaps are short and irregular (so that neither an
+ * 8kB bitset nor runs are a good fit), and sparser chunks whose gaps are far
+ * below 2^16 (so that the 16 bits per value of an array are mostly wasted).
+ *
+ * Layout: the first value (uint16_t, little endian) followed by the deltas
+ * v[i] - v[i - 1] - 1 in blocks of up to PACKED_BLOCK_SIZE deltas. Each block
+ * is a one-byte bit width w (at most 16) followed by ceil(n * w / 8) bytes
+ * holding the n deltas w bits at a time, least significant bit first.
+ * The cardinality is not stored, it is known from the enclosing format.
+ */
+
+#ifndef INCLUDE_CONTAINERS_PACKED_H_
+#define INCLUDE_CONTAINERS_PACKED_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* number of deltas sharing a bit width */
+enum { PACKED_BLOCK_SIZE = 128 };
+
+/* Number of bytes needed to pack the n deltas as one block,
+ * n should be in [1, PACKED_BLOCK_SIZE]. */
+int32_t packed_block_size(const uint16_t *deltas, int32_t n);
+
+/* Pack the n deltas as one block, returns the number of bytes written
+ * (packed_block_size(deltas, n)). */
+int32_t packed_block_write(const uint16_t *deltas, int32_t n, char *buf);
+
+/* Unpack a block of n deltas, returns the number of bytes read. The block must
+ * have been validated (see packed_size_from_buffer). */
+int32_t packed_block_read(int32_t n, uint16_t *deltas, const char *buf);
+
+/* Replace the n deltas at values by the values they encode after previous
+ * (values[i] = values[i - 1] + deltas[i] + 1), computing prefix sums with
+ * SIMD instructions when available. Returns the last value before truncation
+ * to 16 bits, so that values beyond UINT16_MAX can be detected. */
+uint32_t packed_deltas_to_values(uint16_t *values, int32_t n,
+                                 uint32_t previous);
+
+/* Number of bytes taken by a packed container holding cardinality values at
+ * buf, reading at most maxbytes. Returns 0 if the data is truncated or a block
+ * has an invalid width. This does not check that the values fit in 16 bits. */
+size_t packed_size_from_buffer(int32_t cardinality, const char *buf,
+                               size_t maxbytes);
+
+#endif /* INCLUDE_CONTAINERS_PACKED_H_ */
@@ -10,6 +10,10 @@ long as we can expect them to have  ARRAY_LAZY_LOWERBOUND values.
 */
 enum { ARRAY_LAZY_LOWERBOUND = 1024 };
 
+/* when one array is more than ARRAY_SKEW_THRESHOLD times smaller than the
+   other operand (array values or runs), we gallop instead of merging */
+enum { ARRAY_SKEW_THRESHOLD = 64 };
+
 /* default initial size of a run container 
    setting it to zero delays the malloc.*/
 enum { RUN_DEFAULT_INIT_SIZE = 0 };
@@ -18,6 +22,24 @@ enum { RUN_DEFAULT_INIT_SIZE = 0 };
    setting it to zero delays the malloc */
 enum { ARRAY_DEFAULT_INIT_SIZE = 0 };
 
+/* roaring arrays holding at least RA_KEY_INDEX_THRESHOLD containers (out of
+   65536 possible keys) locate their keys with a direct index of about 10kB
+   instead of a binary search; the index is released when they fall under
+   half of that */
+#ifndef RA_KEY_INDEX_THRESHOLD
+#define RA_KEY_INDEX_THRESHOLD 4096
+#endif
+
+/* roaring_bitmap_or_many_plan counts a union of two containers as one unit of
+   cost; copying a bitset container costs UNION_BITSET_COPY_COST units and a
+   horizontal union scans UNION_HORIZONTAL_KEYS_PER_COST keys per unit */
+enum { UNION_BITSET_COPY_COST = 4 };
+enum { UNION_HORIZONTAL_KEYS_PER_COST = 64 };
+
+/* the n-ary bitset operations combine their inputs BITSET_MANY_BLOCK_WORDS
+   words at a time, so that this block of the result stays in L1 cache */
+enum { BITSET_MANY_BLOCK_WORDS = 128 };
+
 /* automatic bitset conversion during lazy or */
 #ifndef LAZY_OR_BITSET_CONVERSION
 #define LAZY_OR_BITSET_CONVERSION true
@@ -193,6 +193,21 @@ static inline void makeRoomAtIndex(run_container_t *run, uint16_t index) {
 /* Add `pos' to `run'. Returns true if `pos' was not present. */
 bool run_container_add(run_container_t *run, uint16_t pos);
 
+/* Append `pos' as a run of its own at the end of `run', even if this leaves
+ * the runs out of order or overlapping (see container_lazy_add). */
+static inline void run_container_lazy_append(run_container_t *run,
+                                             uint16_t pos) {
+    if (run->n_runs == run->capacity)
+        run_container_grow(run, run->n_runs + 1, true);
+    run->runs[run->n_runs].value = pos;
+    run->runs[run->n_runs].length = 0;
+    run->n_runs++;
+}
+
+/* Sort the runs of `run' by value and merge those that overlap or touch.
+ * Runs appended with run_container_lazy_append are restored this way. */
+void run_container_normalize(run_container_t *run);
+
 /* Remove `pos' from `run'. Returns true if `pos' was present. */
 static inline bool run_container_remove(run_container_t *run, uint16_t pos) {
     int32_t index = interleavedBinarySearch(run->runs, run->n_runs, pos);
@@ -243,6 +258,16 @@ inline bool run_container_contains(const run_container_t *run, uint16_t pos) {
     return false;
 }
 
+/**
+ * Checks the n values, which must be sorted, for membership in `run': sets
+ * answer[i] to whether values[i] is present. Returns how many are present.
+ * A single forward pass is made over the runs, skipping them in SIMD blocks
+ * between probes.
+ */
+int32_t run_container_contains_many(const run_container_t *run,
+                                    const uint16_t *values, int32_t n,
+                                    bool *answer);
+
 /*
 * Check whether all positions in a range of positions from pos_start (included)
 * to pos_end (excluded) is present in `run'.
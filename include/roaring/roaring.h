@@ -17,6 +17,18 @@ typedef struct roaring_bitmap_s {
     roaring_array_t high_low_container;
 } roaring_bitmap_t;
 
+/**
+ * A bit-sliced index associates a non-negative integer value with some of the
+ * 32-bit ids: bit i of the value of an id is set when the id is in slices[i].
+ * The bitmaps may be read, but should only be modified through the
+ * roaring_bsi_* functions.
+ */
+typedef struct roaring_bsi_s {
+    roaring_bitmap_t *ebm;      /* the ids having a value */
+    roaring_bitmap_t **slices;  /* one bitmap per bit of the values */
+    uint32_t n_slices;          /* the values are below 2^n_slices */
+} roaring_bsi_t;
+
 /**
  * Creates a new bitmap (initially empty)
  */
@@ -59,6 +71,24 @@ inline void roaring_bitmap_set_copy_on_write(roaring_bitmap_t* r, bool cow) {
     }
 }
 
+/*
+ * Whether set operations (and, or, xor, andnot and their inplace versions)
+ * writing to this bitmap pick run containers when they are smaller, as
+ * roaring_bitmap_run_optimize would, as they produce each container. A new
+ * bitmap returned by such an operation has the flag if either input has it.
+ * Off by default.
+ */
+inline bool roaring_bitmap_get_auto_run(const roaring_bitmap_t *r) {
+    return r->high_low_container.flags & ROARING_FLAG_AUTORUN;
+}
+inline void roaring_bitmap_set_auto_run(roaring_bitmap_t *r, bool autorun) {
+    if (autorun) {
+        r->high_low_container.flags |= ROARING_FLAG_AUTORUN;
+    } else {
+        r->high_low_container.flags &= ~ROARING_FLAG_AUTORUN;
+    }
+}
+
 /**
  * Describe the inner structure of the bitmap.
  */
@@ -172,7 +202,8 @@ void roaring_bitmap_or_inplace(roaring_bitmap_t *x1,
                                const roaring_bitmap_t *x2);
 
 /**
- * Compute the union of 'number' bitmaps. See also roaring_bitmap_or_many_heap.
+ * Compute the union of 'number' bitmaps, following the plan of
+ * roaring_bitmap_or_many_plan. See also roaring_bitmap_or_many_heap.
  * Caller is responsible for freeing the
  * result.
  *
@@ -181,15 +212,33 @@ roaring_bitmap_t *roaring_bitmap_or_many(size_t number,
                                          const roaring_bitmap_t **x);
 
 /**
- * Compute the union of 'number' bitmaps using a heap. This can
- * sometimes be faster than roaring_bitmap_or_many which uses
- * a naive algorithm. Caller is responsible for freeing the
+ * Compute the union of 'number' bitmaps using a heap, which
+ * roaring_bitmap_or_many also does when roaring_bitmap_or_many_plan
+ * finds it cheaper. Caller is responsible for freeing the
  * result.
  *
  */
 roaring_bitmap_t *roaring_bitmap_or_many_heap(uint32_t number,
                                               const roaring_bitmap_t **x);
 
+/**
+ * (For advanced users.)
+ * Inspects the keys and the container types of 'number' bitmaps to estimate
+ * the cost of their union with each strategy, and fills 'plan' with these
+ * estimates and the cheapest strategy. This is the strategy that
+ * roaring_bitmap_or_many follows.
+ */
+void roaring_bitmap_or_many_plan(size_t number, const roaring_bitmap_t **x,
+                                 roaring_union_plan_t *plan);
+
+/**
+ * Compute the union of 'number' bitmaps with the given strategy rather than
+ * the planned one. Caller is responsible for freeing the result.
+ */
+roaring_bitmap_t *roaring_bitmap_or_many_with_strategy(
+    size_t number, const roaring_bitmap_t **x,
+    roaring_union_strategy_t strategy);
+
 /**
  * Computes the symmetric difference (xor) between two bitmaps
  * and returns new bitmap. The caller is responsible for memory management.
@@ -205,14 +254,27 @@ void roaring_bitmap_xor_inplace(roaring_bitmap_t *x1,
                                 const roaring_bitmap_t *x2);
 
 /**
- * Compute the xor of 'number' bitmaps.
- * Caller is responsible for freeing the
+ * Compute the xor of 'number' bitmaps. Unless roaring_bitmap_or_many_plan
+ * finds successive xors cheaper, the containers sharing a key are combined
+ * all at once. Caller is responsible for freeing the
  * result.
  *
  */
 roaring_bitmap_t *roaring_bitmap_xor_many(size_t number,
                                           const roaring_bitmap_t **x);
 
+/**
+ * Compute the values present in at least 'threshold' of 'number' bitmaps:
+ * their union when threshold is 0 or 1, their intersection when it is
+ * 'number', and an empty bitmap when it exceeds 'number'. The values of each
+ * key are counted with bit-sliced counters, and keys present in fewer than
+ * 'threshold' bitmaps are skipped. Caller is responsible for freeing the
+ * result. Returns NULL if memory runs out.
+ */
+roaring_bitmap_t *roaring_bitmap_threshold_many(size_t number,
+                                                const roaring_bitmap_t **x,
+                                                uint32_t threshold);
+
 /**
  * Computes the  difference (andnot) between two bitmaps
  * and returns new bitmap. The caller is responsible for memory management.
@@ -230,9 +292,8 @@ void roaring_bitmap_andnot_inplace(roaring_bitmap_t *x1,
 /**
  * TODO: consider implementing:
  * Compute the xor of 'number' bitmaps using a heap. This can
- * sometimes be faster than roaring_bitmap_xor_many which uses
- * a naive algorithm. Caller is responsible for freeing the
- * result.
+ * sometimes be faster than roaring_bitmap_xor_many. Caller is responsible
+ * for freeing the result.
  *
  * roaring_bitmap_t *roaring_bitmap_xor_many_heap(uint32_t number,
  *                                              const roaring_bitmap_t **x);
@@ -368,6 +429,17 @@ void roaring_bitmap_to_uint32_array(const roaring_bitmap_t *ra, uint32_t *ans);
  */
 bool roaring_bitmap_range_uint32_array(const roaring_bitmap_t *ra, size_t offset, size_t limit, uint32_t *ans);
 
+/**
+ * Like roaring_bitmap_range_uint32_array, but in decreasing order: skips the
+ * "offset" largest values, then writes at most "limit" values to "ans",
+ * largest first. E.g., offset = 0 and limit = 10 retrieves the 10 largest
+ * values.
+ * Return false in case of failure.
+ */
+bool roaring_bitmap_range_uint32_array_descending(const roaring_bitmap_t *ra,
+                                                  size_t offset, size_t limit,
+                                                  uint32_t *ans);
+
 /**
  *  Remove run-length encoding even when it is more space efficient
  *  return whether a change was applied
@@ -446,6 +518,32 @@ roaring_bitmap_t *roaring_bitmap_portable_deserialize_safe(const char *buf, size
  */
 size_t roaring_bitmap_portable_deserialize_size(const char *buf, size_t maxbytes);
 
+/**
+ * Runs the tasks of roaring_bitmap_portable_deserialize_parallel, for
+ * instance on a thread pool. arg is passed through.
+ */
+typedef struct roaring_executor_s {
+    /* Calls task(task_arg, i) for every i below n_tasks, possibly in
+     * parallel, and returns once all the calls have returned. */
+    void (*run)(void (*task)(void *task_arg, uint32_t i), void *task_arg,
+                uint32_t n_tasks, void *arg);
+    uint32_t n_tasks;  // the number of tasks to split the containers into
+    void *arg;
+} roaring_executor_t;
+
+/**
+ * Read a bitmap like roaring_bitmap_portable_deserialize_safe, reading the
+ * containers in executor->n_tasks tasks of similar sizes, run by the executor
+ * (or in the calling thread if it is NULL). The bitmap and all its containers
+ * are allocated at once: it is read-only, like the bitmaps of
+ * roaring_bitmap_frozen_view(), but does not depend on the buffer.
+ * roaring_bitmap_copy() gives a bitmap that can be modified.
+ * Bitmap must be freed as usual, by calling roaring_bitmap_free().
+ * In case of failure, a null pointer is returned.
+ */
+const roaring_bitmap_t *roaring_bitmap_portable_deserialize_parallel(
+    const char *buf, size_t maxbytes, const roaring_executor_t *executor);
+
 
 /**
  * How many bytes are required to serialize this bitmap (meant to be compatible
@@ -465,6 +563,180 @@ size_t roaring_bitmap_portable_size_in_bytes(const roaring_bitmap_t *ra);
  */
 size_t roaring_bitmap_portable_serialize(const roaring_bitmap_t *ra, char *buf);
 
+/**
+ * How many bytes are required to serialize this bitmap with
+ * roaring_bitmap_portable_packed_serialize.
+ */
+size_t roaring_bitmap_portable_packed_size_in_bytes(const roaring_bitmap_t *ra);
+
+/**
+ * write a bitmap to a char buffer using the packed variant of the portable
+ * format. The output buffer should refer to at least
+ * roaring_bitmap_portable_packed_size_in_bytes(ra) bytes of allocated memory.
+ * Bitset and array containers are written as bit-packed deltas when this is
+ * smaller, which suits chunks of a few thousand values with short gaps, as
+ * well as sparser chunks whose gaps are far below 2^16. When no
+ * container is packed, the output is identical to
+ * roaring_bitmap_portable_serialize. Otherwise, it is marked by a distinct
+ * cookie: roaring_bitmap_portable_deserialize and its variants read it, but
+ * the Java and Go versions do not.
+ * Returns how many bytes were written which should be
+ * roaring_bitmap_portable_packed_size_in_bytes(ra).
+ */
+size_t roaring_bitmap_portable_packed_serialize(const roaring_bitmap_t *ra,
+                                                char *buf);
+
+/**
+ * The layout of a bitmap under serialization, computed once by
+ * roaring_serialization_init: the sizes of both formats, the cardinality, and
+ * the header of the portable format (the keys, cardinalities and offsets of
+ * the containers). The bitmap can then be written, or described as a list of
+ * buffers, without traversing it again. The layout becomes invalid when the
+ * bitmap is modified.
+ */
+typedef struct roaring_serialization_s {
+    const roaring_bitmap_t *bitmap;
+    uint64_t cardinality;
+    size_t size_in_bytes;           // as roaring_bitmap_size_in_bytes
+    size_t portable_size_in_bytes;  // as roaring_bitmap_portable_size_in_bytes
+    char *header;                   // the portable format, before the payloads
+    uint32_t header_size;
+    int32_t n_iovecs;  // as needed by roaring_serialization_portable_iovecs
+} roaring_serialization_t;
+
+/**
+ * A buffer of the portable format, with the layout of the POSIX struct iovec
+ * (so that an array of them may be passed to writev on most platforms).
+ */
+typedef struct roaring_iovec_s {
+    const void *base;
+    size_t len;
+} roaring_iovec_t;
+
+/**
+ * Compute the layout of the bitmap under serialization, in a single pass over
+ * its containers. Returns false if memory could not be allocated. The layout
+ * must be released with roaring_serialization_free.
+ */
+bool roaring_serialization_init(const roaring_bitmap_t *ra,
+                                roaring_serialization_t *s);
+
+/**
+ * Release the memory held by a layout (but not the layout itself).
+ */
+void roaring_serialization_free(roaring_serialization_t *s);
+
+/**
+ * Write the bitmap as roaring_bitmap_serialize does. The output buffer should
+ * refer to at least s->size_in_bytes bytes. Returns how many bytes were
+ * written, s->size_in_bytes.
+ */
+size_t roaring_serialization_write(const roaring_serialization_t *s,
+                                   char *buf);
+
+/**
+ * Write the bitmap as roaring_bitmap_portable_serialize does. The output
+ * buffer should refer to at least s->portable_size_in_bytes bytes. Returns
+ * how many bytes were written, s->portable_size_in_bytes.
+ */
+size_t roaring_serialization_portable_write(const roaring_serialization_t *s,
+                                            char *buf);
+
+/**
+ * Describe the portable format as s->n_iovecs buffers, written to iov: the
+ * header of the layout followed by the payloads of the containers, which are
+ * not copied. Their concatenation is the output of
+ * roaring_bitmap_portable_serialize; they remain valid as long as the bitmap
+ * and the layout are neither modified nor freed. As for the portable format,
+ * this assumes a little-endian platform. Returns s->n_iovecs.
+ */
+int32_t roaring_serialization_portable_iovecs(
+    const roaring_serialization_t *s, roaring_iovec_t *iov);
+
+/**
+ * A block compressor, such as LZ4 or zstd, for the compressed envelope of the
+ * portable format (see roaring_bitmap_compressed_serialize). arg is passed
+ * through to both functions.
+ */
+typedef struct roaring_codec_s {
+    /* Compresses the src_len bytes of src into dst, returning the compressed
+     * size, or 0 if it would exceed dst_capacity. */
+    size_t (*compress)(const char *src, size_t src_len, char *dst,
+                       size_t dst_capacity, void *arg);
+    /* Decompresses the src_len bytes of src into exactly dst_len bytes at dst,
+     * returning false if the data is invalid. */
+    bool (*decompress)(const char *src, size_t src_len, char *dst,
+                       size_t dst_len, void *arg);
+    void *arg;
+} roaring_codec_t;
+
+/**
+ * How many bytes roaring_bitmap_compressed_serialize may write at most.
+ */
+size_t roaring_bitmap_compressed_size_bound(const roaring_bitmap_t *ra);
+
+/**
+ * Write the bitmap to a char buffer as a compressed envelope of the portable
+ * format: the header of roaring_bitmap_portable_serialize is kept as is, and
+ * the containers are grouped into blocks of at least block_size bytes (or of
+ * a single container when block_size is 0), each compressed by the codec
+ * unless this does not make it smaller. The blocks can be decompressed one at
+ * a time (see roaring_compressed_init). The codec may be NULL, storing all the
+ * blocks as they are. The output buffer should refer to at least
+ * roaring_bitmap_compressed_size_bound(ra) bytes. Returns how many bytes were
+ * written, or 0 if memory could not be allocated.
+ */
+size_t roaring_bitmap_compressed_serialize(const roaring_bitmap_t *ra,
+                                           const roaring_codec_t *codec,
+                                           uint32_t block_size, char *buf);
+
+/**
+ * Read a bitmap written by roaring_bitmap_compressed_serialize, reading up to
+ * maxbytes, with the same codec. In case of failure, a null pointer is
+ * returned.
+ */
+roaring_bitmap_t *roaring_bitmap_compressed_deserialize_safe(
+    const char *buf, size_t maxbytes, const roaring_codec_t *codec);
+
+/**
+ * A view of a compressed envelope, giving access to its blocks without
+ * decompressing the others. The view points into the buffer, which must
+ * outlive it.
+ */
+typedef struct roaring_compressed_s {
+    const roaring_codec_t *codec;
+    const char *keyscards;  // the keys and cardinalities of the header
+    const char *runs;       // the bitmap of run containers, or NULL
+    const char *table;      // the description of the blocks
+    const char *data;       // the first block
+    size_t size_in_bytes;   // the size of the envelope
+    int32_t n_containers;
+    uint32_t n_blocks;
+} roaring_compressed_t;
+
+/**
+ * Initialize a view of the compressed envelope at buf, reading up to
+ * maxbytes. The blocks are not decompressed: their contents are only
+ * validated when read. Returns false if the envelope is invalid.
+ */
+bool roaring_compressed_init(roaring_compressed_t *c, const char *buf,
+                             size_t maxbytes, const roaring_codec_t *codec);
+
+/**
+ * Returns the index of the block holding the container of x, or c->n_blocks
+ * if there is none (x is then not in the bitmap).
+ */
+uint32_t roaring_compressed_find_block(const roaring_compressed_t *c,
+                                       uint32_t x);
+
+/**
+ * Decompress a single block, returning the bitmap of its values: the union of
+ * the bitmaps of all the blocks is the serialized bitmap. In case of failure,
+ * a null pointer is returned. Caller is responsible for freeing the result.
+ */
+roaring_bitmap_t *roaring_compressed_block_deserialize(
+    const roaring_compressed_t *c, uint32_t block);
+
 /*
  * "Frozen" serialization format imitates memory layout of roaring_bitmap_t.
  * Deserialized bitmap is a constant view of the underlying buffer.
@@ -509,6 +781,86 @@ void roaring_bitmap_frozen_serialize(const roaring_bitmap_t *ra, char *buf);
  */
 const roaring_bitmap_t *roaring_bitmap_frozen_view(const char *buf, size_t length);
 
+/*
+ * The second version of the frozen format is fixed: it is little-endian, and
+ * every container is found through an explicit offset. A view of it only
+ * needs the buffer to be aligned by 8 bytes, so that it can be stored at any
+ * such position of a larger file, and checks that the buffer is consistent
+ * (that all the containers are within bounds) in time proportional to the
+ * number of containers, without reading their data.
+ * Views are not available on big-endian platforms.
+ */
+
+/**
+ * Returns number of bytes required to serialize bitmap using the second
+ * version of the frozen format.
+ */
+size_t roaring_bitmap_frozen_v2_size_in_bytes(const roaring_bitmap_t *ra);
+
+/**
+ * Serializes bitmap using the second version of the frozen format, and returns
+ * the number of bytes written: roaring_bitmap_frozen_v2_size_in_bytes().
+ * Buffer size must be at least that. Containers are placed at offsets below
+ * 2^32: if this is not possible, 0 is returned.
+ */
+size_t roaring_bitmap_frozen_v2_serialize(const roaring_bitmap_t *ra,
+                                          char *buf);
+
+/**
+ * Creates constant bitmap that is a view of a given buffer, which must contain
+ * data written by roaring_bitmap_frozen_v2_serialize(), aligned by 8 bytes.
+ * The data may end before length.
+ *
+ * On error, including when the containers are not all within length bytes,
+ * or when their contents are not valid (unsorted array values, runs out of
+ * order, overlapping or past 65535, bitsets of the wrong cardinality), NULL
+ * is returned. Checking the contents reads all of the data once.
+ *
+ * Bitmap returned by this function can be used in all readonly contexts.
+ * Bitmap must be freed as usual, by calling roaring_bitmap_free().
+ * Underlying buffer must not be freed or modified while it backs any bitmaps.
+ */
+const roaring_bitmap_t *roaring_bitmap_frozen_v2_view(const char *buf,
+                                                      size_t length);
+
+/**
+ * A mutable bitmap over an image in the second version of the frozen format.
+ * Its containers point into the image until they are modified: they are then
+ * copied to the heap, as with copy-on-write. The image must outlive the
+ * overlay and must not be modified while it backs it.
+ */
+typedef struct roaring_overlay_s {
+    roaring_bitmap_t *bitmap;    // the bitmap, which may be modified freely
+    const char *image;           // the frozen image
+    shared_container_t *frozen;  // the containers of the image
+    const uint32_t *offsets;     // their offsets in the image
+    int32_t n_containers;        // the number of containers of the image
+} roaring_overlay_t;
+
+/**
+ * Initializes an overlay over a buffer holding data written by
+ * roaring_bitmap_frozen_v2_serialize(), checked as by
+ * roaring_bitmap_frozen_v2_view(). Returns false on error.
+ */
+bool roaring_overlay_init(roaring_overlay_t *overlay, const char *buf,
+                          size_t length);
+
+/**
+ * Writes the bitmap of the overlay in the second version of the frozen format,
+ * like roaring_bitmap_frozen_v2_serialize(overlay->bitmap, buf), but copying
+ * the data of consecutive unmodified containers from the image at once.
+ * Buffer size must be at least
+ * roaring_bitmap_frozen_v2_size_in_bytes(overlay->bitmap), and the buffer must
+ * not overlap the image.
+ */
+size_t roaring_overlay_write(const roaring_overlay_t *overlay, char *buf);
+
+/**
+ * Frees the bitmap of the overlay. Bitmaps sharing its containers (copies
+ * made with copy-on-write) must be freed before.
+ */
+void roaring_overlay_free(roaring_overlay_t *overlay);
+
 
 /**
  * Iterate over the bitmap elements. The function iterator is called once for
@@ -575,12 +927,22 @@ void roaring_bitmap_lazy_or_inplace(roaring_bitmap_t *x1,
                                     const roaring_bitmap_t *x2,
                                     const bool bitsetconversion);
 
+/**
+ * (For expert users who seek high performance.)
+ *
+ * Add value x without keeping the array and run containers sorted: values
+ * are appended and sorted in bulk later, so that out-of-order ingestion avoids
+ * shifting the arrays or runs on every insertion. Only roaring_bitmap_lazy_add may be
+ * called on the bitmap until roaring_bitmap_repair_after_lazy normalizes it.
+ */
+void roaring_bitmap_lazy_add(roaring_bitmap_t *r, uint32_t x);
+
 /**
  * (For expert users who seek high performance.)
  *
  * Execute maintenance operations on a bitmap created from
- * roaring_bitmap_lazy_or
- * or modified with roaring_bitmap_lazy_or_inplace.
+ * roaring_bitmap_lazy_or or roaring_bitmap_lazy_xor, or modified with one of
+ * the lazy in-place functions or roaring_bitmap_lazy_add.
  */
 void roaring_bitmap_repair_after_lazy(roaring_bitmap_t *x1);
 
@@ -606,6 +968,34 @@ roaring_bitmap_t *roaring_bitmap_lazy_xor(const roaring_bitmap_t *x1,
 void roaring_bitmap_lazy_xor_inplace(roaring_bitmap_t *x1,
                                      const roaring_bitmap_t *x2);
 
+/**
+ * (For expert users who seek high performance.)
+ * Inplace intersection that defers cardinality counts and container
+ * conversions; see roaring_bitmap_lazy_or. x2 must not itself be lazy.
+ * Lazy intersections, differences, unions, symmetric differences and flips
+ * may be chained freely before a single call to
+ * roaring_bitmap_repair_after_lazy.
+ */
+void roaring_bitmap_lazy_and_inplace(roaring_bitmap_t *x1,
+                                     const roaring_bitmap_t *x2);
+
+/**
+ * (For expert users who seek high performance.)
+ * Inplace difference that defers cardinality counts and container
+ * conversions, like roaring_bitmap_lazy_and_inplace. x1 != x2
+ */
+void roaring_bitmap_lazy_andnot_inplace(roaring_bitmap_t *x1,
+                                        const roaring_bitmap_t *x2);
+
+/**
+ * (For expert users who seek high performance.)
+ * Same as roaring_bitmap_flip_inplace, but defers cardinality counts and
+ * container conversions, like roaring_bitmap_lazy_and_inplace.
+ */
+void roaring_bitmap_lazy_flip_inplace(roaring_bitmap_t *x1,
+                                      uint64_t range_start,
+                                      uint64_t range_end);
+
 /**
  * compute the negation of the roaring bitmap within a specified
  * interval: [range_start, range_end). The number of negated values is
@@ -765,6 +1155,219 @@ void roaring_free_uint32_iterator(roaring_uint32_iterator_t *it);
  */
 uint32_t roaring_read_uint32_iterator(roaring_uint32_iterator_t *it, uint32_t* buf, uint32_t count);
 
+/*
+ * Reverse counterpart of roaring_read_uint32_iterator: reads the next ${count}
+ * values in decreasing order, starting from ${it}->current_value, into
+ * user-supplied ${buf}. Returns the number of read elements, which is smaller
+ * than ${count} only when the iterator is drained. Afterwards, the iterator is
+ * positioned at the next smaller element, as with
+ * roaring_previous_uint32_iterator.
+ */
+uint32_t roaring_read_previous_uint32_iterator(roaring_uint32_iterator_t *it,
+                                               uint32_t *buf, uint32_t count);
+
+/**
+* Iterator over the values shared by several bitmaps. The intersection is
+* never materialized: values are found one at a time by leapfrogging the
+* iterators of the input bitmaps, seeking on container keys before looking
+* inside containers. Stopping early (e.g., after the first few matches) costs
+* nothing more.
+*
+* The input bitmaps must outlive the iterator and must not be modified while
+* it is in use.
+*/
+typedef struct roaring_intersection_iterator_s {
+    roaring_uint32_iterator_t *iterators;  // one per input bitmap
+    size_t n;
+    uint32_t current_value;
+    bool has_value;
+} roaring_intersection_iterator_t;
+
+/**
+* Create an iterator over the intersection of the n given bitmaps. If it is
+* not empty, the iterator points to its smallest value, it->has_value is
+* true and the value is in it->current_value.
+* Returns NULL on allocation failure. Caller is responsible for calling
+* roaring_free_intersection_iterator.
+*/
+roaring_intersection_iterator_t *roaring_create_intersection_iterator(
+    size_t n, const roaring_bitmap_t **bitmaps);
+
+/**
+* Advance to the next value of the intersection. For convenience, returns
+* it->has_value.
+*/
+bool roaring_advance_intersection_iterator(roaring_intersection_iterator_t *it);
+
+/**
+* Move the iterator to the first value of the intersection >= val. The
+* iterator never moves backward. For convenience, returns it->has_value.
+*/
+bool roaring_move_intersection_iterator_equalorlarger(
+    roaring_intersection_iterator_t *it, uint32_t val);
+
+/*
+ * Reads next ${count} values of the intersection into user-supplied ${buf}.
+ * Returns the number of read elements, which is smaller than ${count} only
+ * when the iterator is drained. Same semantics as roaring_read_uint32_iterator.
+ */
+uint32_t roaring_read_intersection_iterator(roaring_intersection_iterator_t *it,
+                                            uint32_t *buf, uint32_t count);
+
+/**
+* Free memory following roaring_create_intersection_iterator
+*/
+void roaring_free_intersection_iterator(roaring_intersection_iterator_t *it);
+
+/**
+* Iterator over the union of several bitmaps, or over the values of a bitmap
+* that are absent from several others. The result is never materialized: the
+* inputs are merged one key at a time (through a heap over their container
+* keys in the union case), so that at most one result container is held.
+* Values can be consumed one at a time or in blocks with
+* roaring_read_merge_iterator.
+*
+* The input bitmaps must outlive the iterator and must not be modified while
+* it is in use. The fields are internal, except has_value and current_value.
+*/
+typedef struct roaring_merge_iterator_s {
+    const roaring_bitmap_t **parents;
+    int32_t *positions;  // index of the next container of each input
+    int32_t *heap;       // inputs with containers left, by next key
+    int32_t heap_size;
+    size_t n;
+    bool andnot;
+    bool owned;  // whether container was computed by the iterator
+    uint16_t key;
+    uint8_t typecode;
+    void *container;  // the values having the current key
+    roaring_bitmap_t view;  // single-container bitmap over container
+    roaring_uint32_iterator_t inner;  // iterates over view
+    uint32_t current_value;
+    bool has_value;
+} roaring_merge_iterator_t;
+
+/**
+* Create an iterator over the union of the n given bitmaps. If it is not
+* empty, the iterator points to its smallest value, it->has_value is true
+* and the value is in it->current_value.
+* Returns NULL on allocation failure. Caller is responsible for calling
+* roaring_free_merge_iterator.
+*/
+roaring_merge_iterator_t *roaring_create_union_iterator(
+    size_t n, const roaring_bitmap_t **bitmaps);
+
+/**
+* Create an iterator over the values of bitmaps[0] that are in none of
+* bitmaps[1], ..., bitmaps[n-1]. See roaring_create_union_iterator.
+*/
+roaring_merge_iterator_t *roaring_create_andnot_iterator(
+    size_t n, const roaring_bitmap_t **bitmaps);
+
+/**
+* Advance to the next value. For convenience, returns it->has_value.
+*/
+bool roaring_advance_merge_iterator(roaring_merge_iterator_t *it);
+
+/**
+* Move the iterator to the first value >= val. The iterator never moves
+* backward. For convenience, returns it->has_value.
+*/
+bool roaring_move_merge_iterator_equalorlarger(roaring_merge_iterator_t *it,
+                                               uint32_t val);
+
+/*
+ * Reads next ${count} values into user-supplied ${buf}. Returns the number of
+ * read elements, which is smaller than ${count} only when the iterator is
+ * drained. Same semantics as roaring_read_uint32_iterator.
+ */
+uint32_t roaring_read_merge_iterator(roaring_merge_iterator_t *it,
+                                     uint32_t *buf, uint32_t count);
+
+/**
+* Free memory following roaring_create_union_iterator or
+* roaring_create_andnot_iterator.
+*/
+void roaring_free_merge_iterator(roaring_merge_iterator_t *it);
+
+/**
+ * Creates a new bit-sliced index (initially empty). Returns NULL if memory
+ * runs out.
+ */
+roaring_bsi_t *roaring_bsi_create(void);
+
+/**
+ * Frees the memory of a bit-sliced index.
+ */
+void roaring_bsi_free(roaring_bsi_t *bsi);
+
+/**
+ * Associates 'value' with 'id', replacing its previous value if any. Returns
+ * false if memory runs out.
+ */
+bool roaring_bsi_set_value(roaring_bsi_t *bsi, uint32_t id, uint64_t value);
+
+/**
+ * Returns true and sets *value to the value of 'id' if it has one.
+ */
+bool roaring_bsi_get_value(const roaring_bsi_t *bsi, uint32_t id,
+                           uint64_t *value);
+
+/**
+ * Removes the value of 'id', if any.
+ */
+void roaring_bsi_remove_value(roaring_bsi_t *bsi, uint32_t id);
+
+/**
+ * Converts the containers of all the slices to runs where this saves space.
+ * Returns true if any container changed.
+ */
+bool roaring_bsi_run_optimize(roaring_bsi_t *bsi);
+
+/**
+ * Returns the ids of 'foundset' (of all the ids having a value if foundset is
+ * NULL) whose value satisfies 'op' with x (and y for ROARING_BSI_RANGE,
+ * otherwise ignored). The slices are walked from the most significant one,
+ * with intersections, differences and lazy unions. Caller is responsible for
+ * freeing the result.
+ */
+roaring_bitmap_t *roaring_bsi_compare(const roaring_bsi_t *bsi,
+                                      roaring_bsi_operation_t op, uint64_t x,
+                                      uint64_t y,
+                                      const roaring_bitmap_t *foundset);
+
+/**
+ * Returns the sum (modulo 2^64) of the values of the ids of 'foundset' (of
+ * all the ids if foundset is NULL), and sets *count to the number of these
+ * ids having a value unless count is NULL. Only needs the cardinality of the
+ * intersection of each slice with the foundset.
+ */
+uint64_t roaring_bsi_sum(const roaring_bsi_t *bsi,
+                         const roaring_bitmap_t *foundset, uint64_t *count);
+
+/**
+ * Returns true and sets *value to the smallest value of the ids of 'foundset'
+ * (of all the ids if foundset is NULL), unless none of them has a value.
+ */
+bool roaring_bsi_min(const roaring_bsi_t *bsi,
+                     const roaring_bitmap_t *foundset, uint64_t *value);
+
+/**
+ * Same as roaring_bsi_min, for the largest value.
+ */
+bool roaring_bsi_max(const roaring_bsi_t *bsi,
+                     const roaring_bitmap_t *foundset, uint64_t *value);
+
+/**
+ * Returns the k ids of 'foundset' (of all the ids if foundset is NULL) having
+ * the largest values, or all of them if fewer than k have a value. Among ids
+ * tied at the smallest selected value, the smallest ids are kept. Caller is
+ * responsible for freeing the result.
+ */
+roaring_bitmap_t *roaring_bsi_top_k(const roaring_bsi_t *bsi,
+                                    const roaring_bitmap_t *foundset,
+                                    uint64_t k);
+
 #ifdef __cplusplus
 }
 #endif
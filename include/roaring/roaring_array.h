@@ -7,6 +7,7 @@ extern "C" {
 #include <assert.h>
 #include <roaring/array_util.h>
 #include <roaring/containers/containers.h>
+#include <roaring/containers/perfparameters.h>
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -17,11 +18,15 @@ extern "C" {
 
 #define ROARING_FLAG_COW UINT8_C(0x1)
 #define ROARING_FLAG_FROZEN UINT8_C(0x2)
+#define ROARING_FLAG_AUTORUN UINT8_C(0x4)
 
 enum {
     SERIAL_COOKIE_NO_RUNCONTAINER = 12346,
     SERIAL_COOKIE = 12347,
+    SERIAL_COOKIE_PACKED = 12348,
+    SERIAL_COOKIE_COMPRESSED = 12349,
     FROZEN_COOKIE = 13766,
+    FROZEN_COOKIE_V2 = 13767,
     NO_OFFSET_THRESHOLD = 4
 };
 
@@ -30,6 +35,18 @@ enum {
  * and 16-bit integer keys. A roaring bitmap  might be implemented as such.
  */
 
+/**
+ * Direct index from the 16-bit keys to their position in a roaring array,
+ * maintained by arrays holding many containers (see RA_KEY_INDEX_THRESHOLD).
+ * Bit k of present is set when k is a key, and rank[w] is the number of keys
+ * smaller than 64 * w, so that the position of a key is found in constant
+ * time. Only the ranks up to the word of the largest key are kept up to date.
+ */
+typedef struct ra_key_index_s {
+    uint64_t present[MAX_CONTAINERS / 64];
+    uint16_t rank[MAX_CONTAINERS / 64];
+} ra_key_index_t;
+
 // parallel arrays.  Element sizes quite different.
 // Alternative is array
 // of structs.  Which would have better
@@ -42,6 +59,7 @@ typedef struct roaring_array_s {
     uint16_t *keys;
     uint8_t *typecodes;
     uint8_t flags;
+    ra_key_index_t *key_index;  // NULL unless there are many containers
 } roaring_array_t;
 
 /**
@@ -92,12 +110,26 @@ void ra_clear_without_containers(roaring_array_t *r);
  */
 void ra_clear_containers(roaring_array_t *ra);
 
+/**
+ * Same result as binarySearch over the keys, using the key index: the array
+ * must have a key index and at least one container.
+ */
+inline int32_t ra_key_index_search(const roaring_array_t *ra, uint16_t x) {
+    if (x > ra->keys[ra->size - 1]) return -(ra->size + 1);
+    const uint64_t word = ra->key_index->present[x >> 6];
+    const int32_t pos =
+        ra->key_index->rank[x >> 6] +
+        __builtin_popcountll(word & ((UINT64_C(1) << (x & 63)) - 1));
+    return ((word >> (x & 63)) & 1) ? pos : -(pos + 1);
+}
+
 /**
  * Get the index corresponding to a 16-bit key
  */
 inline int32_t ra_get_index(const roaring_array_t *ra, uint16_t x) {
     if ((ra->size == 0) || ra->keys[ra->size - 1] == x) return ra->size - 1;
-    return binarySearch(ra->keys, (int32_t)ra->size, x);
+    if (ra->key_index != NULL) return ra_key_index_search(ra, x);
+    return branchlessBinarySearch(ra->keys, (int32_t)ra->size, x);
 }
 
 /**
@@ -191,6 +223,12 @@ inline int32_t ra_get_size(const roaring_array_t *ra) { return ra->size; }
 
 static inline int32_t ra_advance_until(const roaring_array_t *ra, uint16_t x,
                                        int32_t pos) {
+    if (ra->key_index != NULL) {
+        const int32_t lower = pos + 1;
+        if ((lower >= ra->size) || (ra->keys[lower] >= x)) return lower;
+        const int32_t i = ra_key_index_search(ra, x);
+        return i >= 0 ? i : -i - 1;
+    }
     return advanceUntil(ra->keys, pos, ra->size, x);
 }
 
@@ -198,11 +236,26 @@ int32_t ra_advance_until_freeing(roaring_array_t *ra, uint16_t x, int32_t pos);
 
 void ra_downsize(roaring_array_t *ra, int32_t new_length);
 
+/**
+ * Frees the key index, if any.
+ */
+void ra_drop_key_index(roaring_array_t *ra);
+
+/**
+ * Builds the key index if there is none and the array has enough containers.
+ * To be called once the keys are sorted again after they were rewritten in
+ * place, which drops the key index.
+ */
+void ra_reindex_keys(roaring_array_t *ra);
+
 inline void ra_replace_key_and_container_at_index(roaring_array_t *ra,
                                                   int32_t i, uint16_t key,
                                                   void *c, uint8_t typecode) {
     assert(i < ra->size);
 
+    if ((ra->key_index != NULL) && (ra->keys[i] != key)) {
+        ra_drop_key_index(ra);
+    }
     ra->keys[i] = key;
     ra->containers[i] = c;
     ra->typecodes[i] = typecode;
@@ -248,6 +301,23 @@ size_t ra_portable_deserialize_size(const char *buf, const size_t maxbytes);
  */
 size_t ra_portable_size_in_bytes(const roaring_array_t *ra);
 
+/**
+ * write a bitmap to a buffer using the packed variant of the portable format:
+ * it differs only when some bitset or array containers are smaller as packed
+ * containers (see containers/packed.h). Such output is marked by
+ * SERIAL_COOKIE_PACKED and can be read by ra_portable_deserialize but not by
+ * the Java and Go versions.
+ * Return the size in bytes of the serialized output (which should be
+ * ra_portable_packed_size_in_bytes(ra)).
+ */
+size_t ra_portable_packed_serialize(const roaring_array_t *ra, char *buf);
+
+/**
+ * How many bytes are required to serialize this bitmap with
+ * ra_portable_packed_serialize.
+ */
+size_t ra_portable_packed_size_in_bytes(const roaring_array_t *ra);
+
 /**
  * return true if it contains at least one run container.
  */
@@ -259,6 +329,16 @@ bool ra_has_run_container(const roaring_array_t *ra);
  */
 uint32_t ra_portable_header_size(const roaring_array_t *ra);
 
+/**
+ * Write the header of the portable format, everything but the containers, to
+ * buf, which should hold ra_portable_header_size(ra) bytes. The cardinalities
+ * and sizes of the containers are computed once for the keys and offsets, and
+ * their sums are stored in cardinality and size_in_bytes (the size of the
+ * whole serialized bitmap). Return the size of the header.
+ */
+uint32_t ra_portable_header_write(const roaring_array_t *ra, char *buf,
+                                 uint64_t *cardinality, size_t *size_in_bytes);
+
 /**
  * If the container at the index i is share, unshare it (creating a local
  * copy if needed).
@@ -294,6 +374,7 @@ void ra_remove_at_index_and_free(roaring_array_t *ra, int32_t i);
 // used in inplace andNot only, to slide left the containers from
 // the mutated RoaringBitmap that are after the largest container of
 // the argument RoaringBitmap.  It is followed by a call to resize.
+// The key index is dropped.
 //
 void ra_copy_range(roaring_array_t *ra, uint32_t begin, uint32_t end,
                    uint32_t new_begin);
@@ -303,7 +384,8 @@ void ra_copy_range(roaring_array_t *ra, uint32_t begin, uint32_t end,
  * to the right (distance > 0).
  * Allocates memory if necessary.
  * This function doesn't free or create new containers.
- * Caller is responsible for that.
+ * Caller is responsible for that, and for calling ra_reindex_keys once
+ * the keys are set (the key index is dropped).
  */
 void ra_shift_tail(roaring_array_t *ra, int32_t count, int32_t distance);
 
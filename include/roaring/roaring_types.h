@@ -45,4 +45,47 @@ typedef struct roaring_statistics_s {
     // and n_values_arrays, n_values_rle, n_values_bitmap
 } roaring_statistics_t;
 
+/**
+*  (For advanced users.)
+* The strategies available to roaring_bitmap_or_many.
+*/
+typedef enum roaring_union_strategy_e {
+    ROARING_UNION_FOLD,       /* unions the inputs one after the other */
+    ROARING_UNION_HEAP,       /* unions the two smallest bitmaps, repeatedly */
+    ROARING_UNION_HORIZONTAL  /* unions all the containers of a key at once */
+} roaring_union_strategy_t;
+
+/**
+*  (For advanced users.)
+* The roaring_union_plan_t describes the inputs of a union of many bitmaps
+* and the strategy chosen to compute it (see roaring_bitmap_or_many_plan).
+* Costs are estimated in container merges.
+*/
+typedef struct roaring_union_plan_s {
+    roaring_union_strategy_t strategy; /* the cheapest strategy */
+
+    uint64_t n_inputs;            /* number of bitmaps */
+    uint64_t n_containers;        /* number of containers in all inputs */
+    uint64_t n_bitset_containers; /* number of bitmap containers among them */
+    uint32_t n_keys;              /* number of distinct keys */
+    uint32_t key_span;            /* largest key - smallest key + 1 */
+
+    uint64_t fold_cost;       /* estimated cost of ROARING_UNION_FOLD */
+    uint64_t heap_cost;       /* estimated cost of ROARING_UNION_HEAP */
+    uint64_t horizontal_cost; /* estimated cost of ROARING_UNION_HORIZONTAL */
+} roaring_union_plan_t;
+
+/**
+* The comparisons available to roaring_bsi_compare.
+*/
+typedef enum roaring_bsi_operation_e {
+    ROARING_BSI_EQ,    /* value == x */
+    ROARING_BSI_NEQ,   /* value != x */
+    ROARING_BSI_LT,    /* value < x */
+    ROARING_BSI_LE,    /* value <= x */
+    ROARING_BSI_GT,    /* value > x */
+    ROARING_BSI_GE,    /* value >= x */
+    ROARING_BSI_RANGE  /* x <= value <= y */
+} roaring_bsi_operation_t;
+
 #endif /* ROARING_TYPES_H */
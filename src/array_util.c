@@ -10,6 +10,8 @@
 #include <roaring/utilasm.h>
 extern inline int32_t binarySearch(const uint16_t *array, int32_t lenarray,
                                    uint16_t ikey);
+extern inline int32_t branchlessBinarySearch(const uint16_t *array,
+                                             int32_t lenarray, uint16_t ikey);
 
 #ifdef USESSE4
 // used by intersect_vector16
@@ -867,6 +869,101 @@ bool intersect_skewed_uint16_nonempty(const uint16_t *small, size_t size_s,
     return false;
 }
 
+// Gallops from pos (inclusive) to the first index of large holding a value
+// >= val, or size_l.
+static inline size_t skewed_seek(const uint16_t *large, size_t pos,
+                                 size_t size_l, uint16_t val) {
+    if (pos >= size_l || large[pos] >= val) return pos;
+    return (size_t)advanceUntil(large, (int32_t)pos, (int32_t)size_l, val);
+}
+
+int32_t union_skewed_uint16(const uint16_t *small, size_t size_s,
+                            const uint16_t *large, size_t size_l,
+                            uint16_t *buffer) {
+    size_t pos = 0, idx_l = 0;
+    for (size_t idx_s = 0; idx_s < size_s; idx_s++) {
+        const uint16_t val = small[idx_s];
+        const size_t next = skewed_seek(large, idx_l, size_l, val);
+        memmove(buffer + pos, large + idx_l, (next - idx_l) * sizeof(uint16_t));
+        pos += next - idx_l;
+        idx_l = next;
+        if (idx_l < size_l && large[idx_l] == val) idx_l++;
+        buffer[pos++] = val;
+    }
+    memmove(buffer + pos, large + idx_l, (size_l - idx_l) * sizeof(uint16_t));
+    return (int32_t)(pos + size_l - idx_l);
+}
+
+int32_t xor_skewed_uint16(const uint16_t *small, size_t size_s,
+                          const uint16_t *large, size_t size_l,
+                          uint16_t *buffer) {
+    size_t pos = 0, idx_l = 0;
+    for (size_t idx_s = 0; idx_s < size_s; idx_s++) {
+        const uint16_t val = small[idx_s];
+        const size_t next = skewed_seek(large, idx_l, size_l, val);
+        memmove(buffer + pos, large + idx_l, (next - idx_l) * sizeof(uint16_t));
+        pos += next - idx_l;
+        idx_l = next;
+        if (idx_l < size_l && large[idx_l] == val) {
+            idx_l++;
+        } else {
+            buffer[pos++] = val;
+        }
+    }
+    memmove(buffer + pos, large + idx_l, (size_l - idx_l) * sizeof(uint16_t));
+    return (int32_t)(pos + size_l - idx_l);
+}
+
+int32_t difference_skewed_uint16(const uint16_t *set_1, size_t size_1,
+                                 const uint16_t *set_2, size_t size_2,
+                                 uint16_t *buffer) {
+    size_t pos = 0;
+    if (size_1 <= size_2) {
+        // look up each value of set_1 in set_2
+        size_t idx_2 = 0;
+        for (size_t idx_1 = 0; idx_1 < size_1; idx_1++) {
+            const uint16_t val = set_1[idx_1];
+            idx_2 = skewed_seek(set_2, idx_2, size_2, val);
+            if (idx_2 == size_2 || set_2[idx_2] != val) buffer[pos++] = val;
+        }
+        return (int32_t)pos;
+    }
+    // copy set_1 in blocks around the values of set_2; buffer may be set_1
+    size_t idx_1 = 0;
+    for (size_t idx_2 = 0; idx_2 < size_2; idx_2++) {
+        const size_t next = skewed_seek(set_1, idx_1, size_1, set_2[idx_2]);
+        memmove(buffer + pos, set_1 + idx_1, (next - idx_1) * sizeof(uint16_t));
+        pos += next - idx_1;
+        idx_1 = next;
+        if (idx_1 < size_1 && set_1[idx_1] == set_2[idx_2]) idx_1++;
+    }
+    memmove(buffer + pos, set_1 + idx_1, (size_1 - idx_1) * sizeof(uint16_t));
+    return (int32_t)(pos + size_1 - idx_1);
+}
+
+int32_t union_skewed_uint16_inplace(uint16_t *large, size_t size_l,
+                                    const uint16_t *small, size_t size_s) {
+    // first count the new values, so that we know where the result ends
+    size_t newvalues = 0, idx_l = 0;
+    for (size_t idx_s = 0; idx_s < size_s; idx_s++) {
+        idx_l = skewed_seek(large, idx_l, size_l, small[idx_s]);
+        if (idx_l == size_l || large[idx_l] != small[idx_s]) newvalues++;
+    }
+    // then fill in from the back, shifting each block of large only once
+    size_t end = size_l, write = size_l + newvalues;
+    for (size_t idx_s = size_s; idx_s > 0 && write > end; idx_s--) {
+        const uint16_t val = small[idx_s - 1];
+        const int32_t loc = binarySearch(large, (int32_t)end, val);
+        const size_t start = (loc >= 0) ? (size_t)loc + 1 : (size_t)(-loc - 1);
+        memmove(large + write - (end - start), large + start,
+                (end - start) * sizeof(uint16_t));
+        write -= end - start;
+        end = start;
+        if (loc < 0) large[--write] = val;
+    }
+    return (int32_t)(size_l + newvalues);
+}
+
 /**
  * Generic intersection function.
  */
@@ -1118,11 +1215,11 @@ int32_t xor_uint16(const uint16_t *array_1, int32_t card_1,
     }
     if (pos1 < card_1) {
         const size_t n_elems = card_1 - pos1;
-        memcpy(out + pos_out, array_1 + pos1, n_elems * sizeof(uint16_t));
+        memmove(out + pos_out, array_1 + pos1, n_elems * sizeof(uint16_t));
         pos_out += (int32_t)n_elems;
     } else if (pos2 < card_2) {
         const size_t n_elems = card_2 - pos2;
-        memcpy(out + pos_out, array_2 + pos2, n_elems * sizeof(uint16_t));
+        memmove(out + pos_out, array_2 + pos2, n_elems * sizeof(uint16_t));
         pos_out += (int32_t)n_elems;
     }
     return pos_out;
@@ -1546,10 +1643,11 @@ static int uint16_compare(const void *a, const void *b) {
     return (*(uint16_t *)a - *(uint16_t *)b);
 }
 
-// a one-pass SSE union algorithm
-uint32_t union_vector16(const uint16_t *__restrict__ array1, uint32_t length1,
-                        const uint16_t *__restrict__ array2, uint32_t length2,
-                        uint16_t *__restrict__ output) {
+// a one-pass SSE union algorithm; output may overlap a shifted input (see
+// array_util.h)
+uint32_t union_vector16(const uint16_t *array1, uint32_t length1,
+                        const uint16_t *array2, uint32_t length2,
+                        uint16_t *output) {
     if ((length1 < 8) || (length2 < 8)) {
         return (uint32_t)union_uint16(array1, length1, array2, length2, output);
     }
@@ -1667,10 +1765,11 @@ static inline uint32_t unique_xor(uint16_t *out, uint32_t len) {
     return pos;
 }
 
-// a one-pass SSE xor algorithm
-uint32_t xor_vector16(const uint16_t *__restrict__ array1, uint32_t length1,
-                      const uint16_t *__restrict__ array2, uint32_t length2,
-                      uint16_t *__restrict__ output) {
+// a one-pass SSE xor algorithm; output may overlap a shifted input (see
+// array_util.h)
+uint32_t xor_vector16(const uint16_t *array1, uint32_t length1,
+                      const uint16_t *array2, uint32_t length2,
+                      uint16_t *output) {
     if ((length1 < 8) || (length2 < 8)) {
         return xor_uint16(array1, length1, array2, length2, output);
     }
@@ -1744,7 +1843,7 @@ uint32_t xor_vector16(const uint16_t *__restrict__ array1, uint32_t length1,
                (length1 - 8 * len1) * sizeof(uint16_t));
         leftoversize += length1 - 8 * len1;
         if (leftoversize == 0) {  // trivial case
-            memcpy(output, array2 + 8 * pos2,
+            memmove(output, array2 + 8 * pos2,
                    (length2 - 8 * pos2) * sizeof(uint16_t));
             len += (length2 - 8 * pos2);
         } else {
@@ -1758,7 +1857,7 @@ uint32_t xor_vector16(const uint16_t *__restrict__ array1, uint32_t length1,
                (length2 - 8 * len2) * sizeof(uint16_t));
         leftoversize += length2 - 8 * len2;
         if (leftoversize == 0) {  // trivial case
-            memcpy(output, array1 + 8 * pos1,
+            memmove(output, array1 + 8 * pos1,
                    (length1 - 8 * pos1) * sizeof(uint16_t));
             len += (length1 - 8 * pos1);
         } else {
@@ -1918,8 +2017,9 @@ bool memequals(const void *s1, const void *s2, size_t n) {
     }
 
     while (ptr1 < end8) {
-        uint64_t v1 = *((const uint64_t*)ptr1);
-        uint64_t v2 = *((const uint64_t*)ptr2);
+        uint64_t v1, v2;
+        memcpy(&v1, ptr1, sizeof(uint64_t));
+        memcpy(&v2, ptr2, sizeof(uint64_t));
         if (v1 != v2) {
             return false;
         }
@@ -5,6 +5,7 @@
 
 #include <assert.h>
 #include <roaring/containers/array.h>
+#include <roaring/containers/packed.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -140,6 +141,65 @@ void array_container_grow(array_container_t *container, int32_t min,
     assert(container->array != NULL);
 }
 
+/* LSD radix sort of n 16-bit values in two byte-wide passes, using buffer
+ * (room for n values) as scratch space. */
+static void radix_sort_uint16(uint16_t *values, uint16_t *buffer, int32_t n) {
+    int32_t low[256] = {0};
+    int32_t high[256] = {0};
+    for (int32_t i = 0; i < n; i++) {
+        low[values[i] & 0xFF]++;
+        high[values[i] >> 8]++;
+    }
+    int32_t lowsum = 0, highsum = 0;
+    for (int b = 0; b < 256; b++) {
+        const int32_t lowcount = low[b], highcount = high[b];
+        low[b] = lowsum;
+        high[b] = highsum;
+        lowsum += lowcount;
+        highsum += highcount;
+    }
+    for (int32_t i = 0; i < n; i++) buffer[low[values[i] & 0xFF]++] = values[i];
+    for (int32_t i = 0; i < n; i++) values[high[buffer[i] >> 8]++] = buffer[i];
+}
+
+static int array_uint16_compare(const void *a, const void *b) {
+    return (int)*(const uint16_t *)a - (int)*(const uint16_t *)b;
+}
+
+/* Drops the repeated values of a sorted array, returns how many remain. */
+static int32_t unique_uint16(uint16_t *values, int32_t n) {
+    int32_t unique = 1;
+    for (int32_t i = 1; i < n; i++) {
+        if (values[i] != values[unique - 1]) values[unique++] = values[i];
+    }
+    return unique;
+}
+
+void array_container_normalize(array_container_t *arr) {
+    int32_t sorted = 1;
+    while (sorted < arr->cardinality &&
+           arr->array[sorted - 1] < arr->array[sorted]) {
+        sorted++;
+    }
+    if (sorted >= arr->cardinality) return;
+
+    uint16_t *merged = (uint16_t *)malloc(arr->capacity * sizeof(uint16_t));
+    if (merged == NULL) {
+        // without room to merge into, the whole array is sorted in place
+        qsort(arr->array, arr->cardinality, sizeof(uint16_t), array_uint16_compare);
+        arr->cardinality = unique_uint16(arr->array, arr->cardinality);
+        return;
+    }
+    uint16_t *tail = arr->array + sorted;
+    int32_t tail_size = arr->cardinality - sorted;
+    radix_sort_uint16(tail, merged, tail_size);
+    const int32_t unique = unique_uint16(tail, tail_size);
+    arr->cardinality = (int32_t)union_uint16(arr->array, sorted, tail, unique,
+                                             merged);
+    free(arr->array);
+    arr->array = merged;
+}
+
 /* Copy one container into another. We assume that they are distinct. */
 void array_container_copy(const array_container_t *src,
                           array_container_t *dst) {
@@ -171,9 +231,18 @@ void array_container_union(const array_container_t *array_1,
     if (out->capacity < max_cardinality) {
       array_container_grow(out, max_cardinality, false);
     }
-    out->cardinality = (int32_t)fast_union_uint16(array_1->array, card_1,
-                                      array_2->array, card_2, out->array);
-
+    if (card_1 * ARRAY_SKEW_THRESHOLD < card_2) {
+        out->cardinality = union_skewed_uint16(array_1->array, card_1,
+                                               array_2->array, card_2,
+                                               out->array);
+    } else if (card_2 * ARRAY_SKEW_THRESHOLD < card_1) {
+        out->cardinality = union_skewed_uint16(array_2->array, card_2,
+                                               array_1->array, card_1,
+                                               out->array);
+    } else {
+        out->cardinality = (int32_t)fast_union_uint16(
+            array_1->array, card_1, array_2->array, card_2, out->array);
+    }
 }
 
 /* Computes the  difference of array1 and array2 and write the result
@@ -183,8 +252,15 @@ void array_container_union(const array_container_t *array_1,
 void array_container_andnot(const array_container_t *array_1,
                             const array_container_t *array_2,
                             array_container_t *out) {
-    if (out->capacity < array_1->cardinality)
-        array_container_grow(out, array_1->cardinality, false);
+    const int32_t card_1 = array_1->cardinality, card_2 = array_2->cardinality;
+    if (out->capacity < card_1)
+        array_container_grow(out, card_1, false);
+    if (card_1 * ARRAY_SKEW_THRESHOLD < card_2 ||
+        card_2 * ARRAY_SKEW_THRESHOLD < card_1) {
+        out->cardinality = difference_skewed_uint16(
+            array_1->array, card_1, array_2->array, card_2, out->array);
+        return;
+    }
 #ifdef ROARING_VECTOR_OPERATIONS_ENABLED
     out->cardinality =
         difference_vector16(array_1->array, array_1->cardinality,
@@ -209,6 +285,17 @@ void array_container_xor(const array_container_t *array_1,
     if (out->capacity < max_cardinality) {
         array_container_grow(out, max_cardinality, false);
     }
+    if (card_1 * ARRAY_SKEW_THRESHOLD < card_2) {
+        out->cardinality = xor_skewed_uint16(array_1->array, card_1,
+                                             array_2->array, card_2,
+                                             out->array);
+        return;
+    } else if (card_2 * ARRAY_SKEW_THRESHOLD < card_1) {
+        out->cardinality = xor_skewed_uint16(array_2->array, card_2,
+                                             array_1->array, card_1,
+                                             out->array);
+        return;
+    }
 
 #ifdef ROARING_VECTOR_OPERATIONS_ENABLED
     out->cardinality =
@@ -362,12 +449,11 @@ void array_container_printf_as_uint32_array(const array_container_t *v,
 
 /* Compute the number of runs */
 int32_t array_container_number_of_runs(const array_container_t *a) {
-    // Can SIMD work here?
-    int32_t nr_runs = 0;
-    int32_t prev = -2;
-    for (const uint16_t *p = a->array; p != a->array + a->cardinality; ++p) {
-        if (*p != prev + 1) nr_runs++;
-        prev = *p;
+    if (a->cardinality == 0) return 0;
+    // branch-free so that the compiler can vectorize it
+    int32_t nr_runs = 1;
+    for (int32_t i = 1; i < a->cardinality; ++i) {
+        nr_runs += a->array[i] != (uint16_t)(a->array[i - 1] + 1);
     }
     return nr_runs;
 }
@@ -394,6 +480,62 @@ int32_t array_container_write(const array_container_t *container, char *buf) {
     return array_container_size_in_bytes(container);
 }
 
+/* Packs the deltas of the values (see packed.h). If buf is NULL, only counts
+ * the bytes, stopping once limit is reached. */
+static int32_t array_container_pack(const array_container_t *container,
+                                    char *buf, int32_t limit) {
+    uint16_t deltas[PACKED_BLOCK_SIZE];
+    const uint16_t *values = container->array;
+    if (buf != NULL) memcpy(buf, values, sizeof(uint16_t));
+    int32_t bytes = sizeof(uint16_t);
+    for (int32_t i = 1; i < container->cardinality; i += PACKED_BLOCK_SIZE) {
+        const int32_t remaining = container->cardinality - i;
+        const int32_t n =
+            remaining < PACKED_BLOCK_SIZE ? remaining : PACKED_BLOCK_SIZE;
+        for (int32_t j = 0; j < n; ++j) {
+            deltas[j] = (uint16_t)(values[i + j] - values[i + j - 1] - 1);
+        }
+        if (buf != NULL) {
+            bytes += packed_block_write(deltas, n, buf + bytes);
+        } else {
+            bytes += packed_block_size(deltas, n);
+            if (bytes >= limit) return limit;
+        }
+    }
+    return (buf == NULL && bytes >= limit) ? limit : bytes;
+}
+
+int32_t array_container_packed_size_in_bytes(const array_container_t *container,
+                                             int32_t limit) {
+    return array_container_pack(container, NULL, limit);
+}
+
+int32_t array_container_write_packed(const array_container_t *container,
+                                     char *buf) {
+    return array_container_pack(container, buf, INT32_MAX);
+}
+
+int32_t array_container_read_packed(int32_t cardinality,
+                                    array_container_t *container,
+                                    const char *buf) {
+    uint16_t first;
+    memcpy(&first, buf, sizeof(first));
+    container->array[0] = first;
+    int32_t bytes = sizeof(first);
+    uint32_t previous = first;
+    for (int32_t i = 1; i < cardinality; i += PACKED_BLOCK_SIZE) {
+        const int32_t remaining = cardinality - i;
+        const int32_t n =
+            remaining < PACKED_BLOCK_SIZE ? remaining : PACKED_BLOCK_SIZE;
+        // the deltas are unpacked in place, then summed
+        bytes += packed_block_read(n, container->array + i, buf + bytes);
+        previous = packed_deltas_to_values(container->array + i, n, previous);
+        if (previous > UINT16_MAX) return -1;
+    }
+    container->cardinality = cardinality;
+    return bytes;
+}
+
 bool array_container_is_subset(const array_container_t *container1,
                                const array_container_t *container2) {
     if (container1->cardinality > container2->cardinality) {
@@ -12,6 +12,7 @@
 
 #include <roaring/bitset_util.h>
 #include <roaring/containers/bitset.h>
+#include <roaring/containers/perfparameters.h>
 #include <roaring/portability.h>
 #include <roaring/utilasm.h>
 
@@ -429,8 +430,120 @@ BITSET_CONTAINER_FN(intersection, &, _mm256_and_si256, vandq_u64)
 
 BITSET_CONTAINER_FN(xor,    ^,  _mm256_xor_si256,    veorq_u64)
 BITSET_CONTAINER_FN(andnot, &~, _mm256_andnot_si256, vbicq_u64)
+
+#ifdef USEAVX
+
+/* The bits of w that start a run, i.e. that are set while the bit before them
+   is clear; prev is the 256-bit word before w. */
+static inline __m256i avx2_run_starts(__m256i w, __m256i prev) {
+    /* [prev[3], w[0], w[1], w[2]] as 64-bit words */
+    const __m256i before =
+        _mm256_alignr_epi8(w, _mm256_permute2x128_si256(prev, w, 0x21), 8);
+    return _mm256_andnot_si256(
+        _mm256_or_si256(_mm256_slli_epi64(w, 1), _mm256_srli_epi64(before, 63)),
+        w);
+}
+
+static inline int32_t avx2_sum_epi64(__m256i v) {
+    return (int32_t)(_mm256_extract_epi64(v, 0) + _mm256_extract_epi64(v, 1) +
+                     _mm256_extract_epi64(v, 2) + _mm256_extract_epi64(v, 3));
+}
+
+/* Same as bitset_container_##opname, but also counts the runs of the result
+   in the same pass, for auto-run. dst may be src_1. */
+#define BITSET_CONTAINER_RUNS_FN(opname, opsymbol, avx_intrinsic)             \
+int bitset_container_##opname##_runs(const bitset_container_t *src_1,         \
+                                     const bitset_container_t *src_2,         \
+                                     bitset_container_t *dst,                 \
+                                     int32_t *n_runs) {                       \
+    const __m256i *array_1 = (const __m256i *)src_1->array;                   \
+    const __m256i *array_2 = (const __m256i *)src_2->array;                   \
+    __m256i *out = (__m256i *)dst->array;                                     \
+    __m256i card = _mm256_setzero_si256();                                    \
+    __m256i runs = _mm256_setzero_si256();                                    \
+    __m256i prev = _mm256_setzero_si256();                                    \
+    for (size_t i = 0;                                                        \
+         i < BITSET_CONTAINER_SIZE_IN_WORDS / (WORDS_IN_AVX2_REG); i++) {     \
+        const __m256i w = avx_intrinsic(_mm256_lddqu_si256(array_2 + i),      \
+                                        _mm256_lddqu_si256(array_1 + i));     \
+        _mm256_storeu_si256(out + i, w);                                      \
+        card = _mm256_add_epi64(card, popcount256(w));                        \
+        runs = _mm256_add_epi64(runs, popcount256(avx2_run_starts(w, prev))); \
+        prev = w;                                                             \
+    }                                                                         \
+    *n_runs = avx2_sum_epi64(runs);                                           \
+    dst->cardinality = avx2_sum_epi64(card);                                  \
+    return dst->cardinality;                                                  \
+}
+
+#else /* not USEAVX  */
+
+/* Same as bitset_container_##opname, but also counts the runs of the result
+   in the same pass, for auto-run: a run starts at each set bit whose
+   predecessor is clear. dst may be src_1. */
+#define BITSET_CONTAINER_RUNS_FN(opname, opsymbol, avx_intrinsic)             \
+int bitset_container_##opname##_runs(const bitset_container_t *src_1,         \
+                                     const bitset_container_t *src_2,         \
+                                     bitset_container_t *dst,                 \
+                                     int32_t *n_runs) {                       \
+    const uint64_t *array_1 = src_1->array;                                   \
+    const uint64_t *array_2 = src_2->array;                                   \
+    uint64_t *out = dst->array;                                               \
+    int32_t sum = 0;                                                          \
+    int32_t runs = 0;                                                         \
+    uint64_t carry = 0; /* last bit of the previous word */                   \
+    for (size_t i = 0; i < BITSET_CONTAINER_SIZE_IN_WORDS; i++) {             \
+        const uint64_t word = (array_1[i])opsymbol(array_2[i]);               \
+        out[i] = word;                                                        \
+        sum += hamming(word);                                                 \
+        runs += hamming(word & ~((word << 1) | carry));                       \
+        carry = word >> 63;                                                   \
+    }                                                                         \
+    *n_runs = runs;                                                           \
+    dst->cardinality = sum;                                                   \
+    return dst->cardinality;                                                  \
+}
+
+#endif
+
+BITSET_CONTAINER_RUNS_FN(or,     |,  _mm256_or_si256)
+BITSET_CONTAINER_RUNS_FN(and,    &,  _mm256_and_si256)
+BITSET_CONTAINER_RUNS_FN(xor,    ^,  _mm256_xor_si256)
+BITSET_CONTAINER_RUNS_FN(andnot, &~, _mm256_andnot_si256)
 // clang-format On
 
+/* Combines n bitsets into dst, one block of words at a time: the block of dst
+   stays in L1 cache while the inputs stream through it, two at a time. The
+   inner loops are left to the auto-vectorizer. */
+#define BITSET_CONTAINER_MANY_FN(opname, opsymbol)                            \
+void bitset_container_##opname##_many(bitset_container_t *dst,                \
+                                      const bitset_container_t *const *srcs,  \
+                                      int32_t n) {                            \
+    for (int32_t block = 0; block < BITSET_CONTAINER_SIZE_IN_WORDS;           \
+         block += BITSET_MANY_BLOCK_WORDS) {                                  \
+        uint64_t *__restrict__ out = dst->array + block;                      \
+        int32_t i = 0;                                                        \
+        for (; i + 1 < n; i += 2) {                                           \
+            const uint64_t *__restrict__ in_1 = srcs[i]->array + block;       \
+            const uint64_t *__restrict__ in_2 = srcs[i + 1]->array + block;   \
+            for (int32_t j = 0; j < BITSET_MANY_BLOCK_WORDS; j++) {           \
+                out[j] = out[j] opsymbol (in_1[j] opsymbol in_2[j]);          \
+            }                                                                 \
+        }                                                                     \
+        if (i < n) {                                                          \
+            const uint64_t *__restrict__ in = srcs[i]->array + block;         \
+            for (int32_t j = 0; j < BITSET_MANY_BLOCK_WORDS; j++) {           \
+                out[j] = out[j] opsymbol in[j];                               \
+            }                                                                 \
+        }                                                                     \
+    }                                                                         \
+    dst->cardinality = BITSET_UNKNOWN_CARDINALITY;                            \
+}
+
+BITSET_CONTAINER_MANY_FN(or,  |)
+BITSET_CONTAINER_MANY_FN(xor, ^)
+BITSET_CONTAINER_MANY_FN(and, &)
+
 
 
 int bitset_container_to_uint32_array( void *vout, const bitset_container_t *cont, uint32_t base) {
@@ -495,6 +608,18 @@ void bitset_container_printf_as_uint32_array(const bitset_container_t * v, uint3
 
 // TODO: use the fast lower bound, also
 int bitset_container_number_of_runs(bitset_container_t *b) {
+#ifdef USEAVX
+  const __m256i *words = (const __m256i *)b->array;
+  __m256i runs = _mm256_setzero_si256();
+  __m256i prev = _mm256_setzero_si256();
+  for (size_t i = 0; i < BITSET_CONTAINER_SIZE_IN_WORDS / (WORDS_IN_AVX2_REG);
+       i++) {
+    const __m256i w = _mm256_lddqu_si256(words + i);
+    runs = _mm256_add_epi64(runs, popcount256(avx2_run_starts(w, prev)));
+    prev = w;
+  }
+  return avx2_sum_epi64(runs);
+#else
   int num_runs = 0;
   uint64_t next_word = b->array[0];
 
@@ -509,6 +634,7 @@ int bitset_container_number_of_runs(bitset_container_t *b) {
   if((word & 0x8000000000000000ULL) != 0)
     num_runs++;
   return num_runs;
+#endif
 }
 
 int32_t bitset_container_serialize(const bitset_container_t *container, char *buf) {
@@ -601,8 +727,8 @@ bool bitset_container_equals(const bitset_container_t *container1, const bitset_
   const __m256i *ptr1 = (const __m256i*)container1->array;
   const __m256i *ptr2 = (const __m256i*)container2->array;
   for (size_t i = 0; i < BITSET_CONTAINER_SIZE_IN_WORDS*sizeof(uint64_t)/32; i++) {
-      __m256i r1 = _mm256_load_si256(ptr1+i);
-      __m256i r2 = _mm256_load_si256(ptr2+i);
+      __m256i r1 = _mm256_lddqu_si256(ptr1+i);
+      __m256i r2 = _mm256_lddqu_si256(ptr2+i);
       int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(r1, r2));
       if ((uint32_t)mask != UINT32_MAX) {
           return false;
@@ -245,6 +245,365 @@ void shared_container_free(shared_container_t *container) {
     }
 }
 
+static inline bool bitset_words_full(const uint64_t *words) {
+    for (int32_t i = 0; i < BITSET_CONTAINER_SIZE_IN_WORDS; i++) {
+        if (words[i] != UINT64_MAX) return false;
+    }
+    return true;
+}
+
+// Combines the bitsets among the n containers into dst with kernel (one of
+// the n-ary bitset operations), passing them by chunks.
+static void bitsets_many(bitset_container_t *dst,
+                         const void *const *containers,
+                         const uint8_t *typecodes, int32_t n,
+                         void (*kernel)(bitset_container_t *,
+                                        const bitset_container_t *const *,
+                                        int32_t)) {
+    const bitset_container_t *chunk[32];
+    int32_t size = 0;
+    for (int32_t i = 0; i < n; i++) {
+        uint8_t type = typecodes[i];
+        const void *c = container_unwrap_shared(containers[i], &type);
+        if (type != BITSET_CONTAINER_TYPE_CODE) continue;
+        chunk[size++] = (const bitset_container_t *)c;
+        if (size == 32) {
+            kernel(dst, chunk, size);
+            size = 0;
+        }
+    }
+    if (size > 0) kernel(dst, chunk, size);
+}
+
+// converts the result of an n-ary operation to an array when it is small
+static void *bitset_many_result(bitset_container_t *bitset,
+                                uint8_t *result_type) {
+    bitset->cardinality = bitset_container_compute_cardinality(bitset);
+    if (bitset->cardinality <= DEFAULT_MAX_SIZE) {
+        array_container_t *array = array_container_from_bitset(bitset);
+        bitset_container_free(bitset);
+        if (array == NULL) return NULL;
+        *result_type = ARRAY_CONTAINER_TYPE_CODE;
+        return array;
+    }
+    *result_type = BITSET_CONTAINER_TYPE_CODE;
+    return bitset;
+}
+
+// successive operations on containers cost about n times the final
+// cardinality, which is bounded by the sum of the input cardinalities; this
+// is only worth it when that stays below the size of a bitset
+static bool containers_many_small(const void *const *containers,
+                                  const uint8_t *typecodes, int32_t n) {
+    uint64_t cardinality = 0;
+    for (int32_t i = 0; i < n; i++) {
+        cardinality += container_get_cardinality(containers[i], typecodes[i]);
+        if (cardinality * (n - 1) > DEFAULT_MAX_SIZE) return false;
+    }
+    return true;
+}
+
+void *container_or_many(const void *const *containers, const uint8_t *typecodes,
+                        int32_t n, uint8_t *result_type) {
+    for (int32_t i = 0; i < n; i++) {
+        uint8_t type = typecodes[i];
+        const void *c = container_unwrap_shared(containers[i], &type);
+        if (container_is_full(c, type)) {
+            *result_type = type;
+            return container_clone(c, type);
+        }
+    }
+    if (containers_many_small(containers, typecodes, n)) {
+        void *answer = container_or(containers[0], typecodes[0], containers[1],
+                                    typecodes[1], result_type);
+        for (int32_t i = 2; i < n; i++) {
+            uint8_t type = 0;
+            void *c = container_ior(answer, *result_type, containers[i],
+                                    typecodes[i], &type);
+            if (c != answer) {
+                container_free(answer, *result_type);
+            }
+            answer = c;
+            *result_type = type;
+        }
+        return answer;
+    }
+    bitset_container_t *bitset = bitset_container_create();
+    if (bitset == NULL) return NULL;
+    bitsets_many(bitset, containers, typecodes, n, bitset_container_or_many);
+    // unions often saturate, which is cheap to check as the scan stops at the
+    // first missing value
+    bool full = bitset_words_full(bitset->array);
+    for (int32_t i = 0; i < n && !full; i++) {
+        uint8_t type = typecodes[i];
+        const void *c = container_unwrap_shared(containers[i], &type);
+        if (type == ARRAY_CONTAINER_TYPE_CODE) {
+            const array_container_t *array = (const array_container_t *)c;
+            bitset_set_list(bitset->array, array->array, array->cardinality);
+        } else if (type == RUN_CONTAINER_TYPE_CODE) {
+            run_bitset_container_lazy_union((const run_container_t *)c,
+                                            bitset, bitset);
+        } else {
+            continue;
+        }
+        full = bitset_words_full(bitset->array);
+    }
+    if (full) {
+        bitset_container_free(bitset);
+        *result_type = RUN_CONTAINER_TYPE_CODE;
+        return run_container_create_range(0, (1 << 16));
+    }
+    return bitset_many_result(bitset, result_type);
+}
+
+void *container_xor_many(const void *const *containers,
+                         const uint8_t *typecodes, int32_t n,
+                         uint8_t *result_type) {
+    if (containers_many_small(containers, typecodes, n)) {
+        void *answer = container_xor(containers[0], typecodes[0], containers[1],
+                                     typecodes[1], result_type);
+        for (int32_t i = 2; i < n; i++) {
+            uint8_t type = 0;
+            answer = container_ixor(answer, *result_type, containers[i],
+                                    typecodes[i], &type);
+            *result_type = type;
+        }
+        return answer;
+    }
+    bitset_container_t *bitset = bitset_container_create();
+    if (bitset == NULL) return NULL;
+    bitsets_many(bitset, containers, typecodes, n, bitset_container_xor_many);
+    for (int32_t i = 0; i < n; i++) {
+        uint8_t type = typecodes[i];
+        const void *c = container_unwrap_shared(containers[i], &type);
+        if (type == ARRAY_CONTAINER_TYPE_CODE) {
+            const array_container_t *array = (const array_container_t *)c;
+            bitset_flip_list(bitset->array, array->array, array->cardinality);
+        } else if (type == RUN_CONTAINER_TYPE_CODE) {
+            const run_container_t *run = (const run_container_t *)c;
+            for (int32_t r = 0; r < run->n_runs; r++) {
+                const uint32_t start = run->runs[r].value;
+                bitset_flip_range(bitset->array, start,
+                                  start + run->runs[r].length + 1);
+            }
+        }
+    }
+    return bitset_many_result(bitset, result_type);
+}
+
+// slice s of the initial value of the counters, for all the values of a word
+static inline uint64_t counters_initial_word(
+    const container_counters_t *counters, int32_t s) {
+    const uint64_t initial =
+        (UINT64_C(1) << counters->n_slices) - counters->threshold;
+    return ((initial >> s) & 1) ? UINT64_MAX : 0;
+}
+
+bool container_counters_init(container_counters_t *counters,
+                             uint32_t threshold) {
+    assert(threshold >= 2);
+    int32_t n_slices = 0;
+    while ((UINT64_C(1) << n_slices) < threshold) n_slices++;
+    counters->threshold = threshold;
+    counters->n_slices = n_slices;
+    counters->slices = (uint64_t *)malloc(
+        (size_t)n_slices * BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t));
+    counters->reached =
+        (uint64_t *)calloc(BITSET_CONTAINER_SIZE_IN_WORDS, sizeof(uint64_t));
+    if (counters->slices == NULL || counters->reached == NULL) {
+        container_counters_free(counters);
+        return false;
+    }
+    for (int32_t s = 0; s < n_slices; s++) {
+        memset(counters->slices + s * BITSET_CONTAINER_SIZE_IN_WORDS,
+               (int)(counters_initial_word(counters, s) & 0xFF),
+               BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t));
+    }
+    memset(counters->dirty, 0, sizeof(counters->dirty));
+    return true;
+}
+
+void container_counters_free(container_counters_t *counters) {
+    free(counters->slices);
+    free(counters->reached);
+    counters->slices = NULL;
+    counters->reached = NULL;
+}
+
+// adds one to the counters of word w selected by mask, without branching on
+// the carry (sparse additions are too irregular to predict)
+static inline void counters_add_word(container_counters_t *counters,
+                                     uint32_t w, uint64_t mask) {
+    uint64_t carry = mask;
+    uint64_t *slice = counters->slices + w;
+    for (int32_t s = 0; s < counters->n_slices;
+         s++, slice += BITSET_CONTAINER_SIZE_IN_WORDS) {
+        const uint64_t next = *slice & carry;
+        *slice ^= carry;
+        carry = next;
+    }
+    counters->reached[w] |= carry;
+    counters->dirty[w / 64] |= UINT64_C(1) << (w % 64);
+}
+
+// Adds the words [begin, end) of a bitset (all ones if words is NULL) to the
+// counters with carry-save adders, one block at a time, stopping as soon as
+// no carry is left.
+static void counters_add_words(container_counters_t *counters,
+                               const uint64_t *words, uint32_t begin,
+                               uint32_t end) {
+    uint64_t carry[BITSET_MANY_BLOCK_WORDS];
+    for (uint32_t block = begin; block < end;
+         block += BITSET_MANY_BLOCK_WORDS) {
+        const uint32_t length = end - block < BITSET_MANY_BLOCK_WORDS
+                                    ? end - block
+                                    : BITSET_MANY_BLOCK_WORDS;
+        if (words == NULL) {
+            memset(carry, 0xFF, length * sizeof(uint64_t));
+        } else {
+            memcpy(carry, words + block, length * sizeof(uint64_t));
+        }
+        for (int32_t s = 0; s < counters->n_slices; s++) {
+            uint64_t *slice =
+                counters->slices + s * BITSET_CONTAINER_SIZE_IN_WORDS + block;
+            uint64_t any = 0;
+            for (uint32_t j = 0; j < length; j++) {
+                const uint64_t next = slice[j] & carry[j];
+                slice[j] ^= carry[j];
+                carry[j] = next;
+                any |= next;
+            }
+            if (any == 0) break;
+        }
+        uint64_t *reached = counters->reached + block;
+        for (uint32_t j = 0; j < length; j++) {
+            reached[j] |= carry[j];
+        }
+    }
+    bitset_set_range(counters->dirty, begin, end);
+}
+
+static void counters_add_array(container_counters_t *counters,
+                               const array_container_t *array) {
+    for (int32_t i = 0; i < array->cardinality; i++) {
+        const uint16_t v = array->array[i];
+        counters_add_word(counters, v / 64, UINT64_C(1) << (v % 64));
+    }
+}
+
+static void counters_add_run(container_counters_t *counters,
+                             const run_container_t *run) {
+    for (int32_t r = 0; r < run->n_runs; r++) {
+        const uint32_t start = run->runs[r].value;
+        const uint32_t end = start + run->runs[r].length;  // inclusive
+        const uint64_t first = UINT64_MAX << (start % 64);
+        const uint64_t last = UINT64_MAX >> (63 - end % 64);
+        if (start / 64 == end / 64) {
+            counters_add_word(counters, start / 64, first & last);
+            continue;
+        }
+        counters_add_word(counters, start / 64, first);
+        counters_add_words(counters, NULL, start / 64 + 1, end / 64);
+        counters_add_word(counters, end / 64, last);
+    }
+}
+
+// extracts the values that reached the threshold and resets the counters
+static void *counters_result(container_counters_t *counters,
+                             uint8_t *result_type) {
+    int32_t cardinality = 0;
+    for (int32_t i = 0; i < BITSET_CONTAINER_SIZE_IN_WORDS / 64; i++) {
+        for (uint64_t d = counters->dirty[i]; d != 0; d &= d - 1) {
+            const uint32_t w = i * 64 + __builtin_ctzll(d);
+            cardinality += hamming(counters->reached[w]);
+        }
+    }
+    void *answer = NULL;
+    if (cardinality == (1 << 16)) {
+        *result_type = RUN_CONTAINER_TYPE_CODE;
+        answer = run_container_create_range(0, (1 << 16));
+    } else if (cardinality > DEFAULT_MAX_SIZE) {
+        bitset_container_t *bitset = bitset_container_create();
+        if (bitset != NULL) {
+            memcpy(bitset->array, counters->reached,
+                   BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t));
+            bitset->cardinality = cardinality;
+        }
+        *result_type = BITSET_CONTAINER_TYPE_CODE;
+        answer = bitset;
+    } else {
+        array_container_t *array =
+            array_container_create_given_capacity(cardinality);
+        if (array != NULL) {
+            for (int32_t i = 0; i < BITSET_CONTAINER_SIZE_IN_WORDS / 64; i++) {
+                for (uint64_t d = counters->dirty[i]; d != 0; d &= d - 1) {
+                    const uint32_t w = i * 64 + __builtin_ctzll(d);
+                    for (uint64_t word = counters->reached[w]; word != 0;
+                         word &= word - 1) {
+                        array->array[array->cardinality++] =
+                            (uint16_t)(w * 64 + __builtin_ctzll(word));
+                    }
+                }
+            }
+        }
+        *result_type = ARRAY_CONTAINER_TYPE_CODE;
+        answer = array;
+    }
+    for (int32_t i = 0; i < BITSET_CONTAINER_SIZE_IN_WORDS / 64; i++) {
+        for (uint64_t d = counters->dirty[i]; d != 0; d &= d - 1) {
+            const uint32_t w = i * 64 + __builtin_ctzll(d);
+            counters->reached[w] = 0;
+            for (int32_t s = 0; s < counters->n_slices; s++) {
+                counters->slices[s * BITSET_CONTAINER_SIZE_IN_WORDS + w] =
+                    counters_initial_word(counters, s);
+            }
+        }
+        counters->dirty[i] = 0;
+    }
+    return answer;
+}
+
+void *container_threshold_many(const void *const *containers,
+                               const uint8_t *typecodes, int32_t n,
+                               container_counters_t *counters,
+                               uint8_t *result_type) {
+    bool all_bitsets = true;
+    for (int32_t i = 0; i < n; i++) {
+        all_bitsets = all_bitsets && get_container_type(containers[i],
+                                                        typecodes[i]) ==
+                                         BITSET_CONTAINER_TYPE_CODE;
+    }
+    if ((uint32_t)n == counters->threshold && all_bitsets) {
+        // an intersection
+        bitset_container_t *bitset = bitset_container_create();
+        if (bitset == NULL) return NULL;
+        bitset_container_set_all(bitset);
+        bitsets_many(bitset, containers, typecodes, n,
+                     bitset_container_and_many);
+        return bitset_many_result(bitset, result_type);
+    }
+    for (int32_t i = 0; i < n; i++) {
+        uint8_t type = typecodes[i];
+        const void *c = container_unwrap_shared(containers[i], &type);
+        switch (type) {
+            case BITSET_CONTAINER_TYPE_CODE:
+                counters_add_words(counters,
+                                   ((const bitset_container_t *)c)->array, 0,
+                                   BITSET_CONTAINER_SIZE_IN_WORDS);
+                break;
+            case ARRAY_CONTAINER_TYPE_CODE:
+                counters_add_array(counters, (const array_container_t *)c);
+                break;
+            default:
+                counters_add_run(counters, (const run_container_t *)c);
+        }
+        // once all values are reached, the remaining inputs cannot matter;
+        // the scan usually stops at the first word
+        if (bitset_words_full(counters->reached)) break;
+    }
+    return counters_result(counters, result_type);
+}
+
 extern inline void *container_not(const void *c1, uint8_t type1, uint8_t *result_type);
 
 extern inline void *container_not_range(const void *c1, uint8_t type1,
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <string.h>
 
 #include <roaring/bitset_util.h>
 #include <roaring/containers/containers.h>
@@ -43,6 +44,7 @@ array_container_t *array_container_from_run(const run_container_t *arr) {
 array_container_t *array_container_from_bitset(const bitset_container_t *bits) {
     array_container_t *result =
         array_container_create_given_capacity(bits->cardinality);
+    if (result == NULL) return NULL;
     result->cardinality = bits->cardinality;
     //  sse version ends up being slower here
     // (bitset_extract_setbits_sse_uint16)
@@ -177,6 +179,46 @@ void *convert_run_to_efficient_container_and_free(run_container_t *c,
     return answer;
 }
 
+/* Builds the run container holding the values of a non-empty bitset that has
+   n_runs runs. The bitset is not freed or modified. */
+static run_container_t *run_container_from_bitset_given_runs(
+    const bitset_container_t *bits, int32_t n_runs) {
+    // bitset to runcontainer (ported from Java  RunContainer(
+    // BitmapContainer bc, int nbrRuns))
+    assert(n_runs > 0);  // no empty bitmaps
+    run_container_t *answer = run_container_create_given_capacity(n_runs);
+    if (answer == NULL) return NULL;
+
+    int long_ctr = 0;
+    uint64_t cur_word = bits->array[0];
+    while (true) {
+        while (cur_word == UINT64_C(0) &&
+               long_ctr < BITSET_CONTAINER_SIZE_IN_WORDS - 1)
+            cur_word = bits->array[++long_ctr];
+
+        if (cur_word == UINT64_C(0)) return answer;
+
+        int local_run_start = __builtin_ctzll(cur_word);
+        int run_start = local_run_start + 64 * long_ctr;
+        uint64_t cur_word_with_1s = cur_word | (cur_word - 1);
+
+        int run_end = 0;
+        while (cur_word_with_1s == UINT64_C(0xFFFFFFFFFFFFFFFF) &&
+               long_ctr < BITSET_CONTAINER_SIZE_IN_WORDS - 1)
+            cur_word_with_1s = bits->array[++long_ctr];
+
+        if (cur_word_with_1s == UINT64_C(0xFFFFFFFFFFFFFFFF)) {
+            run_end = 64 + long_ctr * 64;  // exclusive, I guess
+            add_run(answer, run_start, run_end - 1);
+            return answer;
+        }
+        int local_run_end = __builtin_ctzll(~cur_word_with_1s);
+        run_end = local_run_end + long_ctr * 64;
+        add_run(answer, run_start, run_end - 1);
+        cur_word = cur_word_with_1s & (cur_word_with_1s + 1);
+    }
+}
+
 /* once converted, the original container is disposed here, rather than
    in roaring_array
 */
@@ -243,47 +285,14 @@ void *convert_run_optimize(void *c, uint8_t typecode_original,
             *typecode_after = BITSET_CONTAINER_TYPE_CODE;
             return c;
         }
-        // bitset to runcontainer (ported from Java  RunContainer(
-        // BitmapContainer bc, int nbrRuns))
-        assert(n_runs > 0);  // no empty bitmaps
-        run_container_t *answer = run_container_create_given_capacity(n_runs);
-
-        int long_ctr = 0;
-        uint64_t cur_word = c_qua_bitset->array[0];
-        int run_count = 0;
-        while (true) {
-            while (cur_word == UINT64_C(0) &&
-                   long_ctr < BITSET_CONTAINER_SIZE_IN_WORDS - 1)
-                cur_word = c_qua_bitset->array[++long_ctr];
-
-            if (cur_word == UINT64_C(0)) {
-                bitset_container_free(c_qua_bitset);
-                *typecode_after = RUN_CONTAINER_TYPE_CODE;
-                return answer;
-            }
-
-            int local_run_start = __builtin_ctzll(cur_word);
-            int run_start = local_run_start + 64 * long_ctr;
-            uint64_t cur_word_with_1s = cur_word | (cur_word - 1);
-
-            int run_end = 0;
-            while (cur_word_with_1s == UINT64_C(0xFFFFFFFFFFFFFFFF) &&
-                   long_ctr < BITSET_CONTAINER_SIZE_IN_WORDS - 1)
-                cur_word_with_1s = c_qua_bitset->array[++long_ctr];
-
-            if (cur_word_with_1s == UINT64_C(0xFFFFFFFFFFFFFFFF)) {
-                run_end = 64 + long_ctr * 64;  // exclusive, I guess
-                add_run(answer, run_start, run_end - 1);
-                bitset_container_free(c_qua_bitset);
-                *typecode_after = RUN_CONTAINER_TYPE_CODE;
-                return answer;
-            }
-            int local_run_end = __builtin_ctzll(~cur_word_with_1s);
-            run_end = local_run_end + long_ctr * 64;
-            add_run(answer, run_start, run_end - 1);
-            run_count++;
-            cur_word = cur_word_with_1s & (cur_word_with_1s + 1);
+        run_container_t *answer =
+            run_container_from_bitset_given_runs(c_qua_bitset, n_runs);
+        if (answer == NULL) {  // keep the bitset
+            *typecode_after = BITSET_CONTAINER_TYPE_CODE;
+            return c;
         }
+        bitset_container_free(c_qua_bitset);
+        *typecode_after = RUN_CONTAINER_TYPE_CODE;
         return answer;
     } else {
         assert(false);
@@ -292,6 +301,42 @@ void *convert_run_optimize(void *c, uint8_t typecode_original,
     }
 }
 
+void *convert_bitset_run_optimize(bitset_container_t *c, int32_t n_runs,
+                                  uint8_t *typecode_after) {
+    const int32_t card = c->cardinality;
+    const int32_t size_as_run_container =
+        run_container_serialized_size_in_bytes(n_runs);
+    if (card <= DEFAULT_MAX_SIZE) {
+        void *answer;
+        if (card > 0 && size_as_run_container <
+                            array_container_serialized_size_in_bytes(card)) {
+            answer = run_container_from_bitset_given_runs(c, n_runs);
+            *typecode_after = RUN_CONTAINER_TYPE_CODE;
+        } else {
+            answer = array_container_from_bitset(c);
+            *typecode_after = ARRAY_CONTAINER_TYPE_CODE;
+        }
+        if (answer == NULL) {  // keep the bitset
+            *typecode_after = BITSET_CONTAINER_TYPE_CODE;
+            return c;
+        }
+        bitset_container_free(c);
+        return answer;
+    }
+    if (bitset_container_serialized_size_in_bytes() <= size_as_run_container) {
+        *typecode_after = BITSET_CONTAINER_TYPE_CODE;
+        return c;
+    }
+    run_container_t *answer = run_container_from_bitset_given_runs(c, n_runs);
+    if (answer == NULL) {
+        *typecode_after = BITSET_CONTAINER_TYPE_CODE;
+        return c;
+    }
+    bitset_container_free(c);
+    *typecode_after = RUN_CONTAINER_TYPE_CODE;
+    return answer;
+}
+
 bitset_container_t *bitset_container_from_run_range(const run_container_t *run,
                                                     uint32_t min, uint32_t max) {
     bitset_container_t *bitset = bitset_container_create();
@@ -308,3 +353,79 @@ bitset_container_t *bitset_container_from_run_range(const run_container_t *run,
     bitset->cardinality = union_cardinality;
     return bitset;
 }
+
+/* Walks the values of the bitset and packs their deltas (see packed.h). If buf
+ * is NULL, only counts the bytes, stopping once limit is reached. */
+static int32_t bitset_container_pack(const bitset_container_t *bits, char *buf,
+                                     int32_t limit) {
+    uint16_t deltas[PACKED_BLOCK_SIZE];
+    int32_t n = 0;
+    int32_t bytes = 0;
+    int32_t previous = -1;
+    for (int32_t i = 0; i < BITSET_CONTAINER_SIZE_IN_WORDS; ++i) {
+        uint64_t w = bits->array[i];
+        while (w != 0) {
+            const int32_t value = i * 64 + __builtin_ctzll(w);
+            w &= w - 1;
+            if (previous < 0) {
+                if (buf != NULL) {
+                    const uint16_t first = (uint16_t)value;
+                    memcpy(buf, &first, sizeof(first));
+                }
+                bytes = sizeof(uint16_t);
+            } else {
+                deltas[n++] = (uint16_t)(value - previous - 1);
+                if (n == PACKED_BLOCK_SIZE) {
+                    if (buf != NULL) {
+                        bytes += packed_block_write(deltas, n, buf + bytes);
+                    } else {
+                        bytes += packed_block_size(deltas, n);
+                        if (bytes >= limit) return limit;
+                    }
+                    n = 0;
+                }
+            }
+            previous = value;
+        }
+    }
+    if (n > 0) {
+        bytes += (buf != NULL) ? packed_block_write(deltas, n, buf + bytes)
+                               : packed_block_size(deltas, n);
+    }
+    return (buf == NULL && bytes >= limit) ? limit : bytes;
+}
+
+int32_t bitset_container_packed_size_in_bytes(const bitset_container_t *bits,
+                                              int32_t limit) {
+    return bitset_container_pack(bits, NULL, limit);
+}
+
+int32_t bitset_container_write_packed(const bitset_container_t *bits,
+                                      char *buf) {
+    return bitset_container_pack(bits, buf, INT32_MAX);
+}
+
+int32_t bitset_container_read_packed(int32_t cardinality,
+                                     bitset_container_t *bits,
+                                     const char *buf) {
+    uint16_t deltas[PACKED_BLOCK_SIZE];
+    uint16_t first;
+    memcpy(&first, buf, sizeof(first));
+    int32_t bytes = sizeof(first);
+    bitset_container_clear(bits);
+    uint32_t value = first;
+    bitset_container_set(bits, (uint16_t)value);
+    for (int32_t remaining = cardinality - 1; remaining > 0;
+         remaining -= PACKED_BLOCK_SIZE) {
+        const int32_t n =
+            remaining < PACKED_BLOCK_SIZE ? remaining : PACKED_BLOCK_SIZE;
+        bytes += packed_block_read(n, deltas, buf + bytes);
+        value = packed_deltas_to_values(deltas, n, value);
+        if (value > UINT16_MAX) return -1;
+        for (int32_t i = 0; i < n; ++i) {
+            bits->array[deltas[i] >> 6] |= UINT64_C(1) << (deltas[i] & 63);
+        }
+    }
+    bits->cardinality = cardinality;
+    return bytes;
+}
@@ -11,6 +11,7 @@
 #include <roaring/containers/containers.h>
 #include <roaring/containers/convert.h>
 #include <roaring/containers/mixed_andnot.h>
+#include <roaring/containers/mixed_intersection.h>
 #include <roaring/containers/perfparameters.h>
 
 /* Compute the andnot of src_1 and src_2 and write the result to
@@ -87,6 +88,14 @@ bool bitset_array_container_iandnot(bitset_container_t *src_1,
         return true;
 }
 
+void bitset_array_container_lazy_iandnot(bitset_container_t *src_1,
+                                         const array_container_t *src_2) {
+    // the cardinality passed in is irrelevant since we discard the result
+    bitset_clear_list(src_1->array, 0, src_2->array,
+                      (uint64_t)src_2->cardinality);
+    src_1->cardinality = BITSET_UNKNOWN_CARDINALITY;
+}
+
 /* Compute the andnot of src_1 and src_2 and write the result to
  * dst. Result may be either a bitset or an array container
  * (returns "result is bitset"). dst does not initially have
@@ -211,6 +220,16 @@ bool bitset_run_container_iandnot(bitset_container_t *src_1,
         return true;
 }
 
+void bitset_run_container_lazy_iandnot(bitset_container_t *src_1,
+                                       const run_container_t *src_2) {
+    for (int32_t rlepos = 0; rlepos < src_2->n_runs; ++rlepos) {
+        rle16_t rle = src_2->runs[rlepos];
+        bitset_reset_range(src_1->array, rle.value,
+                           rle.value + rle.length + UINT32_C(1));
+    }
+    src_1->cardinality = BITSET_UNKNOWN_CARDINALITY;
+}
+
 /* helper. a_out must be a valid array container with adequate capacity.
  * Returns the cardinality of the output container. Partly Based on Java
  * implementation Util.unsignedDifference.
@@ -383,6 +402,31 @@ void array_run_container_andnot(const array_container_t *src_1,
         dst->cardinality = src_1->cardinality;
         return;
     }
+    if (src_1->cardinality * ARRAY_SKEW_THRESHOLD < src_2->n_runs) {
+        // few values, many runs: binary search each value in the runs
+        // left after the previous one
+        int32_t rlepos = 0;
+        int dest_card = 0;
+        for (int i = 0; i < src_1->cardinality; ++i) {
+            const uint16_t val = src_1->array[i];
+            const int32_t loc = interleavedBinarySearch(
+                src_2->runs + rlepos, src_2->n_runs - rlepos, val);
+            if (loc >= 0) {
+                rlepos += loc;
+                continue;
+            }
+            rlepos += -loc - 2;  // last run starting before val, if any
+            if (rlepos < 0) {
+                rlepos = 0;
+            } else if (val <= src_2->runs[rlepos].value +
+                                  src_2->runs[rlepos].length) {
+                continue;
+            }
+            dst->array[dest_card++] = val;
+        }
+        dst->cardinality = dest_card;
+        return;
+    }
     int32_t run_start = src_2->runs[0].value;
     int32_t run_end = run_start + src_2->runs[0].length;
     int which_run = 0;
@@ -505,3 +549,61 @@ bool bitset_bitset_container_iandnot(bitset_container_t *src_1,
         return true;
     }
 }
+
+/* The kernels below count the difference without building it: whichever side
+ * has a known cardinality contributes it directly, and only the overlap is
+ * computed. */
+
+int array_bitset_container_andnot_cardinality(const array_container_t *src_1,
+                                              const bitset_container_t *src_2) {
+    return src_1->cardinality -
+           array_bitset_container_intersection_cardinality(src_1, src_2);
+}
+
+int bitset_array_container_andnot_cardinality(const bitset_container_t *src_1,
+                                              const array_container_t *src_2) {
+    return bitset_container_cardinality(src_1) -
+           array_bitset_container_intersection_cardinality(src_2, src_1);
+}
+
+int run_bitset_container_andnot_cardinality(const run_container_t *src_1,
+                                            const bitset_container_t *src_2) {
+    int answer = 0;
+    for (int32_t rlepos = 0; rlepos < src_1->n_runs; ++rlepos) {
+        rle16_t rle = src_1->runs[rlepos];
+        answer += rle.length + 1 -
+                  bitset_lenrange_cardinality(src_2->array, rle.value,
+                                              rle.length);
+    }
+    return answer;
+}
+
+int bitset_run_container_andnot_cardinality(const bitset_container_t *src_1,
+                                            const run_container_t *src_2) {
+    return bitset_container_cardinality(src_1) -
+           run_bitset_container_intersection_cardinality(src_2, src_1);
+}
+
+int array_run_container_andnot_cardinality(const array_container_t *src_1,
+                                           const run_container_t *src_2) {
+    return src_1->cardinality -
+           array_run_container_intersection_cardinality(src_1, src_2);
+}
+
+int run_array_container_andnot_cardinality(const run_container_t *src_1,
+                                           const array_container_t *src_2) {
+    return run_container_cardinality(src_1) -
+           array_run_container_intersection_cardinality(src_2, src_1);
+}
+
+int array_array_container_andnot_cardinality(const array_container_t *src_1,
+                                             const array_container_t *src_2) {
+    return src_1->cardinality -
+           array_container_intersection_cardinality(src_1, src_2);
+}
+
+int run_run_container_andnot_cardinality(const run_container_t *src_1,
+                                         const run_container_t *src_2) {
+    return run_container_cardinality(src_1) -
+           run_container_intersection_cardinality(src_1, src_2);
+}
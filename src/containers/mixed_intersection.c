@@ -105,6 +105,20 @@ void array_run_container_intersection(const array_container_t *src_1,
     dst->cardinality = newcard;
 }
 
+void run_bitset_container_lazy_intersection(const run_container_t *src_1,
+                                            const bitset_container_t *src_2,
+                                            bitset_container_t *dst) {
+    if (src_2 != dst) bitset_container_copy(src_2, dst);
+    uint32_t start = 0;
+    for (int32_t rlepos = 0; rlepos < src_1->n_runs; ++rlepos) {
+        const rle16_t rle = src_1->runs[rlepos];
+        bitset_reset_range(dst->array, start, rle.value);
+        start = (uint32_t)rle.value + rle.length + 1;
+    }
+    bitset_reset_range(dst->array, start, UINT32_C(1) << 16);
+    dst->cardinality = BITSET_UNKNOWN_CARDINALITY;
+}
+
 /* Compute the intersection of src_1 and src_2 and write the result to
  * *dst. If the result is true then the result is a bitset_container_t
  * otherwise is a array_container_t. If *dst ==  src_2, an in-place processing
@@ -7,6 +7,7 @@
 #include <string.h>
 
 #include <roaring/bitset_util.h>
+#include <roaring/containers/containers.h>
 #include <roaring/containers/convert.h>
 #include <roaring/containers/mixed_union.h>
 #include <roaring/containers/perfparameters.h>
@@ -56,6 +57,54 @@ void run_bitset_container_lazy_union(const run_container_t *src_1,
     dst->cardinality = BITSET_UNKNOWN_CARDINALITY;
 }
 
+// Appends the runs [begin, end) of src to dst, merging the first one with
+// the last run of dst. The others are copied as a block: they cannot touch it.
+static inline void run_container_append_block(run_container_t *dst,
+                                              const rle16_t *src,
+                                              int32_t begin, int32_t end,
+                                              rle16_t *previousrle) {
+    if (begin == end) return;
+    if (dst->n_runs == 0) {
+        *previousrle = run_container_append_first(dst, src[begin]);
+    } else {
+        run_container_append(dst, src[begin], previousrle);
+    }
+    begin++;
+    if (begin < end) {
+        memcpy(dst->runs + dst->n_runs, src + begin,
+               (end - begin) * sizeof(rle16_t));
+        dst->n_runs += end - begin;
+        *previousrle = src[end - 1];
+    }
+}
+
+// Union of a few values with many runs: binary search where each value goes
+// and copy the runs in between as blocks.
+static void array_run_container_union_skewed(const array_container_t *src_1,
+                                             const run_container_t *src_2,
+                                             run_container_t *dst) {
+    dst->n_runs = 0;
+    int32_t rlepos = 0;
+    rle16_t previousrle;
+    for (int32_t arraypos = 0; arraypos < src_1->cardinality; arraypos++) {
+        const uint16_t val = src_1->array[arraypos];
+        // runs starting at or before val come first
+        const int32_t loc = interleavedBinarySearch(
+            src_2->runs + rlepos, src_2->n_runs - rlepos, val);
+        const int32_t stop = rlepos + (loc >= 0 ? loc + 1 : -loc - 1);
+        run_container_append_block(dst, src_2->runs, rlepos, stop,
+                                   &previousrle);
+        rlepos = stop;
+        if (dst->n_runs == 0) {
+            previousrle = run_container_append_value_first(dst, val);
+        } else {
+            run_container_append_value(dst, val, &previousrle);
+        }
+    }
+    run_container_append_block(dst, src_2->runs, rlepos, src_2->n_runs,
+                               &previousrle);
+}
+
 // why do we leave the result as a run container??
 void array_run_container_union(const array_container_t *src_1,
                                const run_container_t *src_2,
@@ -66,6 +115,10 @@ void array_run_container_union(const array_container_t *src_1,
     }
     // TODO: see whether the "2*" is spurious
     run_container_grow(dst, 2 * (src_1->cardinality + src_2->n_runs), false);
+    if (src_1->cardinality * ARRAY_SKEW_THRESHOLD < src_2->n_runs) {
+        array_run_container_union_skewed(src_1, src_2, dst);
+        return;
+    }
     int32_t rlepos = 0;
     int32_t arraypos = 0;
     rle16_t previousrle;
@@ -106,6 +159,13 @@ void array_run_container_inplace_union(const array_container_t *src_1,
     if (run_container_is_full(src_2)) {
         return;
     }
+    if (src_1->cardinality * ARRAY_SKEW_THRESHOLD < src_2->n_runs) {
+        // a few insertions are cheaper than rebuilding all the runs
+        for (int32_t i = 0; i < src_1->cardinality; i++) {
+            run_container_add(src_2, src_1->array[i]);
+        }
+        return;
+    }
     const int32_t maxoutput = src_1->cardinality + src_2->n_runs;
     const int32_t neededcapacity = maxoutput + src_2->n_runs;
     if (src_2->capacity < neededcapacity)
@@ -153,6 +213,36 @@ void array_run_container_inplace_union(const array_container_t *src_1,
     }
 }
 
+int array_run_container_ior(array_container_t *src_1,
+                            const run_container_t *src_2, void **dst) {
+    run_container_t *answer = run_container_create();
+    array_run_container_union(src_1, src_2, answer);
+    // same choice as convert_run_to_efficient_container, but an array result
+    // reuses src_1 rather than a new allocation
+    const int32_t card = run_container_cardinality(answer);
+    const int32_t size_as_run_container =
+        run_container_serialized_size_in_bytes(answer->n_runs);
+    if (card > DEFAULT_MAX_SIZE ||
+        size_as_run_container <= array_container_serialized_size_in_bytes(card)) {
+        uint8_t typecode_after;
+        *dst = convert_run_to_efficient_container_and_free(answer,
+                                                           &typecode_after);
+        return typecode_after;
+    }
+    if (src_1->capacity < card) array_container_grow(src_1, card, false);
+    src_1->cardinality = 0;
+    for (int32_t rlepos = 0; rlepos < answer->n_runs; ++rlepos) {
+        const int run_start = answer->runs[rlepos].value;
+        const int run_end = run_start + answer->runs[rlepos].length;
+        for (int run_value = run_start; run_value <= run_end; ++run_value) {
+            src_1->array[src_1->cardinality++] = (uint16_t)run_value;
+        }
+    }
+    run_container_free(answer);
+    *dst = src_1;
+    return ARRAY_CONTAINER_TYPE_CODE;
+}
+
 bool array_array_container_union(const array_container_t *src_1,
                                  const array_container_t *src_2, void **dst) {
     int totalCardinality = src_1->cardinality + src_2->cardinality;
@@ -189,19 +279,24 @@ bool array_array_container_inplace_union(array_container_t *src_1,
     *dst = NULL;
     if (totalCardinality <= DEFAULT_MAX_SIZE) {
         if(src_1->capacity < totalCardinality) {
-          *dst = array_container_create_given_capacity(2  * totalCardinality); // be purposefully generous
-          if (*dst != NULL) {
-              array_container_union(src_1, src_2, (array_container_t *)*dst);
-          } else {
+          // grow geometrically so that repeated unions into the same
+          // container do not allocate every time
+          array_container_grow(src_1, totalCardinality, true);
+          if (src_1->array == NULL) {
               return true; // otherwise failure won't be caught
           }
-          return false;  // not a bitset
-        } else {
-          memmove(src_1->array + src_2->cardinality, src_1->array, src_1->cardinality * sizeof(uint16_t));
-          src_1->cardinality = (int32_t)fast_union_uint16(src_1->array + src_2->cardinality, src_1->cardinality,
-                                  src_2->array, src_2->cardinality, src_1->array);
+        }
+        if (src_2->cardinality * ARRAY_SKEW_THRESHOLD < src_1->cardinality) {
+          // only the tail of src_1 past the first new value moves
+          src_1->cardinality = union_skewed_uint16_inplace(
+              src_1->array, src_1->cardinality, src_2->array,
+              src_2->cardinality);
           return false; // not a bitset
         }
+        memmove(src_1->array + src_2->cardinality, src_1->array, src_1->cardinality * sizeof(uint16_t));
+        src_1->cardinality = (int32_t)fast_union_uint16(src_1->array + src_2->cardinality, src_1->cardinality,
+                                src_2->array, src_2->cardinality, src_1->array);
+        return false; // not a bitset
     }
     *dst = bitset_container_create();
     bool returnval = true;  // expect a bitset
@@ -261,19 +356,15 @@ bool array_array_container_lazy_inplace_union(array_container_t *src_1,
     *dst = NULL;
     if (totalCardinality <= ARRAY_LAZY_LOWERBOUND) {
         if(src_1->capacity < totalCardinality) {
-          *dst = array_container_create_given_capacity(2  * totalCardinality); // be purposefully generous
-          if (*dst != NULL) {
-              array_container_union(src_1, src_2, (array_container_t *)*dst);
-          } else {
+          array_container_grow(src_1, totalCardinality, true);
+          if (src_1->array == NULL) {
             return true; // otherwise failure won't be caught
           }
-          return false;  // not a bitset
-        } else {
-          memmove(src_1->array + src_2->cardinality, src_1->array, src_1->cardinality * sizeof(uint16_t));
-          src_1->cardinality = (int32_t)fast_union_uint16(src_1->array + src_2->cardinality, src_1->cardinality,
-                                  src_2->array, src_2->cardinality, src_1->array);
-          return false; // not a bitset
         }
+        memmove(src_1->array + src_2->cardinality, src_1->array, src_1->cardinality * sizeof(uint16_t));
+        src_1->cardinality = (int32_t)fast_union_uint16(src_1->array + src_2->cardinality, src_1->cardinality,
+                                src_2->array, src_2->cardinality, src_1->array);
+        return false; // not a bitset
     }
     *dst = bitset_container_create();
     bool returnval = true;  // expect a bitset
@@ -8,6 +8,7 @@
 #include <roaring/bitset_util.h>
 #include <roaring/containers/containers.h>
 #include <roaring/containers/convert.h>
+#include <roaring/containers/mixed_intersection.h>
 #include <roaring/containers/mixed_xor.h>
 #include <roaring/containers/perfparameters.h>
 
@@ -332,6 +333,23 @@ int run_array_container_ixor(run_container_t *src_1,
 
 bool array_array_container_ixor(array_container_t *src_1,
                                 const array_container_t *src_2, void **dst) {
+    const int32_t card_1 = src_1->cardinality, card_2 = src_2->cardinality;
+    if (card_1 + card_2 <= DEFAULT_MAX_SIZE) {
+        // grow src_1 if needed and shift its values up by card_2 so that the
+        // merge can write the result from the start of the same buffer: its
+        // writes never pass the values of src_1 it has yet to read (see
+        // array_util.h)
+        if (src_1->capacity < card_1 + card_2) {
+            array_container_grow(src_1, card_1 + card_2, true);
+        }
+        memmove(src_1->array + card_2, src_1->array,
+                card_1 * sizeof(uint16_t));
+        const array_container_t shifted = {card_1, card_1,
+                                           src_1->array + card_2};
+        array_container_xor(&shifted, src_2, src_1);
+        *dst = src_1;
+        return false;  // not a bitset
+    }
     bool ans = array_array_container_xor(src_1, src_2, dst);
     array_container_free(src_1);
     return ans;
@@ -343,3 +361,40 @@ int run_run_container_ixor(run_container_t *src_1, const run_container_t *src_2,
     run_container_free(src_1);
     return ans;
 }
+
+int array_bitset_container_xor_cardinality(const array_container_t *src_1,
+                                           const bitset_container_t *src_2) {
+    return src_1->cardinality + bitset_container_cardinality(src_2) -
+           2 * array_bitset_container_intersection_cardinality(src_1, src_2);
+}
+
+int run_bitset_container_xor_cardinality(const run_container_t *src_1,
+                                         const bitset_container_t *src_2) {
+    // each run adds its values missing from the bitset and removes the others
+    int answer = bitset_container_cardinality(src_2);
+    for (int32_t rlepos = 0; rlepos < src_1->n_runs; ++rlepos) {
+        rle16_t rle = src_1->runs[rlepos];
+        answer += rle.length + 1 -
+                  2 * bitset_lenrange_cardinality(src_2->array, rle.value,
+                                                  rle.length);
+    }
+    return answer;
+}
+
+int array_run_container_xor_cardinality(const array_container_t *src_1,
+                                        const run_container_t *src_2) {
+    return src_1->cardinality + run_container_cardinality(src_2) -
+           2 * array_run_container_intersection_cardinality(src_1, src_2);
+}
+
+int array_array_container_xor_cardinality(const array_container_t *src_1,
+                                          const array_container_t *src_2) {
+    return src_1->cardinality + src_2->cardinality -
+           2 * array_container_intersection_cardinality(src_1, src_2);
+}
+
+int run_run_container_xor_cardinality(const run_container_t *src_1,
+                                      const run_container_t *src_2) {
+    return run_container_cardinality(src_1) + run_container_cardinality(src_2) -
+           2 * run_container_intersection_cardinality(src_1, src_2);
+}
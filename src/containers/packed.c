@@ -0,0 +1,172 @@
+/*
+ * packed.c
+ *
+ */
+
+#include <string.h>
+
+#include <roaring/containers/packed.h>
+#include <roaring/portability.h>
+
+static inline int32_t packed_width(const uint16_t *deltas, int32_t n) {
+    uint32_t accum = 0;
+    for (int32_t i = 0; i < n; ++i) accum |= deltas[i];
+    return accum == 0 ? 0 : 32 - __builtin_clz(accum);
+}
+
+int32_t packed_block_size(const uint16_t *deltas, int32_t n) {
+    return 1 + (n * packed_width(deltas, n) + 7) / 8;
+}
+
+int32_t packed_block_write(const uint16_t *deltas, int32_t n, char *buf) {
+    const int32_t width = packed_width(deltas, n);
+    uint8_t *out = (uint8_t *)buf;
+    *out++ = (uint8_t)width;
+    uint64_t bits = 0;
+    int32_t nbits = 0;
+    for (int32_t i = 0; i < n; ++i) {
+        bits |= (uint64_t)deltas[i] << nbits;
+        nbits += width;
+        while (nbits >= 8) {
+            *out++ = (uint8_t)bits;
+            bits >>= 8;
+            nbits -= 8;
+        }
+    }
+    if (nbits > 0) *out++ = (uint8_t)bits;
+    return (int32_t)((char *)out - buf);
+}
+
+/* Unpacks groups of 8 deltas of the given width, which then take width bytes,
+ * as long as 16 bytes can be read from the start of the group. Called with
+ * a constant width, the shifts and masks are resolved at compile time.
+ * Returns the number of deltas unpacked. */
+static inline int32_t packed_unpack_groups(const uint8_t *in, int32_t bytes,
+                                           int32_t n, uint16_t *deltas,
+                                           const int32_t width) {
+    const uint64_t mask = (UINT64_C(1) << width) - 1;
+    int32_t i = 0;
+    for (; i + 8 <= n && (i / 8) * width + 16 <= bytes; i += 8) {
+        const uint8_t *group = in + (i / 8) * width;
+        uint64_t lo, hi;
+        memcpy(&lo, group, sizeof(lo));
+        memcpy(&hi, group + sizeof(lo), sizeof(hi));
+        for (int32_t j = 0; j < 8; ++j) {
+            const int32_t bit = j * width;
+            uint64_t v;
+            if (bit + width <= 64) {
+                v = lo >> bit;
+            } else if (bit >= 64) {
+                v = hi >> (bit - 64);
+            } else {
+                v = (lo >> bit) | (hi << (64 - bit));
+            }
+            deltas[i + j] = (uint16_t)(v & mask);
+        }
+    }
+    return i;
+}
+
+int32_t packed_block_read(int32_t n, uint16_t *deltas, const char *buf) {
+    const uint8_t *in = (const uint8_t *)buf;
+    const int32_t width = *in++;
+    const int32_t bytes = (n * width + 7) / 8;
+    int32_t i = 0;
+    switch (width) {
+#define PACKED_UNPACK_CASE(w) \
+    case w:                   \
+        i = packed_unpack_groups(in, bytes, n, deltas, w); \
+        break;
+        PACKED_UNPACK_CASE(1)
+        PACKED_UNPACK_CASE(2)
+        PACKED_UNPACK_CASE(3)
+        PACKED_UNPACK_CASE(4)
+        PACKED_UNPACK_CASE(5)
+        PACKED_UNPACK_CASE(6)
+        PACKED_UNPACK_CASE(7)
+        PACKED_UNPACK_CASE(8)
+        PACKED_UNPACK_CASE(9)
+        PACKED_UNPACK_CASE(10)
+        PACKED_UNPACK_CASE(11)
+        PACKED_UNPACK_CASE(12)
+        PACKED_UNPACK_CASE(13)
+        PACKED_UNPACK_CASE(14)
+        PACKED_UNPACK_CASE(15)
+        PACKED_UNPACK_CASE(16)
+#undef PACKED_UNPACK_CASE
+        default:
+            memset(deltas, 0, n * sizeof(uint16_t));
+            return 1;
+    }
+    // the last deltas, from a copy of the rest of the block padded with zeros
+    uint8_t tail[48] = {0};
+    const int32_t start = (i / 8) * width;
+    memcpy(tail, in + start, bytes - start);
+    const uint32_t mask = (UINT32_C(1) << width) - 1;
+    for (; i < n; ++i) {
+        const int32_t bit = i * width - start * 8;
+        uint32_t word;
+        memcpy(&word, tail + (bit >> 3), sizeof(word));
+        deltas[i] = (uint16_t)((word >> (bit & 7)) & mask);
+    }
+    return 1 + bytes;
+}
+
+uint32_t packed_deltas_to_values(uint16_t *values, int32_t n,
+                                 uint32_t previous) {
+    uint32_t last = previous + (uint32_t)n;
+    int32_t i = 0;
+#ifdef IS_X64
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i low_bytes = _mm_set1_epi16(0xFF);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i base = _mm_set1_epi16((int16_t)previous);
+    __m128i low_sums = zero;
+    __m128i high_sums = zero;
+    for (; i + 8 <= n; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(values + i));
+        // the sum of the deltas as 32-bit, by their low and high bytes
+        low_sums = _mm_add_epi64(
+            low_sums, _mm_sad_epu8(_mm_and_si128(x, low_bytes), zero));
+        high_sums =
+            _mm_add_epi64(high_sums, _mm_sad_epu8(_mm_srli_epi16(x, 8), zero));
+        // the prefix sums of the deltas plus one, from the last value
+        x = _mm_add_epi16(x, ones);
+        x = _mm_add_epi16(x, _mm_slli_si128(x, 2));
+        x = _mm_add_epi16(x, _mm_slli_si128(x, 4));
+        x = _mm_add_epi16(x, _mm_slli_si128(x, 8));
+        x = _mm_add_epi16(x, base);
+        _mm_storeu_si128((__m128i *)(values + i), x);
+        base = _mm_shufflehi_epi16(x, 0xFF);
+        base = _mm_unpackhi_epi64(base, base);
+    }
+    const __m128i sums =
+        _mm_add_epi64(low_sums, _mm_slli_epi64(high_sums, 8));
+    last += (uint32_t)(_mm_cvtsi128_si64(sums) +
+                       _mm_cvtsi128_si64(_mm_unpackhi_epi64(sums, sums)));
+    if (i > 0) previous = values[i - 1];
+#endif
+    for (; i < n; ++i) {
+        last += values[i];
+        previous = (uint16_t)(previous + values[i] + 1);
+        values[i] = (uint16_t)previous;
+    }
+    return last;
+}
+
+size_t packed_size_from_buffer(int32_t cardinality, const char *buf,
+                               size_t maxbytes) {
+    size_t bytes = sizeof(uint16_t);  // first value
+    if (bytes > maxbytes) return 0;
+    for (int32_t remaining = cardinality - 1; remaining > 0;
+         remaining -= PACKED_BLOCK_SIZE) {
+        const int32_t n =
+            remaining < PACKED_BLOCK_SIZE ? remaining : PACKED_BLOCK_SIZE;
+        if (bytes + 1 > maxbytes) return 0;
+        const uint8_t width = (uint8_t)buf[bytes];
+        if (width > 16) return 0;
+        bytes += 1 + (n * width + 7) / 8;
+        if (bytes > maxbytes) return 0;
+    }
+    return bytes;
+}
@@ -18,6 +18,104 @@ extern inline int32_t run_container_serialized_size_in_bytes(int32_t num_runs);
 extern inline run_container_t *run_container_create_range(uint32_t start,
                                                    uint32_t stop);
 
+/**
+ * Block skip for rle16_advance_until_end: returns the first index >= pos whose
+ * run ends at or after x. Run ends are increasing, so several runs are
+ * compared at once with SIMD.
+ */
+static int32_t rle16_skip_ending_before(const rle16_t *runs, int32_t n_runs,
+                                        int32_t pos, uint32_t x) {
+#if defined(USEAVX)
+    const __m256i vx = _mm256_set1_epi32((int32_t)x);
+    const __m256i lowmask = _mm256_set1_epi32(0xFFFF);
+    for (; pos + 8 <= n_runs; pos += 8) {
+        // each 32-bit lane holds a value in its low half, a length in its high
+        const __m256i v = _mm256_loadu_si256((const __m256i *)(runs + pos));
+        const __m256i ends = _mm256_add_epi32(_mm256_and_si256(v, lowmask),
+                                              _mm256_srli_epi32(v, 16));
+        const int before = _mm256_movemask_ps(
+            _mm256_castsi256_ps(_mm256_cmpgt_epi32(vx, ends)));
+        if (before != 0xFF) return pos + __builtin_ctzll(~(uint64_t)before);
+    }
+#elif defined(USENEON)
+    const uint32x4_t vx = vdupq_n_u32(x);
+    const uint32x4_t lowmask = vdupq_n_u32(0xFFFF);
+    for (; pos + 4 <= n_runs; pos += 4) {
+        const uint32x4_t v = vld1q_u32((const uint32_t *)(runs + pos));
+        const uint32x4_t ends =
+            vaddq_u32(vandq_u32(v, lowmask), vshrq_n_u32(v, 16));
+        const uint64_t before = vget_lane_u64(
+            vreinterpret_u64_u16(vmovn_u32(vcltq_u32(ends, vx))), 0);
+        if (before != UINT64_MAX) return pos + (__builtin_ctzll(~before) >> 4);
+    }
+#endif
+    while (pos < n_runs && (uint32_t)runs[pos].value + runs[pos].length < x) {
+        pos++;
+    }
+    return pos;
+}
+
+/**
+ * Block skip for rle16_advance_until_start: returns the first index >= pos
+ * whose run starts at or after x.
+ */
+static int32_t rle16_skip_starting_before(const rle16_t *runs, int32_t n_runs,
+                                          int32_t pos, uint32_t x) {
+#if defined(USEAVX)
+    const __m256i vx = _mm256_set1_epi32((int32_t)x);
+    const __m256i lowmask = _mm256_set1_epi32(0xFFFF);
+    for (; pos + 8 <= n_runs; pos += 8) {
+        const __m256i v = _mm256_loadu_si256((const __m256i *)(runs + pos));
+        const int before = _mm256_movemask_ps(_mm256_castsi256_ps(
+            _mm256_cmpgt_epi32(vx, _mm256_and_si256(v, lowmask))));
+        if (before != 0xFF) return pos + __builtin_ctzll(~(uint64_t)before);
+    }
+#elif defined(USENEON)
+    const uint32x4_t vx = vdupq_n_u32(x);
+    const uint32x4_t lowmask = vdupq_n_u32(0xFFFF);
+    for (; pos + 4 <= n_runs; pos += 4) {
+        const uint32x4_t v = vld1q_u32((const uint32_t *)(runs + pos));
+        const uint64_t before = vget_lane_u64(
+            vreinterpret_u64_u16(
+                vmovn_u32(vcltq_u32(vandq_u32(v, lowmask), vx))),
+            0);
+        if (before != UINT64_MAX) return pos + (__builtin_ctzll(~before) >> 4);
+    }
+#endif
+    while (pos < n_runs && runs[pos].value < x) pos++;
+    return pos;
+}
+
+/**
+ * Returns the index of the first run, starting from pos, whose last value is
+ * at least x (n_runs if there is none). When runs interleave the answer is
+ * almost always one of the next two runs, so those are checked inline before
+ * falling back to the block skip.
+ */
+static inline int32_t rle16_advance_until_end(const rle16_t *runs,
+                                              int32_t n_runs, int32_t pos,
+                                              uint32_t x) {
+    if (pos >= n_runs || (uint32_t)runs[pos].value + runs[pos].length >= x)
+        return pos;
+    pos++;
+    if (pos >= n_runs || (uint32_t)runs[pos].value + runs[pos].length >= x)
+        return pos;
+    return rle16_skip_ending_before(runs, n_runs, pos + 1, x);
+}
+
+/**
+ * Returns the index of the first run, starting from pos, whose first value is
+ * at least x (n_runs if there is none).
+ */
+static inline int32_t rle16_advance_until_start(const rle16_t *runs,
+                                                int32_t n_runs, int32_t pos,
+                                                uint32_t x) {
+    if (pos >= n_runs || runs[pos].value >= x) return pos;
+    pos++;
+    if (pos >= n_runs || runs[pos].value >= x) return pos;
+    return rle16_skip_starting_before(runs, n_runs, pos + 1, x);
+}
+
 bool run_container_add(run_container_t *run, uint16_t pos) {
     int32_t index = interleavedBinarySearch(run->runs, run->n_runs, pos);
     if (index >= 0) return false;  // already there
@@ -67,6 +165,70 @@ bool run_container_add(run_container_t *run, uint16_t pos) {
     return true;
 }
 
+/* LSD radix sort of n runs by value in two byte-wide passes, using buffer
+ * (room for n runs) as scratch space. */
+static void radix_sort_rle16(rle16_t *runs, rle16_t *buffer, int32_t n) {
+    int32_t low[256] = {0};
+    int32_t high[256] = {0};
+    for (int32_t i = 0; i < n; i++) {
+        low[runs[i].value & 0xFF]++;
+        high[runs[i].value >> 8]++;
+    }
+    int32_t lowsum = 0, highsum = 0;
+    for (int b = 0; b < 256; b++) {
+        const int32_t lowcount = low[b], highcount = high[b];
+        low[b] = lowsum;
+        high[b] = highsum;
+        lowsum += lowcount;
+        highsum += highcount;
+    }
+    for (int32_t i = 0; i < n; i++) {
+        buffer[low[runs[i].value & 0xFF]++] = runs[i];
+    }
+    for (int32_t i = 0; i < n; i++) {
+        runs[high[buffer[i].value >> 8]++] = buffer[i];
+    }
+}
+
+static int rle16_compare(const void *a, const void *b) {
+    return (int)((const rle16_t *)a)->value - (int)((const rle16_t *)b)->value;
+}
+
+void run_container_normalize(run_container_t *run) {
+    int32_t sorted = 1;
+    while (sorted < run->n_runs &&
+           run->runs[sorted].value >
+               run->runs[sorted - 1].value + run->runs[sorted - 1].length + 1) {
+        sorted++;
+    }
+    if (sorted >= run->n_runs) return;
+
+    rle16_t *buffer = (rle16_t *)malloc(run->n_runs * sizeof(rle16_t));
+    if (buffer == NULL) {
+        // without scratch space, the runs are sorted in place
+        qsort(run->runs, run->n_runs, sizeof(rle16_t), rle16_compare);
+    } else {
+        radix_sort_rle16(run->runs, buffer, run->n_runs);
+        free(buffer);
+    }
+    int32_t last = 0;
+    for (int32_t i = 1; i < run->n_runs; i++) {
+        const uint32_t end =
+            (uint32_t)run->runs[last].value + run->runs[last].length;
+        if (run->runs[i].value <= end + 1) {
+            const uint32_t i_end =
+                (uint32_t)run->runs[i].value + run->runs[i].length;
+            if (i_end > end) {
+                run->runs[last].length =
+                    (uint16_t)(i_end - run->runs[last].value);
+            }
+        } else {
+            run->runs[++last] = run->runs[i];
+        }
+    }
+    run->n_runs = last + 1;
+}
+
 /* Create a new run container. Return NULL in case of failure. */
 run_container_t *run_container_create_given_capacity(int32_t size) {
     run_container_t *run;
@@ -192,15 +354,20 @@ void run_container_union(const run_container_t *src_1,
     }
 
     while ((xrlepos < src_2->n_runs) && (rlepos < src_1->n_runs)) {
-        rle16_t newrl;
+        // take every run starting before the other side's next run at once
         if (src_1->runs[rlepos].value <= src_2->runs[xrlepos].value) {
-            newrl = src_1->runs[rlepos];
-            rlepos++;
+            const int32_t stop = rle16_advance_until_start(
+                src_1->runs, src_1->n_runs, rlepos + 1,
+                (uint32_t)src_2->runs[xrlepos].value + 1);
+            for (; rlepos < stop; rlepos++)
+                run_container_append(dst, src_1->runs[rlepos], &previousrle);
         } else {
-            newrl = src_2->runs[xrlepos];
-            xrlepos++;
+            const int32_t stop = rle16_advance_until_start(
+                src_2->runs, src_2->n_runs, xrlepos + 1,
+                src_1->runs[rlepos].value);
+            for (; xrlepos < stop; xrlepos++)
+                run_container_append(dst, src_2->runs[xrlepos], &previousrle);
         }
-        run_container_append(dst, newrl, &previousrle);
     }
     while (xrlepos < src_2->n_runs) {
         run_container_append(dst, src_2->runs[xrlepos], &previousrle);
@@ -252,15 +419,20 @@ void run_container_union_inplace(run_container_t *src_1,
         xrlepos++;
     }
     while ((xrlepos < src_2->n_runs) && (rlepos < input1nruns)) {
-        rle16_t newrl;
+        // take every run starting before the other side's next run at once
         if (inputsrc1[rlepos].value <= src_2->runs[xrlepos].value) {
-            newrl = inputsrc1[rlepos];
-            rlepos++;
+            const int32_t stop = rle16_advance_until_start(
+                inputsrc1, input1nruns, rlepos + 1,
+                (uint32_t)src_2->runs[xrlepos].value + 1);
+            for (; rlepos < stop; rlepos++)
+                run_container_append(src_1, inputsrc1[rlepos], &previousrle);
         } else {
-            newrl = src_2->runs[xrlepos];
-            xrlepos++;
+            const int32_t stop = rle16_advance_until_start(
+                src_2->runs, src_2->n_runs, xrlepos + 1,
+                inputsrc1[rlepos].value);
+            for (; xrlepos < stop; xrlepos++)
+                run_container_append(src_1, src_2->runs[xrlepos], &previousrle);
         }
-        run_container_append(src_1, newrl, &previousrle);
     }
     while (xrlepos < src_2->n_runs) {
         run_container_append(src_1, src_2->runs[xrlepos], &previousrle);
@@ -329,7 +501,6 @@ void run_container_intersection(const run_container_t *src_1,
             return;
         }
     }
-    // TODO: this could be a lot more efficient, could use SIMD optimizations
     const int32_t neededcapacity = src_1->n_runs + src_2->n_runs;
     if (dst->capacity < neededcapacity)
         run_container_grow(dst, neededcapacity, false);
@@ -342,13 +513,15 @@ void run_container_intersection(const run_container_t *src_1,
     int32_t xend = xstart + src_2->runs[xrlepos].length + 1;
     while ((rlepos < src_1->n_runs) && (xrlepos < src_2->n_runs)) {
         if (end <= xstart) {
-            ++rlepos;
+            rlepos = rle16_advance_until_end(src_1->runs, src_1->n_runs,
+                                             rlepos + 1, xstart);
             if (rlepos < src_1->n_runs) {
                 start = src_1->runs[rlepos].value;
                 end = start + src_1->runs[rlepos].length + 1;
             }
         } else if (xend <= start) {
-            ++xrlepos;
+            xrlepos = rle16_advance_until_end(src_2->runs, src_2->n_runs,
+                                              xrlepos + 1, start);
             if (xrlepos < src_2->n_runs) {
                 xstart = src_2->runs[xrlepos].value;
                 xend = xstart + src_2->runs[xrlepos].length + 1;
@@ -414,13 +587,15 @@ int run_container_intersection_cardinality(const run_container_t *src_1,
     int32_t xend = xstart + src_2->runs[xrlepos].length + 1;
     while ((rlepos < src_1->n_runs) && (xrlepos < src_2->n_runs)) {
         if (end <= xstart) {
-            ++rlepos;
+            rlepos = rle16_advance_until_end(src_1->runs, src_1->n_runs,
+                                             rlepos + 1, xstart);
             if (rlepos < src_1->n_runs) {
                 start = src_1->runs[rlepos].value;
                 end = start + src_1->runs[rlepos].length + 1;
             }
         } else if (xend <= start) {
-            ++xrlepos;
+            xrlepos = rle16_advance_until_end(src_2->runs, src_2->n_runs,
+                                              xrlepos + 1, start);
             if (xrlepos < src_2->n_runs) {
                 xstart = src_2->runs[xrlepos].value;
                 xend = xstart + src_2->runs[xrlepos].length + 1;
@@ -482,13 +657,15 @@ bool run_container_intersect(const run_container_t *src_1,
     int32_t xend = xstart + src_2->runs[xrlepos].length + 1;
     while ((rlepos < src_1->n_runs) && (xrlepos < src_2->n_runs)) {
         if (end <= xstart) {
-            ++rlepos;
+            rlepos = rle16_advance_until_end(src_1->runs, src_1->n_runs,
+                                             rlepos + 1, xstart);
             if (rlepos < src_1->n_runs) {
                 start = src_1->runs[rlepos].value;
                 end = start + src_1->runs[rlepos].length + 1;
             }
         } else if (xend <= start) {
-            ++xrlepos;
+            xrlepos = rle16_advance_until_end(src_2->runs, src_2->n_runs,
+                                              xrlepos + 1, start);
             if (xrlepos < src_2->n_runs) {
                 xstart = src_2->runs[xrlepos].value;
                 xend = xstart + src_2->runs[xrlepos].length + 1;
@@ -521,18 +698,24 @@ void run_container_andnot(const run_container_t *src_1,
 
     while ((rlepos1 < src_1->n_runs) && (rlepos2 < src_2->n_runs)) {
         if (end <= start2) {
-            // output the first run
+            // output the first run, along with any others ending before start2
             dst->runs[dst->n_runs++] =
                 (rle16_t){.value = (uint16_t)start,
                           .length = (uint16_t)(end - start - 1)};
-            rlepos1++;
+            const int next = rle16_advance_until_end(
+                src_1->runs, src_1->n_runs, rlepos1 + 1, start2);
+            memcpy(dst->runs + dst->n_runs, src_1->runs + rlepos1 + 1,
+                   sizeof(rle16_t) * (next - rlepos1 - 1));
+            dst->n_runs += next - rlepos1 - 1;
+            rlepos1 = next;
             if (rlepos1 < src_1->n_runs) {
                 start = src_1->runs[rlepos1].value;
                 end = start + src_1->runs[rlepos1].length + 1;
             }
         } else if (end2 <= start) {
-            // exit the second run
-            rlepos2++;
+            // exit the second run, along with any others ending before start
+            rlepos2 = rle16_advance_until_end(src_2->runs, src_2->n_runs,
+                                              rlepos2 + 1, start);
             if (rlepos2 < src_2->n_runs) {
                 start2 = src_2->runs[rlepos2].value;
                 end2 = start2 + src_2->runs[rlepos2].length + 1;
@@ -834,3 +1017,16 @@ int run_container_rank(const run_container_t *container, uint16_t x) {
     }
     return sum;
 }
+
+int32_t run_container_contains_many(const run_container_t *run,
+                                    const uint16_t *values, int32_t n,
+                                    bool *answer) {
+    int32_t found = 0;
+    int32_t pos = 0;
+    for (int32_t i = 0; i < n; i++) {
+        pos = rle16_advance_until_end(run->runs, run->n_runs, pos, values[i]);
+        answer[i] = (pos < run->n_runs) && (run->runs[pos].value <= values[i]);
+        found += answer[i];
+    }
+    return found;
+}
@@ -13,6 +13,8 @@ extern inline bool roaring_bitmap_contains(const roaring_bitmap_t *r,
                                            uint32_t val);
 extern inline bool roaring_bitmap_get_copy_on_write(const roaring_bitmap_t* r);
 extern inline void roaring_bitmap_set_copy_on_write(roaring_bitmap_t* r, bool cow);
+extern inline bool roaring_bitmap_get_auto_run(const roaring_bitmap_t *r);
+extern inline void roaring_bitmap_set_auto_run(roaring_bitmap_t *r, bool autorun);
 
 static inline bool is_cow(const roaring_bitmap_t *r) {
     return r->high_low_container.flags & ROARING_FLAG_COW;
@@ -20,6 +22,55 @@ static inline bool is_cow(const roaring_bitmap_t *r) {
 static inline bool is_frozen(const roaring_bitmap_t *r) {
     return r->high_low_container.flags & ROARING_FLAG_FROZEN;
 }
+static inline bool is_autorun(const roaring_bitmap_t *r) {
+    return r->high_low_container.flags & ROARING_FLAG_AUTORUN;
+}
+
+// Under auto-run, a container freshly computed by a set operation is given
+// its smallest representation right away, while it is still in cache, rather
+// than in a later roaring_bitmap_run_optimize pass. c must be non-empty.
+// n_runs is the number of runs of c if autorun_bitsets counted them, else -1.
+static inline void *autorun_container(void *c, uint8_t *typecode,
+                                      int32_t n_runs, bool autorun) {
+    if (!autorun) return c;
+    uint8_t typecode_after;
+    if (n_runs >= 0) {
+        c = convert_bitset_run_optimize((bitset_container_t *)c, n_runs,
+                                        &typecode_after);
+    } else {
+        c = convert_run_optimize(c, *typecode, &typecode_after);
+    }
+    *typecode = typecode_after;
+    return c;
+}
+
+// Under auto-run, two bitsets are combined with op, one of the
+// bitset_container_*_runs kernels, which counts the runs of the result while
+// writing it: autorun_container then need not scan the result again. The
+// result goes into c1 (which must be writable) if inplace, else into a new
+// bitset, and stays a bitset whatever its cardinality until autorun_container
+// converts it. Returns NULL, for the caller to fall back on the general
+// operation, if autorun is off or c1 and c2 are not both bitsets.
+static inline void *autorun_bitsets(
+    void *c1, uint8_t type1, const void *c2, uint8_t type2,
+    int (*op)(const bitset_container_t *, const bitset_container_t *,
+              bitset_container_t *, int32_t *),
+    bool inplace, bool autorun, uint8_t *result_type, int32_t *n_runs) {
+    if (!autorun) return NULL;
+    if (!inplace) c1 = (void *)container_unwrap_shared(c1, &type1);
+    c2 = container_unwrap_shared(c2, &type2);
+    if (type1 != BITSET_CONTAINER_TYPE_CODE ||
+        type2 != BITSET_CONTAINER_TYPE_CODE) {
+        return NULL;
+    }
+    bitset_container_t *dst =
+        inplace ? (bitset_container_t *)c1 : bitset_container_create();
+    if (dst == NULL) return NULL;
+    op((const bitset_container_t *)c1, (const bitset_container_t *)c2, dst,
+       n_runs);
+    *result_type = BITSET_CONTAINER_TYPE_CODE;
+    return dst;
+}
 
 // this is like roaring_bitmap_add, but it populates pointer arguments in such a
 // way
@@ -232,6 +283,7 @@ void roaring_bitmap_add_range_closed(roaring_bitmap_t *ra, uint32_t min, uint32_
                                               key, new_container, new_type);
         dst--;
     }
+    ra_reindex_keys(&ra->high_low_container);
 }
 
 void roaring_bitmap_remove_range_closed(roaring_bitmap_t *ra, uint32_t min, uint32_t max) {
@@ -269,6 +321,7 @@ void roaring_bitmap_remove_range_closed(roaring_bitmap_t *ra, uint32_t min, uint
     if (src > dst) {
         ra_shift_tail(&ra->high_low_container, ra->high_low_container.size - src, dst - src);
     }
+    ra_reindex_keys(&ra->high_low_container);
 }
 
 extern inline void roaring_bitmap_add_range(roaring_bitmap_t *ra, uint64_t min, uint64_t max);
@@ -384,6 +437,7 @@ roaring_bitmap_t *roaring_bitmap_copy(const roaring_bitmap_t *r) {
         return NULL;
     }
     roaring_bitmap_set_copy_on_write(ans, is_cow(r));
+    roaring_bitmap_set_auto_run(ans, is_autorun(r));
     return ans;
 }
 
@@ -430,6 +484,31 @@ void roaring_bitmap_add(roaring_bitmap_t *r, uint32_t val) {
     }
 }
 
+void roaring_bitmap_lazy_add(roaring_bitmap_t *r, uint32_t val) {
+    const uint16_t hb = val >> 16;
+    const int i = ra_get_index(&r->high_low_container, hb);
+    uint8_t typecode;
+    if (i >= 0) {
+        ra_unshare_container_at_index(&r->high_low_container, i);
+        void *container =
+            ra_get_container_at_index(&r->high_low_container, i, &typecode);
+        uint8_t newtypecode = typecode;
+        void *container2 = container_lazy_add(container, val & 0xFFFF,
+                                              typecode, &newtypecode);
+        if (container2 != container) {
+            container_free(container, typecode);
+            ra_set_container_at_index(&r->high_low_container, i, container2,
+                                      newtypecode);
+        }
+    } else {
+        array_container_t *newac = array_container_create();
+        void *container = container_lazy_add(
+            newac, val & 0xFFFF, ARRAY_CONTAINER_TYPE_CODE, &typecode);
+        ra_insert_new_key_value_at(&r->high_low_container, -i - 1, hb,
+                                   container, typecode);
+    }
+}
+
 bool roaring_bitmap_add_checked(roaring_bitmap_t *r, uint32_t val) {
     const uint16_t hb = val >> 16;
     const int i = ra_get_index(&r->high_low_container, hb);
@@ -575,6 +654,8 @@ roaring_bitmap_t *roaring_bitmap_and(const roaring_bitmap_t *x1,
     uint32_t neededcap = length1 > length2 ? length2 : length1;
     roaring_bitmap_t *answer = roaring_bitmap_create_with_capacity(neededcap);
     roaring_bitmap_set_copy_on_write(answer, is_cow(x1) && is_cow(x2));
+    const bool autorun = is_autorun(x1) || is_autorun(x2);
+    roaring_bitmap_set_auto_run(answer, autorun);
 
     int pos1 = 0, pos2 = 0;
 
@@ -588,9 +669,18 @@ roaring_bitmap_t *roaring_bitmap_and(const roaring_bitmap_t *x1,
                                                  &container_type_1);
             void *c2 = ra_get_container_at_index(&x2->high_low_container, pos2,
                                                  &container_type_2);
-            void *c = container_and(c1, container_type_1, c2, container_type_2,
-                                    &container_result_type);
+            int32_t n_runs = -1;
+            void *c = autorun_bitsets(c1, container_type_1, c2,
+                                      container_type_2,
+                                      bitset_container_and_runs, false, autorun,
+                                      &container_result_type, &n_runs);
+            if (c == NULL) {
+                c = container_and(c1, container_type_1, c2, container_type_2,
+                                  &container_result_type);
+            }
             if (container_nonzero_cardinality(c, container_result_type)) {
+                c = autorun_container(c, &container_result_type, n_runs,
+                                      autorun);
                 ra_append(&answer->high_low_container, s1, c,
                           container_result_type);
             } else {
@@ -608,11 +698,9 @@ roaring_bitmap_t *roaring_bitmap_and(const roaring_bitmap_t *x1,
     return answer;
 }
 
-/**
- * Compute the union of 'number' bitmaps.
- */
-roaring_bitmap_t *roaring_bitmap_or_many(size_t number,
-                                         const roaring_bitmap_t **x) {
+// unions the inputs one after the other into the result
+static roaring_bitmap_t *or_many_fold(size_t number,
+                                      const roaring_bitmap_t **x) {
     if (number == 0) {
         return roaring_bitmap_create();
     }
@@ -628,6 +716,211 @@ roaring_bitmap_t *roaring_bitmap_or_many(size_t number,
     return answer;
 }
 
+// The containers of the inputs of an n-ary operation grouped by key with a
+// counting sort over the key span: the containers of key min_key + k are at
+// positions [starts[k], starts[k + 1]), in the order of the inputs.
+typedef struct key_groups_s {
+    uint32_t min_key;
+    uint32_t span;
+    uint32_t n_keys;
+    uint32_t *starts;
+    const void **containers;
+    uint8_t *typecodes;
+    uint32_t *bitmaps;  // input and position of each container
+    uint16_t *indexes;
+} key_groups_t;
+
+static void key_groups_free(key_groups_t *groups) {
+    free(groups->starts);
+    free(groups->containers);
+    free(groups->typecodes);
+    free(groups->bitmaps);
+    free(groups->indexes);
+}
+
+// Returns false if memory runs out, or if the inputs have no container.
+static bool key_groups_init(key_groups_t *groups, size_t number,
+                            const roaring_bitmap_t **x) {
+    memset(groups, 0, sizeof(*groups));
+    uint32_t min_key = UINT16_MAX, max_key = 0;
+    size_t total = 0;
+    for (size_t i = 0; i < number; i++) {
+        const roaring_array_t *ra = &x[i]->high_low_container;
+        if (ra->size == 0) continue;
+        total += ra->size;
+        if (ra->keys[0] < min_key) min_key = ra->keys[0];
+        if (ra->keys[ra->size - 1] > max_key) max_key = ra->keys[ra->size - 1];
+    }
+    if (total == 0) return false;
+    groups->min_key = min_key;
+    groups->span = max_key - min_key + 1;
+    groups->starts = (uint32_t *)calloc(groups->span + 1, sizeof(uint32_t));
+    groups->containers = (const void **)malloc(total * sizeof(const void *));
+    groups->typecodes = (uint8_t *)malloc(total * sizeof(uint8_t));
+    groups->bitmaps = (uint32_t *)malloc(total * sizeof(uint32_t));
+    groups->indexes = (uint16_t *)malloc(total * sizeof(uint16_t));
+    if (groups->starts == NULL || groups->containers == NULL ||
+        groups->typecodes == NULL || groups->bitmaps == NULL ||
+        groups->indexes == NULL) {
+        key_groups_free(groups);
+        return false;
+    }
+    uint32_t *starts = groups->starts;
+    for (size_t i = 0; i < number; i++) {
+        const roaring_array_t *ra = &x[i]->high_low_container;
+        for (int32_t j = 0; j < ra->size; j++) starts[ra->keys[j] - min_key]++;
+    }
+    uint32_t end = 0;
+    for (uint32_t k = 0; k < groups->span; k++) {
+        groups->n_keys += (starts[k] != 0);
+        end += starts[k];
+        starts[k] = end;
+    }
+    starts[groups->span] = end;
+    for (size_t i = number; i-- > 0;) {
+        const roaring_array_t *ra = &x[i]->high_low_container;
+        for (int32_t j = ra->size; j-- > 0;) {
+            const uint32_t pos = --starts[ra->keys[j] - min_key];
+            groups->containers[pos] = ra->containers[j];
+            groups->typecodes[pos] = ra->typecodes[j];
+            groups->bitmaps[pos] = (uint32_t)i;
+            groups->indexes[pos] = (uint16_t)j;
+        }
+    }
+    return true;
+}
+
+// Computes the union (or the exclusive or) of all the containers of a key at
+// once, walking the inputs grouped by key.
+static roaring_bitmap_t *many_horizontal(size_t number,
+                                         const roaring_bitmap_t **x,
+                                         bool exclusive) {
+    assert(number <= UINT32_MAX);
+    bool cow = true;
+    for (size_t i = 0; i < number; i++) cow = cow && is_cow(x[i]);
+    key_groups_t groups;
+    if (!key_groups_init(&groups, number, x)) {
+        // unless memory ran out, the inputs have no container
+        if (groups.span > 0) return NULL;
+        return roaring_bitmap_create();
+    }
+    roaring_bitmap_t *answer = roaring_bitmap_create_with_capacity(groups.n_keys);
+    if (answer == NULL) {
+        key_groups_free(&groups);
+        return NULL;
+    }
+    roaring_bitmap_set_copy_on_write(answer, cow);
+    for (uint32_t k = 0; k < groups.span; k++) {
+        const uint32_t first = groups.starts[k];
+        const uint32_t n = groups.starts[k + 1] - first;
+        if (n == 0) continue;
+        if (n == 1) {
+            ra_append_copy(&answer->high_low_container,
+                           &x[groups.bitmaps[first]]->high_low_container,
+                           groups.indexes[first], cow);
+            continue;
+        }
+        uint8_t type = 0;
+        void *c = exclusive ? container_xor_many(groups.containers + first,
+                                                 groups.typecodes + first,
+                                                 (int32_t)n, &type)
+                            : container_or_many(groups.containers + first,
+                                                groups.typecodes + first,
+                                                (int32_t)n, &type);
+        if (c == NULL) {  // out of memory
+            roaring_bitmap_free(answer);
+            key_groups_free(&groups);
+            return NULL;
+        }
+        if (container_nonzero_cardinality(c, type)) {
+            ra_append(&answer->high_low_container,
+                      (uint16_t)(groups.min_key + k), c, type);
+        } else {
+            container_free(c, type);
+        }
+    }
+    key_groups_free(&groups);
+    return answer;
+}
+
+void roaring_bitmap_or_many_plan(size_t number, const roaring_bitmap_t **x,
+                                 roaring_union_plan_t *plan) {
+    uint64_t keys[MAX_CONTAINERS / 64];
+    memset(keys, 0, sizeof(keys));
+    memset(plan, 0, sizeof(*plan));
+    plan->n_inputs = number;
+    uint32_t min_key = UINT16_MAX, max_key = 0;
+    for (size_t i = 0; i < number; i++) {
+        const roaring_array_t *ra = &x[i]->high_low_container;
+        if (ra->size == 0) continue;
+        plan->n_containers += ra->size;
+        if (ra->keys[0] < min_key) min_key = ra->keys[0];
+        if (ra->keys[ra->size - 1] > max_key) max_key = ra->keys[ra->size - 1];
+        for (int32_t j = 0; j < ra->size; j++) {
+            keys[ra->keys[j] >> 6] |= UINT64_C(1) << (ra->keys[j] & 63);
+            if (get_container_type(ra->containers[j], ra->typecodes[j]) ==
+                BITSET_CONTAINER_TYPE_CODE) {
+                plan->n_bitset_containers++;
+            }
+        }
+    }
+    plan->strategy = ROARING_UNION_FOLD;
+    if (plan->n_containers == 0) return;
+    for (uint32_t i = 0; i < MAX_CONTAINERS / 64; i++) {
+        plan->n_keys += hamming(keys[i]);
+    }
+    plan->key_span = max_key - min_key + 1;
+    // the keys of the result, which grows to n_keys, are merged with those
+    // of every input
+    plan->fold_cost = plan->n_containers + (number - 1) * plan->n_keys / 2;
+    // containers take part in about log2(number) unions, and those of the
+    // inputs (not of the temporary results) are copied
+    uint64_t depth = 0;
+    while ((UINT64_C(1) << depth) < number) depth++;
+    plan->heap_cost = plan->n_containers * depth +
+                      plan->n_bitset_containers * UNION_BITSET_COPY_COST;
+    // containers are visited once, after a counting sort over the key span
+    plan->horizontal_cost =
+        plan->n_containers + plan->key_span / UNION_HORIZONTAL_KEYS_PER_COST;
+    if (number <= 2) return;  // a single union
+    uint64_t best = plan->fold_cost;
+    if (plan->heap_cost < best) {
+        best = plan->heap_cost;
+        plan->strategy = ROARING_UNION_HEAP;
+    }
+    if (plan->horizontal_cost < best) {
+        plan->strategy = ROARING_UNION_HORIZONTAL;
+    }
+}
+
+roaring_bitmap_t *roaring_bitmap_or_many_with_strategy(
+    size_t number, const roaring_bitmap_t **x,
+    roaring_union_strategy_t strategy) {
+    switch (strategy) {
+        case ROARING_UNION_HEAP:
+            if (number > UINT32_MAX) break;
+            return roaring_bitmap_or_many_heap((uint32_t)number, x);
+        case ROARING_UNION_HORIZONTAL:
+            return many_horizontal(number, x, false);
+        default:
+            break;
+    }
+    return or_many_fold(number, x);
+}
+
+/**
+ * Compute the union of 'number' bitmaps.
+ */
+roaring_bitmap_t *roaring_bitmap_or_many(size_t number,
+                                         const roaring_bitmap_t **x) {
+    if (number <= 2) {
+        return or_many_fold(number, x);
+    }
+    roaring_union_plan_t plan;
+    roaring_bitmap_or_many_plan(number, x, &plan);
+    return roaring_bitmap_or_many_with_strategy(number, x, plan.strategy);
+}
+
 /**
  * Compute the xor of 'number' bitmaps.
  */
@@ -639,6 +932,14 @@ roaring_bitmap_t *roaring_bitmap_xor_many(size_t number,
     if (number == 1) {
         return roaring_bitmap_copy(x[0]);
     }
+    if (number > 2) {
+        // same costs as a union, without the heap
+        roaring_union_plan_t plan;
+        roaring_bitmap_or_many_plan(number, x, &plan);
+        if (plan.horizontal_cost < plan.fold_cost) {
+            return many_horizontal(number, x, true);
+        }
+    }
     roaring_bitmap_t *answer = roaring_bitmap_lazy_xor(x[0], x[1]);
     for (size_t i = 2; i < number; i++) {
         roaring_bitmap_lazy_xor_inplace(answer, x[i]);
@@ -647,9 +948,67 @@ roaring_bitmap_t *roaring_bitmap_xor_many(size_t number,
     return answer;
 }
 
-// inplace and (modifies its first argument).
-void roaring_bitmap_and_inplace(roaring_bitmap_t *x1,
-                                const roaring_bitmap_t *x2) {
+roaring_bitmap_t *roaring_bitmap_threshold_many(size_t number,
+                                                const roaring_bitmap_t **x,
+                                                uint32_t threshold) {
+    if (threshold <= 1) {
+        return roaring_bitmap_or_many(number, x);
+    }
+    if (threshold > number) {
+        return roaring_bitmap_create();
+    }
+    bool cow = true;
+    for (size_t i = 0; i < number; i++) cow = cow && is_cow(x[i]);
+    key_groups_t groups;
+    if (!key_groups_init(&groups, number, x)) {
+        // unless memory ran out, the inputs have no container
+        if (groups.span > 0) return NULL;
+        return roaring_bitmap_create();
+    }
+    container_counters_t counters;
+    if (!container_counters_init(&counters, threshold)) {
+        key_groups_free(&groups);
+        return NULL;
+    }
+    roaring_bitmap_t *answer = roaring_bitmap_create();
+    if (answer == NULL) {
+        container_counters_free(&counters);
+        key_groups_free(&groups);
+        return NULL;
+    }
+    roaring_bitmap_set_copy_on_write(answer, cow);
+    for (uint32_t k = 0; k < groups.span; k++) {
+        const uint32_t first = groups.starts[k];
+        const uint32_t n = groups.starts[k + 1] - first;
+        // keys present in too few inputs are skipped without looking at
+        // their containers
+        if (n < threshold) continue;
+        uint8_t type = 0;
+        void *c = container_threshold_many(groups.containers + first,
+                                           groups.typecodes + first,
+                                           (int32_t)n, &counters, &type);
+        if (c == NULL) {  // out of memory
+            roaring_bitmap_free(answer);
+            container_counters_free(&counters);
+            key_groups_free(&groups);
+            return NULL;
+        }
+        if (container_nonzero_cardinality(c, type)) {
+            ra_append(&answer->high_low_container,
+                      (uint16_t)(groups.min_key + k), c, type);
+        } else {
+            container_free(c, type);
+        }
+    }
+    container_counters_free(&counters);
+    key_groups_free(&groups);
+    return answer;
+}
+
+// inplace and (modifies its first argument); the lazy version leaves
+// bitsets with an unknown cardinality and does not convert the results.
+static void and_inplace(roaring_bitmap_t *x1, const roaring_bitmap_t *x2,
+                        bool lazy) {
     if (x1 == x2) return;
     int pos1 = 0, pos2 = 0, intersection_size = 0;
     const int length1 = ra_get_size(&x1->high_low_container);
@@ -668,13 +1027,26 @@ void roaring_bitmap_and_inplace(roaring_bitmap_t *x1,
             c1 = get_writable_copy_if_shared(c1, &typecode1);
             void *c2 = ra_get_container_at_index(&x2->high_low_container, pos2,
                                                  &typecode2);
-            void *c =
-                container_iand(c1, typecode1, c2, typecode2, &typecode_result);
+            int32_t n_runs = -1;
+            void *c = autorun_bitsets(c1, typecode1, c2, typecode2,
+                                      bitset_container_and_runs, true,
+                                      !lazy && is_autorun(x1), &typecode_result,
+                                      &n_runs);
+            if (c == NULL) {
+                c = lazy ? container_lazy_iand(c1, typecode1, c2, typecode2,
+                                               &typecode_result)
+                         : container_iand(c1, typecode1, c2, typecode2,
+                                          &typecode_result);
+            }
             if (c != c1) {  // in this instance a new container was created, and
                             // we need to free the old one
                 container_free(c1, typecode1);
             }
             if (container_nonzero_cardinality(c, typecode_result)) {
+                if (!lazy) {
+                    c = autorun_container(c, &typecode_result, n_runs,
+                                          is_autorun(x1));
+                }
                 ra_replace_key_and_container_at_index(&x1->high_low_container,
                                                       intersection_size, s1, c,
                                                       typecode_result);
@@ -703,6 +1075,16 @@ void roaring_bitmap_and_inplace(roaring_bitmap_t *x1,
     ra_downsize(&x1->high_low_container, intersection_size);
 }
 
+void roaring_bitmap_and_inplace(roaring_bitmap_t *x1,
+                                const roaring_bitmap_t *x2) {
+    and_inplace(x1, x2, false);
+}
+
+void roaring_bitmap_lazy_and_inplace(roaring_bitmap_t *x1,
+                                     const roaring_bitmap_t *x2) {
+    and_inplace(x1, x2, true);
+}
+
 roaring_bitmap_t *roaring_bitmap_or(const roaring_bitmap_t *x1,
                                     const roaring_bitmap_t *x2) {
     uint8_t container_result_type = 0;
@@ -717,6 +1099,8 @@ roaring_bitmap_t *roaring_bitmap_or(const roaring_bitmap_t *x1,
     roaring_bitmap_t *answer =
         roaring_bitmap_create_with_capacity(length1 + length2);
     roaring_bitmap_set_copy_on_write(answer, is_cow(x1) && is_cow(x2));
+    const bool autorun = is_autorun(x1) || is_autorun(x2);
+    roaring_bitmap_set_auto_run(answer, autorun);
     int pos1 = 0, pos2 = 0;
     uint8_t container_type_1, container_type_2;
     uint16_t s1 = ra_get_key_at_index(&x1->high_low_container, pos1);
@@ -727,8 +1111,16 @@ roaring_bitmap_t *roaring_bitmap_or(const roaring_bitmap_t *x1,
                                                  &container_type_1);
             void *c2 = ra_get_container_at_index(&x2->high_low_container, pos2,
                                                  &container_type_2);
-            void *c = container_or(c1, container_type_1, c2, container_type_2,
-                                   &container_result_type);
+            int32_t n_runs = -1;
+            void *c = autorun_bitsets(c1, container_type_1, c2,
+                                      container_type_2,
+                                      bitset_container_or_runs, false, autorun,
+                                      &container_result_type, &n_runs);
+            if (c == NULL) {
+                c = container_or(c1, container_type_1, c2, container_type_2,
+                                 &container_result_type);
+            }
+            c = autorun_container(c, &container_result_type, n_runs, autorun);
             // since we assume that the initial containers are non-empty, the
             // result here
             // can only be non-empty
@@ -742,32 +1134,22 @@ roaring_bitmap_t *roaring_bitmap_or(const roaring_bitmap_t *x1,
             s2 = ra_get_key_at_index(&x2->high_low_container, pos2);
 
         } else if (s1 < s2) {  // s1 < s2
-            void *c1 = ra_get_container_at_index(&x1->high_low_container, pos1,
-                                                 &container_type_1);
-            // c1 = container_clone(c1, container_type_1);
-            c1 =
-                get_copy_of_container(c1, &container_type_1, is_cow(x1));
-            if (is_cow(x1)) {
-                ra_set_container_at_index(&x1->high_low_container, pos1, c1,
-                                          container_type_1);
-            }
-            ra_append(&answer->high_low_container, s1, c1, container_type_1);
-            pos1++;
+            const int next_pos1 =
+                ra_advance_until(&x1->high_low_container, s2, pos1);
+            ra_append_copy_range(&answer->high_low_container,
+                                 &x1->high_low_container, pos1, next_pos1,
+                                 is_cow(x1));
+            pos1 = next_pos1;
             if (pos1 == length1) break;
             s1 = ra_get_key_at_index(&x1->high_low_container, pos1);
 
         } else {  // s1 > s2
-            void *c2 = ra_get_container_at_index(&x2->high_low_container, pos2,
-                                                 &container_type_2);
-            // c2 = container_clone(c2, container_type_2);
-            c2 =
-                get_copy_of_container(c2, &container_type_2, is_cow(x2));
-            if (is_cow(x2)) {
-                ra_set_container_at_index(&x2->high_low_container, pos2, c2,
-                                          container_type_2);
-            }
-            ra_append(&answer->high_low_container, s2, c2, container_type_2);
-            pos2++;
+            const int next_pos2 =
+                ra_advance_until(&x2->high_low_container, s1, pos2);
+            ra_append_copy_range(&answer->high_low_container,
+                                 &x2->high_low_container, pos2, next_pos2,
+                                 is_cow(x2));
+            pos2 = next_pos2;
             if (pos2 == length2) break;
             s2 = ra_get_key_at_index(&x2->high_low_container, pos2);
         }
@@ -810,14 +1192,22 @@ void roaring_bitmap_or_inplace(roaring_bitmap_t *x1,
 
                 void *c2 = ra_get_container_at_index(&x2->high_low_container,
                                                      pos2, &container_type_2);
-                void *c =
-                    container_ior(c1, container_type_1, c2, container_type_2,
-                                  &container_result_type);
+                int32_t n_runs = -1;
+                void *c = autorun_bitsets(
+                    c1, container_type_1, c2, container_type_2,
+                    bitset_container_or_runs, true, is_autorun(x1),
+                    &container_result_type, &n_runs);
+                if (c == NULL) {
+                    c = container_ior(c1, container_type_1, c2,
+                                      container_type_2, &container_result_type);
+                }
                 if (c !=
                     c1) {  // in this instance a new container was created, and
                            // we need to free the old one
                     container_free(c1, container_type_1);
                 }
+                c = autorun_container(c, &container_result_type, n_runs,
+                                      is_autorun(x1));
 
                 ra_set_container_at_index(&x1->high_low_container, pos1, c,
                                           container_result_type);
@@ -830,7 +1220,7 @@ void roaring_bitmap_or_inplace(roaring_bitmap_t *x1,
             s2 = ra_get_key_at_index(&x2->high_low_container, pos2);
 
         } else if (s1 < s2) {  // s1 < s2
-            pos1++;
+            pos1 = ra_advance_until(&x1->high_low_container, s2, pos1);
             if (pos1 == length1) break;
             s1 = ra_get_key_at_index(&x1->high_low_container, pos1);
 
@@ -874,6 +1264,8 @@ roaring_bitmap_t *roaring_bitmap_xor(const roaring_bitmap_t *x1,
     roaring_bitmap_t *answer =
         roaring_bitmap_create_with_capacity(length1 + length2);
     roaring_bitmap_set_copy_on_write(answer, is_cow(x1) && is_cow(x2));
+    const bool autorun = is_autorun(x1) || is_autorun(x2);
+    roaring_bitmap_set_auto_run(answer, autorun);
     int pos1 = 0, pos2 = 0;
     uint8_t container_type_1, container_type_2;
     uint16_t s1 = ra_get_key_at_index(&x1->high_low_container, pos1);
@@ -884,10 +1276,19 @@ roaring_bitmap_t *roaring_bitmap_xor(const roaring_bitmap_t *x1,
                                                  &container_type_1);
             void *c2 = ra_get_container_at_index(&x2->high_low_container, pos2,
                                                  &container_type_2);
-            void *c = container_xor(c1, container_type_1, c2, container_type_2,
-                                    &container_result_type);
+            int32_t n_runs = -1;
+            void *c = autorun_bitsets(c1, container_type_1, c2,
+                                      container_type_2,
+                                      bitset_container_xor_runs, false, autorun,
+                                      &container_result_type, &n_runs);
+            if (c == NULL) {
+                c = container_xor(c1, container_type_1, c2, container_type_2,
+                                  &container_result_type);
+            }
 
             if (container_nonzero_cardinality(c, container_result_type)) {
+                c = autorun_container(c, &container_result_type, n_runs,
+                                      autorun);
                 ra_append(&answer->high_low_container, s1, c,
                           container_result_type);
             } else {
@@ -901,30 +1302,22 @@ roaring_bitmap_t *roaring_bitmap_xor(const roaring_bitmap_t *x1,
             s2 = ra_get_key_at_index(&x2->high_low_container, pos2);
 
         } else if (s1 < s2) {  // s1 < s2
-            void *c1 = ra_get_container_at_index(&x1->high_low_container, pos1,
-                                                 &container_type_1);
-            c1 =
-                get_copy_of_container(c1, &container_type_1, is_cow(x1));
-            if (is_cow(x1)) {
-                ra_set_container_at_index(&x1->high_low_container, pos1, c1,
-                                          container_type_1);
-            }
-            ra_append(&answer->high_low_container, s1, c1, container_type_1);
-            pos1++;
+            const int next_pos1 =
+                ra_advance_until(&x1->high_low_container, s2, pos1);
+            ra_append_copy_range(&answer->high_low_container,
+                                 &x1->high_low_container, pos1, next_pos1,
+                                 is_cow(x1));
+            pos1 = next_pos1;
             if (pos1 == length1) break;
             s1 = ra_get_key_at_index(&x1->high_low_container, pos1);
 
         } else {  // s1 > s2
-            void *c2 = ra_get_container_at_index(&x2->high_low_container, pos2,
-                                                 &container_type_2);
-            c2 =
-                get_copy_of_container(c2, &container_type_2, is_cow(x2));
-            if (is_cow(x2)) {
-                ra_set_container_at_index(&x2->high_low_container, pos2, c2,
-                                          container_type_2);
-            }
-            ra_append(&answer->high_low_container, s2, c2, container_type_2);
-            pos2++;
+            const int next_pos2 =
+                ra_advance_until(&x2->high_low_container, s1, pos2);
+            ra_append_copy_range(&answer->high_low_container,
+                                 &x2->high_low_container, pos2, next_pos2,
+                                 is_cow(x2));
+            pos2 = next_pos2;
             if (pos2 == length2) break;
             s2 = ra_get_key_at_index(&x2->high_low_container, pos2);
         }
@@ -972,10 +1365,20 @@ void roaring_bitmap_xor_inplace(roaring_bitmap_t *x1,
 
             void *c2 = ra_get_container_at_index(&x2->high_low_container, pos2,
                                                  &container_type_2);
-            void *c = container_ixor(c1, container_type_1, c2, container_type_2,
-                                     &container_result_type);
+            int32_t n_runs = -1;
+            void *c = autorun_bitsets(c1, container_type_1, c2,
+                                      container_type_2,
+                                      bitset_container_xor_runs, true,
+                                      is_autorun(x1), &container_result_type,
+                                      &n_runs);
+            if (c == NULL) {
+                c = container_ixor(c1, container_type_1, c2, container_type_2,
+                                   &container_result_type);
+            }
 
             if (container_nonzero_cardinality(c, container_result_type)) {
+                c = autorun_container(c, &container_result_type, n_runs,
+                                      is_autorun(x1));
                 ra_set_container_at_index(&x1->high_low_container, pos1, c,
                                           container_result_type);
                 ++pos1;
@@ -992,7 +1395,7 @@ void roaring_bitmap_xor_inplace(roaring_bitmap_t *x1,
             s2 = ra_get_key_at_index(&x2->high_low_container, pos2);
 
         } else if (s1 < s2) {  // s1 < s2
-            pos1++;
+            pos1 = ra_advance_until(&x1->high_low_container, s2, pos1);
             if (pos1 == length1) break;
             s1 = ra_get_key_at_index(&x1->high_low_container, pos1);
 
@@ -1036,6 +1439,8 @@ roaring_bitmap_t *roaring_bitmap_andnot(const roaring_bitmap_t *x1,
     }
     roaring_bitmap_t *answer = roaring_bitmap_create_with_capacity(length1);
     roaring_bitmap_set_copy_on_write(answer, is_cow(x1) && is_cow(x2));
+    const bool autorun = is_autorun(x1) || is_autorun(x2);
+    roaring_bitmap_set_auto_run(answer, autorun);
 
     int pos1 = 0, pos2 = 0;
     uint8_t container_type_1, container_type_2;
@@ -1050,11 +1455,19 @@ roaring_bitmap_t *roaring_bitmap_andnot(const roaring_bitmap_t *x1,
                                                  &container_type_1);
             void *c2 = ra_get_container_at_index(&x2->high_low_container, pos2,
                                                  &container_type_2);
-            void *c =
-                container_andnot(c1, container_type_1, c2, container_type_2,
-                                 &container_result_type);
+            int32_t n_runs = -1;
+            void *c = autorun_bitsets(c1, container_type_1, c2,
+                                      container_type_2,
+                                      bitset_container_andnot_runs, false,
+                                      autorun, &container_result_type, &n_runs);
+            if (c == NULL) {
+                c = container_andnot(c1, container_type_1, c2,
+                                     container_type_2, &container_result_type);
+            }
 
             if (container_nonzero_cardinality(c, container_result_type)) {
+                c = autorun_container(c, &container_result_type, n_runs,
+                                      autorun);
                 ra_append(&answer->high_low_container, s1, c,
                           container_result_type);
             } else {
@@ -1089,8 +1502,8 @@ roaring_bitmap_t *roaring_bitmap_andnot(const roaring_bitmap_t *x1,
 
 // inplace andnot (modifies its first argument).
 
-void roaring_bitmap_andnot_inplace(roaring_bitmap_t *x1,
-                                   const roaring_bitmap_t *x2) {
+static void andnot_inplace(roaring_bitmap_t *x1, const roaring_bitmap_t *x2,
+                           bool lazy) {
     assert(x1 != x2);
 
     uint8_t container_result_type = 0;
@@ -1117,11 +1530,26 @@ void roaring_bitmap_andnot_inplace(roaring_bitmap_t *x1,
 
             void *c2 = ra_get_container_at_index(&x2->high_low_container, pos2,
                                                  &container_type_2);
-            void *c =
-                container_iandnot(c1, container_type_1, c2, container_type_2,
-                                  &container_result_type);
+            int32_t n_runs = -1;
+            void *c = autorun_bitsets(c1, container_type_1, c2,
+                                      container_type_2,
+                                      bitset_container_andnot_runs, true,
+                                      !lazy && is_autorun(x1),
+                                      &container_result_type, &n_runs);
+            if (c == NULL) {
+                c = lazy ? container_lazy_iandnot(c1, container_type_1, c2,
+                                                  container_type_2,
+                                                  &container_result_type)
+                         : container_iandnot(c1, container_type_1, c2,
+                                             container_type_2,
+                                             &container_result_type);
+            }
 
             if (container_nonzero_cardinality(c, container_result_type)) {
+                if (!lazy) {
+                    c = autorun_container(c, &container_result_type, n_runs,
+                                          is_autorun(x1));
+                }
                 ra_replace_key_and_container_at_index(&x1->high_low_container,
                                                       intersection_size++, s1,
                                                       c, container_result_type);
@@ -1175,6 +1603,16 @@ void roaring_bitmap_andnot_inplace(roaring_bitmap_t *x1,
     ra_downsize(&x1->high_low_container, intersection_size);
 }
 
+void roaring_bitmap_andnot_inplace(roaring_bitmap_t *x1,
+                                   const roaring_bitmap_t *x2) {
+    andnot_inplace(x1, x2, false);
+}
+
+void roaring_bitmap_lazy_andnot_inplace(roaring_bitmap_t *x1,
+                                        const roaring_bitmap_t *x2) {
+    andnot_inplace(x1, x2, true);
+}
+
 uint64_t roaring_bitmap_get_cardinality(const roaring_bitmap_t *ra) {
     uint64_t card = 0;
     for (int i = 0; i < ra->high_low_container.size; ++i)
@@ -1251,6 +1689,40 @@ bool roaring_bitmap_range_uint32_array(const roaring_bitmap_t *ra, size_t offset
     return ra_range_uint32_array(&ra->high_low_container, offset, limit, ans);
 }
 
+bool roaring_bitmap_range_uint32_array_descending(const roaring_bitmap_t *ra,
+                                                  size_t offset, size_t limit,
+                                                  uint32_t *ans) {
+    const roaring_array_t *hlc = &ra->high_low_container;
+    int32_t i = hlc->size - 1;
+    // skip whole containers from the top
+    for (; i >= 0; i--) {
+        const size_t card =
+            container_get_cardinality(hlc->containers[i], hlc->typecodes[i]);
+        if (offset < card) break;
+        offset -= card;
+    }
+    if (i < 0 || limit == 0) return true;
+    const uint32_t card =
+        container_get_cardinality(hlc->containers[i], hlc->typecodes[i]);
+    uint32_t start_rank = 0;
+    uint32_t element = 0;
+    if (!container_select(hlc->containers[i], hlc->typecodes[i], &start_rank,
+                          card - 1 - (uint32_t)offset, &element)) {
+        return false;
+    }
+    roaring_uint32_iterator_t it;
+    it.parent = ra;
+    roaring_move_uint32_iterator_equalorlarger(
+        &it, ((uint32_t)hlc->keys[i] << 16) | element);
+    while (limit > 0 && it.has_value) {
+        const uint32_t chunk = limit > UINT32_MAX ? UINT32_MAX : (uint32_t)limit;
+        const uint32_t got = roaring_read_previous_uint32_iterator(&it, ans, chunk);
+        ans += got;
+        limit -= got;
+    }
+    return true;
+}
+
 /** convert array and bitmap containers to run containers when it is more
  * efficient;
  * also convert from run containers when more space efficient.  Returns
@@ -1319,26 +1791,54 @@ bool roaring_bitmap_remove_run_compression(roaring_bitmap_t *r) {
     return answer;
 }
 
+// the size of the portable format and the cardinality, in a single pass
+static size_t portable_size_and_cardinality(const roaring_bitmap_t *ra,
+                                            uint64_t *cardinality) {
+    const roaring_array_t *hlc = &ra->high_low_container;
+    size_t portablesize = ra_portable_header_size(hlc);
+    uint64_t card = 0;
+    for (int32_t i = 0; i < hlc->size; ++i) {
+        portablesize +=
+            container_size_in_bytes(hlc->containers[i], hlc->typecodes[i]);
+        card += container_get_cardinality(hlc->containers[i],
+                                          hlc->typecodes[i]);
+    }
+    *cardinality = card;
+    return portablesize;
+}
+
+// writes the bitmap as an array of values, for roaring_bitmap_serialize
+static size_t serialize_as_array(const roaring_bitmap_t *ra,
+                                 uint64_t cardinality, char *buf) {
+    buf[0] = SERIALIZATION_ARRAY_UINT32;
+    memcpy(buf + 1, &cardinality, sizeof(uint32_t));
+    roaring_bitmap_to_uint32_array(ra,
+                                   (uint32_t *)(buf + 1 + sizeof(uint32_t)));
+    return 1 + sizeof(uint32_t) + (size_t)cardinality * sizeof(uint32_t);
+}
+
 size_t roaring_bitmap_serialize(const roaring_bitmap_t *ra, char *buf) {
-    size_t portablesize = roaring_bitmap_portable_size_in_bytes(ra);
-    uint64_t cardinality = roaring_bitmap_get_cardinality(ra);
+    roaring_serialization_t s;
+    if (roaring_serialization_init(ra, &s)) {
+        size_t written = roaring_serialization_write(&s, buf);
+        roaring_serialization_free(&s);
+        return written;
+    }
+    // without memory for the header, it is computed again while writing
+    uint64_t cardinality;
+    size_t portablesize = portable_size_and_cardinality(ra, &cardinality);
     uint64_t sizeasarray = cardinality * sizeof(uint32_t) + sizeof(uint32_t);
     if (portablesize < sizeasarray) {
         buf[0] = SERIALIZATION_CONTAINER;
         return roaring_bitmap_portable_serialize(ra, buf + 1) + 1;
-    } else {
-        buf[0] = SERIALIZATION_ARRAY_UINT32;
-        memcpy(buf + 1, &cardinality, sizeof(uint32_t));
-        roaring_bitmap_to_uint32_array(
-            ra, (uint32_t *)(buf + 1 + sizeof(uint32_t)));
-        return 1 + (size_t)sizeasarray;
     }
+    return serialize_as_array(ra, cardinality, buf);
 }
 
 size_t roaring_bitmap_size_in_bytes(const roaring_bitmap_t *ra) {
-    size_t portablesize = roaring_bitmap_portable_size_in_bytes(ra);
-    uint64_t sizeasarray = roaring_bitmap_get_cardinality(ra) * sizeof(uint32_t) +
-                         sizeof(uint32_t);
+    uint64_t cardinality;
+    size_t portablesize = portable_size_and_cardinality(ra, &cardinality);
+    uint64_t sizeasarray = cardinality * sizeof(uint32_t) + sizeof(uint32_t);
     return portablesize < sizeasarray ? portablesize + 1 : (size_t)sizeasarray + 1;
 }
 
@@ -1379,6 +1879,102 @@ size_t roaring_bitmap_portable_serialize(const roaring_bitmap_t *ra,
     return ra_portable_serialize(&ra->high_low_container, buf);
 }
 
+size_t roaring_bitmap_portable_packed_size_in_bytes(const roaring_bitmap_t *ra) {
+    return ra_portable_packed_size_in_bytes(&ra->high_low_container);
+}
+
+size_t roaring_bitmap_portable_packed_serialize(const roaring_bitmap_t *ra,
+                                                char *buf) {
+    return ra_portable_packed_serialize(&ra->high_low_container, buf);
+}
+
+bool roaring_serialization_init(const roaring_bitmap_t *ra,
+                                roaring_serialization_t *s) {
+    const roaring_array_t *hlc = &ra->high_low_container;
+    s->bitmap = ra;
+    s->header = (char *)malloc(ra_portable_header_size(hlc));
+    if (s->header == NULL) return false;
+    s->header_size = ra_portable_header_write(hlc, s->header, &s->cardinality,
+                                              &s->portable_size_in_bytes);
+    uint64_t sizeasarray = s->cardinality * sizeof(uint32_t) + sizeof(uint32_t);
+    s->size_in_bytes = s->portable_size_in_bytes < sizeasarray
+                           ? s->portable_size_in_bytes + 1
+                           : (size_t)sizeasarray + 1;
+    // the header, then one payload per container and one more for the number
+    // of runs of a run container
+    s->n_iovecs = 1 + hlc->size;
+    for (int32_t i = 0; i < hlc->size; ++i) {
+        if (get_container_type(hlc->containers[i], hlc->typecodes[i]) ==
+            RUN_CONTAINER_TYPE_CODE) {
+            s->n_iovecs++;
+        }
+    }
+    return true;
+}
+
+void roaring_serialization_free(roaring_serialization_t *s) {
+    free(s->header);
+    s->header = NULL;
+}
+
+size_t roaring_serialization_write(const roaring_serialization_t *s,
+                                   char *buf) {
+    uint64_t sizeasarray = s->cardinality * sizeof(uint32_t) + sizeof(uint32_t);
+    if (s->portable_size_in_bytes < sizeasarray) {
+        buf[0] = SERIALIZATION_CONTAINER;
+        return roaring_serialization_portable_write(s, buf + 1) + 1;
+    }
+    return serialize_as_array(s->bitmap, s->cardinality, buf);
+}
+
+size_t roaring_serialization_portable_write(const roaring_serialization_t *s,
+                                            char *buf) {
+    const roaring_array_t *hlc = &s->bitmap->high_low_container;
+    memcpy(buf, s->header, s->header_size);
+    buf += s->header_size;
+    for (int32_t i = 0; i < hlc->size; ++i) {
+        buf += container_write(hlc->containers[i], hlc->typecodes[i], buf);
+    }
+    return s->portable_size_in_bytes;
+}
+
+int32_t roaring_serialization_portable_iovecs(
+    const roaring_serialization_t *s, roaring_iovec_t *iov) {
+    const roaring_array_t *hlc = &s->bitmap->high_low_container;
+    roaring_iovec_t *out = iov;
+    out->base = s->header;
+    out->len = s->header_size;
+    out++;
+    for (int32_t i = 0; i < hlc->size; ++i) {
+        uint8_t typecode = hlc->typecodes[i];
+        const void *c = container_unwrap_shared(hlc->containers[i], &typecode);
+        switch (typecode) {
+            case BITSET_CONTAINER_TYPE_CODE:
+                out->base = ((const bitset_container_t *)c)->array;
+                out->len = BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t);
+                break;
+            case ARRAY_CONTAINER_TYPE_CODE:
+                out->base = ((const array_container_t *)c)->array;
+                out->len = ((const array_container_t *)c)->cardinality *
+                           sizeof(uint16_t);
+                break;
+            default: {
+                // as in run_container_write, the number of runs is written
+                // as the low 16 bits of n_runs
+                const run_container_t *run = (const run_container_t *)c;
+                out->base = &run->n_runs;
+                out->len = sizeof(uint16_t);
+                out++;
+                out->base = run->runs;
+                out->len = run->n_runs * sizeof(rle16_t);
+            }
+        }
+        out++;
+    }
+    assert(out - iov == s->n_iovecs);
+    return s->n_iovecs;
+}
+
 roaring_bitmap_t *roaring_bitmap_deserialize(const void *buf) {
     const char *bufaschar = (const char *)buf;
     if (*(const unsigned char *)buf == SERIALIZATION_ARRAY_UINT32) {
@@ -1827,26 +2423,456 @@ uint32_t roaring_read_uint32_iterator(roaring_uint32_iterator_t *it, uint32_t* b
 
 
 
-void roaring_free_uint32_iterator(roaring_uint32_iterator_t *it) { free(it); }
-
-/****
-* end of roaring_uint32_iterator_t
-*****/
+uint32_t roaring_read_previous_uint32_iterator(roaring_uint32_iterator_t *it,
+                                               uint32_t *buf, uint32_t count) {
+  uint32_t ret = 0;
+  uint32_t num_values;
+  int32_t wordindex;  // used for bitsets
+  uint64_t word;      // used for bitsets
 
-bool roaring_bitmap_equals(const roaring_bitmap_t *ra1,
-                           const roaring_bitmap_t *ra2) {
-    if (ra1->high_low_container.size != ra2->high_low_container.size) {
-        return false;
-    }
-    for (int i = 0; i < ra1->high_low_container.size; ++i) {
-        if (ra1->high_low_container.keys[i] !=
-            ra2->high_low_container.keys[i]) {
-            return false;
+  while (it->has_value && ret < count) {
+    switch (it->typecode) {
+      case BITSET_CONTAINER_TYPE_CODE: {
+        const bitset_container_t *bcont = (const bitset_container_t *)(it->container);
+        wordindex = it->in_container_index / 64;
+        word = bcont->array[wordindex] & (UINT64_MAX >> (63 - (it->in_container_index % 64)));
+        do {
+          while (word != 0 && ret < count) {
+            int bit = 63 - __builtin_clzll(word);
+            buf[0] = it->highbits | (wordindex * 64 + bit);
+            word ^= UINT64_C(1) << bit;
+            buf++;
+            ret++;
+          }
+          while (word == 0 && wordindex > 0) {
+            wordindex--;
+            word = bcont->array[wordindex];
+          }
+        } while (word != 0 && ret < count);
+        it->has_value = (word != 0);
+        if (it->has_value) {
+          it->in_container_index = wordindex * 64 + (63 - __builtin_clzll(word));
+          it->current_value = it->highbits | it->in_container_index;
         }
-    }
-    for (int i = 0; i < ra1->high_low_container.size; ++i) {
-        bool areequal = container_equals(ra1->high_low_container.containers[i],
-                                         ra1->high_low_container.typecodes[i],
+        break;
+      }
+      case ARRAY_CONTAINER_TYPE_CODE: {
+        const array_container_t *acont = (const array_container_t *)(it->container);
+        num_values = minimum_uint32(it->in_container_index + 1, count - ret);
+        for (uint32_t i = 0; i < num_values; i++) {
+          buf[i] = it->highbits | acont->array[it->in_container_index - i];
+        }
+        buf += num_values;
+        ret += num_values;
+        it->in_container_index -= num_values;
+        it->has_value = (it->in_container_index >= 0);
+        if (it->has_value) {
+          it->current_value = it->highbits | acont->array[it->in_container_index];
+        }
+        break;
+      }
+      case RUN_CONTAINER_TYPE_CODE: {
+        const run_container_t *rcont = (const run_container_t *)(it->container);
+        do {
+          uint32_t smallest_run_value = it->highbits | rcont->runs[it->run_index].value;
+          uint32_t run_left = it->current_value - smallest_run_value + 1;
+          num_values = minimum_uint32(run_left, count - ret);
+          for (uint32_t i = 0; i < num_values; i++) {
+            buf[i] = it->current_value - i;
+          }
+          buf += num_values;
+          ret += num_values;
+          if (num_values == run_left) {  // the run is exhausted
+            it->run_index--;
+            if (it->run_index >= 0) {
+              it->current_value = it->highbits | (rcont->runs[it->run_index].value +
+                                                  rcont->runs[it->run_index].length);
+            } else {
+              it->has_value = false;
+            }
+          } else {
+            it->current_value -= num_values;
+          }
+        } while ((ret < count) && it->has_value);
+        break;
+      }
+      default:
+        assert(false);
+    }
+    if (it->has_value) {
+      assert(ret == count);
+      return ret;
+    }
+    it->container_index--;
+    it->has_value = loadlastvalue(it);
+  }
+  return ret;
+}
+
+void roaring_free_uint32_iterator(roaring_uint32_iterator_t *it) { free(it); }
+
+// Moves the iterator forward to the first value >= val; never moves it back.
+// Seeks on keys first (galloping from the current container), and only
+// searches within a container once its key matches.
+static bool iter_skip_to(roaring_uint32_iterator_t *it, uint32_t val) {
+    if (!it->has_value) return false;
+    if (it->current_value >= val) return true;
+    const roaring_array_t *ra = &it->parent->high_low_container;
+    const uint16_t hb = val >> 16;
+    int32_t i = it->container_index;
+    if ((it->highbits >> 16) != hb) {
+        i = ra_advance_until(ra, hb, i);
+        if (i >= ra->size || ra->keys[i] != hb) {
+            it->container_index = i;
+            return (it->has_value = loadfirstvalue(it));
+        }
+    }
+    if (container_maximum(ra->containers[i], ra->typecodes[i]) <
+        (val & 0xFFFF)) {
+        it->container_index = i + 1;
+        return (it->has_value = loadfirstvalue(it));
+    }
+    it->container_index = i;
+    return (it->has_value = loadfirstvalue_largeorequal(it, val));
+}
+
+// Leapfrog: seeks every iterator in turn to the candidate, which grows to
+// whatever value an iterator lands on, until all n agree.
+static bool intersection_iterator_find(roaring_intersection_iterator_t *it,
+                                       uint32_t target) {
+    size_t agree = 0;
+    size_t k = 0;
+    while (true) {
+        roaring_uint32_iterator_t *cur = &it->iterators[k];
+        if (!iter_skip_to(cur, target)) {
+            it->current_value = UINT32_MAX;
+            return (it->has_value = false);
+        }
+        if (cur->current_value != target) {
+            target = cur->current_value;
+            agree = 0;
+        }
+        if (++agree == it->n) {
+            it->current_value = target;
+            return (it->has_value = true);
+        }
+        k = (k + 1 == it->n) ? 0 : k + 1;
+    }
+}
+
+roaring_intersection_iterator_t *roaring_create_intersection_iterator(
+    size_t n, const roaring_bitmap_t **bitmaps) {
+    roaring_intersection_iterator_t *it =
+        (roaring_intersection_iterator_t *)malloc(
+            sizeof(roaring_intersection_iterator_t) +
+            n * sizeof(roaring_uint32_iterator_t));
+    if (it == NULL) return NULL;
+    it->iterators = (roaring_uint32_iterator_t *)(it + 1);
+    it->n = n;
+    // the bitmaps with the fewest containers go first: they propose the
+    // rarest candidates and make the others skip the furthest
+    for (size_t i = 0; i < n; i++) {
+        size_t j = i;
+        while (j > 0 && bitmaps[i]->high_low_container.size <
+                            it->iterators[j - 1].parent->high_low_container.size) {
+            it->iterators[j] = it->iterators[j - 1];
+            j--;
+        }
+        roaring_init_iterator(bitmaps[i], &it->iterators[j]);
+    }
+    if (n == 0) {
+        it->current_value = UINT32_MAX;
+        it->has_value = false;
+    } else {
+        intersection_iterator_find(it, 0);
+    }
+    return it;
+}
+
+bool roaring_advance_intersection_iterator(
+    roaring_intersection_iterator_t *it) {
+    if (!it->has_value || it->current_value == UINT32_MAX) {
+        it->current_value = UINT32_MAX;
+        return (it->has_value = false);
+    }
+    return intersection_iterator_find(it, it->current_value + 1);
+}
+
+bool roaring_move_intersection_iterator_equalorlarger(
+    roaring_intersection_iterator_t *it, uint32_t val) {
+    if (!it->has_value) return false;
+    if (it->current_value >= val) return true;
+    return intersection_iterator_find(it, val);
+}
+
+uint32_t roaring_read_intersection_iterator(roaring_intersection_iterator_t *it,
+                                            uint32_t *buf, uint32_t count) {
+    uint32_t ret = 0;
+    while (it->has_value && ret < count) {
+        buf[ret++] = it->current_value;
+        roaring_advance_intersection_iterator(it);
+    }
+    return ret;
+}
+
+void roaring_free_intersection_iterator(roaring_intersection_iterator_t *it) {
+    free(it);
+}
+
+static inline uint16_t merge_iterator_key(const roaring_merge_iterator_t *it,
+                                          int32_t i) {
+    return it->parents[i]->high_low_container.keys[it->positions[i]];
+}
+
+// the heap holds the inputs having containers left, ordered by next key
+static void merge_iterator_percolate_down(roaring_merge_iterator_t *it,
+                                          int32_t i) {
+    const int32_t size = it->heap_size;
+    const int32_t ai = it->heap[i];
+    const uint16_t ki = merge_iterator_key(it, ai);
+    while (2 * i + 1 < size) {
+        int32_t l = 2 * i + 1;
+        if (l + 1 < size && merge_iterator_key(it, it->heap[l + 1]) <
+                                merge_iterator_key(it, it->heap[l])) {
+            l++;
+        }
+        if (ki <= merge_iterator_key(it, it->heap[l])) break;
+        it->heap[i] = it->heap[l];
+        i = l;
+    }
+    it->heap[i] = ai;
+}
+
+static void merge_iterator_heapify(roaring_merge_iterator_t *it) {
+    it->heap_size = 0;
+    for (int32_t i = 0; i < (int32_t)it->n; i++) {
+        if (it->positions[i] < it->parents[i]->high_low_container.size) {
+            it->heap[it->heap_size++] = i;
+        }
+    }
+    for (int32_t i = it->heap_size / 2 - 1; i >= 0; i--) {
+        merge_iterator_percolate_down(it, i);
+    }
+}
+
+static void merge_iterator_release(roaring_merge_iterator_t *it) {
+    if (it->owned) {
+        container_free(it->container, it->typecode);
+        it->owned = false;
+    }
+    it->container = NULL;
+}
+
+// Computes the union of all containers sharing the smallest pending key.
+// When a single input has the key, its container is used as is.
+static bool merge_iterator_next_union(roaring_merge_iterator_t *it) {
+    if (it->heap_size == 0) return false;
+    const int32_t first = it->heap[0];
+    const roaring_array_t *ra = &it->parents[first]->high_low_container;
+    it->key = merge_iterator_key(it, first);
+    it->container = ra->containers[it->positions[first]];
+    it->typecode = ra->typecodes[it->positions[first]];
+    // lazy operations suffice: iterating does not need the cardinality
+    while (it->heap_size > 0 && merge_iterator_key(it, it->heap[0]) == it->key) {
+        const int32_t i = it->heap[0];
+        ra = &it->parents[i]->high_low_container;
+        if (i != first) {
+            void *c2 = ra->containers[it->positions[i]];
+            uint8_t type2 = ra->typecodes[it->positions[i]];
+            uint8_t result_type = 0;
+            void *c;
+            if (!it->owned) {
+                c = container_lazy_or(it->container, it->typecode, c2, type2,
+                                      &result_type);
+                it->owned = true;
+            } else {
+                c = container_lazy_ior(it->container, it->typecode, c2, type2,
+                                       &result_type);
+                if (c != it->container) {
+                    container_free(it->container, it->typecode);
+                }
+            }
+            it->container = c;
+            it->typecode = result_type;
+        }
+        if (++it->positions[i] < ra->size) {
+            merge_iterator_percolate_down(it, 0);
+        } else {
+            it->heap[0] = it->heap[--it->heap_size];
+            if (it->heap_size > 0) merge_iterator_percolate_down(it, 0);
+        }
+    }
+    return true;
+}
+
+// Computes the next non-empty container of the first input minus the others.
+static bool merge_iterator_next_andnot(roaring_merge_iterator_t *it) {
+    if (it->n == 0) return false;
+    const roaring_array_t *ra1 = &it->parents[0]->high_low_container;
+    while (it->positions[0] < ra1->size) {
+        const int32_t pos = it->positions[0]++;
+        it->key = ra1->keys[pos];
+        it->container = ra1->containers[pos];
+        it->typecode = ra1->typecodes[pos];
+        for (size_t i = 1; i < it->n; i++) {
+            const roaring_array_t *ra = &it->parents[i]->high_low_container;
+            it->positions[i] =
+                ra_advance_until(ra, it->key, it->positions[i] - 1);
+            if (it->positions[i] >= ra->size ||
+                ra->keys[it->positions[i]] != it->key) {
+                continue;
+            }
+            void *c2 = ra->containers[it->positions[i]];
+            uint8_t type2 = ra->typecodes[it->positions[i]];
+            uint8_t result_type = 0;
+            if (!it->owned) {
+                it->container = container_andnot(it->container, it->typecode,
+                                                 c2, type2, &result_type);
+                it->owned = true;
+            } else {
+                it->container = container_iandnot(it->container, it->typecode,
+                                                  c2, type2, &result_type);
+            }
+            it->typecode = result_type;
+            if (!container_nonzero_cardinality(it->container, it->typecode)) {
+                break;
+            }
+        }
+        if (container_nonzero_cardinality(it->container, it->typecode)) {
+            return true;
+        }
+        merge_iterator_release(it);
+    }
+    return false;
+}
+
+// Moves to the first value of the next key having values.
+static bool merge_iterator_load_next(roaring_merge_iterator_t *it) {
+    merge_iterator_release(it);
+    bool found = it->andnot ? merge_iterator_next_andnot(it)
+                            : merge_iterator_next_union(it);
+    if (!found) {
+        it->current_value = UINT32_MAX;
+        return (it->has_value = false);
+    }
+    roaring_init_iterator(&it->view, &it->inner);
+    it->current_value = it->inner.current_value;
+    return (it->has_value = true);
+}
+
+static roaring_merge_iterator_t *merge_iterator_create(
+    size_t n, const roaring_bitmap_t **bitmaps, bool andnot) {
+    roaring_merge_iterator_t *it = (roaring_merge_iterator_t *)malloc(
+        sizeof(roaring_merge_iterator_t) +
+        n * (sizeof(roaring_bitmap_t *) + 2 * sizeof(int32_t)));
+    if (it == NULL) return NULL;
+    it->parents = (const roaring_bitmap_t **)(it + 1);
+    it->positions = (int32_t *)(it->parents + n);
+    it->heap = it->positions + n;
+    it->heap_size = 0;
+    it->n = n;
+    it->andnot = andnot;
+    for (size_t i = 0; i < n; i++) {
+        it->parents[i] = bitmaps[i];
+        it->positions[i] = 0;
+    }
+    // a bitmap with a single container, which is the current one
+    it->view.high_low_container.size = 1;
+    it->view.high_low_container.allocation_size = 1;
+    it->view.high_low_container.containers = &it->container;
+    it->view.high_low_container.keys = &it->key;
+    it->view.high_low_container.typecodes = &it->typecode;
+    it->view.high_low_container.flags = 0;
+    it->view.high_low_container.key_index = NULL;
+    it->container = NULL;
+    it->owned = false;
+    if (!andnot) merge_iterator_heapify(it);
+    merge_iterator_load_next(it);
+    return it;
+}
+
+roaring_merge_iterator_t *roaring_create_union_iterator(
+    size_t n, const roaring_bitmap_t **bitmaps) {
+    return merge_iterator_create(n, bitmaps, false);
+}
+
+roaring_merge_iterator_t *roaring_create_andnot_iterator(
+    size_t n, const roaring_bitmap_t **bitmaps) {
+    return merge_iterator_create(n, bitmaps, true);
+}
+
+bool roaring_advance_merge_iterator(roaring_merge_iterator_t *it) {
+    if (!it->has_value) return false;
+    if (roaring_advance_uint32_iterator(&it->inner)) {
+        it->current_value = it->inner.current_value;
+        return true;
+    }
+    return merge_iterator_load_next(it);
+}
+
+bool roaring_move_merge_iterator_equalorlarger(roaring_merge_iterator_t *it,
+                                               uint32_t val) {
+    if (!it->has_value) return false;
+    if (it->current_value >= val) return true;
+    const uint16_t hb = val >> 16;
+    if (it->key != hb) {
+        // skip the containers of all inputs up to the key of val
+        for (size_t i = 0; i < it->n; i++) {
+            it->positions[i] = ra_advance_until(
+                &it->parents[i]->high_low_container, hb, it->positions[i] - 1);
+            if (it->andnot) break;  // the other inputs follow the first one
+        }
+        if (!it->andnot) merge_iterator_heapify(it);
+        if (!merge_iterator_load_next(it)) return false;
+    }
+    while (it->key == hb) {
+        if (roaring_move_uint32_iterator_equalorlarger(&it->inner, val)) {
+            it->current_value = it->inner.current_value;
+            return true;
+        }
+        if (!merge_iterator_load_next(it)) return false;
+    }
+    return true;
+}
+
+uint32_t roaring_read_merge_iterator(roaring_merge_iterator_t *it,
+                                     uint32_t *buf, uint32_t count) {
+    uint32_t ret = 0;
+    while (it->has_value && ret < count) {
+        ret += roaring_read_uint32_iterator(&it->inner, buf + ret, count - ret);
+        if (it->inner.has_value) {
+            it->current_value = it->inner.current_value;
+            break;
+        }
+        merge_iterator_load_next(it);
+    }
+    return ret;
+}
+
+void roaring_free_merge_iterator(roaring_merge_iterator_t *it) {
+    if (it == NULL) return;
+    merge_iterator_release(it);
+    free(it);
+}
+
+/****
+* end of roaring_uint32_iterator_t
+*****/
+
+bool roaring_bitmap_equals(const roaring_bitmap_t *ra1,
+                           const roaring_bitmap_t *ra2) {
+    if (ra1->high_low_container.size != ra2->high_low_container.size) {
+        return false;
+    }
+    for (int i = 0; i < ra1->high_low_container.size; ++i) {
+        if (ra1->high_low_container.keys[i] !=
+            ra2->high_low_container.keys[i]) {
+            return false;
+        }
+    }
+    for (int i = 0; i < ra1->high_low_container.size; ++i) {
+        bool areequal = container_equals(ra1->high_low_container.containers[i],
+                                         ra1->high_low_container.typecodes[i],
                                          ra2->high_low_container.containers[i],
                                          ra2->high_low_container.typecodes[i]);
         if (!areequal) {
@@ -1919,18 +2945,23 @@ static void insert_flipped_container(roaring_array_t *ans_arr,
 }
 
 static void inplace_flip_container(roaring_array_t *x1_arr, uint16_t hb,
-                                   uint16_t lb_start, uint16_t lb_end) {
+                                   uint16_t lb_start, uint16_t lb_end,
+                                   bool lazy) {
     const int i = ra_get_index(x1_arr, hb);
     uint8_t ctype_in, ctype_out;
     void *flipped_container = NULL;
     if (i >= 0) {
         void *container_to_flip =
             ra_get_container_at_index(x1_arr, i, &ctype_in);
-        flipped_container = container_inot_range(
-            container_to_flip, ctype_in, (uint32_t)lb_start,
-            (uint32_t)(lb_end + 1), &ctype_out);
+        flipped_container =
+            lazy ? container_lazy_inot_range(container_to_flip, ctype_in,
+                                             (uint32_t)lb_start,
+                                             (uint32_t)(lb_end + 1), &ctype_out)
+                 : container_inot_range(container_to_flip, ctype_in,
+                                        (uint32_t)lb_start,
+                                        (uint32_t)(lb_end + 1), &ctype_out);
         // if a new container was created, the old one was already freed
-        if (container_get_cardinality(flipped_container, ctype_out)) {
+        if (container_nonzero_cardinality(flipped_container, ctype_out)) {
             ra_set_container_at_index(x1_arr, i, flipped_container, ctype_out);
         } else {
             container_free(flipped_container, ctype_out);
@@ -1970,7 +3001,8 @@ static void insert_fully_flipped_container(roaring_array_t *ans_arr,
     }
 }
 
-static void inplace_fully_flip_container(roaring_array_t *x1_arr, uint16_t hb) {
+static void inplace_fully_flip_container(roaring_array_t *x1_arr, uint16_t hb,
+                                         bool lazy) {
     const int i = ra_get_index(x1_arr, hb);
     uint8_t ctype_in, ctype_out;
     void *flipped_container = NULL;
@@ -1978,9 +3010,11 @@ static void inplace_fully_flip_container(roaring_array_t *x1_arr, uint16_t hb) {
         void *container_to_flip =
             ra_get_container_at_index(x1_arr, i, &ctype_in);
         flipped_container =
-            container_inot(container_to_flip, ctype_in, &ctype_out);
+            lazy ? container_lazy_inot_range(container_to_flip, ctype_in, 0U,
+                                             0x10000U, &ctype_out)
+                 : container_inot(container_to_flip, ctype_in, &ctype_out);
 
-        if (container_get_cardinality(flipped_container, ctype_out)) {
+        if (container_nonzero_cardinality(flipped_container, ctype_out)) {
             ra_set_container_at_index(x1_arr, i, flipped_container, ctype_out);
         } else {
             container_free(flipped_container, ctype_out);
@@ -2048,8 +3082,8 @@ roaring_bitmap_t *roaring_bitmap_flip(const roaring_bitmap_t *x1,
     return ans;
 }
 
-void roaring_bitmap_flip_inplace(roaring_bitmap_t *x1, uint64_t range_start,
-                                 uint64_t range_end) {
+static void flip_inplace(roaring_bitmap_t *x1, uint64_t range_start,
+                         uint64_t range_end, bool lazy) {
     if (range_start >= range_end) {
         return;  // empty range
     }
@@ -2064,30 +3098,41 @@ void roaring_bitmap_flip_inplace(roaring_bitmap_t *x1, uint64_t range_start,
 
     if (hb_start == hb_end) {
         inplace_flip_container(&x1->high_low_container, hb_start, lb_start,
-                               lb_end);
+                               lb_end, lazy);
     } else {
         // start and end containers are distinct
         if (lb_start > 0) {
             // handle first (partial) container
             inplace_flip_container(&x1->high_low_container, hb_start, lb_start,
-                                   0xFFFF);
+                                   0xFFFF, lazy);
             ++hb_start;  // for the full containers.  Can't wrap.
         }
 
         if (lb_end != 0xFFFF) --hb_end;
 
         for (uint32_t hb = hb_start; hb <= hb_end; ++hb) {
-            inplace_fully_flip_container(&x1->high_low_container, hb);
+            inplace_fully_flip_container(&x1->high_low_container, hb, lazy);
         }
         // handle a partial final container
         if (lb_end != 0xFFFF) {
             inplace_flip_container(&x1->high_low_container, hb_end + 1, 0,
-                                   lb_end);
+                                   lb_end, lazy);
             ++hb_end;
         }
     }
 }
 
+void roaring_bitmap_flip_inplace(roaring_bitmap_t *x1, uint64_t range_start,
+                                 uint64_t range_end) {
+    flip_inplace(x1, range_start, range_end, false);
+}
+
+void roaring_bitmap_lazy_flip_inplace(roaring_bitmap_t *x1,
+                                      uint64_t range_start,
+                                      uint64_t range_end) {
+    flip_inplace(x1, range_start, range_end, true);
+}
+
 roaring_bitmap_t *roaring_bitmap_lazy_or(const roaring_bitmap_t *x1,
                                          const roaring_bitmap_t *x2,
                                          const bool bitsetconversion) {
@@ -2146,30 +3191,22 @@ roaring_bitmap_t *roaring_bitmap_lazy_or(const roaring_bitmap_t *x1,
             s2 = ra_get_key_at_index(&x2->high_low_container, pos2);
 
         } else if (s1 < s2) {  // s1 < s2
-            void *c1 = ra_get_container_at_index(&x1->high_low_container, pos1,
-                                                 &container_type_1);
-            c1 =
-                get_copy_of_container(c1, &container_type_1, is_cow(x1));
-            if (is_cow(x1)) {
-                ra_set_container_at_index(&x1->high_low_container, pos1, c1,
-                                          container_type_1);
-            }
-            ra_append(&answer->high_low_container, s1, c1, container_type_1);
-            pos1++;
+            const int next_pos1 =
+                ra_advance_until(&x1->high_low_container, s2, pos1);
+            ra_append_copy_range(&answer->high_low_container,
+                                 &x1->high_low_container, pos1, next_pos1,
+                                 is_cow(x1));
+            pos1 = next_pos1;
             if (pos1 == length1) break;
             s1 = ra_get_key_at_index(&x1->high_low_container, pos1);
 
         } else {  // s1 > s2
-            void *c2 = ra_get_container_at_index(&x2->high_low_container, pos2,
-                                                 &container_type_2);
-            c2 =
-                get_copy_of_container(c2, &container_type_2, is_cow(x2));
-            if (is_cow(x2)) {
-                ra_set_container_at_index(&x2->high_low_container, pos2, c2,
-                                          container_type_2);
-            }
-            ra_append(&answer->high_low_container, s2, c2, container_type_2);
-            pos2++;
+            const int next_pos2 =
+                ra_advance_until(&x2->high_low_container, s1, pos2);
+            ra_append_copy_range(&answer->high_low_container,
+                                 &x2->high_low_container, pos2, next_pos2,
+                                 is_cow(x2));
+            pos2 = next_pos2;
             if (pos2 == length2) break;
             s2 = ra_get_key_at_index(&x2->high_low_container, pos2);
         }
@@ -2244,7 +3281,7 @@ void roaring_bitmap_lazy_or_inplace(roaring_bitmap_t *x1,
             s2 = ra_get_key_at_index(&x2->high_low_container, pos2);
 
         } else if (s1 < s2) {  // s1 < s2
-            pos1++;
+            pos1 = ra_advance_until(&x1->high_low_container, s2, pos1);
             if (pos1 == length1) break;
             s1 = ra_get_key_at_index(&x1->high_low_container, pos1);
 
@@ -2316,30 +3353,22 @@ roaring_bitmap_t *roaring_bitmap_lazy_xor(const roaring_bitmap_t *x1,
             s2 = ra_get_key_at_index(&x2->high_low_container, pos2);
 
         } else if (s1 < s2) {  // s1 < s2
-            void *c1 = ra_get_container_at_index(&x1->high_low_container, pos1,
-                                                 &container_type_1);
-            c1 =
-                get_copy_of_container(c1, &container_type_1, is_cow(x1));
-            if (is_cow(x1)) {
-                ra_set_container_at_index(&x1->high_low_container, pos1, c1,
-                                          container_type_1);
-            }
-            ra_append(&answer->high_low_container, s1, c1, container_type_1);
-            pos1++;
+            const int next_pos1 =
+                ra_advance_until(&x1->high_low_container, s2, pos1);
+            ra_append_copy_range(&answer->high_low_container,
+                                 &x1->high_low_container, pos1, next_pos1,
+                                 is_cow(x1));
+            pos1 = next_pos1;
             if (pos1 == length1) break;
             s1 = ra_get_key_at_index(&x1->high_low_container, pos1);
 
         } else {  // s1 > s2
-            void *c2 = ra_get_container_at_index(&x2->high_low_container, pos2,
-                                                 &container_type_2);
-            c2 =
-                get_copy_of_container(c2, &container_type_2, is_cow(x2));
-            if (is_cow(x2)) {
-                ra_set_container_at_index(&x2->high_low_container, pos2, c2,
-                                          container_type_2);
-            }
-            ra_append(&answer->high_low_container, s2, c2, container_type_2);
-            pos2++;
+            const int next_pos2 =
+                ra_advance_until(&x2->high_low_container, s1, pos2);
+            ra_append_copy_range(&answer->high_low_container,
+                                 &x2->high_low_container, pos2, next_pos2,
+                                 is_cow(x2));
+            pos2 = next_pos2;
             if (pos2 == length2) break;
             s2 = ra_get_key_at_index(&x2->high_low_container, pos2);
         }
@@ -2399,7 +3428,7 @@ void roaring_bitmap_lazy_xor_inplace(roaring_bitmap_t *x1,
             s2 = ra_get_key_at_index(&x2->high_low_container, pos2);
 
         } else if (s1 < s2) {  // s1 < s2
-            pos1++;
+            pos1 = ra_advance_until(&x1->high_low_container, s2, pos1);
             if (pos1 == length1) break;
             s1 = ra_get_key_at_index(&x1->high_low_container, pos1);
 
@@ -2435,6 +3464,8 @@ void roaring_bitmap_repair_after_lazy(roaring_bitmap_t *ra) {
         uint8_t new_typecode = original_typecode;
         void *newcontainer =
             container_repair_after_lazy(container, &new_typecode);
+        newcontainer =
+            autorun_container(newcontainer, &new_typecode, -1, is_autorun(ra));
         ra->high_low_container.containers[i] = newcontainer;
         ra->high_low_container.typecodes[i] = new_typecode;
     }
@@ -2601,17 +3632,82 @@ uint64_t roaring_bitmap_or_cardinality(const roaring_bitmap_t *x1,
 
 uint64_t roaring_bitmap_andnot_cardinality(const roaring_bitmap_t *x1,
                                            const roaring_bitmap_t *x2) {
-    const uint64_t c1 = roaring_bitmap_get_cardinality(x1);
-    const uint64_t inter = roaring_bitmap_and_cardinality(x1, x2);
-    return c1 - inter;
+    const int length1 = x1->high_low_container.size,
+              length2 = x2->high_low_container.size;
+    uint64_t answer = 0;
+    int pos1 = 0, pos2 = 0;
+    uint8_t container_type_1, container_type_2;
+
+    while (pos1 < length1 && pos2 < length2) {
+        const uint16_t s1 = ra_get_key_at_index(&x1->high_low_container, pos1);
+        const uint16_t s2 = ra_get_key_at_index(&x2->high_low_container, pos2);
+        void *c1 = ra_get_container_at_index(&x1->high_low_container, pos1,
+                                             &container_type_1);
+        if (s1 == s2) {
+            void *c2 = ra_get_container_at_index(&x2->high_low_container, pos2,
+                                                 &container_type_2);
+            answer += container_andnot_cardinality(c1, container_type_1, c2,
+                                                   container_type_2);
+            ++pos1;
+            ++pos2;
+        } else if (s1 < s2) {  // s1 < s2
+            answer += container_get_cardinality(c1, container_type_1);
+            ++pos1;
+        } else {  // s1 > s2
+            pos2 = ra_advance_until(&x2->high_low_container, s1, pos2);
+        }
+    }
+    for (; pos1 < length1; ++pos1) {
+        void *c1 = ra_get_container_at_index(&x1->high_low_container, pos1,
+                                             &container_type_1);
+        answer += container_get_cardinality(c1, container_type_1);
+    }
+    return answer;
 }
 
 uint64_t roaring_bitmap_xor_cardinality(const roaring_bitmap_t *x1,
                                         const roaring_bitmap_t *x2) {
-    const uint64_t c1 = roaring_bitmap_get_cardinality(x1);
-    const uint64_t c2 = roaring_bitmap_get_cardinality(x2);
-    const uint64_t inter = roaring_bitmap_and_cardinality(x1, x2);
-    return c1 + c2 - 2 * inter;
+    const int length1 = x1->high_low_container.size,
+              length2 = x2->high_low_container.size;
+    uint64_t answer = 0;
+    int pos1 = 0, pos2 = 0;
+    uint8_t container_type_1, container_type_2;
+
+    while (pos1 < length1 && pos2 < length2) {
+        const uint16_t s1 = ra_get_key_at_index(&x1->high_low_container, pos1);
+        const uint16_t s2 = ra_get_key_at_index(&x2->high_low_container, pos2);
+        if (s1 == s2) {
+            void *c1 = ra_get_container_at_index(&x1->high_low_container, pos1,
+                                                 &container_type_1);
+            void *c2 = ra_get_container_at_index(&x2->high_low_container, pos2,
+                                                 &container_type_2);
+            answer += container_xor_cardinality(c1, container_type_1, c2,
+                                                container_type_2);
+            ++pos1;
+            ++pos2;
+        } else if (s1 < s2) {  // s1 < s2
+            void *c1 = ra_get_container_at_index(&x1->high_low_container, pos1,
+                                                 &container_type_1);
+            answer += container_get_cardinality(c1, container_type_1);
+            ++pos1;
+        } else {  // s1 > s2
+            void *c2 = ra_get_container_at_index(&x2->high_low_container, pos2,
+                                                 &container_type_2);
+            answer += container_get_cardinality(c2, container_type_2);
+            ++pos2;
+        }
+    }
+    for (; pos1 < length1; ++pos1) {
+        void *c1 = ra_get_container_at_index(&x1->high_low_container, pos1,
+                                             &container_type_1);
+        answer += container_get_cardinality(c1, container_type_1);
+    }
+    for (; pos2 < length2; ++pos2) {
+        void *c2 = ra_get_container_at_index(&x2->high_low_container, pos2,
+                                             &container_type_2);
+        answer += container_get_cardinality(c2, container_type_2);
+    }
+    return answer;
 }
 
 
@@ -2900,6 +3996,7 @@ roaring_bitmap_frozen_view(const char *buf, size_t length) {
     rb->high_low_container.size = num_containers;
     rb->high_low_container.keys = (uint16_t *)keys;
     rb->high_low_container.typecodes = (uint8_t *)typecodes;
+    rb->high_low_container.key_index = NULL;
     rb->high_low_container.containers =
             (void **)arena_alloc(&arena, sizeof(void*) * num_containers);
     for (int32_t i = 0; i < num_containers; i++) {
@@ -2940,3 +4037,403 @@ roaring_bitmap_frozen_view(const char *buf, size_t length) {
 
     return rb;
 }
+
+/*
+ * FROZEN SERIALIZATION FORMAT, SECOND VERSION
+ *
+ * -- (beginning must be aligned by 8 bytes) --
+ * <cookie>      uint32_t FROZEN_COOKIE_V2
+ * <size>        uint32_t number of containers
+ * <keys>        uint16_t[num_containers]
+ * <counts>      uint16_t[num_containers]
+ * <offsets>     uint32_t[num_containers]
+ * <typecodes>   uint8_t[num_containers]
+ * <containers>  the data of every container, in order, at its offset
+ *
+ * <counts> are as in the first version. <offsets> are from the beginning of
+ * the buffer: bitset data is written at multiples of 32 bytes, and array and
+ * run data at even offsets, with zeroes in between. When reading, offsets
+ * only need to be multiples of 8 for bitsets, and even otherwise.
+ *
+ * Unlike the first version, the format does not depend on the platform:
+ * like the portable format, it is little-endian. Containers are found through
+ * their offsets rather than by summing the sizes of the previous ones, so
+ * that a view checks the whole buffer in O(num_containers) without reading
+ * container data.
+ */
+
+#define FROZEN_V2_HEADER_BYTES 8
+#define FROZEN_V2_BYTES_PER_CONTAINER (2 + 2 + 4 + 1)
+
+// the number of bytes of the data of a frozen container, given its count
+static inline size_t frozen_v2_data_bytes(uint8_t typecode, uint16_t count) {
+    switch (typecode) {
+        case BITSET_CONTAINER_TYPE_CODE:
+            return BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t);
+        case RUN_CONTAINER_TYPE_CODE:
+            return count * sizeof(rle16_t);
+        default:
+            return (count + UINT32_C(1)) * sizeof(uint16_t);
+    }
+}
+
+// the count of a container, as stored in <counts>
+static uint16_t frozen_count(const void *container, uint8_t typecode) {
+    switch (typecode) {
+        case BITSET_CONTAINER_TYPE_CODE: {
+            const bitset_container_t *bitset =
+                (const bitset_container_t *)container;
+            if (bitset->cardinality != BITSET_UNKNOWN_CARDINALITY) {
+                return bitset->cardinality - 1;
+            }
+            return bitset_container_compute_cardinality(bitset) - 1;
+        }
+        case RUN_CONTAINER_TYPE_CODE:
+            return ((const run_container_t *)container)->n_runs;
+        default:
+            return ((const array_container_t *)container)->cardinality - 1;
+    }
+}
+
+// the offset of the data of a container starting at or after end
+static inline size_t frozen_v2_offset(size_t end, uint8_t typecode) {
+    const size_t alignment = typecode == BITSET_CONTAINER_TYPE_CODE ? 32 : 2;
+    return (end + alignment - 1) & ~(alignment - 1);
+}
+
+size_t roaring_bitmap_frozen_v2_size_in_bytes(const roaring_bitmap_t *rb) {
+    const roaring_array_t *ra = &rb->high_low_container;
+    size_t end = FROZEN_V2_HEADER_BYTES +
+                 FROZEN_V2_BYTES_PER_CONTAINER * (size_t)ra->size;
+    for (int32_t i = 0; i < ra->size; i++) {
+        uint8_t typecode = ra->typecodes[i];
+        const void *c = container_unwrap_shared(ra->containers[i], &typecode);
+        end = frozen_v2_offset(end, typecode) +
+              frozen_v2_data_bytes(typecode, frozen_count(c, typecode));
+    }
+    return end;
+}
+
+// writes the data of a container, of num_bytes bytes
+static void frozen_v2_write_data(char *dst, const void *container,
+                                 uint8_t typecode, size_t num_bytes) {
+    switch (typecode) {
+        case BITSET_CONTAINER_TYPE_CODE:
+            memcpy(dst, ((const bitset_container_t *)container)->array,
+                   num_bytes);
+            break;
+        case RUN_CONTAINER_TYPE_CODE:
+            memcpy(dst, ((const run_container_t *)container)->runs, num_bytes);
+            break;
+        default:
+            memcpy(dst, ((const array_container_t *)container)->array,
+                   num_bytes);
+            break;
+    }
+}
+
+// Serializes the roaring array. When overlay is not NULL, consecutive
+// containers still shared with its image are copied from it at once.
+static size_t frozen_v2_write(const roaring_array_t *ra,
+                              const roaring_overlay_t *overlay, char *buf) {
+    const uint32_t header[2] = {FROZEN_COOKIE_V2, (uint32_t)ra->size};
+    memcpy(buf, header, sizeof(header));
+    char *key_zone = buf + FROZEN_V2_HEADER_BYTES;
+    char *count_zone = key_zone + 2 * ra->size;
+    char *offset_zone = count_zone + 2 * ra->size;
+    char *typecode_zone = offset_zone + 4 * ra->size;
+    size_t end = typecode_zone + ra->size - buf;
+    memcpy(key_zone, ra->keys, ra->size * sizeof(uint16_t));
+    // the bytes of the image still to be copied, and the last container
+    size_t copy_src = 0, copy_dst = 0, copy_len = 0;
+    int32_t last_copied = -1;
+    for (int32_t i = 0; i < ra->size; i++) {
+        uint8_t typecode = ra->typecodes[i];
+        const void *c = ra->containers[i];
+        int32_t k = -1;  // the index of the container in the image
+        if (overlay != NULL && typecode == SHARED_CONTAINER_TYPE_CODE &&
+            (const shared_container_t *)c >= overlay->frozen &&
+            (const shared_container_t *)c <
+                overlay->frozen + overlay->n_containers) {
+            k = (int32_t)((const shared_container_t *)c - overlay->frozen);
+        }
+        c = container_unwrap_shared(c, &typecode);
+        const uint16_t count = frozen_count(c, typecode);
+        const size_t offset = frozen_v2_offset(end, typecode);
+        if ((uint64_t)offset > UINT32_MAX) {
+            return 0;
+        }
+        const uint32_t offset32 = (uint32_t)offset;
+        memcpy(count_zone + 2 * i, &count, sizeof(count));
+        memcpy(offset_zone + 4 * i, &offset32, sizeof(offset32));
+        typecode_zone[i] = typecode;
+        const size_t num_bytes = frozen_v2_data_bytes(typecode, count);
+        if (k >= 0 && k == last_copied + 1 && copy_len > 0 &&
+            overlay->offsets[k] - copy_src == offset - copy_dst) {
+            // the next container of the image, at the same relative place
+            copy_len = offset + num_bytes - copy_dst;
+        } else {
+            if (copy_len > 0) {
+                memcpy(buf + copy_dst, overlay->image + copy_src, copy_len);
+                copy_len = 0;
+            }
+            memset(buf + end, 0, offset - end);
+            if (k >= 0) {
+                copy_src = overlay->offsets[k];
+                copy_dst = offset;
+                copy_len = num_bytes;
+            } else {
+                frozen_v2_write_data(buf + offset, c, typecode, num_bytes);
+            }
+        }
+        last_copied = k;
+        end = offset + num_bytes;
+    }
+    if (copy_len > 0) {
+        memcpy(buf + copy_dst, overlay->image + copy_src, copy_len);
+    }
+    return end;
+}
+
+size_t roaring_bitmap_frozen_v2_serialize(const roaring_bitmap_t *rb,
+                                          char *buf) {
+    return frozen_v2_write(&rb->high_low_container, NULL, buf);
+}
+
+// Checks the data of a container: strictly increasing array values, runs
+// sorted without overlap and ending within 16 bits, and a bitset of the
+// stored cardinality.
+static bool frozen_v2_data_check(const char *data, uint8_t typecode,
+                                 uint16_t count) {
+    switch (typecode) {
+        case BITSET_CONTAINER_TYPE_CODE: {
+            bitset_container_t bitset;
+            bitset.array = (uint64_t *)data;
+            return count + 1 > DEFAULT_MAX_SIZE &&
+                   bitset_container_compute_cardinality(&bitset) == count + 1;
+        }
+        case RUN_CONTAINER_TYPE_CODE: {
+            const rle16_t *runs = (const rle16_t *)data;
+            uint32_t previous_end = 0;
+            for (uint16_t j = 0; j < count; j++) {
+                const uint32_t end = (uint32_t)runs[j].value + runs[j].length;
+                if (end > UINT16_MAX ||
+                    (j > 0 && runs[j].value <= previous_end)) {
+                    return false;
+                }
+                previous_end = end;
+            }
+            return true;
+        }
+        default: {
+            const uint16_t *array = (const uint16_t *)data;
+            for (uint32_t j = 1; j <= count; j++) {
+                if (array[j] <= array[j - 1]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+}
+
+// Checks that the buffer holds a valid image, and counts its containers of
+// each type. Returns the number of containers, or -1 if it is not valid.
+static int32_t frozen_v2_check(const char *buf, size_t length,
+                               int32_t num_by_type[4]) {
+    if ((uintptr_t)buf % 8 != 0 || IS_BIG_ENDIAN) {
+        return -1;
+    }
+    if (length < FROZEN_V2_HEADER_BYTES) {
+        return -1;
+    }
+    const uint32_t *header = (const uint32_t *)buf;
+    if (header[0] != FROZEN_COOKIE_V2 || header[1] > MAX_CONTAINERS) {
+        return -1;
+    }
+    const int32_t num_containers = header[1];
+    size_t end = FROZEN_V2_HEADER_BYTES +
+                 FROZEN_V2_BYTES_PER_CONTAINER * (size_t)num_containers;
+    if (length < end) {
+        return -1;
+    }
+    const uint16_t *keys = (const uint16_t *)(buf + FROZEN_V2_HEADER_BYTES);
+    const uint16_t *counts = keys + num_containers;
+    const uint32_t *offsets = (const uint32_t *)(counts + num_containers);
+    const uint8_t *typecodes = (const uint8_t *)(offsets + num_containers);
+
+    // the containers are sorted by key, in bounds, do not overlap and hold
+    // valid data
+    memset(num_by_type, 0, 4 * sizeof(int32_t));
+    for (int32_t i = 0; i < num_containers; i++) {
+        if (i > 0 && keys[i] <= keys[i - 1]) {
+            return -1;
+        }
+        size_t alignment;
+        switch (typecodes[i]) {
+            case BITSET_CONTAINER_TYPE_CODE:
+                alignment = 8;
+                break;
+            case RUN_CONTAINER_TYPE_CODE:
+                if (counts[i] == 0) {
+                    return -1;
+                }
+                alignment = 2;
+                break;
+            case ARRAY_CONTAINER_TYPE_CODE:
+                if (counts[i] >= DEFAULT_MAX_SIZE) {
+                    return -1;
+                }
+                alignment = 2;
+                break;
+            default:
+                return -1;
+        }
+        num_by_type[typecodes[i]]++;
+        const size_t num_bytes = frozen_v2_data_bytes(typecodes[i], counts[i]);
+        if (offsets[i] % alignment != 0 || offsets[i] < end ||
+            offsets[i] > length || num_bytes > length - offsets[i]) {
+            return -1;
+        }
+        if (!frozen_v2_data_check(buf + offsets[i], typecodes[i], counts[i])) {
+            return -1;
+        }
+        end = offsets[i] + num_bytes;
+    }
+    return num_containers;
+}
+
+// the size of the views of the containers counted by frozen_v2_check
+static size_t frozen_v2_views_size(const int32_t num_by_type[4]) {
+    return num_by_type[BITSET_CONTAINER_TYPE_CODE] *
+               sizeof(bitset_container_t) +
+           num_by_type[RUN_CONTAINER_TYPE_CODE] * sizeof(run_container_t) +
+           num_by_type[ARRAY_CONTAINER_TYPE_CODE] * sizeof(array_container_t);
+}
+
+// creates in the arena the views of the containers of a valid image
+static void frozen_v2_views(const char *buf, char **arena, void **containers) {
+    const int32_t num_containers = ((const uint32_t *)buf)[1];
+    const uint16_t *counts = (const uint16_t *)(buf + FROZEN_V2_HEADER_BYTES) +
+                             num_containers;
+    const uint32_t *offsets = (const uint32_t *)(counts + num_containers);
+    const uint8_t *typecodes = (const uint8_t *)(offsets + num_containers);
+    for (int32_t i = 0; i < num_containers; i++) {
+        const char *data = buf + offsets[i];
+        switch (typecodes[i]) {
+            case BITSET_CONTAINER_TYPE_CODE: {
+                bitset_container_t *bitset = (bitset_container_t *)
+                        arena_alloc(arena, sizeof(bitset_container_t));
+                bitset->array = (uint64_t *)data;
+                bitset->cardinality = counts[i] + UINT32_C(1);
+                containers[i] = bitset;
+                break;
+            }
+            case RUN_CONTAINER_TYPE_CODE: {
+                run_container_t *run = (run_container_t *)
+                        arena_alloc(arena, sizeof(run_container_t));
+                run->capacity = counts[i];
+                run->n_runs = counts[i];
+                run->runs = (rle16_t *)data;
+                containers[i] = run;
+                break;
+            }
+            default: {
+                array_container_t *array = (array_container_t *)
+                        arena_alloc(arena, sizeof(array_container_t));
+                array->capacity = counts[i] + UINT32_C(1);
+                array->cardinality = counts[i] + UINT32_C(1);
+                array->array = (uint16_t *)data;
+                containers[i] = array;
+                break;
+            }
+        }
+    }
+}
+
+const roaring_bitmap_t *roaring_bitmap_frozen_v2_view(const char *buf,
+                                                     size_t length) {
+    int32_t num_by_type[4];
+    const int32_t num_containers = frozen_v2_check(buf, length, num_by_type);
+    if (num_containers < 0) {
+        return NULL;
+    }
+
+    size_t alloc_size = 0;
+    alloc_size += sizeof(roaring_bitmap_t);
+    alloc_size += num_containers * sizeof(void *);
+    alloc_size += frozen_v2_views_size(num_by_type);
+
+    char *arena = (char *)malloc(alloc_size);
+    if (arena == NULL) {
+        return NULL;
+    }
+
+    roaring_bitmap_t *rb = (roaring_bitmap_t *)
+            arena_alloc(&arena, sizeof(roaring_bitmap_t));
+    rb->high_low_container.flags = ROARING_FLAG_FROZEN;
+    rb->high_low_container.allocation_size = num_containers;
+    rb->high_low_container.size = num_containers;
+    rb->high_low_container.keys =
+        (uint16_t *)(buf + FROZEN_V2_HEADER_BYTES);
+    rb->high_low_container.typecodes =
+        (uint8_t *)(buf + FROZEN_V2_HEADER_BYTES + 8 * num_containers);
+    rb->high_low_container.key_index = NULL;
+    rb->high_low_container.containers =
+            (void **)arena_alloc(&arena, sizeof(void*) * num_containers);
+    frozen_v2_views(buf, &arena, rb->high_low_container.containers);
+
+    return rb;
+}
+
+bool roaring_overlay_init(roaring_overlay_t *overlay, const char *buf,
+                          size_t length) {
+    int32_t num_by_type[4];
+    const int32_t num_containers = frozen_v2_check(buf, length, num_by_type);
+    if (num_containers < 0) {
+        return false;
+    }
+    const uint16_t *keys = (const uint16_t *)(buf + FROZEN_V2_HEADER_BYTES);
+    roaring_bitmap_t *rb = roaring_bitmap_create_with_capacity(num_containers);
+    if (rb == NULL) {
+        return false;
+    }
+    // the shared containers, then the views they hold
+    char *arena = (char *)malloc(num_containers * sizeof(shared_container_t) +
+                                 frozen_v2_views_size(num_by_type));
+    if (arena == NULL) {
+        roaring_bitmap_free(rb);
+        return false;
+    }
+    overlay->bitmap = rb;
+    overlay->image = buf;
+    overlay->frozen = (shared_container_t *)arena_alloc(
+        &arena, num_containers * sizeof(shared_container_t));
+    overlay->offsets = (const uint32_t *)(keys + 2 * num_containers);
+    overlay->n_containers = num_containers;
+    // the views are first stored where the bitmap then appends their wrappers
+    void **views = rb->high_low_container.containers;
+    frozen_v2_views(buf, &arena, views);
+    const uint8_t *typecodes =
+        (const uint8_t *)(buf + FROZEN_V2_HEADER_BYTES + 8 * num_containers);
+    for (int32_t i = 0; i < num_containers; i++) {
+        // the overlay holds a reference to every container, so that the
+        // bitmap copies them before any change and never frees them
+        shared_container_t *shared = overlay->frozen + i;
+        shared->container = views[i];
+        shared->typecode = typecodes[i];
+        shared->counter = 2;
+        ra_append(&rb->high_low_container, keys[i], shared,
+                  SHARED_CONTAINER_TYPE_CODE);
+    }
+    return true;
+}
+
+size_t roaring_overlay_write(const roaring_overlay_t *overlay, char *buf) {
+    return frozen_v2_write(&overlay->bitmap->high_low_container, overlay, buf);
+}
+
+void roaring_overlay_free(roaring_overlay_t *overlay) {
+    roaring_bitmap_free(overlay->bitmap);
+    free(overlay->frozen);
+}
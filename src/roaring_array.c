@@ -13,6 +13,8 @@
 //  [ra->size, ra->allocation_size) is junk and contains nothing needing freeing
 
 extern inline int32_t ra_get_size(const roaring_array_t *ra);
+extern inline int32_t ra_key_index_search(const roaring_array_t *ra,
+                                          uint16_t x);
 extern inline int32_t ra_get_index(const roaring_array_t *ra, uint16_t x);
 extern inline void *ra_get_container_at_index(const roaring_array_t *ra,
                                               uint16_t i, uint8_t *typecode);
@@ -110,6 +112,73 @@ void ra_init(roaring_array_t *new_ra) {
     new_ra->allocation_size = 0;
     new_ra->size = 0;
     new_ra->flags = 0;
+    new_ra->key_index = NULL;
+}
+
+static void ra_build_key_index(roaring_array_t *ra) {
+    if (ra->key_index == NULL) {
+        ra->key_index = (ra_key_index_t *)malloc(sizeof(ra_key_index_t));
+        // the key index is optional, we do without it if memory is short
+        if (ra->key_index == NULL) return;
+    }
+    ra_key_index_t *index = ra->key_index;
+    memset(index->present, 0, sizeof(index->present));
+    int32_t word = -1;
+    for (int32_t i = 0; i < ra->size; ++i) {
+        const int32_t w = ra->keys[i] >> 6;
+        while (word < w) index->rank[++word] = (uint16_t)i;
+        index->present[w] |= UINT64_C(1) << (ra->keys[i] & 63);
+    }
+}
+
+void ra_drop_key_index(roaring_array_t *ra) {
+    free(ra->key_index);
+    ra->key_index = NULL;
+}
+
+void ra_reindex_keys(roaring_array_t *ra) {
+    if ((ra->key_index == NULL) && (ra->size >= RA_KEY_INDEX_THRESHOLD)) {
+        ra_build_key_index(ra);
+    }
+}
+
+// to be called once the key at index i was inserted
+static inline void ra_key_index_insert(roaring_array_t *ra, int32_t i) {
+    ra_key_index_t *index = ra->key_index;
+    if (index == NULL) {
+        if (ra->size >= RA_KEY_INDEX_THRESHOLD) ra_build_key_index(ra);
+        return;
+    }
+    const uint16_t key = ra->keys[i];
+    const int32_t w = key >> 6;
+    index->present[w] |= UINT64_C(1) << (key & 63);
+    if (i == ra->size - 1) {
+        // new largest key, the ranks past the previous one are stale
+        for (int32_t word = (i > 0) ? (ra->keys[i - 1] >> 6) + 1 : 0;
+             word <= w; ++word) {
+            index->rank[word] = (uint16_t)i;
+        }
+    } else {
+        const int32_t last = ra->keys[ra->size - 1] >> 6;
+        for (int32_t word = w + 1; word <= last; ++word) index->rank[word]++;
+    }
+}
+
+// to be called once the key at index i was removed
+static inline void ra_key_index_remove(roaring_array_t *ra, uint16_t key,
+                                       int32_t i) {
+    ra_key_index_t *index = ra->key_index;
+    if (index == NULL) return;
+    if (ra->size < RA_KEY_INDEX_THRESHOLD / 2) {
+        ra_drop_key_index(ra);
+        return;
+    }
+    const int32_t w = key >> 6;
+    index->present[w] &= ~(UINT64_C(1) << (key & 63));
+    if (i < ra->size) {
+        const int32_t last = ra->keys[ra->size - 1] >> 6;
+        for (int32_t word = w + 1; word <= last; ++word) index->rank[word]--;
+    }
 }
 
 bool ra_copy(const roaring_array_t *source, roaring_array_t *dest,
@@ -150,12 +219,14 @@ bool ra_copy(const roaring_array_t *source, roaring_array_t *dest,
             }
         }
     }
+    ra_reindex_keys(dest);
     return true;
 }
 
 bool ra_overwrite(const roaring_array_t *source, roaring_array_t *dest,
                   bool copy_on_write) {
     ra_clear_containers(dest);  // we are going to overwrite them
+    ra_drop_key_index(dest);
     if (dest->allocation_size < source->size) {
         if (!realloc_array(dest, source->size)) {
             return false;
@@ -189,6 +260,7 @@ bool ra_overwrite(const roaring_array_t *source, roaring_array_t *dest,
             }
         }
     }
+    ra_reindex_keys(dest);
     return true;
 }
 
@@ -201,6 +273,7 @@ void ra_clear_containers(roaring_array_t *ra) {
 void ra_reset(roaring_array_t *ra) {
   ra_clear_containers(ra);
   ra->size = 0;
+  ra_drop_key_index(ra);
   ra_shrink_to_fit(ra);
 }
 
@@ -211,6 +284,7 @@ void ra_clear_without_containers(roaring_array_t *ra) {
     ra->containers = NULL;
     ra->keys = NULL;
     ra->typecodes = NULL;
+    ra_drop_key_index(ra);
 }
 
 void ra_clear(roaring_array_t *ra) {
@@ -242,6 +316,7 @@ void ra_append(roaring_array_t *ra, uint16_t key, void *container,
     ra->containers[pos] = container;
     ra->typecodes[pos] = typecode;
     ra->size++;
+    ra_key_index_insert(ra, pos);
 }
 
 void ra_append_copy(roaring_array_t *ra, const roaring_array_t *sa,
@@ -263,6 +338,7 @@ void ra_append_copy(roaring_array_t *ra, const roaring_array_t *sa,
         ra->typecodes[pos] = sa->typecodes[index];
     }
     ra->size++;
+    ra_key_index_insert(ra, pos);
 }
 
 void ra_append_copies_until(roaring_array_t *ra, const roaring_array_t *sa,
@@ -291,6 +367,7 @@ void ra_append_copy_range(roaring_array_t *ra, const roaring_array_t *sa,
             ra->typecodes[pos] = sa->typecodes[i];
         }
         ra->size++;
+        ra_key_index_insert(ra, pos);
     }
 }
 
@@ -315,6 +392,7 @@ void ra_append_move_range(roaring_array_t *ra, roaring_array_t *sa,
         ra->containers[pos] = sa->containers[i];
         ra->typecodes[pos] = sa->typecodes[i];
         ra->size++;
+        ra_key_index_insert(ra, pos);
     }
 }
 
@@ -337,11 +415,12 @@ void ra_append_range(roaring_array_t *ra, roaring_array_t *sa,
             ra->typecodes[pos] = sa->typecodes[i];
         }
         ra->size++;
+        ra_key_index_insert(ra, pos);
     }
 }
 
 void *ra_get_container(roaring_array_t *ra, uint16_t x, uint8_t *typecode) {
-    int i = binarySearch(ra->keys, (int32_t)ra->size, x);
+    int i = ra_get_index(ra, x);
     if (i < 0) return NULL;
     *typecode = ra->typecodes[i];
     return ra->containers[i];
@@ -352,7 +431,7 @@ extern inline void *ra_get_container_at_index(const roaring_array_t *ra, uint16_
 
 void *ra_get_writable_container(roaring_array_t *ra, uint16_t x,
                                 uint8_t *typecode) {
-    int i = binarySearch(ra->keys, (int32_t)ra->size, x);
+    int i = ra_get_index(ra, x);
     if (i < 0) return NULL;
     *typecode = ra->typecodes[i];
     return get_writable_copy_if_shared(ra->containers[i], typecode);
@@ -397,6 +476,7 @@ void ra_insert_new_key_value_at(roaring_array_t *ra, int32_t i, uint16_t key,
     ra->containers[i] = container;
     ra->typecodes[i] = typecode;
     ra->size++;
+    ra_key_index_insert(ra, i);
 }
 
 // note: Java routine set things to 0, enabling GC.
@@ -406,10 +486,23 @@ void ra_insert_new_key_value_at(roaring_array_t *ra, int32_t i, uint16_t key,
 
 void ra_downsize(roaring_array_t *ra, int32_t new_length) {
     assert(new_length <= ra->size);
+    if (ra->key_index != NULL) {
+        if (new_length < RA_KEY_INDEX_THRESHOLD / 2) {
+            ra_drop_key_index(ra);
+        } else {
+            // the remaining keys did not move (or the index would be gone)
+            for (int32_t i = new_length; i < ra->size; ++i) {
+                ra->key_index->present[ra->keys[i] >> 6] &=
+                    ~(UINT64_C(1) << (ra->keys[i] & 63));
+            }
+        }
+    }
     ra->size = new_length;
+    ra_reindex_keys(ra);
 }
 
 void ra_remove_at_index(roaring_array_t *ra, int32_t i) {
+    const uint16_t key = ra->keys[i];
     memmove(&(ra->containers[i]), &(ra->containers[i + 1]),
             sizeof(void *) * (ra->size - i - 1));
     memmove(&(ra->keys[i]), &(ra->keys[i + 1]),
@@ -417,6 +510,7 @@ void ra_remove_at_index(roaring_array_t *ra, int32_t i) {
     memmove(&(ra->typecodes[i]), &(ra->typecodes[i + 1]),
             sizeof(uint8_t) * (ra->size - i - 1));
     ra->size--;
+    ra_key_index_remove(ra, key, i);
 }
 
 void ra_remove_at_index_and_free(roaring_array_t *ra, int32_t i) {
@@ -445,6 +539,7 @@ void ra_copy_range(roaring_array_t *ra, uint32_t begin, uint32_t end,
             sizeof(uint16_t) * range);
     memmove(&(ra->typecodes[new_begin]), &(ra->typecodes[begin]),
             sizeof(uint8_t) * range);
+    ra_drop_key_index(ra);
 }
 
 void ra_shift_tail(roaring_array_t *ra, int32_t count, int32_t distance) {
@@ -460,6 +555,7 @@ void ra_shift_tail(roaring_array_t *ra, int32_t count, int32_t distance) {
     memmove(&(ra->typecodes[dstpos]), &(ra->typecodes[srcpos]),
             sizeof(uint8_t) * count);
     ra->size += distance;
+    ra_drop_key_index(ra);
 }
 
 
@@ -602,31 +698,25 @@ size_t ra_portable_size_in_bytes(const roaring_array_t *ra) {
     return count;
 }
 
-size_t ra_portable_serialize(const roaring_array_t *ra, char *buf) {
+uint32_t ra_portable_header_write(const roaring_array_t *ra, char *buf,
+                                 uint64_t *cardinality,
+                                 size_t *size_in_bytes) {
     char *initbuf = buf;
-    uint32_t startOffset = 0;
     bool hasrun = ra_has_run_container(ra);
     if (hasrun) {
         uint32_t cookie = SERIAL_COOKIE | ((ra->size - 1) << 16);
         memcpy(buf, &cookie, sizeof(cookie));
         buf += sizeof(cookie);
         uint32_t s = (ra->size + 7) / 8;
-        uint8_t *bitmapOfRunContainers = (uint8_t *)calloc(s, 1);
-        assert(bitmapOfRunContainers != NULL);  // todo: handle
+        uint8_t *bitmapOfRunContainers = (uint8_t *)buf;
+        memset(bitmapOfRunContainers, 0, s);
         for (int32_t i = 0; i < ra->size; ++i) {
             if (get_container_type(ra->containers[i], ra->typecodes[i]) ==
                 RUN_CONTAINER_TYPE_CODE) {
                 bitmapOfRunContainers[i / 8] |= (1 << (i % 8));
             }
         }
-        memcpy(buf, bitmapOfRunContainers, s);
         buf += s;
-        free(bitmapOfRunContainers);
-        if (ra->size < NO_OFFSET_THRESHOLD) {
-            startOffset = 4 + 4 * ra->size + s;
-        } else {
-            startOffset = 4 + 8 * ra->size + s;
-        }
     } else {  // backwards compatibility
         uint32_t cookie = SERIAL_COOKIE_NO_RUNCONTAINER;
 
@@ -634,31 +724,128 @@ size_t ra_portable_serialize(const roaring_array_t *ra, char *buf) {
         buf += sizeof(cookie);
         memcpy(buf, &ra->size, sizeof(ra->size));
         buf += sizeof(ra->size);
-
-        startOffset = 4 + 4 + 4 * ra->size + 4 * ra->size;
     }
+    // the keys and cardinalities, then the offsets of the containers if any
+    char *offsets = NULL;
+    uint32_t header_size = (uint32_t)(buf - initbuf) + 4 * ra->size;
+    if ((!hasrun) || (ra->size >= NO_OFFSET_THRESHOLD)) {
+        offsets = buf + 4 * ra->size;
+        header_size += 4 * ra->size;
+    }
+    uint32_t startOffset = header_size;
+    uint64_t card = 0;
     for (int32_t k = 0; k < ra->size; ++k) {
         memcpy(buf, &ra->keys[k], sizeof(ra->keys[k]));
         buf += sizeof(ra->keys[k]);
+        const int32_t c =
+            container_get_cardinality(ra->containers[k], ra->typecodes[k]);
+        card += c;
         // get_cardinality returns a value in [1,1<<16], subtracting one
         // we get [0,1<<16 - 1] which fits in 16 bits
+        uint16_t card16 = (uint16_t)(c - 1);
+        memcpy(buf, &card16, sizeof(card16));
+        buf += sizeof(card16);
+        if (offsets != NULL) {
+            memcpy(offsets, &startOffset, sizeof(startOffset));
+            offsets += sizeof(startOffset);
+        }
+        startOffset +=
+            container_size_in_bytes(ra->containers[k], ra->typecodes[k]);
+    }
+    *cardinality = card;
+    *size_in_bytes = startOffset;
+    return header_size;
+}
+
+size_t ra_portable_serialize(const roaring_array_t *ra, char *buf) {
+    uint64_t cardinality;
+    size_t size_in_bytes;
+    buf += ra_portable_header_write(ra, buf, &cardinality, &size_in_bytes);
+    for (int32_t k = 0; k < ra->size; ++k) {
+        buf += container_write(ra->containers[k], ra->typecodes[k], buf);
+    }
+    return size_in_bytes;
+}
+
+size_t ra_portable_packed_size_in_bytes(const roaring_array_t *ra) {
+    size_t count = 0;
+    bool haspacked = false;
+    for (int32_t k = 0; k < ra->size; ++k) {
+        int32_t packedsize =
+            container_packed_size_in_bytes(ra->containers[k], ra->typecodes[k]);
+        if (packedsize > 0) {
+            haspacked = true;
+            count += packedsize;
+        } else {
+            count +=
+                container_size_in_bytes(ra->containers[k], ra->typecodes[k]);
+        }
+    }
+    if (!haspacked) return count + ra_portable_header_size(ra);
+    // cookie, bitmaps of run and packed containers, keys and cardinalities
+    count += 4 + 2 * ((ra->size + 7) / 8) + 4 * ra->size;
+    if (ra->size >= NO_OFFSET_THRESHOLD) count += 4 * ra->size;
+    return count;
+}
+
+/*
+ * The packed variant has the layout of the SERIAL_COOKIE format, with a second
+ * bitmap flagging the packed containers right after the bitmap of run
+ * containers.
+ */
+size_t ra_portable_packed_serialize(const roaring_array_t *ra, char *buf) {
+    // the containers before the first packed one are written as usual, so
+    // that every packed size is computed once, without allocating
+    int32_t firstpacked = 0;
+    int32_t packedsize = 0;
+    for (; firstpacked < ra->size; ++firstpacked) {
+        packedsize = container_packed_size_in_bytes(
+            ra->containers[firstpacked], ra->typecodes[firstpacked]);
+        if (packedsize > 0) break;
+    }
+    if (firstpacked == ra->size) return ra_portable_serialize(ra, buf);
+    char *initbuf = buf;
+    uint32_t cookie = SERIAL_COOKIE_PACKED | ((ra->size - 1) << 16);
+    memcpy(buf, &cookie, sizeof(cookie));
+    buf += sizeof(cookie);
+    uint32_t s = (ra->size + 7) / 8;
+    uint8_t *bitmapOfRunContainers = (uint8_t *)buf;
+    uint8_t *bitmapOfPackedContainers = bitmapOfRunContainers + s;
+    memset(buf, 0, 2 * s);
+    buf += 2 * s;
+    for (int32_t k = 0; k < ra->size; ++k) {
+        memcpy(buf, &ra->keys[k], sizeof(ra->keys[k]));
+        buf += sizeof(ra->keys[k]);
         uint16_t card = (uint16_t)(
             container_get_cardinality(ra->containers[k], ra->typecodes[k]) - 1);
         memcpy(buf, &card, sizeof(card));
         buf += sizeof(card);
     }
-    if ((!hasrun) || (ra->size >= NO_OFFSET_THRESHOLD)) {
-        // writing the containers offsets
-        for (int32_t k = 0; k < ra->size; k++) {
-            memcpy(buf, &startOffset, sizeof(startOffset));
-            buf += sizeof(startOffset);
-            startOffset =
-                startOffset +
-                container_size_in_bytes(ra->containers[k], ra->typecodes[k]);
-        }
+    char *offsets = NULL;
+    if (ra->size >= NO_OFFSET_THRESHOLD) {
+        offsets = buf;
+        buf += 4 * ra->size;
     }
     for (int32_t k = 0; k < ra->size; ++k) {
-        buf += container_write(ra->containers[k], ra->typecodes[k], buf);
+        if (offsets != NULL) {
+            uint32_t startOffset = (uint32_t)(buf - initbuf);
+            memcpy(offsets + 4 * k, &startOffset, sizeof(startOffset));
+        }
+        if (k > firstpacked) {
+            packedsize = container_packed_size_in_bytes(ra->containers[k],
+                                                        ra->typecodes[k]);
+        }
+        if (k >= firstpacked && packedsize > 0) {
+            bitmapOfPackedContainers[k / 8] |= (1 << (k % 8));
+            buf += container_write_packed(ra->containers[k], ra->typecodes[k],
+                                          buf);
+        } else {
+            if (get_container_type(ra->containers[k], ra->typecodes[k]) ==
+                RUN_CONTAINER_TYPE_CODE) {
+                bitmapOfRunContainers[k / 8] |= (1 << (k % 8));
+            }
+            buf += container_write(ra->containers[k], ra->typecodes[k], buf);
+        }
     }
     return buf - initbuf;
 }
@@ -677,12 +864,13 @@ size_t ra_portable_deserialize_size(const char *buf, const size_t maxbytes) {
     memcpy(&cookie, buf, sizeof(int32_t));
     buf += sizeof(uint32_t);
     if ((cookie & 0xFFFF) != SERIAL_COOKIE &&
+        (cookie & 0xFFFF) != SERIAL_COOKIE_PACKED &&
         cookie != SERIAL_COOKIE_NO_RUNCONTAINER) {
         return 0;
     }
     int32_t size;
 
-    if ((cookie & 0xFFFF) == SERIAL_COOKIE)
+    if (cookie != SERIAL_COOKIE_NO_RUNCONTAINER)
         size = (cookie >> 16) + 1;
     else {
         bytestotal += sizeof(int32_t);
@@ -694,13 +882,21 @@ size_t ra_portable_deserialize_size(const char *buf, const size_t maxbytes) {
        return 0; // logically impossible
     }
     char *bitmapOfRunContainers = NULL;
-    bool hasrun = (cookie & 0xFFFF) == SERIAL_COOKIE;
+    char *bitmapOfPackedContainers = NULL;
+    bool hasrun = cookie != SERIAL_COOKIE_NO_RUNCONTAINER;
+    bool haspacked = (cookie & 0xFFFF) == SERIAL_COOKIE_PACKED;
     if (hasrun) {
         int32_t s = (size + 7) / 8;
         bytestotal += s;
         if(bytestotal > maxbytes) return 0;
         bitmapOfRunContainers = (char *)buf;
         buf += s;
+        if (haspacked) {
+            bytestotal += s;
+            if(bytestotal > maxbytes) return 0;
+            bitmapOfPackedContainers = (char *)buf;
+            buf += s;
+        }
     }
     bytestotal += size * 2 * sizeof(uint16_t);
     if(bytestotal > maxbytes) return 0;
@@ -719,13 +915,27 @@ size_t ra_portable_deserialize_size(const char *buf, const size_t maxbytes) {
         uint32_t thiscard = tmp + 1;
         bool isbitmap = (thiscard > DEFAULT_MAX_SIZE);
         bool isrun = false;
+        bool ispacked = false;
         if(hasrun) {
           if((bitmapOfRunContainers[k / 8] & (1 << (k % 8))) != 0) {
             isbitmap = false;
             isrun = true;
           }
         }
-        if (isbitmap) {
+        if(haspacked) {
+          if((bitmapOfPackedContainers[k / 8] & (1 << (k % 8))) != 0) {
+            // only bitset and array containers are packed
+            if(isrun) return 0;
+            ispacked = true;
+          }
+        }
+        if (ispacked) {
+            size_t containersize =
+                packed_size_from_buffer(thiscard, buf, maxbytes - bytestotal);
+            if(containersize == 0) return 0;
+            bytestotal += containersize;
+            buf += containersize;
+        } else if (isbitmap) {
             size_t containersize = BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t);
             bytestotal += containersize;
             if(bytestotal > maxbytes) return 0;
@@ -764,6 +974,7 @@ bool ra_portable_deserialize(roaring_array_t *answer, const char *buf, const siz
     memcpy(&cookie, buf, sizeof(int32_t));
     buf += sizeof(uint32_t);
     if ((cookie & 0xFFFF) != SERIAL_COOKIE &&
+        (cookie & 0xFFFF) != SERIAL_COOKIE_PACKED &&
         cookie != SERIAL_COOKIE_NO_RUNCONTAINER) {
         fprintf(stderr, "I failed to find one of the right cookies. Found %" PRIu32 "\n",
                 cookie);
@@ -771,7 +982,7 @@ bool ra_portable_deserialize(roaring_array_t *answer, const char *buf, const siz
     }
     int32_t size;
 
-    if ((cookie & 0xFFFF) == SERIAL_COOKIE)
+    if (cookie != SERIAL_COOKIE_NO_RUNCONTAINER)
         size = (cookie >> 16) + 1;
     else {
         *readbytes += sizeof(int32_t);
@@ -788,7 +999,9 @@ bool ra_portable_deserialize(roaring_array_t *answer, const char *buf, const siz
        return false; // logically impossible
     }
     const char *bitmapOfRunContainers = NULL;
-    bool hasrun = (cookie & 0xFFFF) == SERIAL_COOKIE;
+    const char *bitmapOfPackedContainers = NULL;
+    bool hasrun = cookie != SERIAL_COOKIE_NO_RUNCONTAINER;
+    bool haspacked = (cookie & 0xFFFF) == SERIAL_COOKIE_PACKED;
     if (hasrun) {
         int32_t s = (size + 7) / 8;
         *readbytes += s;
@@ -798,6 +1011,15 @@ bool ra_portable_deserialize(roaring_array_t *answer, const char *buf, const siz
         }
         bitmapOfRunContainers = buf;
         buf += s;
+        if (haspacked) {
+            *readbytes += s;
+            if(*readbytes > maxbytes) {// data is corrupted?
+              fprintf(stderr, "Ran out of bytes while reading packed bitmap.\n");
+              return false;
+            }
+            bitmapOfPackedContainers = buf;
+            buf += s;
+        }
     }
     uint16_t *keyscards = (uint16_t *)buf;
 
@@ -837,13 +1059,61 @@ bool ra_portable_deserialize(roaring_array_t *answer, const char *buf, const siz
         uint32_t thiscard = tmp + 1;
         bool isbitmap = (thiscard > DEFAULT_MAX_SIZE);
         bool isrun = false;
+        bool ispacked = false;
         if(hasrun) {
           if((bitmapOfRunContainers[k / 8] & (1 << (k % 8))) != 0) {
             isbitmap = false;
             isrun = true;
           }
         }
-        if (isbitmap) {
+        if(haspacked) {
+          if((bitmapOfPackedContainers[k / 8] & (1 << (k % 8))) != 0) {
+            if(isrun) {
+              fprintf(stderr, "Only bitset and array containers can be packed.\n");
+              ra_clear(answer);// we need to clear the containers already allocated, and the roaring array
+              return false;
+            }
+            ispacked = true;
+          }
+        }
+        if (ispacked) {
+            // we check that the read is allowed
+            size_t containersize =
+                packed_size_from_buffer(thiscard, buf, maxbytes - *readbytes);
+            if(containersize == 0) {
+              fprintf(stderr, "Running out of bytes or invalid data while reading a packed container.\n");
+              ra_clear(answer);// we need to clear the containers already allocated, and the roaring array
+              return false;
+            }
+            *readbytes += containersize;
+            // it is now safe to read
+            void *c = isbitmap
+                          ? (void *)bitset_container_create()
+                          : (void *)array_container_create_given_capacity(
+                                thiscard);
+            if(c == NULL) {// memory allocation failure
+              fprintf(stderr, "Failed to allocate memory for a packed container.\n");
+              ra_clear(answer);// we need to clear the containers already allocated, and the roaring array
+              return false;
+            }
+            const uint8_t typecode = isbitmap ? BITSET_CONTAINER_TYPE_CODE
+                                              : ARRAY_CONTAINER_TYPE_CODE;
+            const int32_t read =
+                isbitmap ? bitset_container_read_packed(
+                               thiscard, (bitset_container_t *)c, buf)
+                         : array_container_read_packed(
+                               thiscard, (array_container_t *)c, buf);
+            if(read < 0) {
+              fprintf(stderr, "Invalid values in a packed container.\n");
+              container_free(c, typecode);
+              ra_clear(answer);// we need to clear the containers already allocated, and the roaring array
+              return false;
+            }
+            answer->size++;
+            buf += containersize;
+            answer->containers[k] = c;
+            answer->typecodes[k] = typecode;
+        } else if (isbitmap) {
             // we check that the read is allowed
             size_t containersize = BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t);
             *readbytes += containersize;
@@ -915,5 +1185,6 @@ bool ra_portable_deserialize(roaring_array_t *answer, const char *buf, const siz
             answer->typecodes[k] = ARRAY_CONTAINER_TYPE_CODE;
         }
     }
+    ra_reindex_keys(answer);
     return true;
 }
@@ -0,0 +1,271 @@
+#include <stdlib.h>
+
+#include <roaring/roaring.h>
+
+roaring_bsi_t *roaring_bsi_create(void) {
+    roaring_bsi_t *bsi = (roaring_bsi_t *)malloc(sizeof(roaring_bsi_t));
+    if (bsi == NULL) return NULL;
+    bsi->ebm = roaring_bitmap_create();
+    if (bsi->ebm == NULL) {
+        free(bsi);
+        return NULL;
+    }
+    bsi->slices = NULL;
+    bsi->n_slices = 0;
+    return bsi;
+}
+
+void roaring_bsi_free(roaring_bsi_t *bsi) {
+    for (uint32_t i = 0; i < bsi->n_slices; i++) {
+        roaring_bitmap_free(bsi->slices[i]);
+    }
+    free(bsi->slices);
+    roaring_bitmap_free(bsi->ebm);
+    free(bsi);
+}
+
+// adds empty slices until values below 2^n_slices fit
+static bool bsi_grow(roaring_bsi_t *bsi, uint32_t n_slices) {
+    if (n_slices <= bsi->n_slices) return true;
+    roaring_bitmap_t **slices = (roaring_bitmap_t **)realloc(
+        bsi->slices, n_slices * sizeof(roaring_bitmap_t *));
+    if (slices == NULL) return false;
+    bsi->slices = slices;
+    for (; bsi->n_slices < n_slices; bsi->n_slices++) {
+        slices[bsi->n_slices] = roaring_bitmap_create();
+        if (slices[bsi->n_slices] == NULL) return false;
+    }
+    return true;
+}
+
+bool roaring_bsi_set_value(roaring_bsi_t *bsi, uint32_t id, uint64_t value) {
+    const uint32_t width = value == 0 ? 0 : 64 - __builtin_clzll(value);
+    if (!bsi_grow(bsi, width)) return false;
+    for (uint32_t i = 0; i < bsi->n_slices; i++) {
+        if ((value >> i) & 1) {
+            roaring_bitmap_add(bsi->slices[i], id);
+        } else {
+            roaring_bitmap_remove(bsi->slices[i], id);
+        }
+    }
+    roaring_bitmap_add(bsi->ebm, id);
+    return true;
+}
+
+bool roaring_bsi_get_value(const roaring_bsi_t *bsi, uint32_t id,
+                           uint64_t *value) {
+    if (!roaring_bitmap_contains(bsi->ebm, id)) return false;
+    *value = 0;
+    for (uint32_t i = 0; i < bsi->n_slices; i++) {
+        if (roaring_bitmap_contains(bsi->slices[i], id)) {
+            *value |= UINT64_C(1) << i;
+        }
+    }
+    return true;
+}
+
+void roaring_bsi_remove_value(roaring_bsi_t *bsi, uint32_t id) {
+    for (uint32_t i = 0; i < bsi->n_slices; i++) {
+        roaring_bitmap_remove(bsi->slices[i], id);
+    }
+    roaring_bitmap_remove(bsi->ebm, id);
+}
+
+bool roaring_bsi_run_optimize(roaring_bsi_t *bsi) {
+    bool changed = roaring_bitmap_run_optimize(bsi->ebm);
+    for (uint32_t i = 0; i < bsi->n_slices; i++) {
+        changed |= roaring_bitmap_run_optimize(bsi->slices[i]);
+    }
+    return changed;
+}
+
+// the ids of the foundset having a value
+static roaring_bitmap_t *bsi_candidates(const roaring_bsi_t *bsi,
+                                        const roaring_bitmap_t *foundset) {
+    if (foundset == NULL) return roaring_bitmap_copy(bsi->ebm);
+    return roaring_bitmap_and(bsi->ebm, foundset);
+}
+
+// Splits the ids of the foundset having a value by comparing their value with
+// x: lt and gt may be NULL when they are not needed. From the most significant
+// slice down, the ids still equal to x so far are split between those having
+// the bit and those not having it, one of which leaves for lt or gt.
+static void bsi_split(const roaring_bsi_t *bsi, uint64_t x,
+                      const roaring_bitmap_t *foundset, roaring_bitmap_t **lt,
+                      roaring_bitmap_t **eq, roaring_bitmap_t **gt) {
+    roaring_bitmap_t *equal = bsi_candidates(bsi, foundset);
+    if (lt != NULL) *lt = roaring_bitmap_create();
+    if (gt != NULL) *gt = roaring_bitmap_create();
+    if (bsi->n_slices < 64 && (x >> bsi->n_slices) != 0) {
+        // x is larger than every value
+        if (lt != NULL) {
+            roaring_bitmap_free(*lt);
+            *lt = equal;
+            equal = roaring_bitmap_create();
+        } else {
+            roaring_bitmap_clear(equal);
+        }
+    }
+    for (uint32_t i = bsi->n_slices;
+         i-- > 0 && !roaring_bitmap_is_empty(equal);) {
+        roaring_bitmap_t *ones = roaring_bitmap_and(equal, bsi->slices[i]);
+        roaring_bitmap_xor_inplace(equal, ones);  // the ids without bit i
+        if ((x >> i) & 1) {
+            if (lt != NULL) roaring_bitmap_lazy_or_inplace(*lt, equal, false);
+            roaring_bitmap_free(equal);
+            equal = ones;
+        } else {
+            if (gt != NULL) roaring_bitmap_lazy_or_inplace(*gt, ones, false);
+            roaring_bitmap_free(ones);
+        }
+    }
+    if (lt != NULL) roaring_bitmap_repair_after_lazy(*lt);
+    if (gt != NULL) roaring_bitmap_repair_after_lazy(*gt);
+    if (eq != NULL) {
+        *eq = equal;
+    } else {
+        roaring_bitmap_free(equal);
+    }
+}
+
+roaring_bitmap_t *roaring_bsi_compare(const roaring_bsi_t *bsi,
+                                      roaring_bsi_operation_t op, uint64_t x,
+                                      uint64_t y,
+                                      const roaring_bitmap_t *foundset) {
+    roaring_bitmap_t *lt = NULL, *eq = NULL, *gt = NULL;
+    switch (op) {
+        case ROARING_BSI_EQ:
+            bsi_split(bsi, x, foundset, NULL, &eq, NULL);
+            return eq;
+        case ROARING_BSI_NEQ:
+            bsi_split(bsi, x, foundset, &lt, NULL, &gt);
+            roaring_bitmap_or_inplace(lt, gt);
+            roaring_bitmap_free(gt);
+            return lt;
+        case ROARING_BSI_LT:
+            bsi_split(bsi, x, foundset, &lt, NULL, NULL);
+            return lt;
+        case ROARING_BSI_LE:
+            bsi_split(bsi, x, foundset, &lt, &eq, NULL);
+            roaring_bitmap_or_inplace(lt, eq);
+            roaring_bitmap_free(eq);
+            return lt;
+        case ROARING_BSI_GT:
+            bsi_split(bsi, x, foundset, NULL, NULL, &gt);
+            return gt;
+        case ROARING_BSI_GE:
+            bsi_split(bsi, x, foundset, NULL, &eq, &gt);
+            roaring_bitmap_or_inplace(gt, eq);
+            roaring_bitmap_free(eq);
+            return gt;
+        case ROARING_BSI_RANGE: {
+            if (x > y) return roaring_bitmap_create();
+            roaring_bitmap_t *above =
+                roaring_bsi_compare(bsi, ROARING_BSI_GE, x, 0, foundset);
+            roaring_bitmap_t *answer =
+                roaring_bsi_compare(bsi, ROARING_BSI_LE, y, 0, above);
+            roaring_bitmap_free(above);
+            return answer;
+        }
+        default:
+            return roaring_bitmap_create();
+    }
+}
+
+uint64_t roaring_bsi_sum(const roaring_bsi_t *bsi,
+                         const roaring_bitmap_t *foundset, uint64_t *count) {
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < bsi->n_slices; i++) {
+        const uint64_t ones =
+            foundset == NULL
+                ? roaring_bitmap_get_cardinality(bsi->slices[i])
+                : roaring_bitmap_and_cardinality(bsi->slices[i], foundset);
+        sum += ones << i;
+    }
+    if (count != NULL) {
+        *count = foundset == NULL
+                     ? roaring_bitmap_get_cardinality(bsi->ebm)
+                     : roaring_bitmap_and_cardinality(bsi->ebm, foundset);
+    }
+    return sum;
+}
+
+// From the most significant slice down, keeps the candidates having the bit
+// (for the largest value) or not having it (for the smallest), when any do.
+static bool bsi_extreme(const roaring_bsi_t *bsi,
+                        const roaring_bitmap_t *foundset, bool largest,
+                        uint64_t *value) {
+    roaring_bitmap_t *candidates = bsi_candidates(bsi, foundset);
+    if (roaring_bitmap_is_empty(candidates)) {
+        roaring_bitmap_free(candidates);
+        return false;
+    }
+    *value = 0;
+    for (uint32_t i = bsi->n_slices; i-- > 0;) {
+        if (roaring_bitmap_get_cardinality(candidates) == 1) {
+            // a single candidate left, read its value
+            uint32_t id = roaring_bitmap_minimum(candidates);
+            roaring_bitmap_free(candidates);
+            return roaring_bsi_get_value(bsi, id, value);
+        }
+        if (largest) {
+            if (roaring_bitmap_intersect(candidates, bsi->slices[i])) {
+                roaring_bitmap_and_inplace(candidates, bsi->slices[i]);
+                *value |= UINT64_C(1) << i;
+            }
+        } else {
+            if (roaring_bitmap_is_subset(candidates, bsi->slices[i])) {
+                *value |= UINT64_C(1) << i;
+            } else {
+                roaring_bitmap_andnot_inplace(candidates, bsi->slices[i]);
+            }
+        }
+    }
+    roaring_bitmap_free(candidates);
+    return true;
+}
+
+bool roaring_bsi_min(const roaring_bsi_t *bsi,
+                     const roaring_bitmap_t *foundset, uint64_t *value) {
+    return bsi_extreme(bsi, foundset, false, value);
+}
+
+bool roaring_bsi_max(const roaring_bsi_t *bsi,
+                     const roaring_bitmap_t *foundset, uint64_t *value) {
+    return bsi_extreme(bsi, foundset, true, value);
+}
+
+roaring_bitmap_t *roaring_bsi_top_k(const roaring_bsi_t *bsi,
+                                    const roaring_bitmap_t *foundset,
+                                    uint64_t k) {
+    // the ids tied with the k-th largest value so far
+    roaring_bitmap_t *tied = bsi_candidates(bsi, foundset);
+    if (roaring_bitmap_get_cardinality(tied) <= k) return tied;
+    // the ids with larger values, all selected
+    roaring_bitmap_t *selected = roaring_bitmap_create();
+    uint64_t n_selected = 0;
+    for (uint32_t i = bsi->n_slices; i-- > 0 && n_selected < k;) {
+        roaring_bitmap_t *ones = roaring_bitmap_and(tied, bsi->slices[i]);
+        const uint64_t n = n_selected + roaring_bitmap_get_cardinality(ones);
+        if (n > k) {
+            // the k-th largest value has bit i
+            roaring_bitmap_free(tied);
+            tied = ones;
+        } else {
+            roaring_bitmap_lazy_or_inplace(selected, ones, false);
+            roaring_bitmap_xor_inplace(tied, ones);  // the ids without bit i
+            roaring_bitmap_free(ones);
+            n_selected = n;
+        }
+    }
+    roaring_bitmap_repair_after_lazy(selected);
+    if (n_selected < k) {
+        uint32_t last = 0;
+        roaring_bitmap_select(tied, (uint32_t)(k - n_selected - 1), &last);
+        roaring_bitmap_remove_range(tied, (uint64_t)last + 1,
+                                    UINT64_C(1) << 32);
+        roaring_bitmap_or_inplace(selected, tied);
+    }
+    roaring_bitmap_free(tied);
+    return selected;
+}
@@ -0,0 +1,311 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <roaring/roaring.h>
+#include <roaring/roaring_array.h>
+
+/*
+ * The compressed envelope of the portable format is made of:
+ * - the cookie, the size of the portable header and the number of blocks;
+ * - for each block, the index of its first container, the size of its
+ *   containers in the portable format, and the end of its data;
+ * - the header of the portable format;
+ * - the data of the blocks, compressed unless this did not make them smaller.
+ * All integers are 32-bit. Decompressing all the blocks after the header
+ * gives back the portable format.
+ */
+
+typedef struct compressed_block_s {
+    uint32_t first;     // the index of the first container
+    uint32_t raw_size;  // the size of the containers in the portable format
+    uint32_t end;       // the end of the data, from the start of the first
+} compressed_block_t;
+
+enum { COMPRESSED_PREAMBLE_BYTES = 3 * sizeof(uint32_t) };
+
+// the largest container in the portable format, of 32768 runs
+#define COMPRESSED_MAX_CONTAINER_BYTES (2 + 32768 * 4)
+
+static inline compressed_block_t read_block(const char *table, uint32_t b) {
+    compressed_block_t block;
+    memcpy(&block, table + b * sizeof(block), sizeof(block));
+    return block;
+}
+
+static inline void write_block(char *table, uint32_t b,
+                               compressed_block_t block) {
+    memcpy(table + b * sizeof(block), &block, sizeof(block));
+}
+
+size_t roaring_bitmap_compressed_size_bound(const roaring_bitmap_t *ra) {
+    const roaring_array_t *hlc = &ra->high_low_container;
+    return COMPRESSED_PREAMBLE_BYTES +
+           hlc->size * sizeof(compressed_block_t) +
+           ra_portable_size_in_bytes(hlc);
+}
+
+size_t roaring_bitmap_compressed_serialize(const roaring_bitmap_t *ra,
+                                           const roaring_codec_t *codec,
+                                           uint32_t block_size, char *buf) {
+    const roaring_array_t *hlc = &ra->high_low_container;
+    roaring_serialization_t s;
+    if (!roaring_serialization_init(ra, &s)) return 0;
+    // groups the containers into blocks
+    char *table = buf + COMPRESSED_PREAMBLE_BYTES;
+    uint32_t n_blocks = 0;
+    uint32_t max_raw_size = 0;
+    for (int32_t k = 0; k < hlc->size; n_blocks++) {
+        compressed_block_t block = {(uint32_t)k, 0, 0};
+        do {
+            block.raw_size +=
+                container_size_in_bytes(hlc->containers[k], hlc->typecodes[k]);
+            k++;
+        } while (k < hlc->size && block.raw_size < block_size);
+        if (block.raw_size > max_raw_size) max_raw_size = block.raw_size;
+        write_block(table, n_blocks, block);
+    }
+    char *raw = (char *)malloc(max_raw_size);
+    if (raw == NULL && max_raw_size > 0) {
+        roaring_serialization_free(&s);
+        return 0;
+    }
+    const uint32_t preamble[3] = {SERIAL_COOKIE_COMPRESSED, s.header_size,
+                                  n_blocks};
+    memcpy(buf, preamble, sizeof(preamble));
+    char *data = table + n_blocks * sizeof(compressed_block_t);
+    memcpy(data, s.header, s.header_size);
+    data += s.header_size;
+    uint32_t end = 0;
+    for (uint32_t b = 0; b < n_blocks; b++) {
+        compressed_block_t block = read_block(table, b);
+        const int32_t last = b + 1 < n_blocks
+                                 ? (int32_t)read_block(table, b + 1).first
+                                 : hlc->size;
+        char *out = raw;
+        for (int32_t k = block.first; k < last; k++) {
+            out += container_write(hlc->containers[k], hlc->typecodes[k], out);
+        }
+        size_t stored = 0;
+        if (codec != NULL) {
+            stored = codec->compress(raw, block.raw_size, data + end,
+                                     block.raw_size - 1, codec->arg);
+        }
+        if (stored == 0 || stored >= block.raw_size) {
+            memcpy(data + end, raw, block.raw_size);
+            stored = block.raw_size;
+        }
+        end += (uint32_t)stored;
+        block.end = end;
+        write_block(table, b, block);
+    }
+    free(raw);
+    roaring_serialization_free(&s);
+    return data + end - buf;
+}
+
+bool roaring_compressed_init(roaring_compressed_t *c, const char *buf,
+                             size_t maxbytes, const roaring_codec_t *codec) {
+    uint32_t preamble[3];
+    if (maxbytes < sizeof(preamble)) return false;
+    memcpy(preamble, buf, sizeof(preamble));
+    const uint32_t header_size = preamble[1];
+    const uint32_t n_blocks = preamble[2];
+    if (preamble[0] != SERIAL_COOKIE_COMPRESSED) return false;
+    if (n_blocks > MAX_CONTAINERS) return false;
+    size_t bytes = sizeof(preamble) + n_blocks * sizeof(compressed_block_t);
+    if (bytes + header_size > maxbytes) return false;
+    c->codec = codec;
+    c->n_blocks = n_blocks;
+    c->table = buf + sizeof(preamble);
+    const char *header = buf + bytes;
+    c->data = header + header_size;
+    bytes += header_size;
+    // the portable header, without the offsets
+    uint32_t cookie;
+    if (header_size < sizeof(cookie)) return false;
+    memcpy(&cookie, header, sizeof(cookie));
+    size_t expected = sizeof(cookie);
+    if ((cookie & 0xFFFF) == SERIAL_COOKIE) {
+        c->n_containers = (cookie >> 16) + 1;
+        c->runs = header + expected;
+        expected += (c->n_containers + 7) / 8;
+    } else if (cookie == SERIAL_COOKIE_NO_RUNCONTAINER) {
+        if (header_size < expected + sizeof(int32_t)) return false;
+        memcpy(&c->n_containers, header + expected, sizeof(int32_t));
+        if (c->n_containers < 0 || c->n_containers > MAX_CONTAINERS) {
+            return false;
+        }
+        c->runs = NULL;
+        expected += sizeof(int32_t);
+    } else {
+        return false;
+    }
+    c->keyscards = header + expected;
+    expected += 4 * (size_t)c->n_containers;
+    if (c->runs == NULL || c->n_containers >= NO_OFFSET_THRESHOLD) {
+        expected += 4 * (size_t)c->n_containers;
+    }
+    if (expected != header_size) return false;
+    // the blocks cover the containers in order, and their data is in bounds
+    if ((n_blocks == 0) != (c->n_containers == 0)) return false;
+    uint32_t end = 0;
+    uint64_t portable_size = header_size;
+    for (uint32_t b = 0; b < n_blocks; b++) {
+        const compressed_block_t block = read_block(c->table, b);
+        const uint32_t last = b + 1 < n_blocks
+                                  ? read_block(c->table, b + 1).first
+                                  : (uint32_t)c->n_containers;
+        if (b == 0 && block.first != 0) return false;
+        if (last <= block.first || last > (uint32_t)c->n_containers) {
+            return false;
+        }
+        if (block.raw_size >
+            (uint64_t)(last - block.first) * COMPRESSED_MAX_CONTAINER_BYTES) {
+            return false;
+        }
+        if (block.end < end || block.end - end > block.raw_size) return false;
+        end = block.end;
+        portable_size += block.raw_size;
+    }
+    // the portable format, once decompressed, must be addressable, also on
+    // 32-bit systems, and no larger than its containers can be
+    if (portable_size > SIZE_MAX ||
+        portable_size > header_size + (uint64_t)c->n_containers *
+                                          COMPRESSED_MAX_CONTAINER_BYTES) {
+        return false;
+    }
+    bytes += end;
+    if (bytes > maxbytes) return false;
+    c->size_in_bytes = bytes;
+    return true;
+}
+
+// decompresses the containers of a block to dst
+static bool decompress_block(const roaring_compressed_t *c, uint32_t b,
+                             char *dst) {
+    const compressed_block_t block = read_block(c->table, b);
+    const uint32_t start = b == 0 ? 0 : read_block(c->table, b - 1).end;
+    const uint32_t stored = block.end - start;
+    if (stored == block.raw_size) {
+        memcpy(dst, c->data + start, stored);
+        return true;
+    }
+    if (c->codec == NULL) return false;
+    return c->codec->decompress(c->data + start, stored, dst, block.raw_size,
+                                c->codec->arg);
+}
+
+// reads a portable format that should fill the buffer exactly
+static roaring_bitmap_t *portable_deserialize_exact(const char *buf,
+                                                    size_t size) {
+    roaring_bitmap_t *ans =
+        (roaring_bitmap_t *)malloc(sizeof(roaring_bitmap_t));
+    if (ans == NULL) return NULL;
+    size_t bytesread;
+    if (!ra_portable_deserialize(&ans->high_low_container, buf, size,
+                                 &bytesread)) {
+        free(ans);
+        return NULL;
+    }
+    roaring_bitmap_set_copy_on_write(ans, false);
+    if (bytesread != size) {
+        roaring_bitmap_free(ans);
+        return NULL;
+    }
+    return ans;
+}
+
+roaring_bitmap_t *roaring_bitmap_compressed_deserialize_safe(
+    const char *buf, size_t maxbytes, const roaring_codec_t *codec) {
+    roaring_compressed_t c;
+    if (!roaring_compressed_init(&c, buf, maxbytes, codec)) return NULL;
+    // the portable format: the header, then the blocks once decompressed,
+    // whose size roaring_compressed_init checked to fit in a size_t
+    const char *header = c.table + c.n_blocks * sizeof(compressed_block_t);
+    const size_t header_size = c.data - header;
+    size_t size = header_size;
+    for (uint32_t b = 0; b < c.n_blocks; b++) {
+        size += read_block(c.table, b).raw_size;
+    }
+    char *portable = (char *)malloc(size);
+    if (portable == NULL) return NULL;
+    memcpy(portable, header, header_size);
+    char *out = portable + header_size;
+    for (uint32_t b = 0; b < c.n_blocks; b++) {
+        if (!decompress_block(&c, b, out)) {
+            free(portable);
+            return NULL;
+        }
+        out += read_block(c.table, b).raw_size;
+    }
+    roaring_bitmap_t *ans = portable_deserialize_exact(portable, size);
+    free(portable);
+    return ans;
+}
+
+uint32_t roaring_compressed_find_block(const roaring_compressed_t *c,
+                                       uint32_t x) {
+    const uint16_t key = x >> 16;
+    int32_t low = 0;
+    int32_t high = c->n_containers - 1;
+    int32_t k = -1;
+    while (low <= high) {
+        const int32_t middle = (low + high) >> 1;
+        uint16_t middlekey;
+        memcpy(&middlekey, c->keyscards + 4 * middle, sizeof(middlekey));
+        if (middlekey < key) {
+            low = middle + 1;
+        } else if (middlekey > key) {
+            high = middle - 1;
+        } else {
+            k = middle;
+            break;
+        }
+    }
+    if (k < 0) return c->n_blocks;
+    // the last block starting at or before the container
+    uint32_t lo = 0;
+    uint32_t hi = c->n_blocks;
+    while (hi - lo > 1) {
+        const uint32_t middle = (lo + hi) / 2;
+        if (read_block(c->table, middle).first <= (uint32_t)k) {
+            lo = middle;
+        } else {
+            hi = middle;
+        }
+    }
+    return lo;
+}
+
+roaring_bitmap_t *roaring_compressed_block_deserialize(
+    const roaring_compressed_t *c, uint32_t block) {
+    if (block >= c->n_blocks) return NULL;
+    const compressed_block_t b = read_block(c->table, block);
+    const uint32_t last = block + 1 < c->n_blocks
+                              ? read_block(c->table, block + 1).first
+                              : (uint32_t)c->n_containers;
+    // a portable header for the containers of the block alone
+    const uint32_t n = last - b.first;
+    const uint32_t s = (n + 7) / 8;
+    size_t header_size = sizeof(uint32_t) + s + 4 * n;
+    if (n >= NO_OFFSET_THRESHOLD) header_size += 4 * n;
+    char *portable = (char *)malloc(header_size + b.raw_size);
+    if (portable == NULL) return NULL;
+    const uint32_t cookie = SERIAL_COOKIE | ((n - 1) << 16);
+    memcpy(portable, &cookie, sizeof(cookie));
+    uint8_t *runs = (uint8_t *)portable + sizeof(cookie);
+    memset(runs, 0, s);
+    for (uint32_t i = 0; i < n && c->runs != NULL; i++) {
+        const uint32_t k = b.first + i;
+        if (c->runs[k / 8] & (1 << (k % 8))) runs[i / 8] |= (1 << (i % 8));
+    }
+    memcpy(runs + s, c->keyscards + 4 * b.first, 4 * n);
+    // the offsets are skipped when reading
+    memset(runs + s + 4 * n, 0, header_size - (sizeof(cookie) + s + 4 * n));
+    roaring_bitmap_t *ans = NULL;
+    if (decompress_block(c, block, portable + header_size)) {
+        ans = portable_deserialize_exact(portable, header_size + b.raw_size);
+    }
+    free(portable);
+    return ans;
+}
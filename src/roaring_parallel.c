@@ -0,0 +1,281 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <roaring/containers/packed.h>
+#include <roaring/roaring.h>
+#include <roaring/roaring_array.h>
+
+/*
+ * The portable format is read in three steps:
+ * - the header is read, and the place of every container in the buffer is
+ *   found, reading only the number of runs of run containers and the widths
+ *   of the blocks of packed containers;
+ * - a single slab is allocated for the bitmap, its arrays, its containers
+ *   and their data, which the bitmap, frozen, frees at once;
+ * - the containers are split into tasks reading similar numbers of bytes,
+ *   which the executor runs.
+ */
+
+typedef struct parallel_header_s {
+    const char *runs;      // the bitmap of run containers, or NULL
+    const char *packed;    // the bitmap of packed containers, or NULL
+    const char *keyscards;
+    int32_t size;
+    size_t data;           // the offset of the first container
+} parallel_header_t;
+
+static inline bool has_bit(const char *bitmap, int32_t k) {
+    return bitmap != NULL && (bitmap[k / 8] & (1 << (k % 8))) != 0;
+}
+
+static inline uint32_t header_cardinality(const parallel_header_t *h,
+                                          int32_t k) {
+    uint16_t card;
+    memcpy(&card, h->keyscards + 4 * k + 2, sizeof(card));
+    return card + UINT32_C(1);
+}
+
+static bool read_header(const char *buf, size_t maxbytes,
+                        parallel_header_t *h) {
+    uint32_t cookie;
+    size_t bytes = sizeof(cookie);
+    if (bytes > maxbytes) return false;
+    memcpy(&cookie, buf, sizeof(cookie));
+    if ((cookie & 0xFFFF) == SERIAL_COOKIE ||
+        (cookie & 0xFFFF) == SERIAL_COOKIE_PACKED) {
+        h->size = (cookie >> 16) + 1;
+        const int32_t s = (h->size + 7) / 8;
+        h->runs = buf + bytes;
+        bytes += s;
+        h->packed = NULL;
+        if ((cookie & 0xFFFF) == SERIAL_COOKIE_PACKED) {
+            h->packed = buf + bytes;
+            bytes += s;
+        }
+    } else if (cookie == SERIAL_COOKIE_NO_RUNCONTAINER) {
+        if (bytes + sizeof(int32_t) > maxbytes) return false;
+        memcpy(&h->size, buf + bytes, sizeof(int32_t));
+        if (h->size < 0 || h->size > MAX_CONTAINERS) return false;
+        bytes += sizeof(int32_t);
+        h->runs = NULL;
+        h->packed = NULL;
+    } else {
+        return false;
+    }
+    h->keyscards = buf + bytes;
+    bytes += 4 * (size_t)h->size;
+    if (h->runs == NULL || h->size >= NO_OFFSET_THRESHOLD) {
+        bytes += 4 * (size_t)h->size;  // skipping the offsets
+    }
+    if (bytes > maxbytes) return false;
+    h->data = bytes;
+    return true;
+}
+
+typedef struct parallel_task_s {
+    roaring_array_t *ra;
+    const char *buf;
+    const size_t *sources;  // the offset of the data of every container
+    const char *packed;     // the bitmap of packed containers, or NULL
+    int32_t *first;         // the first container of every task, and the end
+    bool *failed;           // whether every task failed
+} parallel_task_t;
+
+// reads the containers of task t into the slab
+static void parallel_read(void *arg, uint32_t t) {
+    const parallel_task_t *task = (const parallel_task_t *)arg;
+    const roaring_array_t *ra = task->ra;
+    for (int32_t k = task->first[t]; k < task->first[t + 1]; k++) {
+        const char *src = task->buf + task->sources[k];
+        void *c = ra->containers[k];
+        if (has_bit(task->packed, k)) {
+            const int32_t read =
+                ra->typecodes[k] == BITSET_CONTAINER_TYPE_CODE
+                    ? bitset_container_read_packed(
+                          ((bitset_container_t *)c)->cardinality,
+                          (bitset_container_t *)c, src)
+                    : array_container_read_packed(
+                          ((array_container_t *)c)->cardinality,
+                          (array_container_t *)c, src);
+            if (read < 0) task->failed[t] = true;
+            continue;
+        }
+        switch (ra->typecodes[k]) {
+            case BITSET_CONTAINER_TYPE_CODE:
+                memcpy(((bitset_container_t *)c)->array, src,
+                       BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t));
+                break;
+            case RUN_CONTAINER_TYPE_CODE: {
+                run_container_t *run = (run_container_t *)c;
+                memcpy(run->runs, src, run->n_runs * sizeof(rle16_t));
+                break;
+            }
+            default: {
+                array_container_t *array = (array_container_t *)c;
+                memcpy(array->array, src,
+                       array->cardinality * sizeof(uint16_t));
+                break;
+            }
+        }
+    }
+}
+
+static inline void *slab_alloc(char **slab, size_t num_bytes) {
+    char *res = *slab;
+    *slab += num_bytes;
+    return res;
+}
+
+const roaring_bitmap_t *roaring_bitmap_portable_deserialize_parallel(
+    const char *buf, size_t maxbytes, const roaring_executor_t *executor) {
+    parallel_header_t h;
+    if (!read_header(buf, maxbytes, &h)) return NULL;
+    const int32_t size = h.size;
+    size_t *sources = (size_t *)malloc((size + 1) * sizeof(size_t));
+    if (sources == NULL) return NULL;
+    // where the containers are, and the size of their data once read
+    size_t bitset_zone_size = 0, run_zone_size = 0, array_zone_size = 0;
+    size_t structs_size = 0;
+    size_t pos = h.data;
+    for (int32_t k = 0; k < size; k++) {
+        const uint32_t card = header_cardinality(&h, k);
+        size_t bytes;
+        if (has_bit(h.runs, k)) {
+            if (has_bit(h.packed, k) || pos + sizeof(uint16_t) > maxbytes) {
+                free(sources);
+                return NULL;
+            }
+            uint16_t n_runs;
+            memcpy(&n_runs, buf + pos, sizeof(n_runs));
+            pos += sizeof(n_runs);
+            bytes = n_runs * sizeof(rle16_t);
+            run_zone_size += bytes;
+            structs_size += sizeof(run_container_t);
+        } else {
+            if (card > DEFAULT_MAX_SIZE) {
+                bitset_zone_size +=
+                    BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t);
+                structs_size += sizeof(bitset_container_t);
+                bytes = BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t);
+            } else {
+                array_zone_size += card * sizeof(uint16_t);
+                structs_size += sizeof(array_container_t);
+                bytes = card * sizeof(uint16_t);
+            }
+            if (has_bit(h.packed, k)) {
+                bytes = packed_size_from_buffer(card, buf + pos,
+                                                maxbytes - pos);
+                if (bytes == 0) {
+                    free(sources);
+                    return NULL;
+                }
+            }
+        }
+        if (bytes > maxbytes - pos) {
+            free(sources);
+            return NULL;
+        }
+        sources[k] = pos;
+        pos += bytes;
+    }
+    sources[size] = pos;
+
+    // the bitmap, its arrays, the containers, then their data
+    size_t alloc_size = sizeof(roaring_bitmap_t);
+    alloc_size += size * (sizeof(void *) + sizeof(uint16_t) + sizeof(uint8_t));
+    alloc_size += structs_size;
+    alloc_size += 32 - 1;  // to align the bitsets
+    alloc_size += bitset_zone_size + run_zone_size + array_zone_size;
+    char *slab = (char *)malloc(alloc_size);
+    if (slab == NULL) {
+        free(sources);
+        return NULL;
+    }
+    roaring_bitmap_t *rb =
+        (roaring_bitmap_t *)slab_alloc(&slab, sizeof(roaring_bitmap_t));
+    roaring_array_t *ra = &rb->high_low_container;
+    ra->flags = ROARING_FLAG_FROZEN;
+    ra->allocation_size = size;
+    ra->size = size;
+    ra->key_index = NULL;
+    ra->containers = (void **)slab_alloc(&slab, size * sizeof(void *));
+    char *structs = (char *)slab_alloc(&slab, structs_size);
+    ra->keys = (uint16_t *)slab_alloc(&slab, size * sizeof(uint16_t));
+    ra->typecodes = (uint8_t *)slab_alloc(&slab, size * sizeof(uint8_t));
+    slab += (32 - (uintptr_t)slab % 32) % 32;
+    uint64_t *bitset_zone = (uint64_t *)slab_alloc(&slab, bitset_zone_size);
+    rle16_t *run_zone = (rle16_t *)slab_alloc(&slab, run_zone_size);
+    uint16_t *array_zone = (uint16_t *)slab_alloc(&slab, array_zone_size);
+    for (int32_t k = 0; k < size; k++) {
+        memcpy(&ra->keys[k], h.keyscards + 4 * k, sizeof(uint16_t));
+        const uint32_t card = header_cardinality(&h, k);
+        if (has_bit(h.runs, k)) {
+            run_container_t *run = (run_container_t *)slab_alloc(
+                &structs, sizeof(run_container_t));
+            uint16_t n_runs;
+            memcpy(&n_runs, buf + sources[k] - sizeof(n_runs),
+                   sizeof(n_runs));
+            run->n_runs = n_runs;
+            run->capacity = n_runs;
+            run->runs = run_zone;
+            run_zone += n_runs;
+            ra->containers[k] = run;
+            ra->typecodes[k] = RUN_CONTAINER_TYPE_CODE;
+        } else if (card > DEFAULT_MAX_SIZE) {
+            bitset_container_t *bitset = (bitset_container_t *)slab_alloc(
+                &structs, sizeof(bitset_container_t));
+            bitset->cardinality = card;
+            bitset->array = bitset_zone;
+            bitset_zone += BITSET_CONTAINER_SIZE_IN_WORDS;
+            ra->containers[k] = bitset;
+            ra->typecodes[k] = BITSET_CONTAINER_TYPE_CODE;
+        } else {
+            array_container_t *array = (array_container_t *)slab_alloc(
+                &structs, sizeof(array_container_t));
+            array->cardinality = card;
+            array->capacity = card;
+            array->array = array_zone;
+            array_zone += card;
+            ra->containers[k] = array;
+            ra->typecodes[k] = ARRAY_CONTAINER_TYPE_CODE;
+        }
+    }
+
+    // tasks reading similar numbers of bytes
+    uint32_t n_tasks = executor == NULL ? 1 : executor->n_tasks;
+    if (n_tasks > (uint32_t)size) n_tasks = size;
+    if (n_tasks == 0) n_tasks = 1;
+    int32_t *first = (int32_t *)malloc((n_tasks + 1) * sizeof(int32_t));
+    bool *failed = (bool *)calloc(n_tasks, sizeof(bool));
+    if (first == NULL || failed == NULL) {
+        free(first);
+        free(failed);
+        free(sources);
+        free(rb);
+        return NULL;
+    }
+    const size_t total = sources[size] - h.data;
+    int32_t k = 0;
+    for (uint32_t t = 0; t < n_tasks; t++) {
+        const size_t start = h.data + total / n_tasks * t;
+        while (k < size && sources[k] < start) k++;
+        first[t] = k;
+    }
+    first[n_tasks] = size;
+    parallel_task_t task = {ra, buf, sources, h.packed, first, failed};
+    if (executor == NULL) {
+        parallel_read(&task, 0);
+    } else {
+        executor->run(parallel_read, &task, n_tasks, executor->arg);
+    }
+    bool ok = true;
+    for (uint32_t t = 0; t < n_tasks; t++) ok = ok && !failed[t];
+    free(first);
+    free(failed);
+    free(sources);
+    if (!ok) {
+        free(rb);
+        return NULL;
+    }
+    return rb;
+}
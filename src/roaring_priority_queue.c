@@ -185,11 +185,26 @@ static roaring_bitmap_t *lazy_or_from_lazy_inputs(roaring_bitmap_t *x1,
     return answer;
 }
 
+// Serialized size of the union of two bitmaps of serialized sizes size1 and
+// size2, having length1 and length2 containers. When their keys are disjoint,
+// the union holds all their containers and the sum of their sizes is all but
+// exact, so that we need not walk the containers of the union.
+static uint64_t union_size(const roaring_bitmap_t *answer, uint64_t size1,
+                           int32_t length1, uint64_t size2, int32_t length2) {
+    if (ra_get_size(&answer->high_low_container) == length1 + length2) {
+        return size1 + size2;
+    }
+    return roaring_bitmap_portable_size_in_bytes(answer);
+}
+
 /**
  * Compute the union of 'number' bitmaps using a heap. This can
  * sometimes be faster than roaring_bitmap_or_many which uses
  * a naive algorithm. Caller is responsible for freeing the
  * result.
+ *
+ * The bitmaps are ordered by serialized size, which is only recomputed after
+ * unions of bitmaps sharing keys.
  */
 roaring_bitmap_t *roaring_bitmap_or_many_heap(uint32_t number,
                                               const roaring_bitmap_t **x) {
@@ -203,6 +218,8 @@ roaring_bitmap_t *roaring_bitmap_or_many_heap(uint32_t number,
     while (pq->size > 1) {
         roaring_pq_element_t x1 = pq_poll(pq);
         roaring_pq_element_t x2 = pq_poll(pq);
+        const int32_t length1 = ra_get_size(&x1.bitmap->high_low_container);
+        const int32_t length2 = ra_get_size(&x2.bitmap->high_low_container);
 
         if (x1.is_temporary && x2.is_temporary) {
             roaring_bitmap_t *newb =
@@ -210,23 +227,25 @@ roaring_bitmap_t *roaring_bitmap_or_many_heap(uint32_t number,
             // should normally return a fresh new bitmap *except* that
             // it can return x1.bitmap or x2.bitmap in degenerate cases
             bool temporary = !((newb == x1.bitmap) && (newb == x2.bitmap));
-            uint64_t bsize = roaring_bitmap_portable_size_in_bytes(newb);
+            uint64_t bsize =
+                union_size(newb, x1.size, length1, x2.size, length2);
             roaring_pq_element_t newelement = {
                 .size = bsize, .is_temporary = temporary, .bitmap = newb};
             pq_add(pq, &newelement);
         } else if (x2.is_temporary) {
             roaring_bitmap_lazy_or_inplace(x2.bitmap, x1.bitmap, false);
-            x2.size = roaring_bitmap_portable_size_in_bytes(x2.bitmap);
+            x2.size = union_size(x2.bitmap, x1.size, length1, x2.size, length2);
             pq_add(pq, &x2);
         } else if (x1.is_temporary) {
             roaring_bitmap_lazy_or_inplace(x1.bitmap, x2.bitmap, false);
-            x1.size = roaring_bitmap_portable_size_in_bytes(x1.bitmap);
+            x1.size = union_size(x1.bitmap, x1.size, length1, x2.size, length2);
 
             pq_add(pq, &x1);
         } else {
             roaring_bitmap_t *newb =
                 roaring_bitmap_lazy_or(x1.bitmap, x2.bitmap, false);
-            uint64_t bsize = roaring_bitmap_portable_size_in_bytes(newb);
+            uint64_t bsize =
+                union_size(newb, x1.size, length1, x2.size, length2);
             roaring_pq_element_t newelement = {
                 .size = bsize, .is_temporary = true, .bitmap = newb};
 
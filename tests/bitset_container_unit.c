@@ -161,6 +161,43 @@ void xor_test() {
     bitset_container_free(TMP);
 }
 
+void many_test() {
+    bitset_container_t* B[5];
+    bitset_container_t* BO = bitset_container_create();
+    bitset_container_t* BX = bitset_container_create();
+    bitset_container_t* BA = bitset_container_create();
+    assert_non_null(BO);
+    assert_non_null(BX);
+    assert_non_null(BA);
+
+    for (int i = 0; i < 5; i++) {
+        B[i] = bitset_container_create();
+        assert_non_null(B[i]);
+        for (size_t x = i; x < (1 << 16); x += 2 + i) {
+            bitset_container_set(B[i], x);
+        }
+    }
+    // the operations accumulate into the destination
+    bitset_container_set_all(BA);
+    bitset_container_or_many(BO, (const bitset_container_t* const*)B, 5);
+    bitset_container_xor_many(BX, (const bitset_container_t* const*)B, 5);
+    bitset_container_and_many(BA, (const bitset_container_t* const*)B, 5);
+    assert_int_equal(BO->cardinality, BITSET_UNKNOWN_CARDINALITY);
+
+    for (size_t x = 0; x < (1 << 16); x++) {
+        int count = 0;
+        for (int i = 0; i < 5; i++) count += bitset_container_get(B[i], x);
+        assert_int_equal(bitset_container_get(BO, x), count > 0);
+        assert_int_equal(bitset_container_get(BX, x), count % 2);
+        assert_int_equal(bitset_container_get(BA, x), count == 5);
+    }
+
+    for (int i = 0; i < 5; i++) bitset_container_free(B[i]);
+    bitset_container_free(BO);
+    bitset_container_free(BX);
+    bitset_container_free(BA);
+}
+
 void andnot_test() {
     bitset_container_t* B1 = bitset_container_create();
     bitset_container_t* B2 = bitset_container_create();
@@ -199,6 +236,62 @@ void andnot_test() {
     bitset_container_free(TMP);
 }
 
+// runs counted bit by bit
+static int naive_number_of_runs(const bitset_container_t* B) {
+    int runs = 0;
+    for (int x = 0; x < (1 << 16); x++) {
+        bool starts = x == 0 || !bitset_container_get(B, x - 1);
+        if (bitset_container_get(B, x) && starts) runs++;
+    }
+    return runs;
+}
+
+void runs_test() {
+    bitset_container_t* B1 = bitset_container_create();
+    bitset_container_t* B2 = bitset_container_create();
+    bitset_container_t* EXPECTED = bitset_container_create();
+    bitset_container_t* OUT = bitset_container_create();
+
+    // runs that cross 64-bit and 256-bit word boundaries, plus both ends
+    for (size_t x = 0; x < (1 << 16); x += 7) bitset_container_set(B1, x);
+    for (size_t x = 0; x < (1 << 16); x += 300) {
+        for (size_t y = x + 250; y < x + 262 && y < (1 << 16); y++) {
+            bitset_container_set(B2, y);
+        }
+    }
+    bitset_container_set(B2, 0);
+    bitset_container_set(B2, 65535);
+
+    int (*ops[])(const bitset_container_t*, const bitset_container_t*,
+                 bitset_container_t*) = {
+        bitset_container_or, bitset_container_and, bitset_container_xor,
+        bitset_container_andnot};
+    int (*runs_ops[])(const bitset_container_t*, const bitset_container_t*,
+                      bitset_container_t*, int32_t*) = {
+        bitset_container_or_runs, bitset_container_and_runs,
+        bitset_container_xor_runs, bitset_container_andnot_runs};
+    for (int i = 0; i < 4; i++) {
+        const int card = ops[i](B1, B2, EXPECTED);
+        int32_t n_runs = -1;
+        assert_int_equal(card, runs_ops[i](B1, B2, OUT, &n_runs));
+        assert_int_equal(card, OUT->cardinality);
+        assert_true(bitset_container_equals(EXPECTED, OUT));
+        assert_int_equal(naive_number_of_runs(EXPECTED), n_runs);
+        assert_int_equal(n_runs, bitset_container_number_of_runs(EXPECTED));
+
+        // in place
+        bitset_container_copy(B1, OUT);
+        assert_int_equal(card, runs_ops[i](OUT, B2, OUT, &n_runs));
+        assert_true(bitset_container_equals(EXPECTED, OUT));
+        assert_int_equal(naive_number_of_runs(EXPECTED), n_runs);
+    }
+
+    bitset_container_free(B1);
+    bitset_container_free(B2);
+    bitset_container_free(EXPECTED);
+    bitset_container_free(OUT);
+}
+
 void to_uint32_array_test() {
     for (size_t offset = 1; offset < 128; offset *= 2) {
         bitset_container_t* B = bitset_container_create();
@@ -253,7 +346,8 @@ int main() {
         cmocka_unit_test(test_bitset_lenrange_cardinality),
         cmocka_unit_test(printf_test), cmocka_unit_test(set_get_test),
         cmocka_unit_test(and_or_test), cmocka_unit_test(xor_test),
-        cmocka_unit_test(andnot_test), cmocka_unit_test(to_uint32_array_test),
+        cmocka_unit_test(many_test), cmocka_unit_test(andnot_test),
+        cmocka_unit_test(runs_test), cmocka_unit_test(to_uint32_array_test),
         cmocka_unit_test(select_test),
         cmocka_unit_test(test_bitset_compute_cardinality),
     };
@@ -10,6 +10,7 @@
 #include <string.h>
 #include <time.h>
 #include <iostream>
+#include <vector>
 #include "roaring.hh"
 #include "roaring64map.hh"
 extern "C" {
@@ -488,6 +489,190 @@ void test_cpp_add_remove_checked_64(void **) {
     assert_true(roaring.isEmpty());
 }
 
+void test_cpp_rvalue_operators(void **) {
+    Roaring a, b, c, d, e;
+    a.addRange(0, 1000);
+    b.addRange(500, 1500);
+    c.addRange(2000, 3000);
+    d.addRange(2500, 2600);
+    e.addRange(2550, 2560);
+    Roaring expected = ((a & b) | (c & d)) - e;
+    assert_true(expected.cardinality() == 590);
+    Roaring r = ((Roaring(a) & b) | (Roaring(c) & Roaring(d))) - e;
+    assert_true(r == expected);
+    assert_true((Roaring(a) & b) == (a & b));
+    assert_true((a & Roaring(b)) == (a & b));
+    assert_true((Roaring(a) | b) == (a | b));
+    assert_true((a | Roaring(b)) == (a | b));
+    assert_true((Roaring(a) ^ Roaring(b)) == (a ^ b));
+    assert_true((a ^ Roaring(b)) == (a ^ b));
+    assert_true((Roaring(a) - b) == (a - b));
+    assert_true((Roaring(b) - Roaring(a)) == (b - a));
+    assert_true(a.cardinality() == 1000 && b.cardinality() == 1000);
+
+    Roaring64Map a64, b64;
+    a64.add(uint64_t(1));
+    a64.add(uint64_t(5) << 32);
+    b64.add(uint64_t(5) << 32);
+    b64.add(uint64_t(7) << 32);
+    Roaring64Map and64 = Roaring64Map(a64) & b64;
+    assert_true(and64.cardinality() == 1 && and64.contains(uint64_t(5) << 32));
+    Roaring64Map or64 = a64 | Roaring64Map(b64);
+    assert_true(or64.cardinality() == 3);
+    Roaring64Map xor64 = Roaring64Map(a64) ^ Roaring64Map(b64);
+    assert_true(xor64.cardinality() == 2 && xor64.contains(uint64_t(1)) &&
+                xor64.contains(uint64_t(7) << 32));
+    Roaring64Map andnot64 = Roaring64Map(a64) - b64;
+    assert_true(andnot64.cardinality() == 1 && andnot64.contains(uint64_t(1)));
+    assert_true(a64.cardinality() == 2 && b64.cardinality() == 2);
+}
+
+void test_cpp_bulk_and_reverse_iterators(void **) {
+    Roaring r;
+    r.addRange(10, 20);
+    for (uint32_t i = 100000; i < 200000; i += 3) r.add(i);
+    r.addRange(500000, 600000);
+    r.runOptimize();
+    r.add(0xFFFFFFFF);
+
+    std::vector<uint32_t> values(r.cardinality());
+    r.toUint32Array(values.data());
+
+    size_t n = 0;
+    for (auto i = r.bulk_begin(); i != r.bulk_end(); ++i) {
+        assert_true(*i == values[n++]);
+    }
+    assert_true(n == values.size());
+
+    n = values.size();
+    for (auto i = r.rbegin(); i != r.rend(); ++i) {
+        assert_true(*i == values[--n]);
+    }
+    assert_true(n == 0);
+
+    // copies share the decoded block but keep their values across refills
+    n = 0;
+    for (auto i = r.bulk_begin(); i != r.bulk_end();) {
+        auto old = i++;
+        assert_true(*old == values[n++]);
+    }
+    assert_true(n == values.size());
+    n = values.size();
+    for (auto i = r.rbegin(); i != r.rend();) {
+        auto old = i++;
+        assert_true(*old == values[--n]);
+    }
+    assert_true(n == 0);
+
+    // skipTo only moves forward (backward for the reverse iterator)
+    auto b = r.bulk_begin();
+    assert_true(b.skipTo(15) && *b == 15);
+    assert_true(b.skipTo(5) && *b == 15);
+    assert_true(b.skipTo(100001) && *b == 100003);
+    assert_true(b.skipTo(100003) && *b == 100003);
+    assert_true(b.skipTo(100004) && *b == 100006);
+    assert_true(b.skipTo(300000) && *b == 500000);
+    assert_true(b.skipTo(599999) && *b == 599999);
+    ++b;
+    assert_true(*b == 0xFFFFFFFF);
+    ++b;
+    assert_true(b == r.bulk_end());
+    assert_false(b.skipTo(0));
+
+    auto e = r.rbegin();
+    assert_true(e.skipTo(0xFFFFFFFE) && *e == 599999);
+    assert_true(e.skipTo(0xFFFFFFFF) && *e == 599999);
+    assert_true(e.skipTo(499999) && *e == 199999);
+    assert_true(e.skipTo(100001) && *e == 100000);
+    assert_true(e.skipTo(25) && *e == 19);
+    assert_false(e.skipTo(9));
+    assert_true(e == r.rend());
+
+    Roaring empty;
+    assert_true(empty.bulk_begin() == empty.bulk_end());
+    assert_true(empty.rbegin() == empty.rend());
+}
+
+void test_cpp_intersection_iterator(void **) {
+    Roaring a, b, c;
+    a.addRange(0, 100000);
+    for (uint32_t i = 0; i < 200000; i += 2) b.add(i);
+    for (uint32_t i = 0; i < 200000; i += 3) c.add(i);
+    Roaring expected = a & b & c;
+    const Roaring *inputs[] = {&a, &b, &c};
+    RoaringIntersectionIterator it(3, inputs);
+    for (auto e = expected.begin(); e != expected.end(); ++e) {
+        assert_true(it.has_value() && *it == *e);
+        ++it;
+    }
+    assert_false(it.has_value());
+
+    RoaringIntersectionIterator limited(3, inputs);
+    assert_true(limited.skipTo(1001) && *limited == 1002);
+    uint32_t buf[4];
+    assert_true(limited.read(buf, 4) == 4);
+    assert_true(buf[0] == 1002 && buf[3] == 1020);
+    assert_false(limited.skipTo(100000));
+}
+
+void test_cpp_merge_iterators(void **) {
+    Roaring a, b, c;
+    a.addRange(0, 100000);
+    for (uint32_t i = 0; i < 200000; i += 2) b.add(i);
+    for (uint32_t i = 0; i < 300000; i += 3) c.add(i);
+    const Roaring *inputs[] = {&a, &b, &c};
+
+    Roaring expected = a | b | c;
+    RoaringMergeIterator u = RoaringMergeIterator::unionOf(3, inputs);
+    for (auto e = expected.begin(); e != expected.end(); ++e) {
+        assert_true(u.has_value() && *u == *e);
+        ++u;
+    }
+    assert_false(u.has_value());
+
+    expected = a - b - c;
+    RoaringMergeIterator d = RoaringMergeIterator::andnotOf(3, inputs);
+    std::vector<uint32_t> values(expected.cardinality() + 1);
+    assert_true(d.read(values.data(), values.size()) == expected.cardinality());
+    assert_true(Roaring(expected.cardinality(), values.data()) == expected);
+
+    RoaringMergeIterator s = RoaringMergeIterator::andnotOf(3, inputs);
+    assert_true(s.skipTo(1000) && *s == 1001);
+    assert_false(s.skipTo(100000));
+}
+
+void test_cpp_expression_templates(void **) {
+    // arrays, bitsets and runs, with shared containers in a copy
+    Roaring a, b, c, d, e;
+    for (uint32_t x = 0; x < 400000; x += 3) a.add(x);
+    for (uint32_t x = 100000; x < 800000; x += 7) b.add(x);
+    c.addRange(50000, 300000);
+    c.addRange(600000, 700000);
+    c.runOptimize();
+    for (uint32_t x = 0; x < 1000000; x += 1000) d.add(x);
+    e.addRange(250000, 260000);
+    for (uint32_t x = 0; x < 65536 * 20; x += 65536) e.add(x + 5);
+    c.setCopyOnWrite(true);
+    Roaring shared(c);
+
+    Roaring expected = ((a & b) | (c & d)) - e;
+    Roaring r = (RoaringExpr(a) & b) | ((RoaringExpr(c) & d) - e);
+    assert_true(r == ((a & b) | ((c & d) - e)));
+    r = ((RoaringExpr(a) & b) | (RoaringExpr(shared) & d)) - e;
+    assert_true(r == expected);
+    assert_true(Roaring(RoaringExpr(a) ^ b ^ c) == (a ^ b ^ c));
+    assert_true(Roaring(a - (RoaringExpr(b) | c | d)) == (a - (b | c | d)));
+    assert_true(Roaring(RoaringExpr(a) & b & c & d) == (a & b & c & d));
+    assert_true(Roaring(RoaringExpr(d) - d).isEmpty());
+    Roaring empty;
+    assert_true(Roaring(RoaringExpr(empty) | a) == a);
+    assert_true(Roaring(RoaringExpr(a) & empty).isEmpty());
+    // an expression can be evaluated more than once
+    const auto x = RoaringExpr(b) ^ c;
+    assert_true(x.evaluate() == (b ^ c) && x.evaluate() == (b ^ c));
+    assert_true(a.cardinality() == 133334 && shared == c);
+}
+
 int main() {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(serial_test),
@@ -498,7 +683,12 @@ int main() {
         cmocka_unit_test(test_example_cpp_64_true),
         cmocka_unit_test(test_example_cpp_64_false),
         cmocka_unit_test(test_cpp_add_remove_checked),
-        cmocka_unit_test(test_cpp_add_remove_checked_64)};
+        cmocka_unit_test(test_cpp_add_remove_checked_64),
+        cmocka_unit_test(test_cpp_rvalue_operators),
+        cmocka_unit_test(test_cpp_bulk_and_reverse_iterators),
+        cmocka_unit_test(test_cpp_intersection_iterator),
+        cmocka_unit_test(test_cpp_merge_iterators),
+        cmocka_unit_test(test_cpp_expression_templates)};
 
     return cmocka_run_group_tests(tests, NULL, NULL);
 }
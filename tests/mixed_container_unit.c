@@ -7,6 +7,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <roaring/containers/containers.h>
 #include <roaring/containers/mixed_andnot.h>
@@ -1994,6 +1995,199 @@ void run_negation_range_test9() {
                              RUN_CONTAINER_TYPE_CODE, false, false);
 }
 
+// builds a container of the given type; the variant shifts the content so
+// that two containers of the same type still differ
+static void* make_cardinality_test_container(uint8_t type, int variant) {
+    if (type == ARRAY_CONTAINER_TYPE_CODE) {
+        array_container_t* a = array_container_create();
+        for (int x = variant; x < 21000; x += 7)
+            array_container_add(a, (uint16_t)x);
+        return a;
+    }
+    if (type == BITSET_CONTAINER_TYPE_CODE) {
+        bitset_container_t* b = bitset_container_create();
+        for (int x = variant; x < 50000; x += 3)
+            bitset_container_set(b, (uint16_t)x);
+        return b;
+    }
+    run_container_t* r = run_container_create();
+    run_container_add_range(r, 1000 + variant, 1999);
+    run_container_add_range(r, 10000, 14999 + variant * 100);
+    run_container_add_range(r, 40000 - variant, 40100);
+    run_container_add_range(r, 60000, 65535);
+    return r;
+}
+
+void andnot_xor_cardinality_test() {
+    const uint8_t types[] = {ARRAY_CONTAINER_TYPE_CODE,
+                             BITSET_CONTAINER_TYPE_CODE,
+                             RUN_CONTAINER_TYPE_CODE};
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            void* c1 = make_cardinality_test_container(types[i], 0);
+            void* c2 = make_cardinality_test_container(types[j], 1);
+            uint8_t result_type;
+
+            void* diff =
+                container_andnot(c1, types[i], c2, types[j], &result_type);
+            assert_int_equal(
+                container_andnot_cardinality(c1, types[i], c2, types[j]),
+                container_get_cardinality(diff, result_type));
+            container_free(diff, result_type);
+
+            void* sym = container_xor(c1, types[i], c2, types[j], &result_type);
+            assert_int_equal(
+                container_xor_cardinality(c1, types[i], c2, types[j]),
+                container_get_cardinality(sym, result_type));
+            container_free(sym, result_type);
+
+            container_free(c1, types[i]);
+            container_free(c2, types[j]);
+        }
+    }
+}
+
+// checks that the container holds exactly the values flagged in expected
+static void assert_container_matches(const void* c, uint8_t type,
+                                     const bool* expected) {
+    int card = 0;
+    for (int x = 0; x < (1 << 16); x++) {
+        assert_int_equal(container_contains(c, (uint16_t)x, type),
+                         expected[x]);
+        card += expected[x];
+    }
+    assert_int_equal(container_get_cardinality(c, type), card);
+}
+
+// operands far apart in size take the galloping paths
+void skewed_array_ops_test() {
+    static bool in_large[1 << 16], in_small[1 << 16], expected[1 << 16];
+    memset(in_large, 0, sizeof(in_large));
+    memset(in_small, 0, sizeof(in_small));
+
+    array_container_t* large = array_container_create();
+    for (int x = 0; x < 4000; x++) {
+        array_container_add(large, (uint16_t)(x * 16 + 3));
+        in_large[x * 16 + 3] = true;
+    }
+    run_container_t* runs = run_container_create();
+    for (int x = 0; x < 2000; x++) {
+        run_container_add_range(runs, x * 32 + 3, x * 32 + 13);
+    }
+    // hits and misses, both ends of the range and gaps between runs
+    const uint16_t picks[] = {0, 3, 13, 14, 35, 100, 1603, 1604, 19203,
+                              30000, 63971, 63984, 63987, 65535};
+    const int npicks = sizeof(picks) / sizeof(picks[0]);
+    array_container_t* small = array_container_create();
+    for (int i = 0; i < npicks; i++) {
+        array_container_add(small, picks[i]);
+        in_small[picks[i]] = true;
+    }
+
+    for (int pass = 0; pass < 2; pass++) {
+        const void* big = pass == 0 ? (const void*)large : (const void*)runs;
+        const uint8_t big_type =
+            pass == 0 ? ARRAY_CONTAINER_TYPE_CODE : RUN_CONTAINER_TYPE_CODE;
+        bool in_big[1 << 16];
+        for (int x = 0; x < (1 << 16); x++)
+            in_big[x] = container_contains(big, (uint16_t)x, big_type);
+        uint8_t result_type;
+        void* c;
+
+        for (int x = 0; x < (1 << 16); x++)
+            expected[x] = in_big[x] || in_small[x];
+        c = container_or(big, big_type, small, ARRAY_CONTAINER_TYPE_CODE,
+                         &result_type);
+        assert_container_matches(c, result_type, expected);
+        container_free(c, result_type);
+        c = container_or(small, ARRAY_CONTAINER_TYPE_CODE, big, big_type,
+                         &result_type);
+        assert_container_matches(c, result_type, expected);
+        container_free(c, result_type);
+
+        for (int x = 0; x < (1 << 16); x++)
+            expected[x] = in_big[x] != in_small[x];
+        c = container_xor(big, big_type, small, ARRAY_CONTAINER_TYPE_CODE,
+                          &result_type);
+        assert_container_matches(c, result_type, expected);
+        container_free(c, result_type);
+
+        for (int x = 0; x < (1 << 16); x++)
+            expected[x] = in_big[x] && !in_small[x];
+        c = container_andnot(big, big_type, small, ARRAY_CONTAINER_TYPE_CODE,
+                             &result_type);
+        assert_container_matches(c, result_type, expected);
+        container_free(c, result_type);
+
+        for (int x = 0; x < (1 << 16); x++)
+            expected[x] = in_small[x] && !in_big[x];
+        c = container_andnot(small, ARRAY_CONTAINER_TYPE_CODE, big, big_type,
+                             &result_type);
+        assert_container_matches(c, result_type, expected);
+        container_free(c, result_type);
+    }
+
+    // in place, with enough room to avoid reallocating
+    for (int x = 0; x < (1 << 16); x++)
+        expected[x] = in_large[x] || in_small[x];
+    array_container_grow(large, large->cardinality + small->cardinality, true);
+    void* dst;
+    assert_false(array_array_container_inplace_union(large, small, &dst));
+    assert_null(dst);
+    assert_container_matches(large, ARRAY_CONTAINER_TYPE_CODE, expected);
+
+    for (int x = 0; x < (1 << 16); x++)
+        expected[x] = run_container_contains(runs, (uint16_t)x) || in_small[x];
+    array_run_container_inplace_union(small, runs);
+    assert_container_matches(runs, RUN_CONTAINER_TYPE_CODE, expected);
+
+    array_container_free(large);
+    array_container_free(small);
+    run_container_free(runs);
+}
+
+// in-place unions and xors of arrays reuse the first container
+void inplace_ops_reuse_container_test() {
+    static bool expected[1 << 16];
+    array_container_t* a = array_container_create_given_capacity(1);
+    array_container_t* b = array_container_create();
+    for (int x = 0; x < 3000; x += 3) array_container_add(b, (uint16_t)x);
+    run_container_t* r = run_container_create();
+    run_container_add_range(r, 5, 10);
+    run_container_add_range(r, 20000, 20010);
+
+    uint8_t result_type;
+    void* c = container_ior(a, ARRAY_CONTAINER_TYPE_CODE, b,
+                            ARRAY_CONTAINER_TYPE_CODE, &result_type);
+    assert_ptr_equal(c, a);
+    assert_int_equal(result_type, ARRAY_CONTAINER_TYPE_CODE);
+    for (int x = 0; x < (1 << 16); x++) expected[x] = x < 3000 && x % 3 == 0;
+    assert_container_matches(a, ARRAY_CONTAINER_TYPE_CODE, expected);
+
+    c = container_ior(a, ARRAY_CONTAINER_TYPE_CODE, r, RUN_CONTAINER_TYPE_CODE,
+                      &result_type);
+    assert_ptr_equal(c, a);
+    assert_int_equal(result_type, ARRAY_CONTAINER_TYPE_CODE);
+    for (int x = 0; x < (1 << 16); x++)
+        expected[x] = (x < 3000 && x % 3 == 0) || (x >= 5 && x <= 10) ||
+                      (x >= 20000 && x <= 20010);
+    assert_container_matches(a, ARRAY_CONTAINER_TYPE_CODE, expected);
+
+    array_container_clear(b);
+    for (int x = 0; x < 6000; x += 2) array_container_add(b, (uint16_t)x);
+    c = container_ixor(a, ARRAY_CONTAINER_TYPE_CODE, b,
+                       ARRAY_CONTAINER_TYPE_CODE, &result_type);
+    assert_ptr_equal(c, a);
+    assert_int_equal(result_type, ARRAY_CONTAINER_TYPE_CODE);
+    for (int x = 0; x < (1 << 16); x++)
+        expected[x] = expected[x] != (x < 6000 && x % 2 == 0);
+    assert_container_matches(a, ARRAY_CONTAINER_TYPE_CODE, expected);
+
+    array_container_free(a);
+    array_container_free(b);
+    run_container_free(r);
+}
+
 int main() {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(array_bitset_and_or_xor_andnot_test),
@@ -2003,6 +2197,9 @@ int main() {
         cmocka_unit_test(run_andnot_test),
         cmocka_unit_test(run_iandnot_test),
         cmocka_unit_test(run_array_andnot_bug_test),
+        cmocka_unit_test(andnot_xor_cardinality_test),
+        cmocka_unit_test(skewed_array_ops_test),
+        cmocka_unit_test(inplace_ops_reuse_container_test),
         cmocka_unit_test(array_bitset_ixor_test),
         cmocka_unit_test(array_bitset_iandnot_test),
         cmocka_unit_test(array_negation_empty_test),
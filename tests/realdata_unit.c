@@ -649,6 +649,26 @@ bool compare_wide_unions(roaring_bitmap_t **rnorun, roaring_bitmap_t **rruns,
     roaring_bitmap_free(tempornorunheap);
     roaring_bitmap_free(temporrunsheap);
 
+    for (int strategy = ROARING_UNION_FOLD; strategy <= ROARING_UNION_HORIZONTAL;
+         strategy++) {
+        roaring_bitmap_t *tempornorunplanned =
+            roaring_bitmap_or_many_with_strategy(
+                count, (const roaring_bitmap_t **)rnorun,
+                (roaring_union_strategy_t)strategy);
+        roaring_bitmap_t *temporrunsplanned =
+            roaring_bitmap_or_many_with_strategy(
+                count, (const roaring_bitmap_t **)rruns,
+                (roaring_union_strategy_t)strategy);
+        if (!roaring_bitmap_equals(tempornorun, tempornorunplanned) ||
+            !roaring_bitmap_equals(temporruns, temporrunsplanned)) {
+            printf("[compare_wide_unions] Unions don't agree! (strategy %d)\n",
+                   strategy);
+            return false;
+        }
+        roaring_bitmap_free(tempornorunplanned);
+        roaring_bitmap_free(temporrunsplanned);
+    }
+
     roaring_bitmap_t *longtempornorun;
     roaring_bitmap_t *longtemporruns;
     if (count == 1) {
@@ -747,6 +767,43 @@ bool compare_wide_xors(roaring_bitmap_t **rnorun, roaring_bitmap_t **rruns,
     return true;
 }
 
+// values in at least two inputs are those of each input that are in the
+// union of the previous ones; values in all inputs form their intersection
+bool compare_thresholds(roaring_bitmap_t **rnorun, roaring_bitmap_t **rruns,
+                        size_t count) {
+    roaring_bitmap_t *seen = roaring_bitmap_create();
+    roaring_bitmap_t *twice = roaring_bitmap_create();
+    roaring_bitmap_t *all = roaring_bitmap_copy(rnorun[0]);
+    for (size_t i = 0; i < count; ++i) {
+        roaring_bitmap_t *again = roaring_bitmap_and(rnorun[i], seen);
+        roaring_bitmap_or_inplace(twice, again);
+        roaring_bitmap_free(again);
+        roaring_bitmap_or_inplace(seen, rnorun[i]);
+        roaring_bitmap_and_inplace(all, rnorun[i]);
+    }
+    const uint32_t thresholds[] = {1, 2, (uint32_t)count};
+    roaring_bitmap_t *expected[] = {seen, twice, all};
+    bool ok = true;
+    for (int t = 0; t < 3 && ok; t++) {
+        roaring_bitmap_t *tempnorun = roaring_bitmap_threshold_many(
+            count, (const roaring_bitmap_t **)rnorun, thresholds[t]);
+        roaring_bitmap_t *tempruns = roaring_bitmap_threshold_many(
+            count, (const roaring_bitmap_t **)rruns, thresholds[t]);
+        if (!slow_bitmap_equals(tempnorun, expected[t]) ||
+            !slow_bitmap_equals(tempruns, expected[t])) {
+            printf("[compare_thresholds] Thresholds don't agree! (%u) \n",
+                   thresholds[t]);
+            ok = false;
+        }
+        roaring_bitmap_free(tempnorun);
+        roaring_bitmap_free(tempruns);
+    }
+    roaring_bitmap_free(seen);
+    roaring_bitmap_free(twice);
+    roaring_bitmap_free(all);
+    return ok;
+}
+
 bool is_bitmap_equal_to_array(roaring_bitmap_t *bitmap, uint32_t *vals,
                               size_t numbers) {
     uint64_t card;
@@ -835,6 +892,10 @@ bool loadAndCheckAll(const char *dirname, bool copy_on_write) {
         return false;  //  memory leaks
     }
 
+    if (!compare_thresholds(bitmaps, bitmapswrun, count)) {
+        return false;  //  memory leaks
+    }
+
     for (int i = 0; i < (int)count; ++i) {
         free(numbers[i]);
         numbers[i] = NULL;  // paranoid
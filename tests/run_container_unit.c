@@ -203,12 +203,97 @@ void remove_range_test() {
     run_container_free(run);
 }
 
+// many short runs against a few long ones, so that whole blocks of runs get
+// skipped on both sides
+void skewed_runs_test() {
+    run_container_t* B1 = run_container_create();
+    run_container_t* B2 = run_container_create();
+    run_container_t* TMP = run_container_create();
+
+    assert_non_null(B1);
+    assert_non_null(B2);
+    assert_non_null(TMP);
+
+    for (uint32_t x = 0; x + 2 < (1 << 16); x += 7) {
+        run_container_add_range(B1, x, x + 2);
+    }
+    run_container_add_range(B2, 1000, 1200);
+    run_container_add_range(B2, 30000, 30003);
+    run_container_add_range(B2, 30500, 40000);
+    run_container_add_range(B2, 65000, 65535);
+
+    int expected_and = 0, expected_or = 0, expected_andnot = 0;
+    for (uint32_t x = 0; x < (1 << 16); x++) {
+        const bool in1 = run_container_contains(B1, (uint16_t)x);
+        const bool in2 = run_container_contains(B2, (uint16_t)x);
+        expected_and += in1 && in2;
+        expected_or += in1 || in2;
+        expected_andnot += in1 && !in2;
+    }
+
+    assert_int_equal(run_container_intersection_cardinality(B1, B2),
+                     expected_and);
+    assert_int_equal(run_container_intersection_cardinality(B2, B1),
+                     expected_and);
+    assert_true(run_container_intersect(B1, B2));
+
+    run_container_intersection(B1, B2, TMP);
+    assert_int_equal(run_container_cardinality(TMP), expected_and);
+    run_container_union(B1, B2, TMP);
+    assert_int_equal(run_container_cardinality(TMP), expected_or);
+    run_container_union(B2, B1, TMP);
+    assert_int_equal(run_container_cardinality(TMP), expected_or);
+    run_container_andnot(B1, B2, TMP);
+    assert_int_equal(run_container_cardinality(TMP), expected_andnot);
+    for (uint32_t x = 0; x < (1 << 16); x++) {
+        assert_true(run_container_contains(TMP, (uint16_t)x) ==
+                    (run_container_contains(B1, (uint16_t)x) &&
+                     !run_container_contains(B2, (uint16_t)x)));
+    }
+
+    run_container_t* U = run_container_clone(B1);
+    run_container_union_inplace(U, B2);
+    assert_int_equal(run_container_cardinality(U), expected_or);
+    run_container_free(U);
+
+    run_container_free(B1);
+    run_container_free(B2);
+    run_container_free(TMP);
+}
+
+void contains_many_test() {
+    run_container_t* B = run_container_create();
+    for (uint32_t x = 0; x < (1 << 16); x += 100) {
+        run_container_add_range(B, x, x + 9);
+    }
+    uint16_t values[(1 << 12) + 1];
+    bool answer[(1 << 12) + 1];
+    int32_t n = 0;
+    for (uint32_t x = 0; x < (1 << 16); x += 16) values[n++] = (uint16_t)x;
+    values[n++] = 65535;
+
+    int32_t expected = 0;
+    for (int32_t i = 0; i < n; i++) {
+        expected += run_container_contains(B, values[i]);
+    }
+    assert_int_equal(run_container_contains_many(B, values, n, answer),
+                     expected);
+    for (int32_t i = 0; i < n; i++) {
+        assert_true(answer[i] == run_container_contains(B, values[i]));
+    }
+    assert_int_equal(run_container_contains_many(B, values, 0, answer), 0);
+
+    run_container_free(B);
+}
+
 int main() {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(printf_test), cmocka_unit_test(add_contains_test),
         cmocka_unit_test(and_or_test), cmocka_unit_test(to_uint32_array_test),
         cmocka_unit_test(select_test),
         cmocka_unit_test(remove_range_test),
+        cmocka_unit_test(skewed_runs_test),
+        cmocka_unit_test(contains_many_test),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
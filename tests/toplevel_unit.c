@@ -1011,6 +1011,73 @@ void test_remove_withrun() {
     roaring_bitmap_free(r1);
 }
 
+void test_portable_packed_serialize() {
+    roaring_bitmap_t *r1 = roaring_bitmap_create();
+    // 5k-20k values with short irregular gaps: packed
+    uint32_t lcg = 1234;
+    for (uint32_t x = 0; x < 65536; x += 1 + (lcg >> 16) % 8) {
+        roaring_bitmap_add(r1, x);
+        lcg = lcg * 1103515245 + 12345;
+    }
+    // an array, a run and a dense bitset: not packed
+    roaring_bitmap_add(r1, 65536 + 17);
+    roaring_bitmap_add_range(r1, 2 * 65536 + 100, 2 * 65536 + 50000);
+    for (uint32_t x = 0; x < 65536; x++) {
+        if ((lcg >> 16) % 2 == 0) roaring_bitmap_add(r1, 3 * 65536 + x);
+        lcg = lcg * 1103515245 + 12345;
+    }
+    roaring_bitmap_run_optimize(r1);
+
+    size_t expectedsize = roaring_bitmap_portable_packed_size_in_bytes(r1);
+    assert_true(expectedsize < roaring_bitmap_portable_size_in_bytes(r1));
+    char *serialized = malloc(expectedsize);
+    size_t serialize_len =
+        roaring_bitmap_portable_packed_serialize(r1, serialized);
+    assert_int_equal(serialize_len, expectedsize);
+    assert_int_equal(
+        roaring_bitmap_portable_deserialize_size(serialized, expectedsize),
+        expectedsize);
+    assert_int_equal(
+        roaring_bitmap_portable_deserialize_size(serialized, expectedsize - 1),
+        0);
+
+    roaring_bitmap_t *r2 =
+        roaring_bitmap_portable_deserialize_safe(serialized, expectedsize);
+    assert_non_null(r2);
+    assert_true(roaring_bitmap_equals(r1, r2));
+    roaring_bitmap_free(r2);
+    assert_null(
+        roaring_bitmap_portable_deserialize_safe(serialized, expectedsize - 1));
+
+    // the first container starts after the cookie, the run and packed
+    // bitmaps, the keys and cardinalities and the offsets; its first block
+    // width follows the first value
+    const size_t width_offset = 4 + 2 * 1 + 4 * 4 + 4 * 4 + 2;
+    assert_true(serialized[width_offset] <= 16);
+    serialized[width_offset] = 17;
+    assert_int_equal(
+        roaring_bitmap_portable_deserialize_size(serialized, expectedsize), 0);
+    assert_null(
+        roaring_bitmap_portable_deserialize_safe(serialized, expectedsize));
+    free(serialized);
+
+    // without packed containers, the output is the portable format
+    roaring_bitmap_remove_range(r1, 0, 65536);
+    expectedsize = roaring_bitmap_portable_size_in_bytes(r1);
+    assert_int_equal(roaring_bitmap_portable_packed_size_in_bytes(r1),
+                     expectedsize);
+    serialized = malloc(expectedsize);
+    char *packed = malloc(expectedsize);
+    assert_int_equal(roaring_bitmap_portable_serialize(r1, serialized),
+                     expectedsize);
+    assert_int_equal(roaring_bitmap_portable_packed_serialize(r1, packed),
+                     expectedsize);
+    assert_memory_equal(serialized, packed, expectedsize);
+    free(serialized);
+    free(packed);
+    roaring_bitmap_free(r1);
+}
+
 void test_portable_serialize() {
     roaring_bitmap_t *r1 =
         roaring_bitmap_of(8, 1, 2, 3, 100, 1000, 10000, 1000000, 20000000);
@@ -1106,6 +1173,338 @@ void test_portable_serialize() {
     roaring_bitmap_free(r2);
 }
 
+void test_portable_packed_serialize_arrays() {
+    roaring_bitmap_t *r1 = roaring_bitmap_create();
+    // arrays of all sizes around the blocks, with gaps well below 2^16
+    const uint32_t cardinalities[] = {2, 9, 16, 17, 128, 129, 130, 1000, 4096};
+    uint32_t lcg = 1234;
+    for (uint32_t key = 0; key < 9; key++) {
+        uint32_t x = key << 16;
+        for (uint32_t i = 0; i < cardinalities[key]; i++) {
+            roaring_bitmap_add(r1, x);
+            x += 1 + (lcg >> 16) % 15;
+            lcg = lcg * 1103515245 + 12345;
+        }
+    }
+    // the largest gaps, and a single value: not packed
+    roaring_bitmap_add(r1, 20 << 16);
+    roaring_bitmap_add(r1, (20 << 16) + 65535);
+    roaring_bitmap_add(r1, 21 << 16);
+
+    size_t expectedsize = roaring_bitmap_portable_packed_size_in_bytes(r1);
+    assert_true(2 * expectedsize < roaring_bitmap_portable_size_in_bytes(r1));
+    char *serialized = malloc(expectedsize);
+    assert_int_equal(roaring_bitmap_portable_packed_serialize(r1, serialized),
+                     expectedsize);
+    assert_int_equal(
+        roaring_bitmap_portable_deserialize_size(serialized, expectedsize),
+        expectedsize);
+    roaring_bitmap_t *r2 =
+        roaring_bitmap_portable_deserialize_safe(serialized, expectedsize);
+    assert_non_null(r2);
+    assert_true(roaring_bitmap_equals(r1, r2));
+    roaring_bitmap_free(r2);
+    free(serialized);
+    roaring_bitmap_free(r1);
+
+    // values beyond 16 bits are rejected
+    r1 = roaring_bitmap_from_range(0, 1000, 10);
+    expectedsize = roaring_bitmap_portable_packed_size_in_bytes(r1);
+    serialized = malloc(expectedsize);
+    roaring_bitmap_portable_packed_serialize(r1, serialized);
+    // the cookie, the run and packed bitmaps, the key and cardinality
+    const size_t first_offset = 4 + 2 * 1 + 4;
+    serialized[first_offset] = (char)0xFF;
+    serialized[first_offset + 1] = (char)0xFF;
+    assert_null(
+        roaring_bitmap_portable_deserialize_safe(serialized, expectedsize));
+    free(serialized);
+    roaring_bitmap_free(r1);
+}
+
+// runs the tasks in reverse order
+static void reverse_executor_run(void (*task)(void *, uint32_t),
+                                 void *task_arg, uint32_t n_tasks, void *arg) {
+    (*(uint32_t *)arg)++;
+    for (uint32_t i = n_tasks; i-- > 0;) task(task_arg, i);
+}
+
+static void check_deserialize_parallel(const roaring_bitmap_t *r,
+                                       const char *buf, size_t size) {
+    uint32_t runs = 0;
+    const uint32_t n_tasks[] = {0, 1, 3, 100000};
+    for (size_t i = 0; i < sizeof(n_tasks) / sizeof(n_tasks[0]); i++) {
+        roaring_executor_t executor = {reverse_executor_run, n_tasks[i],
+                                       &runs};
+        const roaring_bitmap_t *r2 =
+            roaring_bitmap_portable_deserialize_parallel(buf, size, &executor);
+        assert_non_null(r2);
+        assert_true(roaring_bitmap_equals(r, r2));
+        roaring_bitmap_free(r2);
+    }
+    assert_int_equal(runs, 4);
+    const roaring_bitmap_t *r2 =
+        roaring_bitmap_portable_deserialize_parallel(buf, size, NULL);
+    assert_true(roaring_bitmap_equals(r, r2));
+    roaring_bitmap_t *copy = roaring_bitmap_copy(r2);
+    roaring_bitmap_add(copy, 12345);
+    assert_true(roaring_bitmap_contains(copy, 12345));
+    roaring_bitmap_free(copy);
+    roaring_bitmap_free(r2);
+    for (size_t truncated = 0; truncated < size; truncated += 1 + size / 7) {
+        assert_null(
+            roaring_bitmap_portable_deserialize_parallel(buf, truncated, NULL));
+    }
+    assert_null(
+        roaring_bitmap_portable_deserialize_parallel(buf, size - 1, NULL));
+}
+
+void test_portable_deserialize_parallel() {
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    char *buf = malloc(roaring_bitmap_portable_size_in_bytes(r));
+    size_t size = roaring_bitmap_portable_serialize(r, buf);
+    const roaring_bitmap_t *r2 =
+        roaring_bitmap_portable_deserialize_parallel(buf, size, NULL);
+    assert_true(roaring_bitmap_is_empty(r2));
+    roaring_bitmap_free(r2);
+    free(buf);
+
+    // arrays, runs and bitsets, with and without offsets
+    roaring_bitmap_add_range(r, 70000, 80000);
+    roaring_bitmap_add(r, 5);
+    buf = malloc(roaring_bitmap_portable_size_in_bytes(r));
+    size = roaring_bitmap_portable_serialize(r, buf);
+    check_deserialize_parallel(r, buf, size);
+    free(buf);
+    for (uint32_t k = 3; k < 40; k++) {
+        for (uint32_t i = 0; i < 65536; i += 1 + k % 17) {
+            roaring_bitmap_add(r, (k << 16) + i);
+        }
+    }
+    roaring_bitmap_add_range(r, 100 << 16, 102 << 16);
+    roaring_bitmap_run_optimize(r);
+    buf = malloc(roaring_bitmap_portable_size_in_bytes(r));
+    size = roaring_bitmap_portable_serialize(r, buf);
+    check_deserialize_parallel(r, buf, size);
+    size = roaring_bitmap_portable_packed_serialize(r, buf);
+    assert_true(size < roaring_bitmap_portable_size_in_bytes(r));
+    check_deserialize_parallel(r, buf, size);
+    roaring_bitmap_remove_run_compression(r);
+    free(buf);
+    buf = malloc(roaring_bitmap_portable_size_in_bytes(r));
+    size = roaring_bitmap_portable_serialize(r, buf);
+    check_deserialize_parallel(r, buf, size);
+    free(buf);
+    roaring_bitmap_free(r);
+}
+
+// the layout matches the serialization functions, and so do the buffers
+static void check_serialization(const roaring_bitmap_t *r) {
+    roaring_serialization_t s;
+    assert_true(roaring_serialization_init(r, &s));
+    assert_int_equal(s.cardinality, roaring_bitmap_get_cardinality(r));
+    assert_int_equal(s.size_in_bytes, roaring_bitmap_size_in_bytes(r));
+    assert_int_equal(s.portable_size_in_bytes,
+                     roaring_bitmap_portable_size_in_bytes(r));
+
+    char *expected = malloc(s.size_in_bytes);
+    char *written = malloc(s.size_in_bytes);
+    assert_int_equal(roaring_bitmap_serialize(r, expected), s.size_in_bytes);
+    assert_int_equal(roaring_serialization_write(&s, written),
+                     s.size_in_bytes);
+    assert_memory_equal(expected, written, s.size_in_bytes);
+    free(expected);
+    free(written);
+
+    expected = malloc(s.portable_size_in_bytes);
+    written = malloc(s.portable_size_in_bytes);
+    assert_int_equal(roaring_bitmap_portable_serialize(r, expected),
+                     s.portable_size_in_bytes);
+    assert_int_equal(roaring_serialization_portable_write(&s, written),
+                     s.portable_size_in_bytes);
+    assert_memory_equal(expected, written, s.portable_size_in_bytes);
+
+    roaring_iovec_t *iov = malloc(s.n_iovecs * sizeof(roaring_iovec_t));
+    assert_int_equal(roaring_serialization_portable_iovecs(&s, iov),
+                     s.n_iovecs);
+    size_t offset = 0;
+    for (int32_t i = 0; i < s.n_iovecs; i++) {
+        assert_true(offset + iov[i].len <= s.portable_size_in_bytes);
+        memcpy(written + offset, iov[i].base, iov[i].len);
+        offset += iov[i].len;
+    }
+    assert_int_equal(offset, s.portable_size_in_bytes);
+    assert_memory_equal(expected, written, s.portable_size_in_bytes);
+    free(iov);
+    free(expected);
+    free(written);
+    roaring_serialization_free(&s);
+}
+
+void test_serialization_context() {
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    check_serialization(r);
+    // a few sparse values, written as an array of values
+    roaring_bitmap_add(r, 7);
+    roaring_bitmap_add(r, 1000000);
+    check_serialization(r);
+    // arrays and bitsets, without run containers
+    for (uint32_t x = 0; x < 65536; x += 3) roaring_bitmap_add(r, x);
+    for (uint32_t x = 65536; x < 2 * 65536; x += 100) roaring_bitmap_add(r, x);
+    check_serialization(r);
+    // a run container, with fewer containers than NO_OFFSET_THRESHOLD
+    roaring_bitmap_add_range(r, 5 * 65536 + 10, 5 * 65536 + 20000);
+    check_serialization(r);
+    // with offsets
+    roaring_bitmap_add_range(r, 9 * 65536, 12 * 65536);
+    roaring_bitmap_run_optimize(r);
+    check_serialization(r);
+    // shared containers
+    roaring_bitmap_set_copy_on_write(r, true);
+    roaring_bitmap_t *copy = roaring_bitmap_copy(r);
+    check_serialization(copy);
+    roaring_bitmap_free(copy);
+    roaring_bitmap_free(r);
+}
+
+// a codec replacing each run of up to 255 zero bytes by a zero and its length
+static size_t zero_runs_compress(const char *src, size_t src_len, char *dst,
+                                 size_t dst_capacity, void *arg) {
+    (*(int *)arg)++;
+    size_t out = 0;
+    for (size_t i = 0; i < src_len; out++) {
+        if (out + 2 > dst_capacity) return 0;
+        if (src[i] != 0) {
+            dst[out] = src[i++];
+            continue;
+        }
+        size_t length = 0;
+        while (i < src_len && src[i] == 0 && length < 255) i++, length++;
+        dst[out++] = 0;
+        dst[out] = (char)length;
+    }
+    return out;
+}
+
+static bool zero_runs_decompress(const char *src, size_t src_len, char *dst,
+                                 size_t dst_len, void *arg) {
+    (void)arg;
+    size_t out = 0;
+    for (size_t i = 0; i < src_len; i++) {
+        if (src[i] != 0) {
+            if (out == dst_len) return false;
+            dst[out++] = src[i];
+            continue;
+        }
+        if (++i == src_len) return false;
+        const size_t length = (unsigned char)src[i];
+        if (length == 0 || out + length > dst_len) return false;
+        memset(dst + out, 0, length);
+        out += length;
+    }
+    return out == dst_len;
+}
+
+static void check_compressed(const roaring_bitmap_t *r,
+                             const roaring_codec_t *codec,
+                             uint32_t block_size) {
+    const size_t bound = roaring_bitmap_compressed_size_bound(r);
+    char *buf = malloc(bound);
+    const size_t size =
+        roaring_bitmap_compressed_serialize(r, codec, block_size, buf);
+    assert_true(size > 0 && size <= bound);
+    roaring_bitmap_t *r2 =
+        roaring_bitmap_compressed_deserialize_safe(buf, size, codec);
+    assert_non_null(r2);
+    assert_true(roaring_bitmap_equals(r, r2));
+    roaring_bitmap_free(r2);
+    assert_null(roaring_bitmap_compressed_deserialize_safe(buf, size - 1,
+                                                           codec));
+
+    // the blocks one at a time
+    roaring_compressed_t c;
+    assert_true(roaring_compressed_init(&c, buf, size, codec));
+    assert_int_equal(c.size_in_bytes, size);
+    assert_int_equal(c.n_containers, r->high_low_container.size);
+    roaring_bitmap_t *blocks = roaring_bitmap_create();
+    for (uint32_t b = 0; b < c.n_blocks; b++) {
+        roaring_bitmap_t *block = roaring_compressed_block_deserialize(&c, b);
+        assert_non_null(block);
+        assert_false(roaring_bitmap_intersect(blocks, block));
+        const uint32_t first = roaring_bitmap_minimum(block);
+        const uint32_t last = roaring_bitmap_maximum(block);
+        assert_int_equal(roaring_compressed_find_block(&c, first), b);
+        assert_int_equal(roaring_compressed_find_block(&c, last), b);
+        roaring_bitmap_or_inplace(blocks, block);
+        roaring_bitmap_free(block);
+    }
+    assert_true(roaring_bitmap_equals(r, blocks));
+    roaring_bitmap_free(blocks);
+    assert_null(roaring_compressed_block_deserialize(&c, c.n_blocks));
+    // a key without container
+    assert_int_equal(roaring_compressed_find_block(&c, 25 * 65536), c.n_blocks);
+
+    buf[0] ^= 1;
+    assert_false(roaring_compressed_init(&c, buf, size, codec));
+    assert_null(roaring_bitmap_compressed_deserialize_safe(buf, size, codec));
+    free(buf);
+}
+
+void test_compressed_serialize() {
+    int calls = 0;
+    const roaring_codec_t codec = {zero_runs_compress, zero_runs_decompress,
+                                   &calls};
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    check_compressed(r, &codec, 0);
+    check_compressed(r, NULL, 0);
+    // a bitset with many zero bytes, arrays and runs
+    for (uint32_t x = 0; x < 65536; x += 7) {
+        if ((x / 1024) % 2 == 0) roaring_bitmap_add(r, x);
+    }
+    for (uint32_t key = 1; key < 20; key++) {
+        roaring_bitmap_add(r, key * 65536 + 3 * key);
+        roaring_bitmap_add(r, key * 65536 + 1000);
+    }
+    roaring_bitmap_add_range(r, 30 * 65536 + 100, 31 * 65536 + 20000);
+    roaring_bitmap_run_optimize(r);
+    const uint32_t block_sizes[] = {0, 1, 64, 10000, UINT32_MAX};
+    for (size_t i = 0; i < sizeof(block_sizes) / sizeof(block_sizes[0]); i++) {
+        check_compressed(r, &codec, block_sizes[i]);
+        check_compressed(r, NULL, block_sizes[i]);
+    }
+    assert_true(calls > 0);
+
+    // the zero bytes of the bitset compress
+    const size_t bound = roaring_bitmap_compressed_size_bound(r);
+    char *buf = malloc(bound);
+    const size_t size = roaring_bitmap_compressed_serialize(r, &codec, 0, buf);
+    assert_true(size < roaring_bitmap_portable_size_in_bytes(r));
+    assert_int_equal(roaring_bitmap_compressed_serialize(r, NULL, 0, buf),
+                     bound);
+    // compressed blocks cannot be read without the codec
+    roaring_bitmap_compressed_serialize(r, &codec, 0, buf);
+    assert_null(roaring_bitmap_compressed_deserialize_safe(buf, size, NULL));
+
+    // blocks claiming more bytes than their containers can hold
+    const uint32_t oversized[] = {2 + 32768 * 4 + 1, UINT32_MAX};
+    for (size_t i = 0; i < sizeof(oversized) / sizeof(oversized[0]); i++) {
+        const size_t one_per_block =
+            roaring_bitmap_compressed_serialize(r, &codec, 1, buf);
+        roaring_compressed_t c;
+        assert_true(roaring_compressed_init(&c, buf, one_per_block, &codec));
+        for (uint32_t b = 0; b < c.n_blocks; b++) {
+            // the raw size follows the first container of the block
+            memcpy(buf + 3 * sizeof(uint32_t) + 12 * b + 4, &oversized[i],
+                   sizeof(uint32_t));
+        }
+        assert_false(roaring_compressed_init(&c, buf, one_per_block, &codec));
+        assert_null(roaring_bitmap_compressed_deserialize_safe(
+            buf, one_per_block, &codec));
+    }
+    free(buf);
+    roaring_bitmap_free(r);
+}
+
 void test_serialize() {
     roaring_bitmap_t *r1 =
         roaring_bitmap_of(8, 1, 2, 3, 100, 1000, 10000, 1000000, 20000000);
@@ -3309,6 +3708,333 @@ void test_or_many_memory_leak() {
     }
 }
 
+// checks the plan of a union of n bitmaps, its result with all strategies and
+// the xor of the same bitmaps
+static void check_or_many_plan(size_t n, const roaring_bitmap_t **x,
+                               roaring_union_strategy_t expected) {
+    roaring_union_plan_t plan;
+    roaring_bitmap_or_many_plan(n, x, &plan);
+    assert_int_equal(plan.strategy, expected);
+    assert_int_equal(plan.n_inputs, n);
+    roaring_bitmap_t *naive = roaring_bitmap_create();
+    uint64_t n_containers = 0;
+    for (size_t i = 0; i < n; i++) {
+        roaring_bitmap_or_inplace(naive, x[i]);
+        n_containers += x[i]->high_low_container.size;
+    }
+    assert_int_equal(plan.n_containers, n_containers);
+    assert_int_equal(plan.n_keys, naive->high_low_container.size);
+    roaring_bitmap_t *answer = roaring_bitmap_or_many(n, x);
+    assert_true(roaring_bitmap_equals(naive, answer));
+    roaring_bitmap_free(answer);
+    for (int s = ROARING_UNION_FOLD; s <= ROARING_UNION_HORIZONTAL; s++) {
+        answer = roaring_bitmap_or_many_with_strategy(
+            n, x, (roaring_union_strategy_t)s);
+        assert_true(roaring_bitmap_equals(naive, answer));
+        roaring_bitmap_free(answer);
+    }
+    roaring_bitmap_clear(naive);
+    for (size_t i = 0; i < n; i++) {
+        roaring_bitmap_xor_inplace(naive, x[i]);
+    }
+    answer = roaring_bitmap_xor_many(n, x);
+    assert_true(roaring_bitmap_equals(naive, answer));
+    roaring_bitmap_free(answer);
+    roaring_bitmap_free(naive);
+}
+
+void test_or_many_plan() {
+    roaring_bitmap_t *r[100];
+    // disjoint neighbouring keys
+    for (uint32_t i = 0; i < 100; i++) {
+        r[i] = roaring_bitmap_create();
+        roaring_bitmap_add(r[i], i << 16);
+    }
+    check_or_many_plan(100, (const roaring_bitmap_t **)r,
+                       ROARING_UNION_HORIZONTAL);
+    // disjoint keys spread out
+    for (uint32_t i = 0; i < 100; i++) {
+        roaring_bitmap_clear(r[i]);
+        roaring_bitmap_add(r[i], (i * 600) << 16);
+    }
+    check_or_many_plan(100, (const roaring_bitmap_t **)r, ROARING_UNION_HEAP);
+    // a few shared keys spread out
+    for (uint32_t i = 0; i < 3; i++) {
+        roaring_bitmap_clear(r[i]);
+        roaring_bitmap_add_range(r[i], i * 3000, 10000 + i * 3000);
+        roaring_bitmap_add_range(r[i], UINT32_C(60000) << 16,
+                                 (UINT32_C(60000) << 16) + 5000 * i + 1);
+    }
+    check_or_many_plan(3, (const roaring_bitmap_t **)r, ROARING_UNION_FOLD);
+    // many overlapping containers of all types, some shared
+    for (uint32_t i = 0; i < 100; i++) {
+        roaring_bitmap_clear(r[i]);
+        roaring_bitmap_set_copy_on_write(r[i], i % 2 == 0);
+        for (uint32_t k = 0; k < 20; k++) {
+            const uint32_t base = k << 16;
+            if ((i + k) % 3 == 0) {
+                roaring_bitmap_add_range(r[i], base + i * 100, base + i * 300);
+            } else if ((i + k) % 3 == 1) {
+                for (uint32_t v = i; v < 65536; v += 7 + k) {
+                    roaring_bitmap_add(r[i], base + v);
+                }
+            } else {
+                for (uint32_t v = 0; v < 10; v++) {
+                    roaring_bitmap_add(r[i], base + i * 10 + v);
+                }
+            }
+        }
+        roaring_bitmap_run_optimize(r[i]);
+    }
+    roaring_bitmap_t *copy = roaring_bitmap_copy(r[0]);
+    roaring_bitmap_add_range(r[99], 5 << 16, 6 << 16);
+    check_or_many_plan(100, (const roaring_bitmap_t **)r,
+                       ROARING_UNION_HORIZONTAL);
+    roaring_bitmap_free(copy);
+    for (uint32_t i = 0; i < 100; i++) {
+        roaring_bitmap_free(r[i]);
+    }
+}
+
+void test_xor_many_cancelling() {
+    roaring_bitmap_t *r[40];
+    // every container appears an even number of times in keys 0 to 9, and the
+    // arrays, runs and bitsets of keys 10 to 19 overlap
+    for (uint32_t i = 0; i < 40; i++) {
+        r[i] = roaring_bitmap_create();
+        for (uint32_t k = 0; k < 20; k++) {
+            const uint32_t base = k << 16;
+            const uint32_t j = k < 10 ? i / 2 : i;
+            if ((j + k) % 3 == 0) {
+                roaring_bitmap_add_range(r[i], base + j * 100, base + j * 1500);
+            } else if ((j + k) % 3 == 1) {
+                for (uint32_t v = j; v < 65536; v += 5 + j) {
+                    roaring_bitmap_add(r[i], base + v);
+                }
+            } else {
+                for (uint32_t v = 0; v < 200; v++) {
+                    roaring_bitmap_add(r[i], base + j * 1000 + v);
+                }
+            }
+        }
+        roaring_bitmap_run_optimize(r[i]);
+    }
+    roaring_bitmap_t *naive = roaring_bitmap_create();
+    for (uint32_t i = 0; i < 40; i++) {
+        roaring_bitmap_xor_inplace(naive, r[i]);
+    }
+    assert_true(naive->high_low_container.size <= 10);
+    roaring_bitmap_t *answer =
+        roaring_bitmap_xor_many(40, (const roaring_bitmap_t **)r);
+    assert_true(roaring_bitmap_equals(naive, answer));
+    assert_true(answer->high_low_container.size <= 10);
+    roaring_bitmap_free(answer);
+    roaring_bitmap_free(naive);
+    for (uint32_t i = 0; i < 40; i++) {
+        roaring_bitmap_free(r[i]);
+    }
+}
+
+// checks roaring_bitmap_threshold_many against a count of each value
+static void check_threshold_many(size_t n, const roaring_bitmap_t **x,
+                                 uint32_t universe) {
+    uint8_t *counts = (uint8_t *)calloc(universe, sizeof(uint8_t));
+    for (size_t i = 0; i < n; i++) {
+        roaring_uint32_iterator_t it;
+        roaring_init_iterator(x[i], &it);
+        for (; it.has_value; roaring_advance_uint32_iterator(&it)) {
+            assert_true(it.current_value < universe);
+            counts[it.current_value]++;
+        }
+    }
+    for (uint32_t threshold = 0; threshold <= n + 1; threshold++) {
+        roaring_bitmap_t *answer = roaring_bitmap_threshold_many(n, x, threshold);
+        uint64_t cardinality = 0;
+        for (uint32_t v = 0; v < universe; v++) {
+            const bool expected = counts[v] >= threshold && counts[v] > 0;
+            cardinality += expected;
+            if (roaring_bitmap_contains(answer, v) != expected) {
+                printf("value %u counted %d times, threshold %u\n", v,
+                       counts[v], threshold);
+                assert_true(false);
+            }
+        }
+        assert_int_equal(roaring_bitmap_get_cardinality(answer), cardinality);
+        roaring_bitmap_free(answer);
+    }
+    free(counts);
+}
+
+void test_threshold_many() {
+    roaring_bitmap_t *r[12];
+    // keys 0 to 5 mix arrays, runs and bitsets, and overlap; key 6 only has
+    // bitsets; key 7 has too few containers for most thresholds; key 8 is full
+    // in a few inputs
+    for (uint32_t i = 0; i < 12; i++) {
+        r[i] = roaring_bitmap_create();
+        roaring_bitmap_set_copy_on_write(r[i], i % 3 == 0);
+        for (uint32_t k = 0; k < 6; k++) {
+            const uint32_t base = k << 16;
+            if ((i + k) % 3 == 0) {
+                roaring_bitmap_add_range(r[i], base + i * 1000 + 7,
+                                         base + i * 3000 + 7000);
+            } else if ((i + k) % 3 == 1) {
+                for (uint32_t v = i % 4; v < 65536; v += 2 + (i + k) % 5) {
+                    roaring_bitmap_add(r[i], base + v);
+                }
+            } else {
+                for (uint32_t v = 0; v < 300; v++) {
+                    roaring_bitmap_add(r[i], base + (v * (i + 1) * 37) % 65536);
+                }
+            }
+        }
+        for (uint32_t v = 0; v < 65536; v += 2 + i % 3) {
+            roaring_bitmap_add(r[i], (6 << 16) + v);
+        }
+        if (i < 2) roaring_bitmap_add(r[i], (7 << 16) + 10);
+        // key 8 saturates before its last containers for small thresholds
+        if (i < 4) {
+            roaring_bitmap_add_range(r[i], 8 << 16, 9 << 16);
+        } else {
+            roaring_bitmap_add_range(r[i], (8 << 16) + i, (8 << 16) + i * 100);
+        }
+        roaring_bitmap_run_optimize(r[i]);
+    }
+    roaring_bitmap_t *copy = roaring_bitmap_copy(r[0]);  // shares containers
+    check_threshold_many(12, (const roaring_bitmap_t **)r, 9 << 16);
+    check_threshold_many(2, (const roaring_bitmap_t **)r, 9 << 16);
+    check_threshold_many(0, NULL, 1);
+    roaring_bitmap_free(copy);
+    for (uint32_t i = 0; i < 12; i++) {
+        roaring_bitmap_free(r[i]);
+    }
+}
+
+static bool bsi_matches(roaring_bsi_operation_t op, uint64_t value,
+                        uint64_t x, uint64_t y) {
+    switch (op) {
+        case ROARING_BSI_EQ: return value == x;
+        case ROARING_BSI_NEQ: return value != x;
+        case ROARING_BSI_LT: return value < x;
+        case ROARING_BSI_LE: return value <= x;
+        case ROARING_BSI_GT: return value > x;
+        case ROARING_BSI_GE: return value >= x;
+        default: return x <= value && value <= y;
+    }
+}
+
+// checks all the queries of a bit-sliced index against the values of the ids
+// below n (UINT64_MAX when they have none), over the foundset
+static void check_bsi(const roaring_bsi_t *bsi, const uint64_t *values,
+                      uint32_t n, const roaring_bitmap_t *foundset) {
+    const uint64_t xs[] = {0, 1, 5, 100, 1000, 1001, 65535, UINT64_MAX - 1};
+    for (int op = ROARING_BSI_EQ; op <= ROARING_BSI_RANGE; op++) {
+        for (size_t i = 0; i < sizeof(xs) / sizeof(xs[0]); i++) {
+            const uint64_t x = xs[i], y = x + 500;
+            roaring_bitmap_t *answer = roaring_bsi_compare(
+                bsi, (roaring_bsi_operation_t)op, x, y, foundset);
+            uint64_t cardinality = 0;
+            for (uint32_t id = 0; id < n; id++) {
+                const bool expected =
+                    values[id] != UINT64_MAX &&
+                    (!foundset || roaring_bitmap_contains(foundset, id)) &&
+                    bsi_matches((roaring_bsi_operation_t)op, values[id], x, y);
+                cardinality += expected;
+                assert_int_equal(roaring_bitmap_contains(answer, id),
+                                 expected);
+            }
+            assert_int_equal(roaring_bitmap_get_cardinality(answer),
+                             cardinality);
+            roaring_bitmap_free(answer);
+        }
+    }
+    uint64_t sum = 0, count = 0, min = UINT64_MAX, max = 0;
+    for (uint32_t id = 0; id < n; id++) {
+        if (values[id] == UINT64_MAX) continue;
+        if (foundset && !roaring_bitmap_contains(foundset, id)) continue;
+        sum += values[id];
+        count++;
+        if (values[id] < min) min = values[id];
+        if (values[id] > max) max = values[id];
+    }
+    uint64_t bsi_count = 0, value = 0;
+    assert_int_equal(roaring_bsi_sum(bsi, foundset, &bsi_count), sum);
+    assert_int_equal(bsi_count, count);
+    assert_int_equal(roaring_bsi_min(bsi, foundset, &value), count > 0);
+    if (count > 0) assert_int_equal(value, min);
+    assert_int_equal(roaring_bsi_max(bsi, foundset, &value), count > 0);
+    if (count > 0) assert_int_equal(value, max);
+    const uint64_t ks[] = {0, 1, 7, 100, count, count + 1};
+    for (size_t i = 0; i < sizeof(ks) / sizeof(ks[0]); i++) {
+        roaring_bitmap_t *top = roaring_bsi_top_k(bsi, foundset, ks[i]);
+        const uint64_t k = ks[i] < count ? ks[i] : count;
+        assert_int_equal(roaring_bitmap_get_cardinality(top), k);
+        // no id left out has a larger value, or an equal one and a smaller id
+        uint64_t smallest = UINT64_MAX;
+        uint32_t last_tied = 0;
+        roaring_uint32_iterator_t it;
+        roaring_init_iterator(top, &it);
+        for (; it.has_value; roaring_advance_uint32_iterator(&it)) {
+            if (values[it.current_value] <= smallest) {
+                smallest = values[it.current_value];
+                last_tied = it.current_value;
+            }
+        }
+        for (uint32_t id = 0; id < n && k > 0; id++) {
+            if (values[id] == UINT64_MAX || roaring_bitmap_contains(top, id) ||
+                (foundset != NULL && !roaring_bitmap_contains(foundset, id))) {
+                continue;
+            }
+            assert_true(values[id] < smallest ||
+                        (values[id] == smallest && id > last_tied));
+        }
+        roaring_bitmap_free(top);
+    }
+}
+
+void test_bsi() {
+    const uint32_t n = 5000;
+    uint64_t *values = (uint64_t *)malloc(n * sizeof(uint64_t));
+    roaring_bsi_t *bsi = roaring_bsi_create();
+    assert_non_null(bsi);
+    check_bsi(bsi, values, 0, NULL);
+    uint64_t state = 12345;
+    for (uint32_t id = 0; id < n; id++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        if ((state >> 60) == 0) {
+            values[id] = UINT64_MAX;  // no value
+            continue;
+        }
+        // values of all magnitudes, many of them repeated
+        values[id] = (state >> 33) % 2000;
+        if ((state >> 59) == 1) values[id] = (state >> 20) & 0xFFFFFFFFFFull;
+        assert_true(roaring_bsi_set_value(bsi, id, values[id]));
+    }
+    check_bsi(bsi, values, n, NULL);
+    // overwrite and remove some values
+    for (uint32_t id = 0; id < n; id += 7) {
+        values[id] = id % 3 == 0 ? 1000 : 5;
+        assert_true(roaring_bsi_set_value(bsi, id, values[id]));
+    }
+    for (uint32_t id = 3; id < n; id += 11) {
+        values[id] = UINT64_MAX;
+        roaring_bsi_remove_value(bsi, id);
+    }
+    for (uint32_t id = 0; id < n; id++) {
+        uint64_t value = 0;
+        assert_int_equal(roaring_bsi_get_value(bsi, id, &value),
+                         values[id] != UINT64_MAX);
+        if (values[id] != UINT64_MAX) assert_int_equal(value, values[id]);
+    }
+    roaring_bsi_run_optimize(bsi);
+    check_bsi(bsi, values, n, NULL);
+    roaring_bitmap_t *foundset = roaring_bitmap_from_range(0, n + 100, 3);
+    check_bsi(bsi, values, n, foundset);
+    roaring_bitmap_free(foundset);
+    roaring_bsi_free(bsi);
+    free(values);
+}
+
 void test_iterator_generate_data(uint32_t **values_out, uint32_t *count_out) {
     const size_t capacity = 1000*1000;
     uint32_t* values = malloc(sizeof(uint32_t) * capacity); // ascending order
@@ -3468,6 +4194,101 @@ void test_read_uint32_iterator_native() {
     test_read_uint32_iterator(UINT8_MAX); // special value
 }
 
+/*
+ * Read bitmap backward in steps of given size, compare with reference values.
+ */
+void read_previous_compare(roaring_bitmap_t* r, const uint32_t* ref_values, uint32_t ref_count, uint32_t step) {
+    roaring_uint32_iterator_t iter;
+    roaring_init_iterator_last(r, &iter);
+    uint32_t* buffer = malloc(sizeof(uint32_t) * step);
+    while (ref_count > 0) {
+        assert_true(iter.has_value == true);
+        assert_true(iter.current_value == ref_values[ref_count - 1]);
+
+        uint32_t num_got = roaring_read_previous_uint32_iterator(&iter, buffer, step);
+        assert_true(num_got == minimum_uint32(step, ref_count));
+        for (uint32_t i = 0; i < num_got; i++) {
+            assert_true(ref_values[ref_count - 1 - i] == buffer[i]);
+        }
+        ref_count -= num_got;
+    }
+
+    assert_true(iter.has_value == false);
+    assert_true(roaring_read_previous_uint32_iterator(&iter, buffer, step) == 0);
+    assert_true(iter.has_value == false);
+
+    free(buffer);
+}
+
+void test_read_previous_uint32_iterator(uint8_t type) {
+    uint32_t* ref_values;
+    uint32_t ref_count;
+    test_iterator_generate_data(&ref_values, &ref_count);
+
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    for (uint32_t i = 0; i < ref_count; i++) {
+        roaring_bitmap_add(r, ref_values[i]);
+    }
+    if (type != UINT8_MAX) {
+        convert_all_containers(r, type);
+    }
+
+    read_previous_compare(r, ref_values, ref_count, 1);
+    read_previous_compare(r, ref_values, ref_count, 2);
+    read_previous_compare(r, ref_values, ref_count, 7);
+    read_previous_compare(r, ref_values, ref_count, 1000);
+    read_previous_compare(r, ref_values, ref_count, ref_count);
+
+    // mixing with single steps
+    roaring_uint32_iterator_t iter;
+    roaring_init_iterator_last(r, &iter);
+    uint32_t buffer[3];
+    uint32_t i = ref_count;
+    while (iter.has_value) {
+        uint32_t got = roaring_read_previous_uint32_iterator(&iter, buffer, 3);
+        for (uint32_t j = 0; j < got; j++) {
+            assert_true(buffer[j] == ref_values[--i]);
+        }
+        if (iter.has_value) {
+            assert_true(iter.current_value == ref_values[--i]);
+            roaring_previous_uint32_iterator(&iter);
+        }
+    }
+    assert_true(i == 0);
+
+    // paging from the top
+    uint32_t *page = malloc(sizeof(uint32_t) * ref_count);
+    uint32_t offsets[] = {0, 1, 100, ref_count / 2, ref_count - 1, ref_count};
+    for (size_t k = 0; k < sizeof(offsets) / sizeof(offsets[0]); k++) {
+        const uint32_t limit = 1000;
+        memset(page, 0, sizeof(uint32_t) * ref_count);
+        assert_true(roaring_bitmap_range_uint32_array_descending(
+            r, offsets[k], limit, page));
+        uint32_t expected = minimum_uint32(limit, ref_count - offsets[k]);
+        for (uint32_t j = 0; j < expected; j++) {
+            assert_true(page[j] == ref_values[ref_count - 1 - offsets[k] - j]);
+        }
+        if (expected < ref_count) assert_true(page[expected] == 0);
+    }
+    free(page);
+
+    roaring_bitmap_free(r);
+    free(ref_values);
+}
+
+void test_read_previous_uint32_iterator_array() {
+    test_read_previous_uint32_iterator(ARRAY_CONTAINER_TYPE_CODE);
+}
+void test_read_previous_uint32_iterator_bitset() {
+    test_read_previous_uint32_iterator(BITSET_CONTAINER_TYPE_CODE);
+}
+void test_read_previous_uint32_iterator_run() {
+    test_read_previous_uint32_iterator(RUN_CONTAINER_TYPE_CODE);
+}
+void test_read_previous_uint32_iterator_native() {
+    test_read_previous_uint32_iterator(UINT8_MAX); // special value
+}
+
 void test_previous_iterator(uint8_t type) {
     uint32_t* ref_values;
     uint32_t ref_count;
@@ -3514,6 +4335,338 @@ void test_previous_iterator_native() {
     test_previous_iterator(UINT8_MAX); // special value
 }
 
+// every container of r is in the representation run_optimize would pick
+static bool is_run_optimized(const roaring_bitmap_t *r) {
+    roaring_bitmap_t *copy = roaring_bitmap_copy(r);
+    roaring_bitmap_run_optimize(copy);
+    roaring_statistics_t s1, s2;
+    roaring_bitmap_statistics(r, &s1);
+    roaring_bitmap_statistics(copy, &s2);
+    roaring_bitmap_free(copy);
+    return s1.n_run_containers == s2.n_run_containers &&
+           s1.n_array_containers == s2.n_array_containers &&
+           s1.n_bitset_containers == s2.n_bitset_containers;
+}
+
+void test_auto_run() {
+    roaring_bitmap_t *x1 = roaring_bitmap_create();
+    roaring_bitmap_t *x2 = roaring_bitmap_create();
+    for (uint32_t i = 0; i < 300000; i += 1000) {
+        roaring_bitmap_add_range(x1, i, i + 600);
+        roaring_bitmap_add_range(x2, i + 300, i + 900);
+    }
+    roaring_bitmap_add(x1, 500000);
+    roaring_bitmap_add(x2, 500002);
+    // two bitsets whose and, or, xor and andnot have too many runs to be
+    // run containers: they stay bitsets, or become arrays under 4096 values
+    for (uint32_t i = 0; i < 65536; i++) {
+        if (i % 3 == 0) roaring_bitmap_add(x1, (10 << 16) + i);
+        if (i % 2 == 0) roaring_bitmap_add(x2, (10 << 16) + i);
+        if (i % 2 == 0) roaring_bitmap_add(x1, (11 << 16) + i);
+        if (i % 2 == 0 ? i < 8192 : i > 60000) {
+            roaring_bitmap_add(x2, (11 << 16) + i);
+        }
+    }
+    // x1 and x2 start out as bitsets and arrays, not runs
+    roaring_bitmap_remove_run_compression(x1);
+    roaring_bitmap_remove_run_compression(x2);
+    assert_false(roaring_bitmap_get_auto_run(x1));
+    roaring_bitmap_set_auto_run(x1, true);
+    assert_true(roaring_bitmap_get_auto_run(x1));
+
+    roaring_bitmap_t *(*ops[])(const roaring_bitmap_t *,
+                               const roaring_bitmap_t *) = {
+        roaring_bitmap_and, roaring_bitmap_or, roaring_bitmap_xor,
+        roaring_bitmap_andnot};
+    void (*inplace_ops[])(roaring_bitmap_t *, const roaring_bitmap_t *) = {
+        roaring_bitmap_and_inplace, roaring_bitmap_or_inplace,
+        roaring_bitmap_xor_inplace, roaring_bitmap_andnot_inplace};
+    for (int i = 0; i < 4; i++) {
+        roaring_bitmap_set_auto_run(x1, false);
+        roaring_bitmap_t *expected = ops[i](x1, x2);
+        roaring_bitmap_set_auto_run(x1, true);
+        roaring_bitmap_t *result = ops[i](x1, x2);
+        assert_true(roaring_bitmap_get_auto_run(result));
+        assert_true(roaring_bitmap_equals(expected, result));
+        assert_true(is_run_optimized(result));
+
+        roaring_bitmap_t *inplace = roaring_bitmap_copy(x1);
+        assert_true(roaring_bitmap_get_auto_run(inplace));
+        inplace_ops[i](inplace, x2);
+        assert_true(roaring_bitmap_equals(expected, inplace));
+        assert_true(is_run_optimized(inplace));
+
+        roaring_bitmap_free(inplace);
+        roaring_bitmap_free(result);
+        roaring_bitmap_free(expected);
+    }
+    roaring_bitmap_free(x1);
+    roaring_bitmap_free(x2);
+}
+
+void test_lazy_add() {
+    roaring_bitmap_t *expected = roaring_bitmap_create();
+    roaring_bitmap_t *lazy = roaring_bitmap_create();
+    // pseudo-random order with repeats: a sparse key, a key that ends up as a
+    // bitset, a key that starts out as a bitset, and two keys that start out
+    // as runs, the first one extending its runs and the last one getting
+    // enough runs to be converted
+    roaring_bitmap_t *both[] = {expected, lazy};
+    for (int b = 0; b < 2; b++) {
+        roaring_bitmap_add_range(both[b], 0x30000, 0x38000);
+        roaring_bitmap_add_range(both[b], 0x40000 + 1000, 0x40000 + 2000);
+        roaring_bitmap_add_range(both[b], 0x40000 + 5000, 0x40000 + 9000);
+        roaring_bitmap_add_range(both[b], 0x50000, 0x50000 + 100);
+        roaring_bitmap_run_optimize(both[b]);
+    }
+    const uint32_t firsts[] = {0, 0x20000, 0x30000, 0x40000 + 1000, 0x50000};
+    const uint32_t spans[] = {3000, 50000, 50000, 1100, 50000};
+    uint32_t x = 1;
+    for (int i = 0; i < 50000; i++) {
+        x = x * 1103515245 + 12345;
+        const uint32_t value = firsts[i % 5] + (x >> 16) % spans[i % 5];
+        roaring_bitmap_add(expected, value);
+        roaring_bitmap_lazy_add(lazy, value);
+        roaring_bitmap_lazy_add(lazy, value);
+    }
+    roaring_bitmap_repair_after_lazy(lazy);
+    assert_true(roaring_bitmap_equals(expected, lazy));
+    // the runs were merged back
+    const int32_t runs = ra_get_index(&lazy->high_low_container, 4);
+    assert_int_equal(lazy->high_low_container.typecodes[runs],
+                     RUN_CONTAINER_TYPE_CODE);
+    assert_int_equal(
+        ((run_container_t *)lazy->high_low_container.containers[runs])->n_runs,
+        2);
+    assert_int_equal(roaring_bitmap_get_cardinality(expected),
+                     roaring_bitmap_get_cardinality(lazy));
+    roaring_bitmap_free(expected);
+    roaring_bitmap_free(lazy);
+}
+
+void test_lazy_chain() {
+    roaring_bitmap_t *dense = roaring_bitmap_create();
+    roaring_bitmap_t *sparse = roaring_bitmap_create();
+    roaring_bitmap_t *runs = roaring_bitmap_create();
+    for (uint32_t i = 0; i < 400000; i += 3) roaring_bitmap_add(dense, i);
+    for (uint32_t i = 500000; i < 700000; i += 2) roaring_bitmap_add(dense, i);
+    for (uint32_t i = 0; i < 800000; i += 997) roaring_bitmap_add(sparse, i);
+    for (uint32_t i = 150000; i < 600000; i += 7) roaring_bitmap_add(sparse, i);
+    roaring_bitmap_add_range(runs, 10000, 90000);
+    roaring_bitmap_add_range(runs, 200000, 200100);
+    roaring_bitmap_add_range(runs, 520000, 650000);
+    roaring_bitmap_run_optimize(runs);
+
+    roaring_bitmap_t *expected = roaring_bitmap_copy(dense);
+    roaring_bitmap_t *lazy = roaring_bitmap_copy(dense);
+    roaring_bitmap_or_inplace(expected, sparse);
+    roaring_bitmap_lazy_or_inplace(lazy, sparse, false);
+    roaring_bitmap_and_inplace(expected, runs);
+    roaring_bitmap_lazy_and_inplace(lazy, runs);
+    roaring_bitmap_flip_inplace(expected, 5000, 300000);
+    roaring_bitmap_lazy_flip_inplace(lazy, 5000, 300000);
+    roaring_bitmap_andnot_inplace(expected, sparse);
+    roaring_bitmap_lazy_andnot_inplace(lazy, sparse);
+    roaring_bitmap_and_inplace(expected, dense);
+    roaring_bitmap_lazy_and_inplace(lazy, dense);
+    roaring_bitmap_xor_inplace(expected, runs);
+    roaring_bitmap_lazy_xor_inplace(lazy, runs);
+    roaring_bitmap_andnot_inplace(expected, runs);
+    roaring_bitmap_lazy_andnot_inplace(lazy, runs);
+    roaring_bitmap_andnot_inplace(expected, dense);
+    roaring_bitmap_lazy_andnot_inplace(lazy, dense);
+    roaring_bitmap_flip_inplace(expected, 0, 0x30000);
+    roaring_bitmap_lazy_flip_inplace(lazy, 0, 0x30000);
+    roaring_bitmap_repair_after_lazy(lazy);
+
+    assert_true(roaring_bitmap_equals(expected, lazy));
+    assert_int_equal(roaring_bitmap_get_cardinality(expected),
+                     roaring_bitmap_get_cardinality(lazy));
+    // the repair pass leaves the same containers as the eager operations
+    assert_int_equal(lazy->high_low_container.size,
+                     expected->high_low_container.size);
+    for (int i = 0; i < lazy->high_low_container.size; i++) {
+        assert_int_equal(lazy->high_low_container.typecodes[i],
+                         expected->high_low_container.typecodes[i]);
+    }
+    roaring_bitmap_free(expected);
+    roaring_bitmap_free(lazy);
+    roaring_bitmap_free(dense);
+    roaring_bitmap_free(sparse);
+    roaring_bitmap_free(runs);
+}
+
+void test_intersection_iterator() {
+    roaring_bitmap_t *r1 = roaring_bitmap_create();
+    roaring_bitmap_t *r2 = roaring_bitmap_create();
+    roaring_bitmap_t *r3 = roaring_bitmap_create();
+    for (uint32_t i = 0; i < 1000000; i += 3) roaring_bitmap_add(r1, i);
+    for (uint32_t i = 0; i < 1000000; i += 5) roaring_bitmap_add(r2, i);
+    roaring_bitmap_add_range(r2, 2000000, 2100000);
+    roaring_bitmap_add_range(r3, 0, 300000);
+    roaring_bitmap_add_range(r3, 600000, 2050000);
+    roaring_bitmap_run_optimize(r3);
+    for (uint32_t i = 2040000; i < 2060000; i += 7) roaring_bitmap_add(r1, i);
+    roaring_bitmap_add(r1, UINT32_MAX);
+    roaring_bitmap_add(r2, UINT32_MAX);
+    roaring_bitmap_add(r3, UINT32_MAX);
+
+    const roaring_bitmap_t *bitmaps[] = {r1, r2, r3};
+    roaring_bitmap_t *expected = roaring_bitmap_and(r1, r2);
+    roaring_bitmap_and_inplace(expected, r3);
+    uint64_t card = roaring_bitmap_get_cardinality(expected);
+    uint32_t *ref = malloc(card * sizeof(uint32_t));
+    uint32_t *buf = malloc(card * sizeof(uint32_t));
+    roaring_bitmap_to_uint32_array(expected, ref);
+
+    roaring_intersection_iterator_t *it =
+        roaring_create_intersection_iterator(3, bitmaps);
+    uint64_t count = 0;
+    for (; it->has_value; roaring_advance_intersection_iterator(it)) {
+        assert_true(count < card);
+        assert_true(it->current_value == ref[count]);
+        count++;
+    }
+    assert_true(count == card);
+    assert_false(roaring_advance_intersection_iterator(it));
+    roaring_free_intersection_iterator(it);
+
+    it = roaring_create_intersection_iterator(3, bitmaps);
+    assert_true(roaring_read_intersection_iterator(it, buf, 7) == 7);
+    uint32_t got = roaring_read_intersection_iterator(it, buf + 7, card);
+    assert_true(got == card - 7);
+    assert_true(array_equals(buf, card, ref, card));
+    roaring_free_intersection_iterator(it);
+
+    it = roaring_create_intersection_iterator(3, bitmaps);
+    assert_true(roaring_move_intersection_iterator_equalorlarger(it, 250001));
+    assert_true(it->current_value == 250005);
+    assert_true(roaring_move_intersection_iterator_equalorlarger(it, 10));
+    assert_true(it->current_value == 250005);
+    assert_true(roaring_move_intersection_iterator_equalorlarger(it, 300000));
+    assert_true(it->current_value == 600000);
+    assert_true(roaring_move_intersection_iterator_equalorlarger(it, 1000000));
+    assert_true(it->current_value == 2040000);
+    assert_true(roaring_move_intersection_iterator_equalorlarger(it, 2050000));
+    assert_true(it->current_value == UINT32_MAX);
+    assert_false(roaring_advance_intersection_iterator(it));
+    roaring_free_intersection_iterator(it);
+
+    it = roaring_create_intersection_iterator(1, bitmaps);
+    assert_true(roaring_read_intersection_iterator(it, buf, 1) == 1);
+    assert_true(buf[0] == 0);
+    roaring_free_intersection_iterator(it);
+
+    roaring_bitmap_t *empty = roaring_bitmap_create();
+    const roaring_bitmap_t *with_empty[] = {r1, empty, r2};
+    it = roaring_create_intersection_iterator(3, with_empty);
+    assert_false(it->has_value);
+    roaring_free_intersection_iterator(it);
+    it = roaring_create_intersection_iterator(0, NULL);
+    assert_false(it->has_value);
+    roaring_free_intersection_iterator(it);
+
+    free(ref);
+    free(buf);
+    roaring_bitmap_free(empty);
+    roaring_bitmap_free(expected);
+    roaring_bitmap_free(r1);
+    roaring_bitmap_free(r2);
+    roaring_bitmap_free(r3);
+}
+
+static void check_merge_iterator(roaring_merge_iterator_t *it,
+                                 const roaring_bitmap_t *expected) {
+    uint64_t card = roaring_bitmap_get_cardinality(expected);
+    uint32_t *ref = malloc((card + 1) * sizeof(uint32_t));
+    uint32_t *buf = malloc((card + 1) * sizeof(uint32_t));
+    roaring_bitmap_to_uint32_array(expected, ref);
+    uint64_t count = 0;
+    // alternate single steps and block reads
+    while (it->has_value) {
+        assert_true(count < card);
+        assert_true(it->current_value == ref[count]);
+        if (count % 2 == 0) {
+            roaring_advance_merge_iterator(it);
+            count++;
+        } else {
+            uint32_t got = roaring_read_merge_iterator(it, buf, 1000);
+            assert_true(got == minimum_uint32(1000, card - count));
+            assert_true(array_equals(buf, got, ref + count, got));
+            count += got;
+        }
+    }
+    assert_true(count == card);
+    assert_true(it->current_value == UINT32_MAX);
+    assert_false(roaring_advance_merge_iterator(it));
+    assert_true(roaring_read_merge_iterator(it, buf, 10) == 0);
+    free(ref);
+    free(buf);
+    roaring_free_merge_iterator(it);
+}
+
+void test_merge_iterators() {
+    roaring_bitmap_t *r[4];
+    for (int i = 0; i < 4; i++) r[i] = roaring_bitmap_create();
+    for (uint32_t i = 0; i < 1000000; i += 3) roaring_bitmap_add(r[0], i);
+    roaring_bitmap_add_range(r[0], 3000000, 3300000);
+    for (uint32_t i = 0; i < 2000000; i += 62) roaring_bitmap_add(r[1], i);
+    roaring_bitmap_add_range(r[2], 500000, 700000);
+    roaring_bitmap_add_range(r[2], 3100000, 3100005);
+    roaring_bitmap_run_optimize(r[2]);
+    roaring_bitmap_add(r[3], 1);
+    roaring_bitmap_add(r[3], 3000000);
+    roaring_bitmap_add(r[3], UINT32_MAX);
+    roaring_bitmap_set_copy_on_write(r[0], true);
+    roaring_bitmap_t *r0copy = roaring_bitmap_copy(r[0]);  // shared containers
+    const roaring_bitmap_t *inputs[] = {r0copy, r[1], r[2], r[3]};
+
+    roaring_bitmap_t *expected =
+        roaring_bitmap_or_many(4, (const roaring_bitmap_t **)r);
+    check_merge_iterator(roaring_create_union_iterator(4, inputs), expected);
+
+    roaring_merge_iterator_t *it = roaring_create_union_iterator(4, inputs);
+    roaring_uint32_iterator_t ref;
+    roaring_init_iterator(expected, &ref);
+    uint32_t targets[] = {0, 2, 2, 499999, 600001, 2000000, 3100001, 3299999,
+                          3300000};
+    for (size_t i = 0; i < sizeof(targets) / sizeof(targets[0]); i++) {
+        assert_true(roaring_move_merge_iterator_equalorlarger(it, targets[i]));
+        roaring_move_uint32_iterator_equalorlarger(&ref, targets[i]);
+        assert_true(it->current_value == ref.current_value);
+    }
+    roaring_free_merge_iterator(it);
+    roaring_bitmap_free(expected);
+
+    expected = roaring_bitmap_andnot(r[0], r[1]);
+    roaring_bitmap_andnot_inplace(expected, r[2]);
+    roaring_bitmap_andnot_inplace(expected, r[3]);
+    check_merge_iterator(roaring_create_andnot_iterator(4, inputs), expected);
+
+    it = roaring_create_andnot_iterator(4, inputs);
+    assert_true(roaring_move_merge_iterator_equalorlarger(it, 500000));
+    assert_true(it->current_value == 700002);
+    assert_true(roaring_move_merge_iterator_equalorlarger(it, 3000000));
+    assert_true(it->current_value == 3000001);
+    assert_true(roaring_move_merge_iterator_equalorlarger(it, 3100000));
+    assert_true(it->current_value == 3100005);
+    assert_false(roaring_move_merge_iterator_equalorlarger(it, 3300000));
+    roaring_free_merge_iterator(it);
+    roaring_bitmap_free(expected);
+
+    // subtracting a superset leaves nothing
+    const roaring_bitmap_t *subset_first[] = {r[3], r[3]};
+    it = roaring_create_andnot_iterator(2, subset_first);
+    assert_false(it->has_value);
+    roaring_free_merge_iterator(it);
+    it = roaring_create_union_iterator(0, NULL);
+    assert_false(it->has_value);
+    roaring_free_merge_iterator(it);
+
+    roaring_bitmap_free(r0copy);
+    for (int i = 0; i < 4; i++) roaring_bitmap_free(r[i]);
+}
+
 void test_iterator_reuse_retry_count(int retry_count){
     uint32_t* ref_values;
     uint32_t ref_count;
@@ -3972,6 +5125,281 @@ void test_frozen_serialization_max_containers() {
     frozen_serialization_compare(r);
 }
 
+// writes a 16-bit value into a frozen image, checks that it is not valid
+// anymore, and restores it
+static void check_frozen_v2_corrupted(char *buf, const char *copy,
+                                      size_t num_bytes, size_t at,
+                                      uint16_t value) {
+    memcpy(buf + at, &value, sizeof(value));
+    assert(roaring_bitmap_frozen_v2_view(buf, num_bytes) == NULL);
+    memcpy(buf, copy, num_bytes);
+}
+
+void test_frozen_v2_serialization() {
+    const uint64_t s = 65536;
+
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    roaring_bitmap_add(r, 0);
+    roaring_bitmap_add(r, UINT32_MAX);
+    roaring_bitmap_add(r, 1000);
+    roaring_bitmap_add(r, 2000);
+    roaring_bitmap_add(r, 100000);
+    roaring_bitmap_add(r, 200000);
+    roaring_bitmap_add_range(r, s*10 + 100, s*13 - 100);
+    for (uint64_t i = 0; i < s*3; i += 2) {
+        roaring_bitmap_add(r, s*20 + i);
+    }
+    roaring_bitmap_add_range(r, s*30, s*30 + 11);
+    roaring_bitmap_add_range(r, s*30 + 20, s*30 + 31);
+    roaring_bitmap_run_optimize(r);
+    const uint32_t n = r->high_low_container.size;
+
+    // stored 8 bytes into the buffer, so that bitsets are not 32-byte aligned,
+    // and followed by other data
+    size_t num_bytes = roaring_bitmap_frozen_v2_size_in_bytes(r);
+    char *base = aligned_malloc(32, num_bytes + 16);
+    char *buf = base + 8;
+    assert(roaring_bitmap_frozen_v2_serialize(r, buf) == num_bytes);
+    memset(buf + num_bytes, 0xFF, 8);
+    const roaring_bitmap_t *r2 =
+        roaring_bitmap_frozen_v2_view(buf, num_bytes + 8);
+    assert(r2 != NULL);
+    assert(roaring_bitmap_equals(r, r2));
+    assert(roaring_bitmap_and_cardinality(r, r2) ==
+           roaring_bitmap_get_cardinality(r));
+    roaring_bitmap_free(r2);
+
+    assert(roaring_bitmap_frozen_v2_view(buf + 2, num_bytes) == NULL);
+    assert(roaring_bitmap_frozen_v2_view(buf, num_bytes - 1) == NULL);
+    assert(roaring_bitmap_frozen_v2_view(buf, 8) == NULL);
+
+    // corrupted offsets, keys and typecodes
+    char *offsets = buf + 8 + 4 * n;
+    uint32_t offset0, offset1;
+    memcpy(&offset0, offsets, 4);
+    memcpy(&offset1, offsets + 4, 4);
+    const uint32_t past_end = (uint32_t)num_bytes;
+    memcpy(offsets, &past_end, 4);
+    assert(roaring_bitmap_frozen_v2_view(buf, num_bytes) == NULL);
+    memcpy(offsets, &offset0, 4);
+    memcpy(offsets + 4, &offset0, 4);
+    assert(roaring_bitmap_frozen_v2_view(buf, num_bytes) == NULL);
+    memcpy(offsets + 4, &offset1, 4);
+    memcpy(buf + 8 + 2, buf + 8, 2);
+    assert(roaring_bitmap_frozen_v2_view(buf, num_bytes) == NULL);
+    memcpy(buf + 8 + 2, &r->high_low_container.keys[1], 2);
+    buf[8 + 8 * n] = SHARED_CONTAINER_TYPE_CODE;
+    assert(roaring_bitmap_frozen_v2_view(buf, num_bytes) == NULL);
+    buf[8 + 8 * n] = r->high_low_container.typecodes[0];
+    r2 = roaring_bitmap_frozen_v2_view(buf, num_bytes);
+    assert(roaring_bitmap_equals(r, r2));
+    roaring_bitmap_free(r2);
+
+    // corrupted contents: an unsorted array, overlapping runs, a run past
+    // 65535 and a bitset of the wrong cardinality
+    char *copy = malloc(num_bytes);
+    memcpy(copy, buf, num_bytes);
+    const roaring_array_t *ra = &r->high_low_container;
+    const int32_t bitset_index = ra_get_index(ra, 20);
+    const int32_t runs_index = ra_get_index(ra, 30);
+    assert(ra->typecodes[0] == ARRAY_CONTAINER_TYPE_CODE);
+    assert(ra->typecodes[bitset_index] == BITSET_CONTAINER_TYPE_CODE);
+    assert(ra->typecodes[runs_index] == RUN_CONTAINER_TYPE_CODE);
+    uint32_t runs_offset;
+    memcpy(&runs_offset, offsets + 4 * runs_index, 4);
+    uint16_t bitset_count;
+    memcpy(&bitset_count, buf + 8 + 2 * n + 2 * bitset_index, 2);
+    // the array holds 0, 1000 and 2000, the runs start at 0 and 20
+    check_frozen_v2_corrupted(buf, copy, num_bytes, offset0 + 4, 1000);
+    check_frozen_v2_corrupted(buf, copy, num_bytes, runs_offset + 4, 5);
+    check_frozen_v2_corrupted(buf, copy, num_bytes, runs_offset + 6, 65516);
+    check_frozen_v2_corrupted(buf, copy, num_bytes,
+                              8 + 2 * n + 2 * bitset_index, bitset_count - 1);
+    r2 = roaring_bitmap_frozen_v2_view(buf, num_bytes);
+    assert(roaring_bitmap_equals(r, r2));
+    roaring_bitmap_free(r2);
+    free(copy);
+
+    roaring_bitmap_free(r);
+    aligned_free(base);
+}
+
+void test_frozen_v2_overlay() {
+    const uint64_t s = 65536;
+
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    for (uint64_t k = 0; k < 12; k++) {
+        switch (k % 3) {
+            case 0:  // array
+                roaring_bitmap_add_range(r, s*k, s*k + 100);
+                break;
+            case 1:  // run
+                roaring_bitmap_add_range(r, s*k + 1000, s*k + 50000);
+                break;
+            default:  // bitset
+                for (uint64_t i = 0; i < s; i += 3) {
+                    roaring_bitmap_add(r, s*k + i);
+                }
+        }
+    }
+    roaring_bitmap_run_optimize(r);
+    size_t num_bytes = roaring_bitmap_frozen_v2_size_in_bytes(r);
+    char *image = aligned_malloc(32, num_bytes);
+    roaring_bitmap_frozen_v2_serialize(r, image);
+    char *copy = malloc(num_bytes);
+    memcpy(copy, image, num_bytes);
+
+    roaring_overlay_t overlay;
+    assert(!roaring_overlay_init(&overlay, image + 1, num_bytes - 1));
+    assert(roaring_overlay_init(&overlay, image, num_bytes));
+    assert(roaring_bitmap_equals(r, overlay.bitmap));
+
+    // the same changes to both bitmaps, leaving some containers unmodified
+    roaring_bitmap_t *changes[] = {r, overlay.bitmap};
+    for (int i = 0; i < 2; i++) {
+        roaring_bitmap_add(changes[i], s*3 + 5000);
+        roaring_bitmap_remove(changes[i], s*5 + 3);
+        roaring_bitmap_remove_range(changes[i], s*7, s*8);
+        roaring_bitmap_add(changes[i], s*100);
+        roaring_bitmap_add_range(changes[i], s*10, s*10 + 1000);
+    }
+    // a copy sharing the containers
+    roaring_bitmap_set_copy_on_write(overlay.bitmap, true);
+    roaring_bitmap_t *shared = roaring_bitmap_copy(overlay.bitmap);
+    roaring_bitmap_add(shared, s*4 + 7);
+    assert(roaring_bitmap_equals(r, overlay.bitmap));
+    assert(memcmp(copy, image, num_bytes) == 0);
+
+    // writing back gives the same bytes as serializing
+    size_t new_bytes = roaring_bitmap_frozen_v2_size_in_bytes(r);
+    assert(roaring_bitmap_frozen_v2_size_in_bytes(overlay.bitmap) ==
+           new_bytes);
+    char *expected = aligned_malloc(32, new_bytes);
+    char *written = aligned_malloc(32, new_bytes);
+    assert(roaring_bitmap_frozen_v2_serialize(r, expected) == new_bytes);
+    assert(roaring_overlay_write(&overlay, written) == new_bytes);
+    assert(memcmp(expected, written, new_bytes) == 0);
+    const roaring_bitmap_t *view =
+        roaring_bitmap_frozen_v2_view(written, new_bytes);
+    assert(roaring_bitmap_equals(r, view));
+
+    roaring_bitmap_free(view);
+    roaring_bitmap_free(shared);
+    roaring_overlay_free(&overlay);
+    roaring_bitmap_free(r);
+    aligned_free(written);
+    aligned_free(expected);
+    free(copy);
+    aligned_free(image);
+}
+
+// the value of key k checked by test_key_index is (k << 16) | k
+static void check_key_index(const roaring_bitmap_t *r, const bool *expected) {
+    uint64_t card = 0;
+    for (uint32_t k = 0; k < 65536; k++) {
+        assert_true(roaring_bitmap_contains(r, (k << 16) | k) == expected[k]);
+        assert_false(roaring_bitmap_contains(r, (k << 16) | (k ^ 1)));
+        card += expected[k];
+    }
+    assert_true(roaring_bitmap_get_cardinality(r) == card);
+    assert_non_null(r->high_low_container.key_index);
+}
+
+static roaring_bitmap_t *key_index_bitmap(uint32_t modulo, bool multiples) {
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    for (uint32_t k = 0; k < 65536; k++) {
+        if ((k % modulo == 0) == multiples) roaring_bitmap_add(r, (k << 16) | k);
+    }
+    return r;
+}
+
+void test_key_index() {
+    bool *expected = calloc(65536, sizeof(bool));
+    // appending builds the index
+    roaring_bitmap_t *r = key_index_bitmap(2, true);
+    for (uint32_t k = 0; k < 65536; k += 2) expected[k] = true;
+    check_key_index(r, expected);
+
+    // new containers in the middle
+    for (uint32_t k = 19999; k < 20000; k -= 2) {
+        roaring_bitmap_add(r, (k << 16) | k);
+        expected[k] = true;
+    }
+    check_key_index(r, expected);
+
+    // emptied containers
+    for (uint32_t k = 0; k < 65536; k += 3) {
+        roaring_bitmap_remove(r, (k << 16) | k);
+        expected[k] = false;
+    }
+    check_key_index(r, expected);
+
+    // keys rewritten in place
+    roaring_bitmap_remove_range_closed(r, UINT32_C(30000) << 16,
+                                       (UINT32_C(40000) << 16) | 0xFFFF);
+    for (uint32_t k = 30000; k <= 40000; k++) expected[k] = false;
+    check_key_index(r, expected);
+    roaring_bitmap_add_range_closed(r, (UINT32_C(50000) << 16) | 50000,
+                                    (UINT32_C(50010) << 16) | 50010);
+    for (uint32_t k = 50000; k < 50010; k++) {
+        assert_true(roaring_bitmap_contains(r, (k << 16) | 0xFFFF));
+        expected[k] = true;
+    }
+    expected[50010] = true;
+    roaring_bitmap_t *diagonal = key_index_bitmap(1, true);
+    roaring_bitmap_and_inplace(r, diagonal);
+    roaring_bitmap_free(diagonal);
+    check_key_index(r, expected);
+
+    // in-place merges
+    roaring_bitmap_t *other = key_index_bitmap(5, false);
+    roaring_bitmap_and_inplace(r, other);
+    roaring_bitmap_free(other);
+    for (uint32_t k = 0; k < 65536; k += 5) expected[k] = false;
+    check_key_index(r, expected);
+    other = key_index_bitmap(7, true);
+    roaring_bitmap_or_inplace(r, other);
+    roaring_bitmap_free(other);
+    for (uint32_t k = 0; k < 65536; k += 7) expected[k] = true;
+    check_key_index(r, expected);
+    other = key_index_bitmap(11, true);
+    roaring_bitmap_xor_inplace(r, other);
+    roaring_bitmap_free(other);
+    for (uint32_t k = 0; k < 65536; k += 11) expected[k] = !expected[k];
+    check_key_index(r, expected);
+    other = roaring_bitmap_from_range(UINT32_C(60000) << 16, UINT64_C(1) << 32, 1);
+    roaring_bitmap_andnot_inplace(r, other);
+    roaring_bitmap_free(other);
+    for (uint32_t k = 60000; k < 65536; k++) expected[k] = false;
+    check_key_index(r, expected);
+
+    // copies
+    roaring_bitmap_t *copy = roaring_bitmap_copy(r);
+    check_key_index(copy, expected);
+    roaring_bitmap_free(copy);
+    char *serialized = malloc(roaring_bitmap_portable_size_in_bytes(r));
+    roaring_bitmap_portable_serialize(r, serialized);
+    copy = roaring_bitmap_portable_deserialize(serialized);
+    check_key_index(copy, expected);
+    roaring_bitmap_free(copy);
+    free(serialized);
+
+    // the index is released with most containers
+    roaring_bitmap_t *few = roaring_bitmap_from_range(0, 1000 << 16, 1);
+    roaring_bitmap_and_inplace(r, few);
+    roaring_bitmap_free(few);
+    assert_null(r->high_low_container.key_index);
+    for (uint32_t k = 1000; k < 65536; k++) expected[k] = false;
+    uint64_t card = 0;
+    for (uint32_t k = 0; k < 65536; k++) {
+        assert_true(roaring_bitmap_contains(r, (k << 16) | k) == expected[k]);
+        card += expected[k];
+    }
+    assert_true(roaring_bitmap_get_cardinality(r) == card);
+    roaring_bitmap_free(r);
+    free(expected);
+}
+
 
 int main() {
     const struct CMUnitTest tests[] = {
@@ -4021,6 +5449,11 @@ int main() {
         cmocka_unit_test(test_iterate_withrun),
         cmocka_unit_test(test_serialize),
         cmocka_unit_test(test_portable_serialize),
+        cmocka_unit_test(test_portable_packed_serialize),
+        cmocka_unit_test(test_portable_packed_serialize_arrays),
+        cmocka_unit_test(test_portable_deserialize_parallel),
+        cmocka_unit_test(test_serialization_context),
+        cmocka_unit_test(test_compressed_serialize),
         cmocka_unit_test(test_add),
         cmocka_unit_test(test_add_checked),
         cmocka_unit_test(test_remove_checked),
@@ -4074,6 +5507,10 @@ int main() {
         cmocka_unit_test(select_test),
         cmocka_unit_test(test_subset),
         cmocka_unit_test(test_or_many_memory_leak),
+        cmocka_unit_test(test_or_many_plan),
+        cmocka_unit_test(test_xor_many_cancelling),
+        cmocka_unit_test(test_threshold_many),
+        cmocka_unit_test(test_bsi),
         // cmocka_unit_test(test_run_to_bitset),
         // cmocka_unit_test(test_run_to_array),
         cmocka_unit_test(test_read_uint32_iterator_array),
@@ -4084,14 +5521,26 @@ int main() {
         cmocka_unit_test(test_previous_iterator_bitset),
         cmocka_unit_test(test_previous_iterator_run),
         cmocka_unit_test(test_previous_iterator_native),
+        cmocka_unit_test(test_read_previous_uint32_iterator_array),
+        cmocka_unit_test(test_read_previous_uint32_iterator_bitset),
+        cmocka_unit_test(test_read_previous_uint32_iterator_run),
+        cmocka_unit_test(test_read_previous_uint32_iterator_native),
         cmocka_unit_test(test_iterator_reuse),
         cmocka_unit_test(test_iterator_reuse_many),
+        cmocka_unit_test(test_auto_run),
+        cmocka_unit_test(test_lazy_add),
+        cmocka_unit_test(test_lazy_chain),
+        cmocka_unit_test(test_intersection_iterator),
+        cmocka_unit_test(test_merge_iterators),
         cmocka_unit_test(test_add_range),
         cmocka_unit_test(test_remove_range),
         cmocka_unit_test(test_remove_many),
         cmocka_unit_test(test_range_cardinality),
         cmocka_unit_test(test_frozen_serialization),
         cmocka_unit_test(test_frozen_serialization_max_containers),
+        cmocka_unit_test(test_frozen_v2_serialization),
+        cmocka_unit_test(test_frozen_v2_overlay),
+        cmocka_unit_test(test_key_index),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <roaring/array_util.h>
 #include <roaring/bitset_util.h>
 
 #include "test.h"
@@ -129,9 +130,36 @@ void setandextract_avx2_uint32() {
 }
 #endif
 
+void branchless_binary_search() {
+    uint16_t* vals = malloc(65536 * sizeof(uint16_t));
+    // short arrays are scanned, the step puts the last value near 65535
+    for (int32_t length = 0; length <= 40; length++) {
+        const uint32_t step = length > 1 ? 65535 / (length - 1) : 1;
+        for (int32_t k = 0; k < length; ++k) {
+            vals[k] = (uint16_t)(k * step);
+        }
+        for (uint32_t key = 0; key < 65536; ++key) {
+            assert_int_equal(branchlessBinarySearch(vals, length, key),
+                             binarySearch(vals, length, key));
+        }
+    }
+    for (uint32_t step = 1; step <= 3; step++) {
+        const int32_t length = (int32_t)(65536 / step);
+        for (int32_t k = 0; k < length; ++k) {
+            vals[k] = (uint16_t)(k * step);
+        }
+        for (uint32_t key = 0; key < 65536; ++key) {
+            assert_int_equal(branchlessBinarySearch(vals, length, key),
+                             binarySearch(vals, length, key));
+        }
+    }
+    free(vals);
+}
+
 int main() {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(setandextract_uint16),
+        cmocka_unit_test(branchless_binary_search),
 #ifdef IS_X64
         cmocka_unit_test(setandextract_sse_uint16),
 #endif